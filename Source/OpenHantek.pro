@@ -15,21 +15,39 @@ LIBS += -LC:/Qt/lib/fftw-3.3.4-dll32/ -lfftw3-3 # Find .lib files
 # LIBS += -LC:/Qt/lib/fftw-3.3.4-dll32/ -lfftw3 # Find .lib files Linux Build
 
 # Source files
-SOURCES += src/colorbox.cpp \
+SOURCES += src/capturecodec.cpp \
+    src/capturefile.cpp \
+    src/captureplayer.cpp \
+    src/colorbox.cpp \
     src/configdialog.cpp \
     src/configpages.cpp \
+    src/csvwriter.cpp \
     src/dataanalyzer.cpp \
+    src/decibel.cpp \
+    src/digitalfilter.cpp \
+    src/digitalphosphor.cpp \
     src/dockwindows.cpp \
     src/dsocontrol.cpp \
     src/dsowidget.cpp \
     src/exporter.cpp \
+    src/framehistory.cpp \
+    src/framepacer.cpp \
     src/glgenerator.cpp \
     src/glscope.cpp \
+    src/glspectrogram.cpp \
+    src/harmonicanalysis.cpp \
     src/helper.cpp \
     src/levelslider.cpp \
     src/main.cpp \
+    src/masktest.cpp \
+    src/mathexpression.cpp \
+    src/minmaxpyramid.cpp \
     src/openhantek.cpp \
+    src/protocoldecoder.cpp \
     src/settings.cpp \
+    src/sincinterpolator.cpp \
+    src/spectrogram.cpp \
+    src/zoomfft.cpp \
     src/hantek/hantek_control.cpp \
     src/hantek/hantek_device.cpp \
     src/hantek/hantek_types.cpp \
@@ -37,20 +55,38 @@ SOURCES += src/colorbox.cpp \
     src/buudai/buudai_device.cpp \
     src/buudai/buudai_types.cpp \
     src/dso.cpp
-HEADERS += src/colorbox.h \
+HEADERS += src/capturecodec.h \
+    src/capturefile.h \
+    src/captureplayer.h \
+    src/colorbox.h \
     src/configdialog.h \
     src/configpages.h \
+    src/csvwriter.h \
     src/dataanalyzer.h \
+    src/decibel.h \
+    src/digitalfilter.h \
+    src/digitalphosphor.h \
     src/dockwindows.h \
     src/dsocontrol.h \
     src/dsowidget.h \
     src/exporter.h \
+    src/framehistory.h \
+    src/framepacer.h \
     src/glscope.h \
     src/glgenerator.h \
+    src/glspectrogram.h \
+    src/harmonicanalysis.h \
     src/helper.h \
     src/levelslider.h \
+    src/masktest.h \
+    src/mathexpression.h \
+    src/minmaxpyramid.h \
     src/openhantek.h \
+    src/protocoldecoder.h \
     src/settings.h \
+    src/sincinterpolator.h \
+    src/spectrogram.h \
+    src/zoomfft.h \
     src/hantek/hantek_control.h \
     src/hantek/hantek_device.h \
     src/hantek/hantek_types.h \
@@ -0,0 +1,73 @@
+TEMPLATE = app
+
+# Configuration
+CONFIG += warn_on \
+    qt \
+    console \
+    release
+QT += opengl widgets
+
+# Source files, the scope pipeline is taken from the program
+SOURCES += scopebenchmark.cpp \
+    ../src/capturecodec.cpp \
+    ../src/csvwriter.cpp \
+    ../src/dataanalyzer.cpp \
+    ../src/decibel.cpp \
+    ../src/digitalfilter.cpp \
+    ../src/digitalphosphor.cpp \
+    ../src/dso.cpp \
+    ../src/glgenerator.cpp \
+    ../src/glscope.cpp \
+    ../src/harmonicanalysis.cpp \
+    ../src/helper.cpp \
+    ../src/masktest.cpp \
+    ../src/mathexpression.cpp \
+    ../src/minmaxpyramid.cpp \
+    ../src/protocoldecoder.cpp \
+    ../src/settings.cpp \
+    ../src/sincinterpolator.cpp \
+    ../src/spectrogram.cpp \
+    ../src/zoomfft.cpp
+HEADERS += ../src/capturecodec.h \
+    ../src/csvwriter.h \
+    ../src/dataanalyzer.h \
+    ../src/glgenerator.h \
+    ../src/glscope.h \
+    ../src/settings.h
+
+# Destination directory for built binaries
+DESTDIR = bin
+
+# Build directories
+OBJECTS_DIR = build/obj
+MOC_DIR = build/moc
+
+# Include directory
+QMAKE_CXXFLAGS += "-iquote $${IN_PWD}/../src"
+
+# The helpers only need the error codes from the libusb header, no library
+LIBUSB_VERSION = $$(LIBUSB_VERSION)
+!contains(LIBUSB_VERSION, 0): LIBUSB_VERSION = 1
+DEFINES += LIBUSB_VERSION=$${LIBUSB_VERSION}
+
+# Settings for different operating systems
+unix:!macx {
+    TARGET = openhantek-benchmark
+    INCLUDEPATH += /usr/include/libusb
+    LIBS += -lfftw3
+    DEFINES += OS_UNIX
+}
+macx {
+    TARGET = OpenHantekBenchmark
+    CONFIG -= app_bundle
+    INCLUDEPATH += /opt/local/include
+    LIBS += -L/opt/local/lib -lfftw3
+    DEFINES += OS_DARWIN
+}
+win32 {
+    TARGET = OpenHantekBenchmark
+    INCLUDEPATH += C:/Qt/lib/libusb/include \
+        C:/Qt/lib/fftw-3.3.4-dll32
+    LIBS += -LC:/Qt/lib/fftw-3.3.4-dll32/ -lfftw3-3
+    DEFINES += OS_WINDOWS
+}
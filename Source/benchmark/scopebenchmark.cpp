@@ -0,0 +1,411 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  OpenHantek
+//  scopebenchmark.cpp
+//
+//  Measures the time the scope pipeline needs for a frame without a device.
+//  Synthetic samples are analyzed, turned into graphs and drawn into an
+//  offscreen framebuffer, by default with the software renderer of Mesa. It
+//  needs a X server, for example the one of xvfb-run:
+//    xvfb-run bin/openhantek-benchmark [--suite all|scope|csv|codec]
+//        [--frames N] [--width W] [--height H] [--values N]
+//  Every configuration gives a CSV line with the percentiles of the analysis,
+//  the graph generation, the drawing and the whole frame. The csv suite
+//  measures the formatting of the CSV export, the codec suite the compression
+//  of capture files with and without SSE2. No reference results are kept,
+//  compare runs on the same machine.
+//
+//  This program is free software: you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation, either version 3 of the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <cmath>
+#include <cstdlib>
+
+#include <QApplication>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QGLFramebufferObject>
+#include <QIODevice>
+#include <QMutex>
+#include <QStringList>
+#include <QTextStream>
+#include <QVector>
+
+
+#include "capturecodec.h"
+#include "csvwriter.h"
+#include "dataanalyzer.h"
+#include "glgenerator.h"
+#include "glscope.h"
+#include "settings.h"
+
+
+#define BENCHMARK_WARMUP            5 ///< Frames drawn before the measurement starts
+#define BENCHMARK_SAMPLERATE      1e6 ///< The samplerate of the synthetic samples
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// \class BenchmarkScope
+/// \brief A scope that is drawn on demand into the current framebuffer.
+class BenchmarkScope : public GlScope {
+	public:
+		BenchmarkScope(DsoSettings *settings) : GlScope(settings) {
+		}
+		
+		/// \brief Initializes the OpenGL state for the given size.
+		void prepare(int width, int height) {
+			this->makeCurrent();
+			this->initializeGL();
+			this->resizeGL(width, height);
+		}
+		
+		/// \brief Draws the scope and waits until the renderer is done.
+		void render() {
+			this->makeCurrent();
+			this->paintGL();
+			glFinish();
+		}
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \class NullDevice
+/// \brief A device that drops everything written to it.
+class NullDevice : public QIODevice {
+	protected:
+		qint64 readData(char *data, qint64 maxSize) {
+			Q_UNUSED(data);
+			Q_UNUSED(maxSize);
+			return -1;
+		}
+		
+		qint64 writeData(const char *data, qint64 maxSize) {
+			Q_UNUSED(data);
+			return maxSize;
+		}
+};
+
+/// \brief Get a percentile of sorted frame times.
+/// \param times The sorted times in nanoseconds.
+/// \param percentile The percentile in percent.
+/// \return The time in milliseconds.
+static double percentile(const QList<qint64> &times, double percentile) {
+	if(times.isEmpty())
+		return 0;
+	
+	int index = qBound(0, (int) ceil(percentile / 100 * times.count()) - 1, times.count() - 1);
+	return times[index] / 1e6;
+}
+
+/// \brief Write the median, the 90th and 99th percentile and the maximum.
+/// \param output The stream the CSV line is written to.
+/// \param times The sorted times in nanoseconds.
+static void writePercentiles(QTextStream &output, const QList<qint64> &times) {
+	output << ',' << percentile(times, 50) << ',' << percentile(times, 90)
+			<< ',' << percentile(times, 99) << ',' << percentile(times, 100);
+}
+
+/// \brief Get the value of a numeric command line option.
+/// \param arguments The command line arguments.
+/// \param name The name of the option.
+/// \param defaultValue The value if the option isn't given.
+/// \return The value of the option.
+static int option(const QStringList &arguments, const QString &name, int defaultValue) {
+	int index = arguments.indexOf(name);
+	if(index < 0 || index + 1 >= arguments.count())
+		return defaultValue;
+	
+	return arguments[index + 1].toInt();
+}
+
+/// \brief Measures the scope pipeline in all configurations.
+/// \param application The application that delivers the events.
+/// \param output The stream the CSV table is written to.
+/// \param frames The measured frames of every configuration.
+/// \param width The width of the framebuffer.
+/// \param height The height of the framebuffer.
+/// \return false if there is no OpenGL framebuffer.
+static bool benchmarkScope(QApplication &application, QTextStream &output, int frames, int width, int height) {
+	if(!QGLFormat::hasOpenGL() || !QGLFramebufferObject::hasOpenGLFramebufferObjects()) {
+		qWarning("No OpenGL framebuffer objects available");
+		return false;
+	}
+	
+	DsoSettings *settings = new DsoSettings();
+	settings->setChannelCount(2);
+	settings->scope.horizontal.format = Dso::GRAPHFORMAT_TY;
+	settings->view.zoom = false;
+	for(int channel = 0; channel < settings->scope.spectrum.count(); channel++)
+		settings->scope.spectrum[channel].used = false;
+	
+	DataAnalyzer *dataAnalyzer = new DataAnalyzer(settings);
+	GlGenerator *generator = new GlGenerator(settings);
+	generator->setDataAnalyzer(dataAnalyzer);
+	BenchmarkScope *scope = new BenchmarkScope(settings);
+	scope->setAttribute(Qt::WA_DontShowOnScreen);
+	scope->resize(width, height);
+	scope->setGenerator(generator);
+	scope->show();
+	scope->prepare(width, height);
+	QGLFramebufferObject *framebuffer = new QGLFramebufferObject(width, height);
+	
+	// The swept parameters
+	QList<unsigned int> sampleCounts;
+	sampleCounts << 10240 << 131072 << 1048576;
+	QList<int> phosphorDepths;
+	phosphorDepths << -1 << 8 << 0;
+	QStringList phosphorNames;
+	phosphorNames << "off" << "8" << "infinite";
+	QStringList interpolationNames;
+	interpolationNames << "off" << "linear" << "sinc";
+	
+	output << "samples,channels,phosphor,interpolation,antialiasing,frames,"
+			"analyze_p50_ms,analyze_p90_ms,analyze_p99_ms,analyze_max_ms,"
+			"generate_p50_ms,generate_p90_ms,generate_p99_ms,generate_max_ms,"
+			"render_p50_ms,render_p90_ms,render_p99_ms,render_max_ms,"
+			"frame_p50_ms,frame_p90_ms,frame_p99_ms,frame_max_ms\n";
+	output.flush();
+	
+	QMutex dataMutex;
+	for(int sampleIndex = 0; sampleIndex < sampleCounts.count(); sampleIndex++) {
+		unsigned int sampleCount = sampleCounts[sampleIndex];
+		
+		// One screen holds the whole buffer
+		settings->scope.horizontal.samplerate = BENCHMARK_SAMPLERATE;
+		settings->scope.horizontal.timebase = sampleCount / BENCHMARK_SAMPLERATE / DIVS_TIME;
+		
+		QList<double *> data;
+		QList<unsigned int> dataSizes;
+		for(unsigned int channel = 0; channel < settings->scope.physicalChannels; channel++) {
+			data.append(new double[sampleCount]);
+			dataSizes.append(sampleCount);
+		}
+		
+		for(unsigned int channels = 1; channels <= settings->scope.physicalChannels; channels++) {
+			for(int channel = 0; channel < settings->scope.voltage.count(); channel++)
+				settings->scope.voltage[channel].used = (unsigned int) channel < channels;
+			
+			for(int phosphorIndex = 0; phosphorIndex < phosphorDepths.count(); phosphorIndex++) {
+				settings->view.digitalPhosphor = phosphorDepths[phosphorIndex] >= 0;
+				settings->view.digitalPhosphorDepth = qMax(phosphorDepths[phosphorIndex], 0);
+				
+				for(int interpolation = Dso::INTERPOLATION_OFF; interpolation < Dso::INTERPOLATION_COUNT; interpolation++) {
+					settings->view.interpolation = (Dso::InterpolationMode) interpolation;
+					
+					for(int antialiasing = 0; antialiasing < 2; antialiasing++) {
+						settings->view.antialiasing = antialiasing;
+						
+						QList<qint64> analyzeTimes, generateTimes, renderTimes, frameTimes;
+						for(int frame = -BENCHMARK_WARMUP; frame < frames; frame++) {
+							// A noisy sine that moves a bit with every frame
+							for(int channel = 0; channel < data.count(); channel++) {
+								double amplitude = settings->scope.voltage[channel].gain * 3;
+								double cycles = 20.0 * (channel + 1) / sampleCount;
+								for(unsigned int position = 0; position < sampleCount; position++)
+									data[channel][position] = amplitude * sin(2 * M_PI * (cycles * position + frame * 0.01)) + amplitude * 0.02 * (rand() / (double) RAND_MAX - 0.5);
+							}
+							
+							QElapsedTimer timer;
+							timer.start();
+							
+							// Analysis and generation run in their threads, the events connect them like in the program
+							dataAnalyzer->analyze(&data, &dataSizes, BENCHMARK_SAMPLERATE, &dataMutex);
+							dataAnalyzer->wait();
+							qint64 analyzed = timer.nsecsElapsed();
+							application.processEvents();
+							generator->wait();
+							qint64 generated = timer.nsecsElapsed();
+							
+							// The scope accumulates the digital phosphor when the graphs arrive
+							application.processEvents();
+							framebuffer->bind();
+							scope->render();
+							framebuffer->release();
+							qint64 rendered = timer.nsecsElapsed();
+							
+							if(frame >= 0) {
+								analyzeTimes.append(analyzed);
+								generateTimes.append(generated - analyzed);
+								renderTimes.append(rendered - generated);
+								frameTimes.append(rendered);
+							}
+						}
+						
+						qSort(analyzeTimes);
+						qSort(generateTimes);
+						qSort(renderTimes);
+						qSort(frameTimes);
+						output << sampleCount << ',' << channels << ','
+								<< phosphorNames[phosphorIndex] << ','
+								<< interpolationNames.value(interpolation) << ',' << antialiasing << ',' << frames;
+						writePercentiles(output, analyzeTimes);
+						writePercentiles(output, generateTimes);
+						writePercentiles(output, renderTimes);
+						writePercentiles(output, frameTimes);
+						output << '\n';
+						output.flush();
+					}
+				}
+			}
+		}
+		
+		for(int channel = 0; channel < data.count(); channel++)
+			delete[] data[channel];
+	}
+	
+	delete framebuffer;
+	delete scope;
+	delete generator;
+	delete dataAnalyzer;
+	delete settings;
+	
+	return true;
+}
+
+/// \brief Measures the CSV formatting of quantized and arbitrary values.
+/// \param output The stream the CSV table is written to.
+/// \param values The values formatted in every configuration.
+static void benchmarkCsv(QTextStream &output, int values) {
+	// Voltages of a 8 bit ADC like the exporter gets them and random doubles
+	QVector<double> quantized(values), random(values);
+	for(int index = 0; index < values; index++) {
+		quantized[index] = ((rand() & 0xff) - 0x80) * 5.0 / 0x80 - 0.3;
+		random[index] = (rand() / (double) RAND_MAX - 0.5) * 20;
+	}
+	QList<const QVector<double> *> inputs;
+	inputs << &quantized << &random;
+	QStringList inputNames;
+	inputNames << "quantized" << "random";
+	
+	// Precision 0 searches the shortest exact digits, -1 stands for the old QTextStream output
+	QList<int> precisions;
+	precisions << -1 << 0 << 6 << 10 << 15 << 17;
+	
+	output << "values,input,precision,ns_per_value,mb_per_s\n";
+	output.flush();
+	
+	NullDevice device;
+	device.open(QIODevice::WriteOnly);
+	for(int input = 0; input < inputs.count(); input++) {
+		for(int precisionIndex = 0; precisionIndex < precisions.count(); precisionIndex++) {
+			int precision = precisions[precisionIndex];
+			
+			device.reset();
+			QElapsedTimer timer;
+			timer.start();
+			if(precision < 0) {
+				QTextStream stream(&device);
+				for(int index = 0; index < values; index++)
+					stream << ',' << (*inputs[input])[index];
+			}
+			else {
+				CsvWriter csvWriter(&device, precision);
+				for(int index = 0; index < values; index++)
+					csvWriter.writeValue((*inputs[input])[index]);
+			}
+			qint64 elapsed = timer.nsecsElapsed();
+			
+			output << values << ',' << inputNames[input] << ',';
+			if(precision < 0)
+				output << "qtextstream";
+			else
+				output << precision;
+			output << ',' << (double) elapsed / values << ',' << device.pos() * 1e3 / elapsed << '\n';
+			output.flush();
+		}
+	}
+}
+
+/// \brief Measures the compression of capture files with both predictions.
+/// \param output The stream the CSV table is written to.
+/// \param codes The codes compressed in every configuration.
+static void benchmarkCodec(QTextStream &output, int codes) {
+	// The 8 bit codes of a noisy sine like the oscilloscope gives them and random 16 bit codes
+	QVector<qint16> sine(codes), random(codes), decoded(codes);
+	for(int position = 0; position < codes; position++) {
+		sine[position] = (qint16) floor(100 * sin(position * 0.001) + 0.5) + rand() % 3 - 1;
+		random[position] = (qint16) (rand() & 0xffff);
+	}
+	QList<const QVector<qint16> *> inputs;
+	inputs << &sine << &random;
+	QStringList inputNames;
+	inputNames << "sine8" << "random16";
+	QByteArray encoded(CaptureCodec::maxEncodedSize(codes), 0);
+	
+	output << "codes,input,prediction,ratio,encode_mcodes_per_s,decode_mcodes_per_s\n";
+	output.flush();
+	
+	for(int input = 0; input < inputs.count(); input++) {
+		for(int vectorized = CaptureCodec::hasSse2() ? 1 : 0; vectorized >= 0; vectorized--) {
+			// The fastest of a few runs, the first ones warm up the caches
+			qint64 encodeTime = -1, decodeTime = -1;
+			int size = 0;
+			for(int run = 0; run < BENCHMARK_WARMUP; run++) {
+				QElapsedTimer timer;
+				timer.start();
+				size = CaptureCodec::encode(inputs[input]->constData(), codes, (uchar *) encoded.data(), vectorized);
+				qint64 encodeEnd = timer.nsecsElapsed();
+				CaptureCodec::decode((const uchar *) encoded.constData(), size, codes, decoded.data(), vectorized);
+				qint64 decodeEnd = timer.nsecsElapsed();
+				
+				if(encodeTime < 0 || encodeEnd < encodeTime)
+					encodeTime = encodeEnd;
+				if(decodeTime < 0 || decodeEnd - encodeEnd < decodeTime)
+					decodeTime = decodeEnd - encodeEnd;
+			}
+			if(decoded != *inputs[input])
+				qWarning("The codec doesn't give back the %s codes", qPrintable(inputNames[input]));
+			
+			output << codes << ',' << inputNames[input] << ',' << (vectorized ? "sse2" : "c++") << ','
+					<< (double) codes * 2 / size << ',' << codes * 1e3 / qMax(encodeTime, (qint64) 1) << ','
+					<< codes * 1e3 / qMax(decodeTime, (qint64) 1) << '\n';
+			output.flush();
+		}
+	}
+}
+
+/// \brief Runs the selected benchmarks and prints the results.
+int main(int argc, char *argv[]) {
+	// Prefer the software renderer, so the results don't depend on the graphics driver
+	if(qgetenv("LIBGL_ALWAYS_SOFTWARE").isEmpty())
+		qputenv("LIBGL_ALWAYS_SOFTWARE", "1");
+	
+	QApplication application(argc, argv);
+	QStringList arguments = application.arguments();
+	int frames = option(arguments, "--frames", 50);
+	int width = option(arguments, "--width", 800);
+	int height = option(arguments, "--height", 600);
+	int values = option(arguments, "--values", 1000000);
+	int suiteIndex = arguments.indexOf("--suite");
+	QString suite = suiteIndex >= 0 ? arguments.value(suiteIndex + 1) : QString("all");
+	
+	// Every suite writes its own table, an empty line separates them
+	QTextStream output(stdout);
+	if(suite == "all" || suite == "scope") {
+		if(!benchmarkScope(application, output, frames, width, height))
+			return 1;
+		output << '\n';
+	}
+	if(suite == "all" || suite == "csv") {
+		benchmarkCsv(output, values);
+		output << '\n';
+	}
+	if(suite == "all" || suite == "codec") {
+		benchmarkCodec(output, values);
+		output << '\n';
+	}
+	
+	return 0;
+}
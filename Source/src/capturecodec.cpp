@@ -0,0 +1,327 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  OpenHantek
+//  capturecodec.cpp
+//
+//  This program is free software: you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation, either version 3 of the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <cstring>
+
+#include <QtEndian>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+
+#include "capturecodec.h"
+
+
+#ifdef __SSE2__
+/// \brief Adds up four values and the carry from the previous ones.
+/// \param values The values.
+/// \param carry The sum of the previous values in all elements.
+/// \return The running sums.
+static inline __m128i prefixSum(__m128i values, __m128i carry) {
+	values = _mm_add_epi32(values, _mm_slli_si128(values, 4));
+	values = _mm_add_epi32(values, _mm_slli_si128(values, 8));
+	return _mm_add_epi32(values, carry);
+}
+
+/// \brief Combines the bits of four values.
+/// \param values The values.
+/// \return The bitwise or of the values.
+static inline quint32 combineBits(__m128i values) {
+	values = _mm_or_si128(values, _mm_srli_si128(values, 8));
+	values = _mm_or_si128(values, _mm_srli_si128(values, 4));
+	return _mm_cvtsi128_si32(values);
+}
+#endif
+
+
+////////////////////////////////////////////////////////////////////////////////
+// class CaptureCodec
+/// \brief Returns the largest possible size of encoded codes.
+/// \param count The number of codes.
+/// \return The bytes needed for the output of encode().
+int CaptureCodec::maxEncodedSize(unsigned int count) {
+	unsigned int blocks = (count + CAPTURECODEC_BLOCKSIZE - 1) / CAPTURECODEC_BLOCKSIZE;
+	
+	return blocks * (1 + CAPTURECODEC_BLOCKSIZE * CAPTURECODEC_MAXWIDTH / 8);
+}
+
+/// \brief Tells if the prediction and reconstruction can use SSE2.
+/// \return true if the codec has been built with SSE2.
+bool CaptureCodec::hasSse2() {
+#ifdef __SSE2__
+	return true;
+#else
+	return false;
+#endif
+}
+
+/// \brief Compresses the codes of a channel.
+/// \param codes The codes.
+/// \param count The number of codes.
+/// \param output The buffer for the encoded codes, see maxEncodedSize().
+/// \param vectorized false uses the plain C++ prediction even if SSE2 is available.
+/// \return The size of the encoded codes in bytes, the same for both predictions.
+int CaptureCodec::encode(const qint16 *codes, unsigned int count, uchar *output, bool vectorized) {
+	// Two codes of the previous block in front of the current ones
+	qint32 values[CAPTURECODEC_BLOCKSIZE + 2];
+	quint32 deltas[CAPTURECODEC_BLOCKSIZE];
+	quint32 seconds[CAPTURECODEC_BLOCKSIZE];
+	values[0] = 0;
+	values[1] = 0;
+	
+	uchar *start = output;
+	for(unsigned int blockStart = 0; blockStart < count; blockStart += CAPTURECODEC_BLOCKSIZE) {
+		int blockSize = qMin(count - blockStart, (unsigned int) CAPTURECODEC_BLOCKSIZE);
+		const qint16 *blockCodes = codes + blockStart;
+		quint32 deltaBits = 0, secondBits = 0;
+		
+#ifdef __SSE2__
+		if(vectorized && blockSize == CAPTURECODEC_BLOCKSIZE) {
+			for(int position = 0; position < CAPTURECODEC_BLOCKSIZE; position += 8) {
+				__m128i words = _mm_loadu_si128((const __m128i *) (blockCodes + position));
+				_mm_storeu_si128((__m128i *) (values + position + 2), _mm_srai_epi32(_mm_unpacklo_epi16(words, words), 16));
+				_mm_storeu_si128((__m128i *) (values + position + 6), _mm_srai_epi32(_mm_unpackhi_epi16(words, words), 16));
+			}
+		}
+		else
+#endif
+		{
+			for(int position = 0; position < blockSize; position++)
+				values[position + 2] = blockCodes[position];
+			for(int position = blockSize; position < CAPTURECODEC_BLOCKSIZE; position++)
+				values[position + 2] = values[blockSize + 1];
+		}
+		
+		// Prediction errors of both predictors, zigzag coded
+#ifdef __SSE2__
+		if(vectorized) {
+			__m128i deltaMask = _mm_setzero_si128(), secondMask = _mm_setzero_si128();
+			for(int position = 0; position < CAPTURECODEC_BLOCKSIZE; position += 4) {
+				__m128i current = _mm_loadu_si128((const __m128i *) (values + position + 2));
+				__m128i previous = _mm_loadu_si128((const __m128i *) (values + position + 1));
+				__m128i beforePrevious = _mm_loadu_si128((const __m128i *) (values + position));
+				__m128i delta = _mm_sub_epi32(current, previous);
+				__m128i second = _mm_sub_epi32(delta, _mm_sub_epi32(previous, beforePrevious));
+				delta = _mm_xor_si128(_mm_slli_epi32(delta, 1), _mm_srai_epi32(delta, 31));
+				second = _mm_xor_si128(_mm_slli_epi32(second, 1), _mm_srai_epi32(second, 31));
+				_mm_storeu_si128((__m128i *) (deltas + position), delta);
+				_mm_storeu_si128((__m128i *) (seconds + position), second);
+				deltaMask = _mm_or_si128(deltaMask, delta);
+				secondMask = _mm_or_si128(secondMask, second);
+			}
+			deltaBits = combineBits(deltaMask);
+			secondBits = combineBits(secondMask);
+		}
+		else
+#endif
+		{
+			for(int position = 0; position < CAPTURECODEC_BLOCKSIZE; position++) {
+				qint32 delta = values[position + 2] - values[position + 1];
+				qint32 second = delta - (values[position + 1] - values[position]);
+				deltas[position] = ((quint32) delta << 1) ^ (quint32) (delta >> 31);
+				seconds[position] = ((quint32) second << 1) ^ (quint32) (second >> 31);
+				deltaBits |= deltas[position];
+				secondBits |= seconds[position];
+			}
+		}
+		
+		// The padding of the last block isn't stored
+		if(blockSize < CAPTURECODEC_BLOCKSIZE) {
+			deltaBits = 0;
+			secondBits = 0;
+			for(int position = 0; position < blockSize; position++) {
+				deltaBits |= deltas[position];
+				secondBits |= seconds[position];
+			}
+		}
+		
+		int deltaWidth = bitWidth(deltaBits);
+		int secondWidth = bitWidth(secondBits);
+		if(secondWidth < deltaWidth) {
+			*(output++) = 0x80 | secondWidth;
+			output += pack(seconds, blockSize, secondWidth, output);
+		}
+		else {
+			*(output++) = deltaWidth;
+			output += pack(deltas, blockSize, deltaWidth, output);
+		}
+		
+		values[0] = values[blockSize];
+		values[1] = values[blockSize + 1];
+	}
+	
+	return output - start;
+}
+
+/// \brief Decompresses the codes of a channel.
+/// \param input The encoded codes.
+/// \param size The size of the encoded codes in bytes.
+/// \param count The number of codes.
+/// \param codes The array for the decoded codes.
+/// \param vectorized false uses the plain C++ reconstruction even if SSE2 is available.
+/// \return true if the encoded codes were complete and valid.
+bool CaptureCodec::decode(const uchar *input, int size, unsigned int count, qint16 *codes, bool vectorized) {
+	qint32 values[CAPTURECODEC_BLOCKSIZE + 2];
+	quint32 errors[CAPTURECODEC_BLOCKSIZE];
+	values[0] = 0;
+	values[1] = 0;
+	
+	const uchar *end = input + size;
+	for(unsigned int blockStart = 0; blockStart < count; blockStart += CAPTURECODEC_BLOCKSIZE) {
+		int blockSize = qMin(count - blockStart, (unsigned int) CAPTURECODEC_BLOCKSIZE);
+		if(input >= end)
+			return false;
+		
+		int width = *input & 0x1f;
+		bool second = *input & 0x80;
+		if(width > CAPTURECODEC_MAXWIDTH || (*input & 0x60))
+			return false;
+		input++;
+		int length = (blockSize * width + 7) / 8;
+		if(end - input < length)
+			return false;
+		
+		unpack(input, blockSize, width, errors);
+		input += length;
+		
+#ifdef __SSE2__
+		if(vectorized) {
+			// The prediction is reversed by one or two running sums
+			if(blockSize < CAPTURECODEC_BLOCKSIZE)
+				memset(errors + blockSize, 0, (CAPTURECODEC_BLOCKSIZE - blockSize) * sizeof(quint32));
+			__m128i one = _mm_set1_epi32(1);
+			__m128i deltaCarry = _mm_set1_epi32(values[1] - values[0]);
+			__m128i valueCarry = _mm_set1_epi32(values[1]);
+			for(int position = 0; position < CAPTURECODEC_BLOCKSIZE; position += 4) {
+				__m128i error = _mm_loadu_si128((const __m128i *) (errors + position));
+				error = _mm_xor_si128(_mm_srli_epi32(error, 1), _mm_sub_epi32(_mm_setzero_si128(), _mm_and_si128(error, one)));
+				if(second) {
+					error = prefixSum(error, deltaCarry);
+					deltaCarry = _mm_shuffle_epi32(error, 0xff);
+				}
+				__m128i value = prefixSum(error, valueCarry);
+				valueCarry = _mm_shuffle_epi32(value, 0xff);
+				_mm_storeu_si128((__m128i *) (values + position + 2), value);
+			}
+		}
+		else
+#endif
+		{
+			for(int position = 0; position < blockSize; position++) {
+				qint32 error = (qint32) (errors[position] >> 1) ^ -(qint32) (errors[position] & 1);
+				if(second)
+					error += values[position + 1] - values[position];
+				values[position + 2] = values[position + 1] + error;
+			}
+		}
+		
+#ifdef __SSE2__
+		if(vectorized && blockSize == CAPTURECODEC_BLOCKSIZE) {
+			for(int position = 0; position < CAPTURECODEC_BLOCKSIZE; position += 8) {
+				__m128i low = _mm_loadu_si128((const __m128i *) (values + position + 2));
+				__m128i high = _mm_loadu_si128((const __m128i *) (values + position + 6));
+				_mm_storeu_si128((__m128i *) (codes + blockStart + position), _mm_packs_epi32(low, high));
+			}
+		}
+		else
+#endif
+		{
+			for(int position = 0; position < blockSize; position++)
+				codes[blockStart + position] = (qint16) qBound(-32768, values[position + 2], 32767);
+		}
+		
+		values[0] = values[blockSize];
+		values[1] = values[blockSize + 1];
+	}
+	
+	return true;
+}
+
+/// \brief Packs values with the given bit width, starting at the lowest bit.
+/// \param values The values, all smaller than 2^width.
+/// \param count The number of values.
+/// \param width The bit width of the values.
+/// \return The number of written bytes.
+int CaptureCodec::pack(const quint32 *values, int count, int width, uchar *output) {
+	uchar *start = output;
+	quint64 bits = 0;
+	int used = 0;
+	
+	for(int position = 0; position < count; position++) {
+		bits |= (quint64) values[position] << used;
+		used += width;
+		if(used >= 32) {
+			qToLittleEndian<quint32>((quint32) bits, output);
+			output += 4;
+			bits >>= 32;
+			used -= 32;
+		}
+	}
+	for(; used > 0; used -= 8) {
+		*(output++) = (uchar) bits;
+		bits >>= 8;
+	}
+	
+	return output - start;
+}
+
+/// \brief Unpacks values written by pack().
+/// \param input The packed values, (count * width + 7) / 8 bytes.
+/// \param count The number of values.
+/// \param width The bit width of the values.
+/// \param values The array for the values.
+void CaptureCodec::unpack(const uchar *input, int count, int width, quint32 *values) {
+	const uchar *end = input + (count * width + 7) / 8;
+	quint32 mask = (1u << width) - 1;
+	quint64 bits = 0;
+	int available = 0;
+	
+	for(int position = 0; position < count; position++) {
+		if(available < width) {
+			if(end - input >= 4) {
+				bits |= (quint64) qFromLittleEndian<quint32>(input) << available;
+				input += 4;
+				available += 32;
+			}
+			else {
+				while(available < width) {
+					bits |= (quint64) *(input++) << available;
+					available += 8;
+				}
+			}
+		}
+		values[position] = (quint32) bits & mask;
+		bits >>= width;
+		available -= width;
+	}
+}
+
+/// \brief Returns the number of bits needed for a value.
+/// \param bits The value.
+/// \return The position of the highest set bit plus one.
+int CaptureCodec::bitWidth(quint32 bits) {
+	int width = 0;
+	while(bits >> width)
+		width++;
+	
+	return width;
+}
@@ -0,0 +1,61 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  OpenHantek
+/// \file capturecodec.h
+/// \brief Declares the CaptureCodec class.
+//
+//  This program is free software: you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation, either version 3 of the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef CAPTURECODEC_H
+#define CAPTURECODEC_H
+
+
+#include <QtGlobal>
+
+
+// The codes are split into blocks, each one starts with a byte that holds the
+// bit width (bits 0 to 4) and the predictor (bit 7, set for second order).
+// The prediction errors follow, zigzag coded and packed with the bit width
+// starting at the lowest bit. The predictor state continues over the blocks
+// and starts with two zero codes.
+#define CAPTURECODEC_BLOCKSIZE       64 ///< Codes in a block with common predictor and bit width
+#define CAPTURECODEC_MAXWIDTH        18 ///< Bit width of the largest second order prediction error
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// \class CaptureCodec                                           capturecodec.h
+/// \brief Compresses the 16 bit codes of capture files without loss.
+/// Every block uses the first or second order prediction, whichever needs
+/// fewer bits. Slowly varying signals and the few levels of an 8 bit
+/// oscilloscope leave small prediction errors, so most blocks need only a
+/// few bits per code. Prediction and reconstruction use SSE2 if available,
+/// the plain C++ ones give the same results and can be chosen for comparison.
+class CaptureCodec {
+	public:
+		static int maxEncodedSize(unsigned int count);
+		static bool hasSse2();
+		static int encode(const qint16 *codes, unsigned int count, uchar *output, bool vectorized = true);
+		static bool decode(const uchar *input, int size, unsigned int count, qint16 *codes, bool vectorized = true);
+	
+	private:
+		static int pack(const quint32 *values, int count, int width, uchar *output);
+		static void unpack(const uchar *input, int count, int width, quint32 *values);
+		static int bitWidth(quint32 bits);
+};
+
+
+#endif
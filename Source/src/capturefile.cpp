@@ -0,0 +1,953 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  OpenHantek
+//  capturefile.cpp
+//
+//  This program is free software: you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation, either version 3 of the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <cmath>
+#include <cstring>
+#ifdef OS_UNIX
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QTemporaryFile>
+#include <QTime>
+#include <QWaitCondition>
+#include <QtEndian>
+
+
+#include "capturefile.h"
+
+#include "capturecodec.h"
+#include "settings.h"
+
+
+/// \brief Stores a double as little endian value.
+/// \param value The value that should be stored.
+/// \param destination The 8 bytes for the value.
+static void storeDouble(double value, uchar *destination) {
+	quint64 bits;
+	memcpy(&bits, &value, sizeof(bits));
+	qToLittleEndian<quint64>(bits, destination);
+}
+
+/// \brief Loads a little endian double.
+/// \param source The 8 bytes of the value.
+/// \return The value.
+static double loadDouble(const uchar *source) {
+	quint64 bits = qFromLittleEndian<quint64>(source);
+	double value;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+/// \brief Quantizes samples with the given scale.
+/// \param samples The sample values.
+/// \param count The number of samples.
+/// \param offset The value of the code 0.
+/// \param scale The value difference of neighbouring codes.
+/// \param codes The array for the codes.
+/// \return true if every sample is exactly on a code.
+static bool quantize(const double *samples, unsigned int count, double offset, double scale, qint16 *codes) {
+	double factor = 1 / scale;
+	double deviation = 0;
+	for(unsigned int position = 0; position < count; position++) {
+		double value = (samples[position] - offset) * factor;
+		double code = floor(value + 0.5);
+		codes[position] = (qint16) code;
+		deviation = qMax(deviation, fabs(value - code));
+	}
+	
+	return deviation < 1e-3;
+}
+
+/// \brief Returns the size a frame has without compression.
+/// \param frame The frame header.
+/// \param frameSize The size of the stored frame.
+/// \return The size of the uncompressed frame, -1 if the headers don't fit into the frame.
+static qint64 rawFrameSize(const uchar *frame, qint64 frameSize) {
+	unsigned int channelCount = qFromLittleEndian<quint32>(frame + 24);
+	qint64 size = CAPTURE_FRAMEHEADERSIZE + (qint64) channelCount * CAPTURE_CHANNELHEADERSIZE;
+	if(size > frameSize)
+		return -1;
+	
+	for(unsigned int channel = 0; channel < channelCount; channel++) {
+		quint32 count = qFromLittleEndian<quint32>(frame + CAPTURE_FRAMEHEADERSIZE + channel * CAPTURE_CHANNELHEADERSIZE);
+		size += ((qint64) count * 2 + 7) & ~7;
+	}
+	
+	return size;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// class CaptureWriter
+/// \brief Initializes the writer, the recording is started with open().
+/// \param parent The parent object.
+CaptureWriter::CaptureWriter(QObject *parent) : QThread(parent) {
+	this->fileNumber = 0;
+	this->chunkSize = CAPTURE_CHUNKSIZE;
+	this->channels = 0;
+	
+	this->maxFileSize = 0;
+	this->maxFileDuration = 0;
+	this->maxBacklog = CAPTURE_BACKLOG;
+	
+	this->file = 0;
+	this->position = 0;
+	this->fileStartTime = -1;
+	this->buffer = (char *) qMallocAligned(CAPTURE_BUFFERSIZE, CAPTURE_BUFFERALIGNMENT);
+	this->bufferUsed = 0;
+	this->writebackStart = 0;
+	this->writebackLength = 0;
+	this->error = false;
+	
+	this->backlog = 0;
+	this->queueMutex = new QMutex();
+	this->queueCondition = new QWaitCondition();
+	this->accepting = false;
+	this->stopping = false;
+	this->writtenFrames = 0;
+	this->dropped = 0;
+	this->writtenBytes = 0;
+	this->rawBytes = 0;
+	this->frameBytes = 0;
+}
+
+/// \brief Finishes the recording if it's still running.
+CaptureWriter::~CaptureWriter() {
+	this->close();
+	
+	qFreeAligned(this->buffer);
+	delete this->queueCondition;
+	delete this->queueMutex;
+}
+
+/// \brief Sets the limits for the next recording.
+/// \param fileSize Bytes after which a new file is started, 0 for no limit.
+/// \param fileDuration Milliseconds after which a new file is started, 0 for no limit.
+/// \param backlog Bytes of frames that may wait for the writer before frames are dropped.
+void CaptureWriter::setLimits(qint64 fileSize, qint64 fileDuration, qint64 backlog) {
+	if(this->isRunning())
+		return;
+	
+	this->maxFileSize = qMax(fileSize, (qint64) 0);
+	this->maxFileDuration = qMax(fileDuration, (qint64) 0);
+	this->maxBacklog = qMax(backlog, (qint64) CAPTURE_BUFFERSIZE);
+}
+
+/// \brief Creates the first capture file and starts the writer thread.
+/// \param fileName The name of the recording, "-0001" and so on are appended if it's split.
+/// \param settings The settings that are stored in the file headers.
+/// \param channelCount The number of channels in every frame.
+/// \return true if the file has been created.
+bool CaptureWriter::open(const QString &fileName, DsoSettings *settings, unsigned int channelCount) {
+	if(this->isRunning())
+		return false;
+	
+	// The settings are stored as they would be saved into a settings file
+	this->settingsText.clear();
+	QTemporaryFile settingsFile;
+	if(settingsFile.open()) {
+		settingsFile.close();
+		if(settings->save(settingsFile.fileName()) == 0 && settingsFile.open())
+			this->settingsText = settingsFile.readAll();
+		settingsFile.close();
+	}
+	
+	this->fileName = fileName;
+	this->fileNumber = 0;
+	this->channels = channelCount;
+	this->error = false;
+	this->backlog = 0;
+	this->writtenFrames = 0;
+	this->dropped = 0;
+	this->writtenBytes = 0;
+	this->rawBytes = 0;
+	this->frameBytes = 0;
+	if(!this->openFile())
+		return false;
+	
+	this->accepting = true;
+	this->stopping = false;
+	this->start(QThread::HighPriority);
+	return true;
+}
+
+/// \brief Writes the waiting frames and the index and closes the file.
+/// \return true if the whole recording has been written.
+bool CaptureWriter::close() {
+	// The writer thread may still finish the file of a failed recording
+	QMutexLocker locker(this->queueMutex);
+	this->accepting = false;
+	this->stopping = true;
+	this->queueCondition->wakeAll();
+	locker.unlock();
+	this->wait();
+	
+	return !this->error;
+}
+
+/// \brief Tells if a recording is running.
+/// \return true if new frames are recorded.
+bool CaptureWriter::isOpen() const {
+	QMutexLocker locker(this->queueMutex);
+	
+	return this->accepting;
+}
+
+/// \brief Returns the number of written frames.
+/// \return The frames in all files of the recording.
+unsigned long int CaptureWriter::frameCount() const {
+	QMutexLocker locker(this->queueMutex);
+	
+	return this->writtenFrames;
+}
+
+/// \brief Returns the number of dropped frames.
+/// \return The frames that were lost because the disk was too slow.
+unsigned long int CaptureWriter::droppedFrames() const {
+	QMutexLocker locker(this->queueMutex);
+	
+	return this->dropped;
+}
+
+/// \brief Returns the size of the recording.
+/// \return The bytes in all files of the recording.
+qint64 CaptureWriter::bytesWritten() const {
+	QMutexLocker locker(this->queueMutex);
+	
+	return this->writtenBytes;
+}
+
+/// \brief Returns the compression ratio of the recording.
+/// \return The uncompressed size of the frames divided by the stored size.
+double CaptureWriter::compressionRatio() const {
+	QMutexLocker locker(this->queueMutex);
+	
+	return this->frameBytes ? (double) this->rawBytes / this->frameBytes : 1;
+}
+
+/// \brief Quantizes and compresses the samples of all channels into a frame record.
+/// \param data The sample values of the channels.
+/// \param size The sample count of each channel.
+/// \param samplerate The samplerate of the samples.
+/// \param channelCount The number of channels in the frame.
+/// \param time The time of the frame in milliseconds since the epoch.
+/// \return The frame as it's written into the file.
+QByteArray CaptureWriter::encodeFrame(const QList<double *> *data, const QList<unsigned int> *size, double samplerate, unsigned int channelCount, qint64 time) {
+	return CaptureWriter::compressFrame(CaptureWriter::quantizeFrame(data, size, samplerate, channelCount, time));
+}
+
+/// \brief Quantizes the samples of all channels into an uncompressed frame record.
+/// The samples of the oscilloscope are multiples of the step of its ADC, they
+/// are stored exactly with the smallest sample difference as scale. Other
+/// samples get the scale that spreads them over the 16 bit codes.
+/// \param data The sample values of the channels.
+/// \param size The sample count of each channel.
+/// \param samplerate The samplerate of the samples.
+/// \param channelCount The number of channels in the frame.
+/// \param time The time of the frame in milliseconds since the epoch.
+/// \return The frame with the codes stored as they are.
+QByteArray CaptureWriter::quantizeFrame(const QList<double *> *data, const QList<unsigned int> *size, double samplerate, unsigned int channelCount, qint64 time) {
+	unsigned int frameSize = CAPTURE_FRAMEHEADERSIZE + channelCount * CAPTURE_CHANNELHEADERSIZE;
+	for(unsigned int channel = 0; channel < channelCount; channel++) {
+		if((int) channel < data->count() && (int) channel < size->count() && data->at(channel))
+			frameSize += (size->at(channel) * 2 + 7) & ~7;
+	}
+	
+	QByteArray frame(frameSize, 0);
+	uchar *header = (uchar *) frame.data();
+	qToLittleEndian<quint32>(CAPTURE_FRAMEMAGIC, header);
+	qToLittleEndian<quint32>(frameSize, header + 4);
+	qToLittleEndian<qint64>(time, header + 8);
+	storeDouble(samplerate, header + 16);
+	qToLittleEndian<quint32>(channelCount, header + 24);
+	
+	QVector<qint16> channelCodes;
+	uchar *codes = header + CAPTURE_FRAMEHEADERSIZE + channelCount * CAPTURE_CHANNELHEADERSIZE;
+	for(unsigned int channel = 0; channel < channelCount; channel++) {
+		uchar *channelHeader = header + CAPTURE_FRAMEHEADERSIZE + channel * CAPTURE_CHANNELHEADERSIZE;
+		if((int) channel >= data->count() || (int) channel >= size->count() || !data->at(channel))
+			continue;
+		
+		const double *samples = data->at(channel);
+		unsigned int count = size->at(channel);
+		double minimum = 0, maximum = 0, step = 0;
+		if(count) {
+			minimum = maximum = samples[0];
+			for(unsigned int position = 1; position < count; position++) {
+				if(samples[position] < minimum)
+					minimum = samples[position];
+				else if(samples[position] > maximum)
+					maximum = samples[position];
+				
+				double difference = fabs(samples[position] - samples[position - 1]);
+				if(difference > 0 && (step == 0 || difference < step))
+					step = difference;
+			}
+		}
+		
+		channelCodes.resize(count);
+		double offset = 0, scale = 0;
+		if(step > 0 && (maximum - minimum) / step <= 65534) {
+			offset = minimum + floor((maximum - minimum) / step / 2 + 0.5) * step;
+			scale = step;
+			if(!quantize(samples, count, offset, scale, channelCodes.data()))
+				scale = 0;
+		}
+		if(scale == 0) {
+			offset = (minimum + maximum) / 2;
+			scale = (maximum - minimum) / 65534;
+			if(scale <= 0)
+				scale = 1;
+			quantize(samples, count, offset, scale, channelCodes.data());
+		}
+		
+		qToLittleEndian<quint32>(count, channelHeader);
+		storeDouble(scale, channelHeader + 8);
+		storeDouble(offset, channelHeader + 16);
+		for(unsigned int position = 0; position < count; position++)
+			qToLittleEndian<qint16>(channelCodes[position], codes + position * 2);
+		codes += (count * 2 + 7) & ~7;
+	}
+	
+	return frame;
+}
+
+/// \brief Compresses the codes of an uncompressed frame record.
+/// Noise can leave nothing to compress, those codes are kept as they are.
+/// \param frame The frame from quantizeFrame().
+/// \return The frame as it's written into the file.
+QByteArray CaptureWriter::compressFrame(const QByteArray &frame) {
+	const uchar *source = (const uchar *) frame.constData();
+	unsigned int channelCount = qFromLittleEndian<quint32>(source + 24);
+	unsigned int headerSize = CAPTURE_FRAMEHEADERSIZE + channelCount * CAPTURE_CHANNELHEADERSIZE;
+	
+	// Room for the codes with or without compression
+	unsigned int frameSize = headerSize;
+	for(unsigned int channel = 0; channel < channelCount; channel++) {
+		unsigned int count = qFromLittleEndian<quint32>(source + CAPTURE_FRAMEHEADERSIZE + channel * CAPTURE_CHANNELHEADERSIZE);
+		frameSize += (qMax(count * 2, (unsigned int) CaptureCodec::maxEncodedSize(count)) + 7) & ~7;
+	}
+	
+	QByteArray compressed(frameSize, 0);
+	uchar *header = (uchar *) compressed.data();
+	memcpy(header, source, headerSize);
+	
+	QVector<qint16> channelCodes;
+	const uchar *rawCodes = source + headerSize;
+	uchar *codes = header + headerSize;
+	for(unsigned int channel = 0; channel < channelCount; channel++) {
+		uchar *channelHeader = header + CAPTURE_FRAMEHEADERSIZE + channel * CAPTURE_CHANNELHEADERSIZE;
+		unsigned int count = qFromLittleEndian<quint32>(channelHeader);
+		unsigned int rawSize = (count * 2 + 7) & ~7;
+		
+		channelCodes.resize(count);
+		for(unsigned int position = 0; position < count; position++)
+			channelCodes[position] = qFromLittleEndian<qint16>(rawCodes + position * 2);
+		
+		unsigned int encodedSize = CaptureCodec::encode(channelCodes.constData(), count, codes);
+		if(encodedSize < count * 2) {
+			qToLittleEndian<quint32>(encodedSize, channelHeader + 4);
+			memset(codes + encodedSize, 0, ((encodedSize + 7) & ~7) - encodedSize);
+			codes += (encodedSize + 7) & ~7;
+		}
+		else {
+			memcpy(codes, rawCodes, rawSize);
+			codes += rawSize;
+		}
+		rawCodes += rawSize;
+	}
+	
+	frameSize = codes - header;
+	qToLittleEndian<quint32>(frameSize, header + 4);
+	compressed.resize(frameSize);
+	
+	return compressed;
+}
+
+/// \brief Queues the new samples for writing.
+/// Called directly by the acquisition thread, so it never waits for the disk.
+/// \param data The sample values of the channels.
+/// \param size The sample count of each channel.
+/// \param samplerate The samplerate of the samples.
+/// \param mutex The mutex for the sample data.
+void CaptureWriter::addFrame(const QList<double *> *data, const QList<unsigned int> *size, double samplerate, QMutex *mutex) {
+	QMutexLocker locker(this->queueMutex);
+	if(!this->accepting)
+		return;
+	if(this->backlog >= this->maxBacklog) {
+		// The disk doesn't keep up, drop the frame instead of waiting
+		this->dropped++;
+		return;
+	}
+	locker.unlock();
+	
+	// Only the quantization needs the samples, the acquisition goes on during the compression
+	mutex->lock();
+	QByteArray frame = CaptureWriter::quantizeFrame(data, size, samplerate, this->channels, QDateTime::currentMSecsSinceEpoch());
+	mutex->unlock();
+	frame = CaptureWriter::compressFrame(frame);
+	
+	locker.relock();
+	if(!this->accepting)
+		return;
+	this->queue.append(frame);
+	this->backlog += frame.size();
+	this->queueCondition->wakeOne();
+}
+
+/// \brief Writes the queued frames until the recording is closed.
+void CaptureWriter::run() {
+	QTime statisticsTime;
+	statisticsTime.start();
+	qint64 statisticsBytes = 0;
+	
+	forever {
+		this->queueMutex->lock();
+		if(this->queue.isEmpty() && !this->stopping)
+			this->queueCondition->wait(this->queueMutex, CAPTURE_STATISTICSINTERVAL);
+		bool finished = this->queue.isEmpty() && this->stopping;
+		QByteArray frame;
+		if(!this->queue.isEmpty()) {
+			frame = this->queue.takeFirst();
+			this->backlog -= frame.size();
+		}
+		this->queueMutex->unlock();
+		
+		bool failed = false;
+		if(!frame.isEmpty()) {
+			bool written = this->file && this->writeFrame(frame);
+			
+			QMutexLocker locker(this->queueMutex);
+			if(written)
+				this->writtenFrames++;
+			else
+				this->dropped++;
+			
+			// A file that can't be created or written ends the recording
+			if(this->error && this->accepting) {
+				this->accepting = false;
+				this->stopping = true;
+				this->dropped += this->queue.count();
+				this->queue.clear();
+				this->backlog = 0;
+				failed = true;
+			}
+		}
+		if(failed)
+			emit recordingFailed(this->errorFileName);
+		
+		// Report the sustained write rate
+		int elapsed = statisticsTime.elapsed();
+		if(elapsed >= CAPTURE_STATISTICSINTERVAL || elapsed < 0 || finished) {
+			statisticsTime.restart();
+			
+			this->queueMutex->lock();
+			double writeRate = elapsed > 0 ? (this->writtenBytes - statisticsBytes) * 1000.0 / elapsed : 0;
+			statisticsBytes = this->writtenBytes;
+			double waiting = this->backlog;
+			unsigned int droppedFrames = this->dropped;
+			this->queueMutex->unlock();
+			
+			emit statisticsChanged(writeRate, waiting, droppedFrames);
+		}
+		
+		if(finished)
+			break;
+	}
+	
+	if(this->file)
+		this->closeFile();
+}
+
+/// \brief Creates the next capture file and writes its header.
+/// \return true if the file has been created.
+bool CaptureWriter::openFile() {
+	QString currentName = this->fileName;
+	if(this->maxFileSize || this->maxFileDuration) {
+		// The files of a split recording are numbered
+		QFileInfo fileInfo(this->fileName);
+		QString suffix = fileInfo.suffix().isEmpty() ? QString() : "." + fileInfo.suffix();
+		currentName = fileInfo.path() + "/" + fileInfo.completeBaseName() + QString("-%1").arg(++this->fileNumber, 4, 10, QChar('0')) + suffix;
+	}
+	
+	// The own buffer replaces the one of QFile
+	this->file = new QFile(currentName);
+	if(!this->file->open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Unbuffered)) {
+		qWarning("Can't create the capture file %s", qPrintable(currentName));
+		delete this->file;
+		this->file = 0;
+		this->error = true;
+		this->errorFileName = currentName;
+		return false;
+	}
+#ifdef OS_UNIX
+	posix_fadvise(this->file->handle(), 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+	
+	this->position = 0;
+	this->fileStartTime = -1;
+	this->bufferUsed = 0;
+	this->writebackStart = 0;
+	this->writebackLength = 0;
+	this->frameOffsets.clear();
+	this->frameTimes.clear();
+	this->fileRawBytes = 0;
+	this->fileFrameBytes = 0;
+	
+	uchar header[CAPTURE_HEADERSIZE];
+	memcpy(header, CAPTURE_FILEMAGIC, 8);
+	qToLittleEndian<quint32>(CAPTURE_VERSION, header + 8);
+	qToLittleEndian<quint32>(this->chunkSize, header + 12);
+	qToLittleEndian<quint32>(this->channels, header + 16);
+	qToLittleEndian<quint32>(this->settingsText.size(), header + 20);
+	qToLittleEndian<qint64>(QDateTime::currentMSecsSinceEpoch(), header + 24);
+	this->writeData((const char *) header, CAPTURE_HEADERSIZE);
+	this->writeData(this->settingsText.constData(), this->settingsText.size());
+	
+	// The first frame starts at a chunk boundary
+	qint64 padding = (this->chunkSize - this->position % this->chunkSize) % this->chunkSize;
+	return this->writeData(QByteArray(padding, 0).constData(), padding);
+}
+
+/// \brief Writes the index of the current file and closes it.
+/// \return true if the file is complete.
+bool CaptureWriter::closeFile() {
+	this->writeIndex();
+	this->flushBuffer();
+	
+#ifdef OS_UNIX
+	// Nothing of the file has to stay in the page cache
+	if(!this->error && !fdatasync(this->file->handle()))
+		posix_fadvise(this->file->handle(), 0, 0, POSIX_FADV_DONTNEED);
+#endif
+	
+	QString currentName = this->file->fileName();
+	this->file->close();
+	delete this->file;
+	this->file = 0;
+	
+	this->queueMutex->lock();
+	this->rawBytes += this->fileRawBytes;
+	this->frameBytes += this->fileFrameBytes;
+	this->queueMutex->unlock();
+	
+	if(!this->error)
+		emit fileWritten(currentName, this->fileFrameBytes ? (double) this->fileRawBytes / this->fileFrameBytes : 1);
+	
+	return !this->error;
+}
+
+/// \brief Writes a frame at the next position that satisfies the chunk rule.
+/// A new file is started afterwards if the current one reached its limits.
+/// \param frame The encoded frame.
+/// \return true if the frame has been written.
+bool CaptureWriter::writeFrame(const QByteArray &frame) {
+	// Frames that don't fit into the current chunk start at the next one
+	qint64 rest = this->chunkSize - this->position % this->chunkSize;
+	if(rest < this->chunkSize && frame.size() > rest)
+		this->writeData(QByteArray(rest, 0).constData(), rest);
+	
+	qint64 offset = this->position;
+	qint64 time = qFromLittleEndian<qint64>((const uchar *) frame.constData() + 8);
+	if(!this->writeData(frame.constData(), frame.size()))
+		return false;
+	
+	this->fileRawBytes += rawFrameSize((const uchar *) frame.constData(), frame.size());
+	this->fileFrameBytes += frame.size();
+	this->frameOffsets.append(offset);
+	this->frameTimes.append(time);
+	if(this->fileStartTime < 0)
+		this->fileStartTime = time;
+	
+	if((this->maxFileSize && this->position >= this->maxFileSize) || (this->maxFileDuration && time - this->fileStartTime >= this->maxFileDuration)) {
+		this->closeFile();
+		this->openFile();
+	}
+	
+	return true;
+}
+
+/// \brief Writes the index and the footer behind the frames.
+/// \return true if the index has been written.
+bool CaptureWriter::writeIndex() {
+	qint64 indexOffset = this->position;
+	
+	QByteArray index(this->frameOffsets.count() * CAPTURE_INDEXENTRYSIZE + CAPTURE_FOOTERSIZE, 0);
+	uchar *entry = (uchar *) index.data();
+	for(int frame = 0; frame < this->frameOffsets.count(); frame++) {
+		qToLittleEndian<qint64>(this->frameOffsets[frame], entry);
+		qToLittleEndian<qint64>(this->frameTimes[frame], entry + 8);
+		entry += CAPTURE_INDEXENTRYSIZE;
+	}
+	qToLittleEndian<qint64>(indexOffset, entry);
+	qToLittleEndian<quint64>(this->frameOffsets.count(), entry + 8);
+	qToLittleEndian<qint64>(this->fileRawBytes, entry + 16);
+	qToLittleEndian<qint64>(this->fileFrameBytes, entry + 24);
+	memcpy(entry + 32, CAPTURE_ENDMAGIC, 8);
+	
+	return this->writeData(index.constData(), index.size());
+}
+
+/// \brief Appends data to the buffer and writes the buffer when it's full.
+/// \param data The bytes that should be written.
+/// \param length The number of bytes.
+/// \return false if this or a previous write has failed.
+bool CaptureWriter::writeData(const char *data, qint64 length) {
+	if(this->error)
+		return false;
+	
+	this->position += length;
+	while(length > 0) {
+		int part = (int) qMin(length, (qint64) (CAPTURE_BUFFERSIZE - this->bufferUsed));
+		memcpy(this->buffer + this->bufferUsed, data, part);
+		this->bufferUsed += part;
+		data += part;
+		length -= part;
+		
+		if(this->bufferUsed == CAPTURE_BUFFERSIZE && !this->flushBuffer())
+			return false;
+	}
+	
+	return true;
+}
+
+/// \brief Writes the buffer to the current file.
+/// \return false if this or a previous write has failed.
+bool CaptureWriter::flushBuffer() {
+	int length = this->bufferUsed;
+	this->bufferUsed = 0;
+	if(this->error || !length)
+		return !this->error;
+	
+	qint64 start = this->file->pos();
+	if(this->file->write(this->buffer, length) != length) {
+		qWarning("Can't write the capture file %s", qPrintable(this->file->fileName()));
+		this->error = true;
+		this->errorFileName = this->file->fileName();
+		return false;
+	}
+#ifdef OS_UNIX
+	// The recording isn't read again soon, but dirty pages can't be dropped
+	// from the page cache. The writeback of this window is started and the
+	// previous window, that had the time of a whole buffer to reach the disk,
+	// is dropped once it's clean.
+	int handle = this->file->handle();
+#ifdef SYNC_FILE_RANGE_WRITE
+	sync_file_range(handle, start, length, SYNC_FILE_RANGE_WRITE);
+	if(this->writebackLength && !sync_file_range(handle, this->writebackStart, this->writebackLength, SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER))
+		posix_fadvise(handle, this->writebackStart, this->writebackLength, POSIX_FADV_DONTNEED);
+	this->writebackStart = start;
+	this->writebackLength = length;
+#else
+	// Without sync_file_range everything written so far is synced
+	if(!fdatasync(handle))
+		posix_fadvise(handle, this->writebackStart, start + length - this->writebackStart, POSIX_FADV_DONTNEED);
+	this->writebackStart = start + length;
+#endif
+#else
+	Q_UNUSED(start);
+#endif
+	
+	QMutexLocker locker(this->queueMutex);
+	this->writtenBytes += length;
+	return true;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// class CaptureReader
+/// \brief Initializes the reader, the file is opened with open().
+CaptureReader::CaptureReader() {
+	this->file = 0;
+	this->map = 0;
+	this->mapSize = 0;
+	this->chunkSize = CAPTURE_CHUNKSIZE;
+	this->channels = 0;
+	this->settingsSize = 0;
+	this->rawBytes = 0;
+	this->frameBytes = 0;
+	this->index = 0;
+	this->frames = 0;
+}
+
+/// \brief Unmaps the file.
+CaptureReader::~CaptureReader() {
+	this->close();
+}
+
+/// \brief Maps a capture file and finds its frames.
+/// \param fileName The name of the capture file.
+/// \return true if the file is a valid capture file.
+bool CaptureReader::open(const QString &fileName) {
+	this->close();
+	
+	this->file = new QFile(fileName);
+	if(!this->file->open(QIODevice::ReadOnly) || this->file->size() < CAPTURE_HEADERSIZE) {
+		this->close();
+		return false;
+	}
+	
+	this->mapSize = this->file->size();
+	this->map = this->file->map(0, this->mapSize);
+	if(!this->map) {
+		qWarning("Can't map the capture file %s", qPrintable(fileName));
+		this->close();
+		return false;
+	}
+	
+	// Check the header
+	// Version 1 only lacks the compression
+	quint32 version = qFromLittleEndian<quint32>(this->map + 8);
+	if(memcmp(this->map, CAPTURE_FILEMAGIC, 8) || version < 1 || version > CAPTURE_VERSION) {
+		this->close();
+		return false;
+	}
+	this->chunkSize = qFromLittleEndian<quint32>(this->map + 12);
+	this->channels = qFromLittleEndian<quint32>(this->map + 16);
+	this->settingsSize = qFromLittleEndian<quint32>(this->map + 20);
+	if(!this->chunkSize || this->chunkSize % 8 || (qint64) CAPTURE_HEADERSIZE + this->settingsSize > this->mapSize) {
+		this->close();
+		return false;
+	}
+	qint64 firstFrame = ((CAPTURE_HEADERSIZE + this->settingsSize + this->chunkSize - 1) / this->chunkSize) * this->chunkSize;
+	
+	// A complete file ends with the index, the footer of version 1 has no sizes
+	qint64 footerSize = version < 2 ? CAPTURE_OLDFOOTERSIZE : CAPTURE_FOOTERSIZE;
+	if(this->mapSize >= firstFrame + footerSize) {
+		const uchar *footer = this->map + this->mapSize - footerSize;
+		qint64 indexOffset = qFromLittleEndian<qint64>(footer);
+		quint64 frameCount = qFromLittleEndian<quint64>(footer + 8);
+		if(!memcmp(footer + footerSize - 8, CAPTURE_ENDMAGIC, 8) && indexOffset >= firstFrame && frameCount <= (quint64) (this->mapSize - indexOffset) / CAPTURE_INDEXENTRYSIZE && indexOffset + (qint64) frameCount * CAPTURE_INDEXENTRYSIZE + footerSize == this->mapSize) {
+			this->index = this->map + indexOffset;
+			this->frames = frameCount;
+			if(version >= 2) {
+				this->rawBytes = qFromLittleEndian<qint64>(footer + 16);
+				this->frameBytes = qFromLittleEndian<qint64>(footer + 24);
+			}
+			return true;
+		}
+	}
+	
+	// The recording wasn't closed, find the frames that made it into the file
+	qWarning("The capture file %s has no index, searching the frames", qPrintable(fileName));
+	this->scanFrames(firstFrame);
+	return true;
+}
+
+/// \brief Unmaps and closes the file.
+void CaptureReader::close() {
+	if(this->file) {
+		if(this->map)
+			this->file->unmap((uchar *) this->map);
+		delete this->file;
+		this->file = 0;
+	}
+	this->map = 0;
+	this->mapSize = 0;
+	this->rawBytes = 0;
+	this->frameBytes = 0;
+	this->index = 0;
+	this->frames = 0;
+	this->scannedOffsets.clear();
+	this->scannedTimes.clear();
+}
+
+/// \brief Tells if a capture file is open.
+/// \return true if the frames can be read.
+bool CaptureReader::isOpen() const {
+	return this->map != 0;
+}
+
+/// \brief Returns the number of channels in every frame.
+/// \return The channel count of the recording.
+unsigned int CaptureReader::channelCount() const {
+	return this->channels;
+}
+
+/// \brief Returns the settings when the recording was started.
+/// \return The settings as INI text, can be loaded with DsoSettings::load().
+QByteArray CaptureReader::settings() const {
+	if(!this->map)
+		return QByteArray();
+	
+	return QByteArray((const char *) this->map + CAPTURE_HEADERSIZE, this->settingsSize);
+}
+
+/// \brief Returns the number of frames in the file.
+/// \return The frame count.
+int CaptureReader::frameCount() const {
+	return this->frames;
+}
+
+/// \brief Returns the time a frame was acquired.
+/// \param frame The index of the frame.
+/// \return The time in milliseconds since the epoch, -1 if there is no such frame.
+qint64 CaptureReader::frameTime(int frame) const {
+	if(frame < 0 || frame >= this->frames)
+		return -1;
+	
+	if(this->index)
+		return qFromLittleEndian<qint64>(this->index + (qint64) frame * CAPTURE_INDEXENTRYSIZE + 8);
+	return this->scannedTimes[frame];
+}
+
+/// \brief Finds the frame that was shown at the given time.
+/// \param time The time in milliseconds since the epoch.
+/// \return The last frame acquired before or at the time, -1 if there is none.
+int CaptureReader::frameAt(qint64 time) const {
+	// The frames are in chronological order
+	int first = 0, last = this->frames - 1, found = -1;
+	while(first <= last) {
+		int middle = first + (last - first) / 2;
+		if(this->frameTime(middle) <= time) {
+			found = middle;
+			first = middle + 1;
+		}
+		else
+			last = middle - 1;
+	}
+	
+	return found;
+}
+
+/// \brief Converts a frame back into sample values.
+/// The arrays in data are reused if they have the right size, else they are
+/// replaced. The caller deletes them with delete[].
+/// \param frame The index of the frame.
+/// \param data The arrays for the sample values of the channels.
+/// \param size The sample count of each channel.
+/// \param samplerate Gets the samplerate of the frame.
+/// \return true if the frame has been read.
+bool CaptureReader::readFrame(int frame, QList<double *> *data, QList<unsigned int> *size, double *samplerate) const {
+	qint64 frameStart = this->frameOffset(frame);
+	if(frameStart < 0 || !this->validFrame(frameStart))
+		return false;
+	
+	const uchar *header = this->map + frameStart;
+	const uchar *end = header + qFromLittleEndian<quint32>(header + 4);
+	unsigned int channelCount = qFromLittleEndian<quint32>(header + 24);
+	const uchar *codes = header + CAPTURE_FRAMEHEADERSIZE + (qint64) channelCount * CAPTURE_CHANNELHEADERSIZE;
+	if(codes > end)
+		return false;
+	*samplerate = loadDouble(header + 16);
+	
+	QVector<qint16> channelCodes;
+	for(unsigned int channel = 0; channel < channelCount; channel++) {
+		const uchar *channelHeader = header + CAPTURE_FRAMEHEADERSIZE + channel * CAPTURE_CHANNELHEADERSIZE;
+		unsigned int count = qFromLittleEndian<quint32>(channelHeader);
+		unsigned int encodedSize = qFromLittleEndian<quint32>(channelHeader + 4);
+		double scale = loadDouble(channelHeader + 8);
+		double valueOffset = loadDouble(channelHeader + 16);
+		qint64 storedSize = encodedSize ? (qint64) encodedSize : (qint64) count * 2;
+		if(end - codes < ((storedSize + 7) & ~7) || (encodedSize && ((qint64) count + CAPTURECODEC_BLOCKSIZE - 1) / CAPTURECODEC_BLOCKSIZE > encodedSize))
+			return false;
+		
+		while(data->count() <= (int) channel)
+			data->append(0);
+		while(size->count() <= (int) channel)
+			size->append(0);
+		if((*size)[channel] != count || !(*data)[channel]) {
+			if((*data)[channel])
+				delete[] (*data)[channel];
+			(*data)[channel] = new double[qMax(count, 1u)];
+			(*size)[channel] = count;
+		}
+		
+		double *samples = (*data)[channel];
+		if(encodedSize) {
+			channelCodes.resize(count);
+			if(!CaptureCodec::decode(codes, encodedSize, count, channelCodes.data()))
+				return false;
+			for(unsigned int position = 0; position < count; position++)
+				samples[position] = channelCodes[position] * scale + valueOffset;
+		}
+		else {
+			for(unsigned int position = 0; position < count; position++)
+				samples[position] = qFromLittleEndian<qint16>(codes + position * 2) * scale + valueOffset;
+		}
+		codes += (storedSize + 7) & ~7;
+	}
+	
+	return true;
+}
+
+/// \brief Returns the compression ratio of the file.
+/// The sizes are stored in the footer or summed up while the frames of a file
+/// without index are searched. Files of version 1 aren't compressed.
+/// \return The uncompressed size of the frames divided by the stored size.
+double CaptureReader::compressionRatio() const {
+	return this->frameBytes ? (double) this->rawBytes / this->frameBytes : 1;
+}
+
+/// \brief Returns the position of a frame in the file.
+/// \param frame The index of the frame.
+/// \return The offset of the frame, -1 if there is no such frame.
+qint64 CaptureReader::frameOffset(int frame) const {
+	if(frame < 0 || frame >= this->frames)
+		return -1;
+	
+	if(this->index)
+		return qFromLittleEndian<qint64>(this->index + (qint64) frame * CAPTURE_INDEXENTRYSIZE);
+	return this->scannedOffsets[frame];
+}
+
+/// \brief Checks if there is a complete frame at the given position.
+/// \param offset The position in the file.
+/// \return true if the frame header is valid and the frame is inside the file.
+bool CaptureReader::validFrame(qint64 offset) const {
+	if(offset % 8 || offset + CAPTURE_FRAMEHEADERSIZE > this->mapSize)
+		return false;
+	
+	const uchar *header = this->map + offset;
+	quint32 frameSize = qFromLittleEndian<quint32>(header + 4);
+	return qFromLittleEndian<quint32>(header) == CAPTURE_FRAMEMAGIC && frameSize >= CAPTURE_FRAMEHEADERSIZE && offset + frameSize <= this->mapSize;
+}
+
+/// \brief Finds the frames of a file without index.
+/// \param start The position of the first frame.
+void CaptureReader::scanFrames(qint64 start) {
+	qint64 offset = start;
+	while(offset + CAPTURE_FRAMEHEADERSIZE <= this->mapSize) {
+		if(this->validFrame(offset)) {
+			qint64 frameSize = qFromLittleEndian<quint32>(this->map + offset + 4);
+			this->scannedOffsets.append(offset);
+			this->scannedTimes.append(qFromLittleEndian<qint64>(this->map + offset + 8));
+			qint64 rawSize = rawFrameSize(this->map + offset, frameSize);
+			if(rawSize >= 0) {
+				this->rawBytes += rawSize;
+				this->frameBytes += frameSize;
+			}
+			offset += frameSize;
+		}
+		else {
+			// The rest of the chunk is padding
+			offset = (offset / this->chunkSize + 1) * this->chunkSize;
+		}
+	}
+	
+	this->frames = this->scannedOffsets.count();
+}
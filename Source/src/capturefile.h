@@ -0,0 +1,205 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  OpenHantek
+/// \file capturefile.h
+/// \brief Declares the CaptureWriter and CaptureReader classes.
+//
+//  This program is free software: you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation, either version 3 of the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef CAPTUREFILE_H
+#define CAPTUREFILE_H
+
+
+#include <QByteArray>
+#include <QList>
+#include <QThread>
+#include <QVector>
+
+
+class DsoSettings;
+class QFile;
+class QMutex;
+class QWaitCondition;
+
+
+// The capture file, all values are little endian:
+//   File header    "OHCAPTUR", version, chunk size, channel count, settings
+//                  size, start time, followed by the settings as INI text
+//   Frames         Starting at the first chunk boundary after the header
+//   Index          Offset and time of every frame
+//   Footer         Index offset, frame count, uncompressed and stored size of
+//                  the frames, "OHCAPEND"
+// A frame starts in the current chunk if it fits into the rest of it, else
+// at the next chunk boundary. Frames larger than a chunk take several ones.
+// The zeros in front of a chunk boundary are no valid frame, so the frames of
+// a file without index can still be found by walking through the chunks.
+//
+// A frame is the frame header, a header for each channel with the sample
+// count and the scale of the codes, then the 16 bit codes of each channel.
+// The sample value is code * scale + offset. If the encoded size in the
+// channel header isn't zero, the codes are compressed by CaptureCodec.
+#define CAPTURE_VERSION               2 ///< The version of the file format
+#define CAPTURE_CHUNKSIZE       1048576 ///< The default chunk size in bytes
+#define CAPTURE_HEADERSIZE           32 ///< Size of the file header without the settings
+#define CAPTURE_FRAMEHEADERSIZE      32 ///< Magic, size, time, samplerate, channels, flags
+#define CAPTURE_CHANNELHEADERSIZE    24 ///< Sample count, encoded size, scale, offset
+#define CAPTURE_INDEXENTRYSIZE       16 ///< Frame offset and time
+#define CAPTURE_FOOTERSIZE           40 ///< Index offset, frame count, raw and stored bytes, magic
+#define CAPTURE_OLDFOOTERSIZE        24 ///< Index offset, frame count, magic in version 1
+#define CAPTURE_FILEMAGIC    "OHCAPTUR" ///< The first bytes of a capture file
+#define CAPTURE_ENDMAGIC     "OHCAPEND" ///< The last bytes of a complete capture file
+#define CAPTURE_FRAMEMAGIC   0x5246484f ///< "OHFR" at the start of every frame
+#define CAPTURE_BUFFERSIZE      4194304 ///< The size of the write buffer
+#define CAPTURE_BUFFERALIGNMENT    4096 ///< The alignment of the write buffer
+#define CAPTURE_BACKLOG       268435456 ///< Default limit of the bytes waiting for the writer
+#define CAPTURE_STATISTICSINTERVAL 1000 ///< Milliseconds between the statistics
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// \class CaptureWriter                                           capturefile.h
+/// \brief Records the acquired frames into capture files.
+/// The frames are quantized and compressed in the thread that delivers them,
+/// only the quantization holds the mutex of the samples. It's connected
+/// directly to DsoControl::samplesAvailable that's the acquisition thread. The
+/// writer thread collects them in a large aligned buffer and writes it
+/// sequentially. The acquisition never waits for the disk: if the frames
+/// waiting for the writer exceed the backlog limit, new frames are dropped
+/// and counted. Long recordings can be split into files of limited size or
+/// duration, each one complete with its own index. If a file can't be created
+/// or written, the recording stops and recordingFailed() is emitted. The
+/// samples of the oscilloscope are stored as multiples of their step if
+/// possible and the codes are compressed without loss.
+class CaptureWriter : public QThread {
+	Q_OBJECT
+	
+	public:
+		CaptureWriter(QObject *parent = 0);
+		~CaptureWriter();
+		
+		void setLimits(qint64 fileSize, qint64 fileDuration, qint64 backlog);
+		bool open(const QString &fileName, DsoSettings *settings, unsigned int channelCount);
+		bool close();
+		bool isOpen() const;
+		
+		unsigned long int frameCount() const;
+		unsigned long int droppedFrames() const;
+		qint64 bytesWritten() const;
+		double compressionRatio() const;
+		
+		static QByteArray encodeFrame(const QList<double *> *data, const QList<unsigned int> *size, double samplerate, unsigned int channelCount, qint64 time);
+		static QByteArray quantizeFrame(const QList<double *> *data, const QList<unsigned int> *size, double samplerate, unsigned int channelCount, qint64 time);
+		static QByteArray compressFrame(const QByteArray &frame);
+	
+	public slots:
+		void addFrame(const QList<double *> *data, const QList<unsigned int> *size, double samplerate, QMutex *mutex);
+	
+	protected:
+		void run();
+		bool openFile();
+		bool closeFile();
+		bool writeFrame(const QByteArray &frame);
+		bool writeIndex();
+		bool writeData(const char *data, qint64 length);
+		bool flushBuffer();
+		
+		QString fileName; ///< The name of the recording, numbered if it's split
+		int fileNumber; ///< The number of the current file
+		QByteArray settingsText; ///< The settings stored in every file
+		unsigned int chunkSize; ///< The chunk size of the files
+		unsigned int channels; ///< The channels in every frame
+		
+		qint64 maxFileSize; ///< Bytes after which a new file is started, 0 for no limit
+		qint64 maxFileDuration; ///< Milliseconds after which a new file is started, 0 for no limit
+		qint64 maxBacklog; ///< Bytes of frames that may wait for the writer
+		
+		QFile *file; ///< The current capture file, only used by the writer thread
+		qint64 position; ///< The end of the data in the current file
+		qint64 fileStartTime; ///< The time of the first frame in the current file
+		char *buffer; ///< The aligned buffer for the data that wasn't written yet
+		int bufferUsed; ///< The bytes in the buffer
+		qint64 writebackStart; ///< The start of the last written window that is still in the page cache
+		qint64 writebackLength; ///< The length of that window
+		bool error; ///< true if a write has failed
+		QString errorFileName; ///< The file that couldn't be created or written
+		QVector<qint64> frameOffsets; ///< The position of each frame in the current file
+		QVector<qint64> frameTimes; ///< The time of each frame in the current file
+		qint64 fileRawBytes; ///< The uncompressed size of the frames in the current file
+		qint64 fileFrameBytes; ///< The size of the frames in the current file
+		
+		QList<QByteArray> queue; ///< The frames that weren't written yet
+		qint64 backlog; ///< The bytes in the queue
+		QMutex *queueMutex; ///< Protects the queue, the counters and the state
+		QWaitCondition *queueCondition; ///< Wakes the writer for new frames
+		bool accepting; ///< true while new frames are taken
+		bool stopping; ///< true if the writer should finish the file
+		unsigned long int writtenFrames; ///< The frames in all files of the recording
+		unsigned long int dropped; ///< The frames that were dropped
+		qint64 writtenBytes; ///< The bytes in all files of the recording
+		qint64 rawBytes; ///< The uncompressed size of the frames in all files
+		qint64 frameBytes; ///< The size of the frames in all files
+	
+	signals:
+		void statisticsChanged(double writeRate, double backlog, unsigned int droppedFrames); ///< Bytes per second, bytes waiting and frames dropped
+		void fileWritten(const QString &fileName, double compressionRatio); ///< A capture file is complete
+		void recordingFailed(const QString &fileName); ///< A capture file couldn't be created or written, the recording has stopped
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \class CaptureReader                                           capturefile.h
+/// \brief Reads the frames of a capture file.
+/// The file is mapped into memory and the frames are found through the index
+/// at the end, so opening doesn't depend on the size of the recording. Files
+/// without index are walked through once when they are opened.
+class CaptureReader {
+	public:
+		CaptureReader();
+		~CaptureReader();
+		
+		bool open(const QString &fileName);
+		void close();
+		bool isOpen() const;
+		
+		unsigned int channelCount() const;
+		QByteArray settings() const;
+		int frameCount() const;
+		qint64 frameTime(int frame) const;
+		int frameAt(qint64 time) const;
+		bool readFrame(int frame, QList<double *> *data, QList<unsigned int> *size, double *samplerate) const;
+		double compressionRatio() const;
+	
+	protected:
+		qint64 frameOffset(int frame) const;
+		bool validFrame(qint64 offset) const;
+		void scanFrames(qint64 start);
+		
+		QFile *file; ///< The opened capture file
+		const uchar *map; ///< The file mapped into memory
+		qint64 mapSize; ///< The size of the file
+		unsigned int chunkSize; ///< The chunk size of the file
+		unsigned int channels; ///< The channels in every frame
+		unsigned int settingsSize; ///< The length of the settings text
+		qint64 rawBytes; ///< The uncompressed size of the frames
+		qint64 frameBytes; ///< The stored size of the frames
+		
+		const uchar *index; ///< The index in the file, 0 if it was missing
+		int frames; ///< The number of frames in the file
+		QVector<qint64> scannedOffsets; ///< The frame positions if the index was missing
+		QVector<qint64> scannedTimes; ///< The frame times if the index was missing
+};
+
+
+#endif
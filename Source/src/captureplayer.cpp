@@ -0,0 +1,141 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  OpenHantek
+//  captureplayer.cpp
+//
+//  This program is free software: you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation, either version 3 of the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <QMutex>
+#include <QTimer>
+
+
+#include "captureplayer.h"
+
+#include "capturefile.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// class CapturePlayer
+/// \brief Initializes the player, the file is opened with open().
+/// \param parent The parent object.
+CapturePlayer::CapturePlayer(QObject *parent) : QObject(parent) {
+	this->captureReader = new CaptureReader();
+	this->frame = -1;
+	this->samplesMutex = new QMutex();
+	
+	this->frameTimer = new QTimer(this);
+	this->frameTimer->setSingleShot(true);
+	connect(this->frameTimer, SIGNAL(timeout()), this, SLOT(nextFrame()));
+}
+
+/// \brief Closes the file and frees the samples.
+CapturePlayer::~CapturePlayer() {
+	delete this->captureReader;
+	for(int channel = 0; channel < this->samples.count(); channel++)
+		delete[] this->samples[channel];
+	delete this->samplesMutex;
+}
+
+/// \brief Opens a capture file, the playback starts with play().
+/// \param fileName The name of the capture file.
+/// \return true if the file could be opened.
+bool CapturePlayer::open(const QString &fileName) {
+	this->pause();
+	this->frame = -1;
+	
+	return this->captureReader->open(fileName);
+}
+
+/// \brief Returns the reader of the opened file.
+/// \return The reader with the settings and the frame times.
+const CaptureReader *CapturePlayer::reader() const {
+	return this->captureReader;
+}
+
+/// \brief Returns the shown frame.
+/// \return The index of the frame, -1 if none has been shown yet.
+int CapturePlayer::currentFrame() const {
+	return this->frame;
+}
+
+/// \brief Tells if the frames are played.
+/// \return true if the next frame will follow automatically.
+bool CapturePlayer::isPlaying() const {
+	return this->frameTimer->isActive();
+}
+
+/// \brief Plays the frames from the current one on.
+void CapturePlayer::play() {
+	if(!this->captureReader->isOpen())
+		return;
+	
+	if(this->frame + 1 >= this->captureReader->frameCount())
+		this->frame = -1;
+	this->frameTimer->start(0);
+}
+
+/// \brief Stops the playback at the current frame.
+void CapturePlayer::pause() {
+	this->frameTimer->stop();
+}
+
+/// \brief Shows the given frame.
+/// \param frame The index of the frame.
+void CapturePlayer::seekFrame(int frame) {
+	this->showFrame(qBound(0, frame, this->captureReader->frameCount() - 1));
+}
+
+/// \brief Shows the frame that was acquired at the given time.
+/// \param time The time in milliseconds since the epoch.
+void CapturePlayer::seekTime(qint64 time) {
+	this->seekFrame(qMax(this->captureReader->frameAt(time), 0));
+}
+
+/// \brief Reads a frame and passes it on like the oscilloscope would.
+/// \param frame The index of the frame.
+void CapturePlayer::showFrame(int frame) {
+	// Damaged frames are skipped
+	this->frame = frame;
+	
+	double samplerate;
+	this->samplesMutex->lock();
+	bool success = this->captureReader->readFrame(frame, &(this->samples), &(this->samplesSize), &samplerate);
+	this->samplesMutex->unlock();
+	if(!success)
+		return;
+	
+	emit frameChanged(frame, this->captureReader->frameTime(frame));
+	emit samplesAvailable(&(this->samples), &(this->samplesSize), samplerate, this->samplesMutex);
+}
+
+/// \brief Shows the next frame and waits as long as it was recorded.
+void CapturePlayer::nextFrame() {
+	int next = this->frame + 1;
+	if(next >= this->captureReader->frameCount()) {
+		emit finished();
+		return;
+	}
+	
+	this->showFrame(next);
+	
+	if(next + 1 < this->captureReader->frameCount()) {
+		qint64 delay = this->captureReader->frameTime(next + 1) - this->captureReader->frameTime(next);
+		this->frameTimer->start(qBound((qint64) 0, delay, (qint64) CAPTUREPLAYER_MAXDELAY));
+	}
+	else
+		emit finished();
+}
@@ -0,0 +1,84 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  OpenHantek
+/// \file captureplayer.h
+/// \brief Declares the CapturePlayer class.
+//
+//  This program is free software: you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation, either version 3 of the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef CAPTUREPLAYER_H
+#define CAPTUREPLAYER_H
+
+
+#include <QList>
+#include <QObject>
+
+
+class CaptureReader;
+class QMutex;
+class QTimer;
+
+
+#define CAPTUREPLAYER_MAXDELAY     1000 ///< Longest pause between two played frames in ms
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// \class CapturePlayer                                         captureplayer.h
+/// \brief Plays a capture file like an oscilloscope.
+/// The frames are emitted with the same signal as DsoControl::samplesAvailable
+/// and with the pauses they were recorded with, so the analysis and the
+/// screens can't tell the recording from the device.
+class CapturePlayer : public QObject {
+	Q_OBJECT
+	
+	public:
+		CapturePlayer(QObject *parent = 0);
+		~CapturePlayer();
+		
+		bool open(const QString &fileName);
+		const CaptureReader *reader() const;
+		int currentFrame() const;
+		bool isPlaying() const;
+	
+	public slots:
+		void play();
+		void pause();
+		void seekFrame(int frame);
+		void seekTime(qint64 time);
+	
+	private:
+		void showFrame(int frame);
+		
+		CaptureReader *captureReader; ///< The opened capture file
+		QTimer *frameTimer; ///< Shows the next frame when it was recorded
+		int frame; ///< The index of the shown frame
+		
+		QList<double *> samples; ///< The sample values of the shown frame
+		QList<unsigned int> samplesSize; ///< The sample count of each channel
+		QMutex *samplesMutex; ///< Protects the samples while they are replaced
+	
+	private slots:
+		void nextFrame();
+	
+	signals:
+		void samplesAvailable(const QList<double *> *data, const QList<unsigned int> *size, double samplerate, QMutex *mutex); ///< A frame of the recording is shown
+		void frameChanged(int frame, qint64 time); ///< Another frame is shown now
+		void finished(); ///< The last frame has been played
+};
+
+
+#endif
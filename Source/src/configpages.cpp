@@ -35,6 +35,7 @@
 #include "configpages.h"
 
 #include "colorbox.h"
+#include "digitalfilter.h"
 #include "settings.h"
 
 
@@ -64,6 +65,24 @@ DsoConfigAnalysisPage::DsoConfigAnalysisPage(DsoSettings *settings, QWidget *par
 			<< tr("Blackman-Harris")
 			<< tr("Blackman-Nuttall")
 			<< tr("Flat top");
+	QStringList filterTypeStrings;
+	for(int type = 0; type < Dso::FILTERTYPE_COUNT; type++)
+		filterTypeStrings << Dso::filterTypeString((Dso::FilterType) type);
+	QStringList filterDesignStrings;
+	for(int design = 0; design < Dso::FILTERDESIGN_COUNT; design++)
+		filterDesignStrings << Dso::filterDesignString((Dso::FilterDesign) design);
+	QStringList protocolStrings;
+	for(int protocol = 0; protocol < Dso::PROTOCOL_COUNT; protocol++)
+		protocolStrings << Dso::protocolString((Dso::Protocol) protocol);
+	QStringList parityStrings;
+	for(int parity = 0; parity < Dso::PARITY_COUNT; parity++)
+		parityStrings << Dso::parityString((Dso::Parity) parity);
+	QStringList channelStrings;
+	for(unsigned int channel = 0; channel < this->settings->scope.physicalChannels; channel++)
+		channelStrings << this->settings->scope.voltage[channel].name;
+	QStringList allChannelStrings;
+	for(int channel = 0; channel < this->settings->scope.voltage.count(); channel++)
+		allChannelStrings << this->settings->scope.voltage[channel].name;
 	
 	// Initialize elements
 	this->windowFunctionLabel = new QLabel(tr("Window function"));
@@ -93,6 +112,18 @@ DsoConfigAnalysisPage::DsoConfigAnalysisPage(DsoSettings *settings, QWidget *par
 	this->minimumMagnitudeLayout->addWidget(this->minimumMagnitudeSpinBox);
 	this->minimumMagnitudeLayout->addWidget(this->minimumMagnitudeUnitLabel);
 	
+	this->zoomSpectrumCheckBox = new QCheckBox(tr("Narrowband spectrum between markers"));
+	this->zoomSpectrumCheckBox->setChecked(this->settings->scope.spectrumZoom);
+	this->harmonicsCheckBox = new QCheckBox(tr("Measure THD, SNR, SINAD, ENOB and SFDR"));
+	this->harmonicsCheckBox->setChecked(this->settings->scope.spectrumHarmonics);
+	this->preciseCheckBox = new QCheckBox(tr("Exact dB values (slower)"));
+	this->preciseCheckBox->setChecked(this->settings->scope.spectrumPrecise);
+	
+	this->spectrogramChannelLabel = new QLabel(tr("Spectrogram channel"));
+	this->spectrogramChannelComboBox = new QComboBox();
+	this->spectrogramChannelComboBox->addItems(allChannelStrings);
+	this->spectrogramChannelComboBox->setCurrentIndex(this->settings->view.spectrogramChannel);
+	
 	this->spectrumLayout = new QGridLayout();
 	this->spectrumLayout->addWidget(this->windowFunctionLabel, 0, 0);
 	this->spectrumLayout->addWidget(this->windowFunctionComboBox, 0, 1);
@@ -100,12 +131,204 @@ DsoConfigAnalysisPage::DsoConfigAnalysisPage(DsoSettings *settings, QWidget *par
 	this->spectrumLayout->addLayout(this->referenceLevelLayout, 1, 1);
 	this->spectrumLayout->addWidget(this->minimumMagnitudeLabel, 2, 0);
 	this->spectrumLayout->addLayout(this->minimumMagnitudeLayout, 2, 1);
+	this->spectrumLayout->addWidget(this->zoomSpectrumCheckBox, 3, 0, 1, 2);
+	this->spectrumLayout->addWidget(this->harmonicsCheckBox, 4, 0, 1, 2);
+	this->spectrumLayout->addWidget(this->spectrogramChannelLabel, 5, 0);
+	this->spectrumLayout->addWidget(this->spectrogramChannelComboBox, 5, 1);
+	this->spectrumLayout->addWidget(this->preciseCheckBox, 6, 0, 1, 2);
 	
 	this->spectrumGroup = new QGroupBox(tr("Spectrum"));
 	this->spectrumGroup->setLayout(this->spectrumLayout);
 	
+	// Digital filters of the physical channels
+	this->filterLayout = new QGridLayout();
+	this->filterTypeLabel = new QLabel(tr("Type"));
+	this->filterDesignLabel = new QLabel(tr("Design"));
+	this->filterFrequencyLabel = new QLabel(tr("Frequency"));
+	this->filterBandwidthLabel = new QLabel(tr("Bandwidth"));
+	this->filterTapsLabel = new QLabel(tr("Taps"));
+	this->filterLayout->addWidget(this->filterTypeLabel, 0, 1);
+	this->filterLayout->addWidget(this->filterDesignLabel, 0, 2);
+	this->filterLayout->addWidget(this->filterFrequencyLabel, 0, 3);
+	this->filterLayout->addWidget(this->filterBandwidthLabel, 0, 4);
+	this->filterLayout->addWidget(this->filterTapsLabel, 0, 5);
+	
+	for(unsigned int channel = 0; channel < this->settings->scope.physicalChannels; channel++) {
+		const DsoSettingsScopeFilter &filter = this->settings->scope.voltage[channel].filter;
+		
+		this->filterChannelLabel.append(new QLabel(this->settings->scope.voltage[channel].name));
+		this->filterTypeComboBox.append(new QComboBox());
+		this->filterTypeComboBox[channel]->addItems(filterTypeStrings);
+		this->filterTypeComboBox[channel]->setCurrentIndex(filter.type);
+		this->filterDesignComboBox.append(new QComboBox());
+		this->filterDesignComboBox[channel]->addItems(filterDesignStrings);
+		this->filterDesignComboBox[channel]->setCurrentIndex(filter.design);
+		this->filterFrequencySpinBox.append(new QDoubleSpinBox());
+		this->filterFrequencySpinBox[channel]->setDecimals(1);
+		this->filterFrequencySpinBox[channel]->setMinimum(0.1);
+		this->filterFrequencySpinBox[channel]->setMaximum(1e9);
+		this->filterFrequencySpinBox[channel]->setSuffix(tr(" Hz"));
+		this->filterFrequencySpinBox[channel]->setValue(filter.frequency);
+		this->filterBandwidthSpinBox.append(new QDoubleSpinBox());
+		this->filterBandwidthSpinBox[channel]->setDecimals(1);
+		this->filterBandwidthSpinBox[channel]->setMinimum(0.1);
+		this->filterBandwidthSpinBox[channel]->setMaximum(1e9);
+		this->filterBandwidthSpinBox[channel]->setSuffix(tr(" Hz"));
+		this->filterBandwidthSpinBox[channel]->setValue(filter.bandwidth);
+		this->filterTapsSpinBox.append(new QSpinBox());
+		this->filterTapsSpinBox[channel]->setMinimum(3);
+		this->filterTapsSpinBox[channel]->setMaximum(DIGITALFILTER_MAXIMUM_TAPS);
+		this->filterTapsSpinBox[channel]->setSingleStep(2);
+		this->filterTapsSpinBox[channel]->setValue(filter.taps);
+		
+		this->filterLayout->addWidget(this->filterChannelLabel[channel], channel + 1, 0);
+		this->filterLayout->addWidget(this->filterTypeComboBox[channel], channel + 1, 1);
+		this->filterLayout->addWidget(this->filterDesignComboBox[channel], channel + 1, 2);
+		this->filterLayout->addWidget(this->filterFrequencySpinBox[channel], channel + 1, 3);
+		this->filterLayout->addWidget(this->filterBandwidthSpinBox[channel], channel + 1, 4);
+		this->filterLayout->addWidget(this->filterTapsSpinBox[channel], channel + 1, 5);
+	}
+	
+	this->filterGroup = new QGroupBox(tr("Filter"));
+	this->filterGroup->setLayout(this->filterLayout);
+	
+	// Serial protocol decoder
+	this->protocolLabel = new QLabel(tr("Protocol"));
+	this->protocolComboBox = new QComboBox();
+	this->protocolComboBox->addItems(protocolStrings);
+	this->protocolComboBox->setCurrentIndex(this->settings->scope.decoder.protocol);
+	
+	this->decoderDataLabel = new QLabel(tr("Data (RX, MOSI, SDA)"));
+	this->decoderDataComboBox = new QComboBox();
+	this->decoderDataComboBox->addItems(channelStrings);
+	this->decoderDataComboBox->setCurrentIndex(this->settings->scope.decoder.data);
+	
+	this->decoderClockLabel = new QLabel(tr("Clock (SCLK, SCL)"));
+	this->decoderClockComboBox = new QComboBox();
+	this->decoderClockComboBox->addItems(channelStrings);
+	this->decoderClockComboBox->setCurrentIndex(this->settings->scope.decoder.clock);
+	
+	this->decoderThresholdLabel = new QLabel(tr("Threshold"));
+	this->decoderThresholdSpinBox = new QDoubleSpinBox();
+	this->decoderThresholdSpinBox->setDecimals(2);
+	this->decoderThresholdSpinBox->setMinimum(-100.0);
+	this->decoderThresholdSpinBox->setMaximum(100.0);
+	this->decoderThresholdSpinBox->setSingleStep(0.1);
+	this->decoderThresholdSpinBox->setSuffix(tr(" V"));
+	this->decoderThresholdSpinBox->setValue(this->settings->scope.decoder.threshold);
+	
+	this->baudrateLabel = new QLabel(tr("Baudrate"));
+	this->baudrateSpinBox = new QSpinBox();
+	this->baudrateSpinBox->setMinimum(1);
+	this->baudrateSpinBox->setMaximum(100000000);
+	this->baudrateSpinBox->setValue(this->settings->scope.decoder.baudrate);
+	
+	this->decoderBitsLabel = new QLabel(tr("Data bits"));
+	this->decoderBitsSpinBox = new QSpinBox();
+	this->decoderBitsSpinBox->setMinimum(5);
+	this->decoderBitsSpinBox->setMaximum(16);
+	this->decoderBitsSpinBox->setValue(this->settings->scope.decoder.bits);
+	
+	this->parityLabel = new QLabel(tr("Parity"));
+	this->parityComboBox = new QComboBox();
+	this->parityComboBox->addItems(parityStrings);
+	this->parityComboBox->setCurrentIndex(this->settings->scope.decoder.parity);
+	
+	this->spiModeLabel = new QLabel(tr("SPI mode"));
+	this->spiModeSpinBox = new QSpinBox();
+	this->spiModeSpinBox->setMinimum(0);
+	this->spiModeSpinBox->setMaximum(3);
+	this->spiModeSpinBox->setValue(this->settings->scope.decoder.spiMode);
+	
+	this->msbFirstCheckBox = new QCheckBox(tr("MSB first"));
+	this->msbFirstCheckBox->setChecked(this->settings->scope.decoder.msbFirst);
+	
+	this->decoderLayout = new QGridLayout();
+	this->decoderLayout->addWidget(this->protocolLabel, 0, 0);
+	this->decoderLayout->addWidget(this->protocolComboBox, 0, 1);
+	this->decoderLayout->addWidget(this->decoderThresholdLabel, 0, 2);
+	this->decoderLayout->addWidget(this->decoderThresholdSpinBox, 0, 3);
+	this->decoderLayout->addWidget(this->decoderDataLabel, 1, 0);
+	this->decoderLayout->addWidget(this->decoderDataComboBox, 1, 1);
+	this->decoderLayout->addWidget(this->decoderClockLabel, 1, 2);
+	this->decoderLayout->addWidget(this->decoderClockComboBox, 1, 3);
+	this->decoderLayout->addWidget(this->baudrateLabel, 2, 0);
+	this->decoderLayout->addWidget(this->baudrateSpinBox, 2, 1);
+	this->decoderLayout->addWidget(this->parityLabel, 2, 2);
+	this->decoderLayout->addWidget(this->parityComboBox, 2, 3);
+	this->decoderLayout->addWidget(this->decoderBitsLabel, 3, 0);
+	this->decoderLayout->addWidget(this->decoderBitsSpinBox, 3, 1);
+	this->decoderLayout->addWidget(this->spiModeLabel, 3, 2);
+	this->decoderLayout->addWidget(this->spiModeSpinBox, 3, 3);
+	this->decoderLayout->addWidget(this->msbFirstCheckBox, 4, 0, 1, 4);
+	
+	this->decoderGroup = new QGroupBox(tr("Protocol decoder"));
+	this->decoderGroup->setLayout(this->decoderLayout);
+	
+	// Mask test
+	this->maskEnabledCheckBox = new QCheckBox(tr("Test every frame against the mask"));
+	this->maskEnabledCheckBox->setChecked(this->settings->scope.mask.enabled);
+	
+	this->maskChannelLabel = new QLabel(tr("Channel"));
+	this->maskChannelComboBox = new QComboBox();
+	this->maskChannelComboBox->addItems(allChannelStrings);
+	this->maskChannelComboBox->setCurrentIndex(this->settings->scope.mask.channel);
+	
+	this->maskToleranceTimeLabel = new QLabel(tr("Horizontal tolerance"));
+	this->maskToleranceTimeSpinBox = new QDoubleSpinBox();
+	this->maskToleranceTimeSpinBox->setDecimals(2);
+	this->maskToleranceTimeSpinBox->setMaximum(DIVS_TIME);
+	this->maskToleranceTimeSpinBox->setSingleStep(0.05);
+	this->maskToleranceTimeSpinBox->setSuffix(tr(" div"));
+	this->maskToleranceTimeSpinBox->setValue(this->settings->scope.mask.toleranceTime);
+	
+	this->maskToleranceVoltageLabel = new QLabel(tr("Vertical tolerance"));
+	this->maskToleranceVoltageSpinBox = new QDoubleSpinBox();
+	this->maskToleranceVoltageSpinBox->setDecimals(2);
+	this->maskToleranceVoltageSpinBox->setMaximum(DIVS_VOLTAGE);
+	this->maskToleranceVoltageSpinBox->setSingleStep(0.05);
+	this->maskToleranceVoltageSpinBox->setSuffix(tr(" div"));
+	this->maskToleranceVoltageSpinBox->setValue(this->settings->scope.mask.toleranceVoltage);
+	
+	this->maskStopCheckBox = new QCheckBox(tr("Stop on failure"));
+	this->maskStopCheckBox->setChecked(this->settings->scope.mask.stopOnFailure);
+	
+	this->maskLayout = new QGridLayout();
+	this->maskLayout->addWidget(this->maskEnabledCheckBox, 0, 0, 1, 2);
+	this->maskLayout->addWidget(this->maskChannelLabel, 0, 2);
+	this->maskLayout->addWidget(this->maskChannelComboBox, 0, 3);
+	this->maskLayout->addWidget(this->maskToleranceTimeLabel, 1, 0);
+	this->maskLayout->addWidget(this->maskToleranceTimeSpinBox, 1, 1);
+	this->maskLayout->addWidget(this->maskToleranceVoltageLabel, 1, 2);
+	this->maskLayout->addWidget(this->maskToleranceVoltageSpinBox, 1, 3);
+	this->maskLayout->addWidget(this->maskStopCheckBox, 2, 0, 1, 4);
+	
+	this->maskGroup = new QGroupBox(tr("Mask test"));
+	this->maskGroup->setLayout(this->maskLayout);
+	
+	// Delay and phase
+	this->phaseEnabledCheckBox = new QCheckBox(tr("Measure delay and phase of the channels"));
+	this->phaseEnabledCheckBox->setChecked(this->settings->scope.phase.enabled);
+	
+	this->phaseReferenceLabel = new QLabel(tr("Reference"));
+	this->phaseReferenceComboBox = new QComboBox();
+	this->phaseReferenceComboBox->addItems(allChannelStrings);
+	this->phaseReferenceComboBox->setCurrentIndex(this->settings->scope.phase.reference);
+	
+	this->phaseLayout = new QGridLayout();
+	this->phaseLayout->addWidget(this->phaseEnabledCheckBox, 0, 0, 1, 2);
+	this->phaseLayout->addWidget(this->phaseReferenceLabel, 0, 2);
+	this->phaseLayout->addWidget(this->phaseReferenceComboBox, 0, 3);
+	
+	this->phaseGroup = new QGroupBox(tr("Delay and phase"));
+	this->phaseGroup->setLayout(this->phaseLayout);
+	
 	this->mainLayout = new QVBoxLayout();
 	this->mainLayout->addWidget(this->spectrumGroup);
+	this->mainLayout->addWidget(this->filterGroup);
+	this->mainLayout->addWidget(this->decoderGroup);
+	this->mainLayout->addWidget(this->maskGroup);
+	this->mainLayout->addWidget(this->phaseGroup);
 	this->mainLayout->addStretch(1);
 	
 	this->setLayout(this->mainLayout);
@@ -120,6 +343,37 @@ void DsoConfigAnalysisPage::saveSettings() {
 	this->settings->scope.spectrumWindow = (Dso::WindowFunction) this->windowFunctionComboBox->currentIndex();
 	this->settings->scope.spectrumReference = this->referenceLevelSpinBox->value();
 	this->settings->scope.spectrumLimit = this->minimumMagnitudeSpinBox->value();
+	this->settings->scope.spectrumZoom = this->zoomSpectrumCheckBox->isChecked();
+	this->settings->scope.spectrumHarmonics = this->harmonicsCheckBox->isChecked();
+	this->settings->scope.spectrumPrecise = this->preciseCheckBox->isChecked();
+	this->settings->view.spectrogramChannel = this->spectrogramChannelComboBox->currentIndex();
+	
+	for(unsigned int channel = 0; channel < this->settings->scope.physicalChannels; channel++) {
+		DsoSettingsScopeFilter &filter = this->settings->scope.voltage[channel].filter;
+		filter.type = (Dso::FilterType) this->filterTypeComboBox[channel]->currentIndex();
+		filter.design = (Dso::FilterDesign) this->filterDesignComboBox[channel]->currentIndex();
+		filter.frequency = this->filterFrequencySpinBox[channel]->value();
+		filter.bandwidth = this->filterBandwidthSpinBox[channel]->value();
+		filter.taps = this->filterTapsSpinBox[channel]->value() | 1;
+	}
+	
+	this->settings->scope.decoder.protocol = (Dso::Protocol) this->protocolComboBox->currentIndex();
+	this->settings->scope.decoder.data = this->decoderDataComboBox->currentIndex();
+	this->settings->scope.decoder.clock = this->decoderClockComboBox->currentIndex();
+	this->settings->scope.decoder.threshold = this->decoderThresholdSpinBox->value();
+	this->settings->scope.decoder.baudrate = this->baudrateSpinBox->value();
+	this->settings->scope.decoder.bits = this->decoderBitsSpinBox->value();
+	this->settings->scope.decoder.parity = (Dso::Parity) this->parityComboBox->currentIndex();
+	this->settings->scope.decoder.spiMode = this->spiModeSpinBox->value();
+	this->settings->scope.decoder.msbFirst = this->msbFirstCheckBox->isChecked();
+	
+	this->settings->scope.mask.enabled = this->maskEnabledCheckBox->isChecked();
+	this->settings->scope.mask.channel = this->maskChannelComboBox->currentIndex();
+	this->settings->scope.mask.toleranceTime = this->maskToleranceTimeSpinBox->value();
+	this->settings->scope.mask.toleranceVoltage = this->maskToleranceVoltageSpinBox->value();
+	this->settings->scope.mask.stopOnFailure = this->maskStopCheckBox->isChecked();
+	this->settings->scope.phase.enabled = this->phaseEnabledCheckBox->isChecked();
+	this->settings->scope.phase.reference = this->phaseReferenceComboBox->currentIndex();
 }
 
 
@@ -143,6 +397,8 @@ DsoConfigColorsPage::DsoConfigColorsPage(DsoSettings *settings, QWidget *parent)
 	this->gridColorBox = new ColorBox(this->settings->view.color.screen.grid);
 	this->markersLabel = new QLabel(tr("Markers"));
 	this->markersColorBox = new ColorBox(this->settings->view.color.screen.markers);
+	this->maskLabel = new QLabel(tr("Mask"));
+	this->maskColorBox = new ColorBox(this->settings->view.color.screen.mask);
 	this->textLabel = new QLabel(tr("Text"));
 	this->textColorBox = new ColorBox(this->settings->view.color.screen.text);
 	
@@ -159,8 +415,10 @@ DsoConfigColorsPage::DsoConfigColorsPage(DsoSettings *settings, QWidget *parent)
 	this->screenLayout->addWidget(this->borderColorBox, 3, 1);
 	this->screenLayout->addWidget(this->markersLabel, 4, 0);
 	this->screenLayout->addWidget(this->markersColorBox, 4, 1);
-	this->screenLayout->addWidget(this->textLabel, 5, 0);
-	this->screenLayout->addWidget(this->textColorBox, 5, 1);
+	this->screenLayout->addWidget(this->maskLabel, 5, 0);
+	this->screenLayout->addWidget(this->maskColorBox, 5, 1);
+	this->screenLayout->addWidget(this->textLabel, 6, 0);
+	this->screenLayout->addWidget(this->textColorBox, 6, 1);
 	
 	this->screenGroup = new QGroupBox(tr("Screen"));
 	this->screenGroup->setLayout(this->screenLayout);
@@ -212,6 +470,7 @@ void DsoConfigColorsPage::saveSettings() {
 	this->settings->view.color.screen.border = this->borderColorBox->getColor();
 	this->settings->view.color.screen.grid = this->gridColorBox->getColor();
 	this->settings->view.color.screen.markers = this->markersColorBox->getColor();
+	this->settings->view.color.screen.mask = this->maskColorBox->getColor();
 	this->settings->view.color.screen.text = this->textColorBox->getColor();
 	
 	// Graph category
@@ -252,19 +511,68 @@ DsoConfigFilesPage::DsoConfigFilesPage(DsoSettings *settings, QWidget *parent) :
 	this->imageHeightSpinBox->setMinimum(100);
 	this->imageHeightSpinBox->setMaximum(9999);
 	this->imageHeightSpinBox->setValue(this->settings->options.imageSize.height());
+	this->csvPrecisionLabel = new QLabel(tr("CSV precision"));
+	this->csvPrecisionSpinBox = new QSpinBox();
+	this->csvPrecisionSpinBox->setMinimum(0);
+	this->csvPrecisionSpinBox->setMaximum(17);
+	this->csvPrecisionSpinBox->setSuffix(tr(" digits"));
+	this->csvPrecisionSpinBox->setSpecialValueText(tr("Exact"));
+	this->csvPrecisionSpinBox->setValue(this->settings->options.csvPrecision);
+	this->csvLayoutLabel = new QLabel(tr("CSV layout"));
+	this->csvLayoutComboBox = new QComboBox();
+	this->csvLayoutComboBox->addItem(tr("One row per channel"));
+	this->csvLayoutComboBox->addItem(tr("One column per channel"));
+	this->csvLayoutComboBox->setCurrentIndex(this->settings->options.csvColumns ? 1 : 0);
 	
 	this->exportLayout = new QGridLayout();
 	this->exportLayout->addWidget(this->imageWidthLabel, 0, 0);
 	this->exportLayout->addWidget(this->imageWidthSpinBox, 0, 1);
 	this->exportLayout->addWidget(this->imageHeightLabel, 1, 0);
 	this->exportLayout->addWidget(this->imageHeightSpinBox, 1, 1);
+	this->exportLayout->addWidget(this->csvPrecisionLabel, 2, 0);
+	this->exportLayout->addWidget(this->csvPrecisionSpinBox, 2, 1);
+	this->exportLayout->addWidget(this->csvLayoutLabel, 3, 0);
+	this->exportLayout->addWidget(this->csvLayoutComboBox, 3, 1);
 	
 	this->exportGroup = new QGroupBox(tr("Export"));
 	this->exportGroup->setLayout(this->exportLayout);
 	
+	this->recorderFileSizeLabel = new QLabel(tr("Split files after"));
+	this->recorderFileSizeSpinBox = new QSpinBox();
+	this->recorderFileSizeSpinBox->setMinimum(0);
+	this->recorderFileSizeSpinBox->setMaximum(1048576);
+	this->recorderFileSizeSpinBox->setSuffix(tr(" MiB"));
+	this->recorderFileSizeSpinBox->setSpecialValueText(tr("No size limit"));
+	this->recorderFileSizeSpinBox->setValue(this->settings->options.recorder.fileSize);
+	this->recorderFileDurationLabel = new QLabel(tr("Split files every"));
+	this->recorderFileDurationSpinBox = new QSpinBox();
+	this->recorderFileDurationSpinBox->setMinimum(0);
+	this->recorderFileDurationSpinBox->setMaximum(10080);
+	this->recorderFileDurationSpinBox->setSuffix(tr(" min"));
+	this->recorderFileDurationSpinBox->setSpecialValueText(tr("No time limit"));
+	this->recorderFileDurationSpinBox->setValue(this->settings->options.recorder.fileDuration);
+	this->recorderBacklogLabel = new QLabel(tr("Drop frames after"));
+	this->recorderBacklogSpinBox = new QSpinBox();
+	this->recorderBacklogSpinBox->setMinimum(4);
+	this->recorderBacklogSpinBox->setMaximum(65536);
+	this->recorderBacklogSpinBox->setSuffix(tr(" MiB backlog"));
+	this->recorderBacklogSpinBox->setValue(this->settings->options.recorder.backlog);
+	
+	this->recorderLayout = new QGridLayout();
+	this->recorderLayout->addWidget(this->recorderFileSizeLabel, 0, 0);
+	this->recorderLayout->addWidget(this->recorderFileSizeSpinBox, 0, 1);
+	this->recorderLayout->addWidget(this->recorderFileDurationLabel, 1, 0);
+	this->recorderLayout->addWidget(this->recorderFileDurationSpinBox, 1, 1);
+	this->recorderLayout->addWidget(this->recorderBacklogLabel, 2, 0);
+	this->recorderLayout->addWidget(this->recorderBacklogSpinBox, 2, 1);
+	
+	this->recorderGroup = new QGroupBox(tr("Recording"));
+	this->recorderGroup->setLayout(this->recorderLayout);
+	
 	this->mainLayout = new QVBoxLayout();
 	this->mainLayout->addWidget(this->configurationGroup);
 	this->mainLayout->addWidget(this->exportGroup);
+	this->mainLayout->addWidget(this->recorderGroup);
 	this->mainLayout->addStretch(1);
 	
 	this->setLayout(this->mainLayout);
@@ -281,6 +589,11 @@ void DsoConfigFilesPage::saveSettings() {
 	this->settings->options.alwaysSave = this->saveOnExitCheckBox->isChecked();
 	this->settings->options.imageSize.setWidth(this->imageWidthSpinBox->value());
 	this->settings->options.imageSize.setHeight(this->imageHeightSpinBox->value());
+	this->settings->options.csvPrecision = this->csvPrecisionSpinBox->value();
+	this->settings->options.csvColumns = this->csvLayoutComboBox->currentIndex() == 1;
+	this->settings->options.recorder.fileSize = this->recorderFileSizeSpinBox->value();
+	this->settings->options.recorder.fileDuration = this->recorderFileDurationSpinBox->value();
+	this->settings->options.recorder.backlog = this->recorderBacklogSpinBox->value();
 }
 
 
@@ -308,9 +621,16 @@ DsoConfigScopePage::DsoConfigScopePage(DsoSettings *settings, QWidget *parent) :
 	this->interpolationComboBox->setCurrentIndex(this->settings->view.interpolation);
 	this->digitalPhosphorDepthLabel = new QLabel(tr("Digital phosphor depth"));
 	this->digitalPhosphorDepthSpinBox = new QSpinBox();
-	this->digitalPhosphorDepthSpinBox->setMinimum(2);
-	this->digitalPhosphorDepthSpinBox->setMaximum(99);
+	this->digitalPhosphorDepthSpinBox->setMinimum(0);
+	this->digitalPhosphorDepthSpinBox->setMaximum(999);
+	this->digitalPhosphorDepthSpinBox->setSpecialValueText(tr("Infinite"));
 	this->digitalPhosphorDepthSpinBox->setValue(this->settings->view.digitalPhosphorDepth);
+	this->frameRateLabel = new QLabel(tr("Maximum frame rate"));
+	this->frameRateSpinBox = new QSpinBox();
+	this->frameRateSpinBox->setMinimum(1);
+	this->frameRateSpinBox->setMaximum(200);
+	this->frameRateSpinBox->setSuffix(tr(" fps"));
+	this->frameRateSpinBox->setValue(this->settings->view.frameRate);
 	
 	this->graphLayout = new QGridLayout();
 	this->graphLayout->addWidget(this->antialiasingCheckBox, 0, 0, 1, 2);
@@ -318,12 +638,36 @@ DsoConfigScopePage::DsoConfigScopePage(DsoSettings *settings, QWidget *parent) :
 	this->graphLayout->addWidget(this->interpolationComboBox, 1, 1);
 	this->graphLayout->addWidget(this->digitalPhosphorDepthLabel, 2, 0);
 	this->graphLayout->addWidget(this->digitalPhosphorDepthSpinBox, 2, 1);
+	this->graphLayout->addWidget(this->frameRateLabel, 3, 0);
+	this->graphLayout->addWidget(this->frameRateSpinBox, 3, 1);
 	
 	this->graphGroup = new QGroupBox(tr("Graph"));
 	this->graphGroup->setLayout(this->graphLayout);
 	
+	this->historyFramesLabel = new QLabel(tr("Kept frames"));
+	this->historyFramesSpinBox = new QSpinBox();
+	this->historyFramesSpinBox->setMinimum(1);
+	this->historyFramesSpinBox->setMaximum(1000000);
+	this->historyFramesSpinBox->setValue(this->settings->options.history.frames);
+	this->historyMemoryLabel = new QLabel(tr("Memory for kept frames"));
+	this->historyMemorySpinBox = new QSpinBox();
+	this->historyMemorySpinBox->setMinimum(1);
+	this->historyMemorySpinBox->setMaximum(65536);
+	this->historyMemorySpinBox->setSuffix(tr(" MiB"));
+	this->historyMemorySpinBox->setValue(this->settings->options.history.memory);
+	
+	this->historyLayout = new QGridLayout();
+	this->historyLayout->addWidget(this->historyFramesLabel, 0, 0);
+	this->historyLayout->addWidget(this->historyFramesSpinBox, 0, 1);
+	this->historyLayout->addWidget(this->historyMemoryLabel, 1, 0);
+	this->historyLayout->addWidget(this->historyMemorySpinBox, 1, 1);
+	
+	this->historyGroup = new QGroupBox(tr("History"));
+	this->historyGroup->setLayout(this->historyLayout);
+	
 	this->mainLayout = new QVBoxLayout();
 	this->mainLayout->addWidget(this->graphGroup);
+	this->mainLayout->addWidget(this->historyGroup);
 	this->mainLayout->addStretch(1);
 	
 	this->setLayout(this->mainLayout);
@@ -338,4 +682,7 @@ void DsoConfigScopePage::saveSettings() {
 	this->settings->view.antialiasing = this->antialiasingCheckBox->isChecked();
 	this->settings->view.interpolation = (Dso::InterpolationMode) this->interpolationComboBox->currentIndex();
 	this->settings->view.digitalPhosphorDepth = this->digitalPhosphorDepthSpinBox->value();
+	this->settings->view.frameRate = this->frameRateSpinBox->value();
+	this->settings->options.history.frames = this->historyFramesSpinBox->value();
+	this->settings->options.history.memory = this->historyMemorySpinBox->value();
 }
@@ -75,6 +75,59 @@ class DsoConfigAnalysisPage : public QWidget {
 		QDoubleSpinBox *minimumMagnitudeSpinBox;
 		QLabel *minimumMagnitudeUnitLabel;
 		QHBoxLayout *minimumMagnitudeLayout;
+		
+		QCheckBox *zoomSpectrumCheckBox;
+		QCheckBox *harmonicsCheckBox;
+		QCheckBox *preciseCheckBox;
+		QLabel *spectrogramChannelLabel;
+		QComboBox *spectrogramChannelComboBox;
+		
+		QGroupBox *filterGroup;
+		QGridLayout *filterLayout;
+		QLabel *filterTypeLabel, *filterDesignLabel, *filterFrequencyLabel, *filterBandwidthLabel, *filterTapsLabel;
+		QList<QLabel *> filterChannelLabel;
+		QList<QComboBox *> filterTypeComboBox;
+		QList<QComboBox *> filterDesignComboBox;
+		QList<QDoubleSpinBox *> filterFrequencySpinBox;
+		QList<QDoubleSpinBox *> filterBandwidthSpinBox;
+		QList<QSpinBox *> filterTapsSpinBox;
+		
+		QGroupBox *decoderGroup;
+		QGridLayout *decoderLayout;
+		QLabel *protocolLabel;
+		QComboBox *protocolComboBox;
+		QLabel *decoderDataLabel;
+		QComboBox *decoderDataComboBox;
+		QLabel *decoderClockLabel;
+		QComboBox *decoderClockComboBox;
+		QLabel *decoderThresholdLabel;
+		QDoubleSpinBox *decoderThresholdSpinBox;
+		QLabel *baudrateLabel;
+		QSpinBox *baudrateSpinBox;
+		QLabel *decoderBitsLabel;
+		QSpinBox *decoderBitsSpinBox;
+		QLabel *parityLabel;
+		QComboBox *parityComboBox;
+		QLabel *spiModeLabel;
+		QSpinBox *spiModeSpinBox;
+		QCheckBox *msbFirstCheckBox;
+		
+		QGroupBox *maskGroup;
+		QGridLayout *maskLayout;
+		QCheckBox *maskEnabledCheckBox;
+		QLabel *maskChannelLabel;
+		QComboBox *maskChannelComboBox;
+		QLabel *maskToleranceTimeLabel;
+		QDoubleSpinBox *maskToleranceTimeSpinBox;
+		QLabel *maskToleranceVoltageLabel;
+		QDoubleSpinBox *maskToleranceVoltageSpinBox;
+		QCheckBox *maskStopCheckBox;
+		
+		QGroupBox *phaseGroup;
+		QGridLayout *phaseLayout;
+		QCheckBox *phaseEnabledCheckBox;
+		QLabel *phaseReferenceLabel;
+		QComboBox *phaseReferenceComboBox;
 	
 	private slots:
 };
@@ -100,8 +153,8 @@ class DsoConfigColorsPage : public QWidget {
 		
 		QGroupBox *screenGroup;
 		QGridLayout *screenLayout;
-		QLabel *axesLabel, *backgroundLabel, *borderLabel, *gridLabel, *markersLabel, *textLabel;
-		ColorBox *axesColorBox, *backgroundColorBox, *borderColorBox, *gridColorBox, *markersColorBox, *textColorBox;
+		QLabel *axesLabel, *backgroundLabel, *borderLabel, *gridLabel, *markersLabel, *maskLabel, *textLabel;
+		ColorBox *axesColorBox, *backgroundColorBox, *borderColorBox, *gridColorBox, *markersColorBox, *maskColorBox, *textColorBox;
 		
 		QGroupBox *graphGroup;
 		QGridLayout *graphLayout;
@@ -143,6 +196,19 @@ class DsoConfigFilesPage : public QWidget {
 		QSpinBox *imageWidthSpinBox;
 		QLabel *imageHeightLabel;
 		QSpinBox *imageHeightSpinBox;
+		QLabel *csvPrecisionLabel;
+		QSpinBox *csvPrecisionSpinBox;
+		QLabel *csvLayoutLabel;
+		QComboBox *csvLayoutComboBox;
+		
+		QGroupBox *recorderGroup;
+		QGridLayout *recorderLayout;
+		QLabel *recorderFileSizeLabel;
+		QSpinBox *recorderFileSizeSpinBox;
+		QLabel *recorderFileDurationLabel;
+		QSpinBox *recorderFileDurationSpinBox;
+		QLabel *recorderBacklogLabel;
+		QSpinBox *recorderBacklogSpinBox;
 	
 	private slots:
 };
@@ -171,8 +237,17 @@ class DsoConfigScopePage : public QWidget {
 		QCheckBox *antialiasingCheckBox;
 		QLabel *digitalPhosphorDepthLabel;
 		QSpinBox *digitalPhosphorDepthSpinBox;
+		QLabel *frameRateLabel;
+		QSpinBox *frameRateSpinBox;
 		QLabel *interpolationLabel;
 		QComboBox *interpolationComboBox;
+		
+		QGroupBox *historyGroup;
+		QGridLayout *historyLayout;
+		QLabel *historyFramesLabel;
+		QSpinBox *historyFramesSpinBox;
+		QLabel *historyMemoryLabel;
+		QSpinBox *historyMemorySpinBox;
 	
 	private slots:
 };
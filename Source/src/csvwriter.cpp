@@ -0,0 +1,273 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  OpenHantek
+//  csvwriter.cpp
+//
+//  This program is free software: you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation, either version 3 of the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <clocale>
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QString>
+
+
+#include "csvwriter.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// class CsvWriter
+/// \brief Allocates the buffer.
+/// \param device The opened output device.
+/// \param precision The significant digits of the values, 0 for the shortest exact ones.
+/// \param bufferSize The bytes collected before they are written.
+CsvWriter::CsvWriter(QIODevice *device, int precision, int bufferSize) {
+	this->device = device;
+	this->bufferSize = qMax(bufferSize, CSVWRITER_FIELDSIZE * 2);
+	this->buffer = new char[this->bufferSize];
+	this->bufferUsed = 0;
+	this->precision = qBound(0, precision, 17);
+	this->rowStarted = false;
+	this->error = false;
+}
+
+/// \brief Writes the rest of the buffer.
+CsvWriter::~CsvWriter() {
+	this->flush();
+	delete[] this->buffer;
+}
+
+/// \brief Writes a quoted text field.
+/// \param text The text, quotes are doubled.
+void CsvWriter::writeText(const QString &text) {
+	QByteArray bytes = text.toLocal8Bit();
+	bytes.replace('"', "\"\"");
+	
+	this->separate();
+	this->reserve(bytes.size() + 2);
+	this->buffer[this->bufferUsed++] = '"';
+	if(bytes.size() > this->bufferSize - this->bufferUsed - 1) {
+		// Longer than the buffer, write it directly
+		this->flush();
+		if(this->device->write(bytes) != bytes.size())
+			this->error = true;
+	}
+	else {
+		memcpy(this->buffer + this->bufferUsed, bytes.constData(), bytes.size());
+		this->bufferUsed += bytes.size();
+	}
+	this->buffer[this->bufferUsed++] = '"';
+}
+
+/// \brief Writes a numeric field.
+/// \param value The value that should be written.
+void CsvWriter::writeValue(double value) {
+	this->separate();
+	this->reserve(CSVWRITER_FIELDSIZE);
+	this->bufferUsed += CsvWriter::formatValue(value, this->precision, this->buffer + this->bufferUsed);
+}
+
+/// \brief Writes an empty field.
+void CsvWriter::writeEmpty() {
+	this->separate();
+}
+
+/// \brief Finishes the current row.
+void CsvWriter::endRow() {
+	this->reserve(1);
+	this->buffer[this->bufferUsed++] = '\n';
+	this->rowStarted = false;
+}
+
+/// \brief Writes the buffer to the device.
+/// \return true if everything has been written so far.
+bool CsvWriter::flush() {
+	if(this->bufferUsed && !this->error) {
+		if(this->device->write(this->buffer, this->bufferUsed) != this->bufferUsed)
+			this->error = true;
+	}
+	this->bufferUsed = 0;
+	
+	return !this->error;
+}
+
+/// \brief Tells if a write has failed.
+/// \return true if the output is incomplete.
+bool CsvWriter::hasError() const {
+	return this->error;
+}
+
+/// \brief Formats a value without the decimal point of the locale.
+/// \param value The value that should be formatted.
+/// \param precision The significant digits, 0 for the shortest of 15 to 17 that reads back to the same value.
+/// \param field The destination with room for CSVWRITER_FIELDSIZE characters.
+/// \return The length of the formatted value.
+int CsvWriter::formatValue(double value, int precision, char *field) {
+	if(value != value) {
+		memcpy(field, "nan", 3);
+		return 3;
+	}
+	if(fabs(value) > 1.7976931348623157e308) {
+		if(value < 0) {
+			memcpy(field, "-inf", 4);
+			return 4;
+		}
+		memcpy(field, "inf", 3);
+		return 3;
+	}
+	if(value == 0) {
+		// Only the sign tells the negative zero apart
+		if(1 / value < 0) {
+			memcpy(field, "-0", 2);
+			return 2;
+		}
+		field[0] = '0';
+		return 1;
+	}
+	
+	int length;
+	if(precision > 0) {
+		if(precision <= CSVWRITER_FASTDIGITS) {
+			length = CsvWriter::formatFixed(value, precision, false, field);
+			if(length)
+				return length;
+		}
+		length = snprintf(field, CSVWRITER_FIELDSIZE, "%.*g", precision, value);
+	}
+	else {
+		// 15 digits that read back are the only ones, most other values need 17
+		length = CsvWriter::formatFixed(value, CSVWRITER_FASTDIGITS, true, field);
+		if(length)
+			return length;
+		for(precision = 15; precision <= 17; precision++) {
+			length = snprintf(field, CSVWRITER_FIELDSIZE, "%.*g", precision, value);
+			if(precision == 17 || strtod(field, 0) == value)
+				break;
+		}
+	}
+	
+	// printf and strtod use the decimal point of the locale, CSV needs a dot
+	char decimalPoint = localeconv()->decimal_point[0];
+	if(decimalPoint != '.') {
+		for(int position = 0; position < length; position++) {
+			if(field[position] == decimalPoint) {
+				field[position] = '.';
+				break;
+			}
+		}
+	}
+	
+	return length;
+}
+
+/// \brief Formats a value like printf with %.*g, but with integer arithmetic.
+/// \param value The finite value that should be formatted, not 0.
+/// \param precision The significant digits, 1 to CSVWRITER_FASTDIGITS.
+/// \param exact true if the digits have to read back to the same value.
+/// \param field The destination with room for CSVWRITER_FIELDSIZE characters.
+/// \return The length of the formatted value, 0 if printf has to format it.
+int CsvWriter::formatFixed(double value, int precision, bool exact, char *field) {
+	// The powers of ten that are exact doubles
+	static const double powersOfTen[] = {
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+	
+	double magnitude = fabs(value);
+	int exponent = (int) floor(log10(magnitude));
+	int scale = 0;
+	quint64 digits = 0;
+	for(int attempt = 0; attempt < 3; attempt++) {
+		// printf switches to the exponent notation outside of this range
+		if(exponent < -4 || exponent >= precision)
+			return 0;
+		
+		scale = precision - 1 - exponent;
+		double scaled = magnitude * powersOfTen[scale];
+		double integer = floor(scaled);
+		double fraction = scaled - integer;
+		// The product is rounded, printf may round a value this close to a tie the other way
+		if(!exact && fabs(fraction - 0.5) <= scaled * 2.3e-16)
+			return 0;
+		digits = (quint64) integer + (fraction > 0.5 ? 1 : 0);
+		
+		// log10 and the rounding can be off by one digit
+		if(digits >= (quint64) powersOfTen[precision])
+			exponent++;
+		else if(digits < (quint64) powersOfTen[precision - 1])
+			exponent--;
+		else
+			break;
+		digits = 0;
+	}
+	if(!digits)
+		return 0;
+	// The quotient of two exact values is rounded like strtod rounds
+	if(exact && (double) digits / powersOfTen[scale] != magnitude)
+		return 0;
+	
+	// printf drops the trailing zeros of the fraction
+	while(scale > 0 && digits % 10 == 0) {
+		digits /= 10;
+		scale--;
+	}
+	
+	char reversed[CSVWRITER_FASTDIGITS];
+	int count = 0;
+	do {
+		reversed[count++] = '0' + digits % 10;
+		digits /= 10;
+	} while(digits);
+	
+	int length = 0;
+	if(value < 0)
+		field[length++] = '-';
+	if(count <= scale) {
+		field[length++] = '0';
+		field[length++] = '.';
+		for(int zero = count; zero < scale; zero++)
+			field[length++] = '0';
+		scale = 0;
+	}
+	while(count) {
+		if(count == scale)
+			field[length++] = '.';
+		field[length++] = reversed[--count];
+	}
+	
+	return length;
+}
+
+/// \brief Separates the next field from the previous one.
+void CsvWriter::separate() {
+	if(this->rowStarted) {
+		this->reserve(1);
+		this->buffer[this->bufferUsed++] = ',';
+	}
+	this->rowStarted = true;
+}
+
+/// \brief Makes room in the buffer.
+/// \param length The bytes that should fit into the buffer.
+void CsvWriter::reserve(int length) {
+	if(this->bufferUsed + length > this->bufferSize)
+		this->flush();
+}
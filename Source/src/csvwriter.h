@@ -0,0 +1,75 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  OpenHantek
+/// \file csvwriter.h
+/// \brief Declares the CsvWriter class.
+//
+//  This program is free software: you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation, either version 3 of the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef CSVWRITER_H
+#define CSVWRITER_H
+
+
+class QIODevice;
+class QString;
+
+
+#define CSVWRITER_BUFFERSIZE    1048576 ///< Bytes collected before they are written
+#define CSVWRITER_FIELDSIZE          32 ///< Maximum length of a formatted value
+#define CSVWRITER_FASTDIGITS         15 ///< Most significant digits formatted without printf
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// \class CsvWriter                                                 csvwriter.h
+/// \brief Writes comma-separated values through a large buffer.
+/// The values are formatted without the locale and collected in the buffer,
+/// the device only gets large sequential writes. Values in the usual range are
+/// formatted with integer arithmetic, the others with printf. A precision of 0
+/// writes the shortest of 15, 16 or 17 significant digits that reads back to
+/// the same value.
+class CsvWriter {
+	public:
+		CsvWriter(QIODevice *device, int precision = 6, int bufferSize = CSVWRITER_BUFFERSIZE);
+		~CsvWriter();
+		
+		void writeText(const QString &text);
+		void writeValue(double value);
+		void writeEmpty();
+		void endRow();
+		bool flush();
+		
+		bool hasError() const;
+		
+		static int formatValue(double value, int precision, char *field);
+	
+	private:
+		static int formatFixed(double value, int precision, bool exact, char *field);
+		
+		void separate();
+		void reserve(int length);
+		
+		QIODevice *device; ///< The output device
+		char *buffer; ///< The data that wasn't written yet
+		int bufferSize; ///< The capacity of the buffer
+		int bufferUsed; ///< The bytes in the buffer
+		int precision; ///< The significant digits, 0 for the shortest exact ones
+		bool rowStarted; ///< true if the current row has a field already
+		bool error; ///< true if a write has failed
+};
+
+
+#endif
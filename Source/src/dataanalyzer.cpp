@@ -23,18 +23,26 @@
 
 
 #include <cmath>
+#include <cstring>
 
 #include <QColor>
 #include <QMutex>
+#include <QMutexLocker>
 
 #include <fftw3.h>
 
 
 #include "dataanalyzer.h"
 
+#include "decibel.h"
+#include "digitalfilter.h"
 #include "glscope.h"
 #include "helper.h"
+#include "masktest.h"
+#include "mathexpression.h"
 #include "settings.h"
+#include "spectrogram.h"
+#include "zoomfft.h"
 
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -49,6 +57,36 @@ DataAnalyzer::DataAnalyzer(DsoSettings *settings, QObject *parent) : QThread(par
 	this->lastWindow = (Dso::WindowFunction) -1;
 	this->window = 0;
 	
+	this->demandMutex = new QMutex();
+	this->analysisWindow = (Dso::WindowFunction) -1;
+	this->analysisReference = 0;
+	this->analysisLimit = 0;
+	this->analysisPrecise = false;
+	this->analysisZoom = false;
+	this->analysisLowFrequency = 0;
+	this->analysisHighFrequency = 0;
+	this->analysisDelayReference = 0;
+	
+	this->fftSize = 0;
+	this->fftInput = 0;
+	this->fftOutput = 0;
+	this->fftCorrelation = 0;
+	this->fftReference = 0;
+	
+	this->zoomFft = new ZoomFft();
+	this->lastZoomWindowSize = 0;
+	this->lastZoomWindow = (Dso::WindowFunction) -1;
+	this->zoomWindow = 0;
+	
+	this->decoder = 0;
+	this->mask = new MaskTest();
+	this->spectrogramRows = new Spectrogram();
+	this->lastSpectrogramChannel = 0;
+	this->lastSpectrogramInterval = 0;
+	
+	for(int mathChannel = 0; mathChannel < MATH_CHANNELS; mathChannel++)
+		this->mathExpressions.append(new MathExpression());
+	
 	this->analyzedDataMutex = new QMutex();
 }
 
@@ -59,7 +97,32 @@ DataAnalyzer::~DataAnalyzer() {
 			delete[] this->analyzedData[channel]->samples.voltage.sample;
 		if(this->analyzedData[channel]->samples.spectrum.sample)
 			delete[] this->analyzedData[channel]->samples.spectrum.sample;
+		if(this->analyzedData[channel]->samples.zoomSpectrum.sample)
+			delete[] this->analyzedData[channel]->samples.zoomSpectrum.sample;
 	}
+	
+	for(int channel = 0; channel < this->filters.count(); channel++)
+		delete this->filters[channel];
+	for(int mathChannel = 0; mathChannel < this->mathExpressions.count(); mathChannel++)
+		delete this->mathExpressions[mathChannel];
+	delete this->zoomFft;
+	if(this->decoder)
+		delete this->decoder;
+	delete this->mask;
+	delete this->spectrogramRows;
+	if(this->zoomWindow)
+		delete[] this->zoomWindow;
+	if(this->fftSize) {
+		fftw_destroy_plan(this->fftForwardPlan);
+		fftw_destroy_plan(this->fftBackwardPlan);
+		fftw_free(this->fftInput);
+		fftw_free(this->fftOutput);
+		fftw_free(this->fftCorrelation);
+		fftw_free(this->fftReference);
+	}
+	if(this->window)
+		fftw_free(this->window);
+	delete this->demandMutex;
 }
 
 /// \brief Returns the analyzed data.
@@ -84,6 +147,118 @@ QMutex *DataAnalyzer::mutex() const {
 	return this->analyzedDataMutex;
 }
 
+/// \brief Copies the current analyzed data.
+/// The analyzer is only locked while the data is copied, the consumer can take
+/// as long as it needs with the copy.
+/// \return The copy of the data of all channels.
+QSharedPointer<AnalyzedFrame> DataAnalyzer::snapshot() const {
+	QMutexLocker locker(this->analyzedDataMutex);
+	
+	return QSharedPointer<AnalyzedFrame>(new AnalyzedFrame(this->analyzedData, this->maxSamples));
+}
+
+/// \brief Returns the mask test.
+/// \return The mask test with the pass/fail counters.
+const MaskTest *DataAnalyzer::maskTest() const {
+	return this->mask;
+}
+
+/// \brief Returns the spectrogram shown as waterfall.
+/// \return The ring buffer, only valid while the mutex is locked.
+const Spectrogram *DataAnalyzer::spectrogram() const {
+	return this->spectrogramRows;
+}
+
+/// \brief Sets the counters of the mask test to zero.
+void DataAnalyzer::resetMaskTest() {
+	this->analyzedDataMutex->lock();
+	this->mask->resetCounters();
+	this->analyzedDataMutex->unlock();
+}
+
+/// \brief Calculates the factors of a dft window function.
+/// \param windowFunction The window function that should be used.
+/// \param window The array for the window factors.
+/// \param length The number of window factors.
+void DataAnalyzer::calculateWindow(Dso::WindowFunction windowFunction, double *window, unsigned int length) {
+	unsigned int windowEnd = length - 1;
+	
+	switch(windowFunction) {
+		case Dso::WINDOW_HAMMING:
+			for(unsigned int windowPosition = 0; windowPosition < length; windowPosition++)
+				window[windowPosition] = 0.54 - 0.46 * cos(2.0 * M_PI * windowPosition / windowEnd);
+			break;
+		case Dso::WINDOW_HANN:
+			for(unsigned int windowPosition = 0; windowPosition < length; windowPosition++)
+				window[windowPosition] = 0.5 * (1.0 - cos(2.0 * M_PI * windowPosition / windowEnd));
+			break;
+		case Dso::WINDOW_COSINE:
+			for(unsigned int windowPosition = 0; windowPosition < length; windowPosition++)
+				window[windowPosition] = sin(M_PI * windowPosition / windowEnd);
+			break;
+		case Dso::WINDOW_LANCZOS:
+			for(unsigned int windowPosition = 0; windowPosition < length; windowPosition++) {
+				double sincParameter = (2.0 * windowPosition / windowEnd - 1.0) * M_PI;
+				if(sincParameter == 0)
+					window[windowPosition] = 1;
+				else
+					window[windowPosition] = sin(sincParameter) / sincParameter;
+			}
+			break;
+		case Dso::WINDOW_BARTLETT:
+			for(unsigned int windowPosition = 0; windowPosition < length; windowPosition++)
+				window[windowPosition] = 2.0 / windowEnd * (windowEnd / 2 - abs((int)(windowPosition - windowEnd / 2)));
+			break;
+		case Dso::WINDOW_TRIANGULAR:
+			for(unsigned int windowPosition = 0; windowPosition < length; windowPosition++)
+				window[windowPosition] = 2.0 / length * (length / 2 - abs((int)(windowPosition - windowEnd / 2)));
+			break;
+		case Dso::WINDOW_GAUSS:
+			{
+				double sigma = 0.4;
+				for(unsigned int windowPosition = 0; windowPosition < length; windowPosition++)
+					window[windowPosition] = exp(-0.5 * pow(((windowPosition - windowEnd / 2) / (sigma * windowEnd / 2)), 2));
+			}
+			break;
+		case Dso::WINDOW_BARTLETTHANN:
+			for(unsigned int windowPosition = 0; windowPosition < length; windowPosition++)
+				window[windowPosition] = 0.62 - 0.48 * abs(windowPosition / windowEnd - 0.5) - 0.38 * cos(2.0 * M_PI * windowPosition / windowEnd);
+			break;
+		case Dso::WINDOW_BLACKMAN:
+			{
+				double alpha = 0.16;
+				for(unsigned int windowPosition = 0; windowPosition < length; windowPosition++)
+					window[windowPosition] = (1 - alpha) / 2 - 0.5 * cos(2.0 * M_PI * windowPosition / windowEnd) + alpha / 2 * cos(4.0 * M_PI * windowPosition / windowEnd);
+			}
+			break;
+		//case WINDOW_KAISER:
+			// TODO
+			//double alpha = 3.0;
+			//for(unsigned int windowPosition = 0; windowPosition < length; windowPosition++)
+				//window[windowPosition] = ;
+			//break;
+		case Dso::WINDOW_NUTTALL:
+			for(unsigned int windowPosition = 0; windowPosition < length; windowPosition++)
+				window[windowPosition] = 0.355768 - 0.487396 * cos(2 * M_PI * windowPosition / windowEnd) + 0.144232 * cos(4 * M_PI * windowPosition / windowEnd) - 0.012604 * cos(6 * M_PI * windowPosition / windowEnd);
+			break;
+		case Dso::WINDOW_BLACKMANHARRIS:
+			for(unsigned int windowPosition = 0; windowPosition < length; windowPosition++)
+				window[windowPosition] = 0.35875 - 0.48829 * cos(2 * M_PI * windowPosition / windowEnd) + 0.14128 * cos(4 * M_PI * windowPosition / windowEnd) - 0.01168 * cos(6 * M_PI * windowPosition / windowEnd);
+			break;
+		case Dso::WINDOW_BLACKMANNUTTALL:
+			for(unsigned int windowPosition = 0; windowPosition < length; windowPosition++)
+				window[windowPosition] = 0.3635819 - 0.4891775 * cos(2 * M_PI * windowPosition / windowEnd) + 0.1365995 * cos(4 * M_PI * windowPosition / windowEnd) - 0.0106411 * cos(6 * M_PI * windowPosition / windowEnd);
+			break;
+		case Dso::WINDOW_FLATTOP:
+			for(unsigned int windowPosition = 0; windowPosition < length; windowPosition++)
+				window[windowPosition] = 1.0 - 1.93 * cos(2 * M_PI * windowPosition / windowEnd) + 1.29 * cos(4 * M_PI * windowPosition / windowEnd) - 0.388 * cos(6 * M_PI * windowPosition / windowEnd) + 0.032 * cos(8 * M_PI * windowPosition / windowEnd);
+			break;
+		default: // Dso::WINDOW_RECTANGULAR
+			for(unsigned int windowPosition = 0; windowPosition < length; windowPosition++)
+				window[windowPosition] = 1.0;
+	}
+}
+
 /// \brief Analyzes the data from the dso.
 void DataAnalyzer::run() {
 	this->analyzedDataMutex->lock();
@@ -99,277 +274,378 @@ void DataAnalyzer::run() {
 		this->analyzedData[channel]->samples.spectrum.count = 0;
 		this->analyzedData[channel]->samples.spectrum.interval = 0;
 		this->analyzedData[channel]->samples.spectrum.sample = 0;
+		this->analyzedData[channel]->samples.zoomSpectrum.count = 0;
+		this->analyzedData[channel]->samples.zoomSpectrum.interval = 0;
+		this->analyzedData[channel]->samples.zoomSpectrum.sample = 0;
 		this->analyzedData[channel]->amplitude = 0;
 		this->analyzedData[channel]->frequency = 0;
+		this->analyzedData[channel]->zoomSpectrumStart = 0;
+		this->analyzedData[channel]->harmonics.valid = false;
+		this->analyzedData[channel]->delay = 0;
+		this->analyzedData[channel]->phase = 0;
+		this->computedProducts.append(0);
 	}
 	for(int channel = this->settings->scope.voltage.count(); channel < this->analyzedData.count(); channel++) {
 		if(this->analyzedData.last()->samples.voltage.sample)
 			delete[] this->analyzedData.last()->samples.voltage.sample;
 		if(this->analyzedData.last()->samples.spectrum.sample)
 			delete[] this->analyzedData.last()->samples.spectrum.sample;
+		if(this->analyzedData.last()->samples.zoomSpectrum.sample)
+			delete[] this->analyzedData.last()->samples.zoomSpectrum.sample;
 		this->analyzedData.removeLast();
+		this->computedProducts.removeLast();
 	}
 	
+	// Collect the products the consumers need
+	QList<int> neededProducts;
+	this->demandMutex->lock();
+	for(int channel = 0; channel < this->analyzedData.count(); channel++) {
+		int products = 0;
+		for(int consumer = 0; consumer < CONSUMER_COUNT; consumer++) {
+			if(channel < this->demand[consumer].count())
+				products |= this->demand[consumer][channel];
+		}
+		neededProducts.append(products);
+	}
+	this->demandMutex->unlock();
+	
+	QList<bool> changed;
 	for(unsigned int channel = 0; channel < (unsigned int) this->analyzedData.count(); channel++) {
-		// Check if we got data for this channel or if it's a math channel that can be calculated
-		if(((channel < this->settings->scope.physicalChannels) && channel < (unsigned int) this->waitingData.count() && this->waitingData[channel]) || ((channel >= this->settings->scope.physicalChannels) && (this->settings->scope.voltage[channel].used || this->settings->scope.spectrum[channel].used) && this->analyzedData.count() >= 2 && this->analyzedData[0]->samples.voltage.sample && this->analyzedData[1]->samples.voltage.sample)) {
-			// Set sampling interval
-			this->analyzedData[channel]->samples.voltage.interval = 1.0 / this->waitingDataSamplerate;
-			
-			unsigned int size;
-			if(channel < this->settings->scope.physicalChannels) {
+		bool available = false;
+		bool expressionChanged = false;
+		unsigned int size = 0;
+		MathExpression *mathExpression = 0;
+		
+		if(channel < this->settings->scope.physicalChannels) {
+			// Check if we got data for this channel
+			if(channel < (unsigned int) this->waitingData.count() && this->waitingData[channel]) {
+				available = true;
 				size = this->waitingDataSize[channel];
 				if(size > maxSamples)
 					maxSamples = size;
 			}
-			else
-				size = maxSamples;
+		}
+		else if((this->settings->scope.voltage[channel].used || this->settings->scope.spectrum[channel].used) && channel - this->settings->scope.physicalChannels < (unsigned int) this->mathExpressions.count()) {
+			// Math channel, compile the expression again only if it has been changed
+			mathExpression = this->mathExpressions[channel - this->settings->scope.physicalChannels];
+			Dso::MathMode mode = (Dso::MathMode) this->settings->scope.voltage[channel].misc;
+			QString expression = (mode == Dso::MATHMODE_EXPRESSION) ? this->settings->scope.voltage[channel].expression : MathExpression::modeExpression(mode);
+			if(expression != mathExpression->expression()) {
+				mathExpression->compile(expression, this->settings->scope.physicalChannels);
+				expressionChanged = true;
+			}
+			
+			// It can be calculated if all channels used by the expression are available
+			available = mathExpression->isValid();
+			size = maxSamples;
+			for(int index = 0; available && index < mathExpression->channels().count(); index++) {
+				unsigned int sourceChannel = mathExpression->channels()[index];
+				if(!this->analyzedData[sourceChannel]->samples.voltage.sample)
+					available = false;
+				else
+					size = qMin(size, this->analyzedData[sourceChannel]->samples.voltage.count);
+			}
+		}
+		
+		changed.append(true);
+		if(available) {
+			// Set sampling interval
+			double interval = 1.0 / this->waitingDataSamplerate;
+			changed[channel] = this->analyzedData[channel]->samples.voltage.interval != interval;
+			this->analyzedData[channel]->samples.voltage.interval = interval;
+			
 			// Reallocate memory for samples if the sample count has changed
-			if(this->analyzedData[channel]->samples.voltage.count != size) {
+			if(this->analyzedData[channel]->samples.voltage.count != size || !this->analyzedData[channel]->samples.voltage.sample) {
 				this->analyzedData[channel]->samples.voltage.count = size;
 				if(this->analyzedData[channel]->samples.voltage.sample)
 					delete[] this->analyzedData[channel]->samples.voltage.sample;
 				this->analyzedData[channel]->samples.voltage.sample = new double[size];
+				changed[channel] = true;
 			}
 			
 			// Physical channels
 			if(channel < this->settings->scope.physicalChannels) {
-				// Copy the buffer of the oscilloscope into the sample buffer
-				if(channel < (unsigned int) this->waitingData.count())
-					for(unsigned int position = 0; position < this->waitingDataSize[channel]; position++)
-						this->analyzedData[channel]->samples.voltage.sample[position] = this->waitingData[channel][position];
-			}
-			// Math channel
-			else {
-				// Set sampling interval
-				this->analyzedData[this->settings->scope.physicalChannels]->samples.voltage.interval = this->analyzedData[0]->samples.voltage.interval;
+				while((unsigned int) this->filters.count() <= channel)
+					this->filters.append(new DigitalFilter());
 				
-				// Reallocate memory for samples if the sample count has changed
-				if(this->analyzedData[this->settings->scope.physicalChannels]->samples.voltage.count != this->analyzedData[0]->samples.voltage.count) {
-					this->analyzedData[this->settings->scope.physicalChannels]->samples.voltage.count = this->analyzedData[0]->samples.voltage.count;
-					if(this->analyzedData[this->settings->scope.physicalChannels]->samples.voltage.sample)
-						delete[] this->analyzedData[this->settings->scope.physicalChannels]->samples.voltage.sample;
-					this->analyzedData[this->settings->scope.physicalChannels]->samples.voltage.sample = new double[this->analyzedData[this->settings->scope.physicalChannels]->samples.voltage.count];
+				// Filter into a scratch buffer if enabled
+				const double *input = this->waitingData[channel];
+				if(this->filters[channel]->configure(this->settings->scope.voltage[channel].filter, this->waitingDataSamplerate)) {
+					if((unsigned int) this->filterOutput.count() < size)
+						this->filterOutput.resize(size);
+					this->filters[channel]->processFrame(input, this->filterOutput.data(), size);
+					input = this->filterOutput.constData();
 				}
 				
-				// Calculate values and write them into the sample buffer
-				for(unsigned int realPosition = 0; realPosition < this->analyzedData[this->settings->scope.physicalChannels]->samples.voltage.count; realPosition++) {
-					switch(this->settings->scope.voltage[this->settings->scope.physicalChannels].misc) {
-						case Dso::MATHMODE_1ADD2:
-							this->analyzedData[this->settings->scope.physicalChannels]->samples.voltage.sample[realPosition] = this->analyzedData[0]->samples.voltage.sample[realPosition] + this->analyzedData[1]->samples.voltage.sample[realPosition];
-							break;
-						case Dso::MATHMODE_1SUB2:
-							this->analyzedData[this->settings->scope.physicalChannels]->samples.voltage.sample[realPosition] = this->analyzedData[0]->samples.voltage.sample[realPosition] - this->analyzedData[1]->samples.voltage.sample[realPosition];
-							break;
-						case Dso::MATHMODE_2SUB1:
-							this->analyzedData[this->settings->scope.physicalChannels]->samples.voltage.sample[realPosition] = this->analyzedData[1]->samples.voltage.sample[realPosition] - this->analyzedData[0]->samples.voltage.sample[realPosition];
-							break;
-					}
+				// Copy the buffer of the oscilloscope into the sample buffer, the cached results stay valid for an equal frame
+				double *samples = this->analyzedData[channel]->samples.voltage.sample;
+				bool different = false;
+				for(unsigned int position = 0; position < size; position++) {
+					different |= samples[position] != input[position];
+					samples[position] = input[position];
+				}
+				changed[channel] = changed[channel] || different;
+			}
+			// Math channels
+			else {
+				// Only calculated again if one of the used channels has changed
+				for(int index = 0; index < mathExpression->channels().count(); index++)
+					expressionChanged |= changed[mathExpression->channels()[index]];
+				changed[channel] = changed[channel] || expressionChanged;
+				
+				// Calculate the values block by block and write them into the sample buffer
+				if(changed[channel]) {
+					QList<const double *> inputs;
+					for(unsigned int sourceChannel = 0; sourceChannel < this->settings->scope.physicalChannels; sourceChannel++)
+						inputs.append(this->analyzedData[sourceChannel]->samples.voltage.sample);
+					mathExpression->evaluate(inputs, size, this->analyzedData[channel]->samples.voltage.interval, this->analyzedData[channel]->samples.voltage.sample);
 				}
 			}
 		}
 		else {
 			// Clear unused channels
 			this->analyzedData[channel]->samples.voltage.count = 0;
-			this->analyzedData[this->settings->scope.physicalChannels]->samples.voltage.interval = 0;
+			this->analyzedData[channel]->samples.voltage.interval = 0;
+			this->analyzedData[channel]->harmonics.valid = false;
 			if(this->analyzedData[channel]->samples.voltage.sample) {
 				delete[] this->analyzedData[channel]->samples.voltage.sample;
 				this->analyzedData[channel]->samples.voltage.sample = 0;
 			}
 		}
+		
+		if(changed[channel])
+			this->computedProducts[channel] = 0;
 	}
 	
 	this->waitingDataMutex->unlock();
 	
+	// Decode the serial protocol, every record is decoded on its own
+	for(int channel = 0; channel < this->analyzedData.count(); channel++)
+		this->analyzedData[channel]->annotations.clear();
+	const DsoSettingsScopeDecoder &decoderSettings = this->settings->scope.decoder;
+	bool needsClock = decoderSettings.protocol != Dso::PROTOCOL_UART;
+	if(decoderSettings.protocol != Dso::PROTOCOL_OFF && decoderSettings.data < this->settings->scope.physicalChannels && decoderSettings.clock < this->settings->scope.physicalChannels && this->analyzedData[decoderSettings.data]->samples.voltage.sample && (!needsClock || this->analyzedData[decoderSettings.clock]->samples.voltage.sample)) {
+		const SampleValues &data = this->analyzedData[decoderSettings.data]->samples.voltage;
+		double samplerate = 1.0 / data.interval;
+		if(this->decoder && !this->decoder->isConfiguredFor(decoderSettings, samplerate)) {
+			delete this->decoder;
+			this->decoder = 0;
+		}
+		if(!this->decoder)
+			this->decoder = ProtocolDecoder::create(decoderSettings, samplerate);
+		
+		if(this->decoder) {
+			this->decoder->reset();
+			this->decoderData.threshold(data.sample, data.count, decoderSettings.threshold);
+			if(needsClock) {
+				const SampleValues &clock = this->analyzedData[decoderSettings.clock]->samples.voltage;
+				this->decoderClock.threshold(clock.sample, clock.count, decoderSettings.threshold);
+			}
+			this->decoder->decode(this->decoderData, this->decoderClock);
+			this->analyzedData[decoderSettings.data]->annotations = this->decoder->annotations();
+		}
+	}
+	
+	// Test the frame against the mask
+	for(int channel = 0; channel < this->analyzedData.count(); channel++)
+		this->analyzedData[channel]->maskViolations.clear();
+	const DsoSettingsScopeMask &maskSettings = this->settings->scope.mask;
+	if(maskSettings.enabled && maskSettings.channel < (unsigned int) this->analyzedData.count() && this->analyzedData[maskSettings.channel]->samples.voltage.sample) {
+		const SampleValues &voltage = this->analyzedData[maskSettings.channel]->samples.voltage;
+		if(this->mask->prepare(maskSettings, voltage.count, voltage.interval)) {
+			unsigned int violations = this->mask->test(voltage.sample, voltage.count, &this->analyzedData[maskSettings.channel]->maskViolations);
+			if(violations)
+				emit(maskFailed(violations));
+		}
+	}
+	
 	// Lower priority for spectrum calculation
 	this->setPriority(QThread::LowPriority);
 	
+	// The cached spectrums are only valid for the same spectrum settings
+	double lowFrequency = (qMin(this->settings->scope.horizontal.marker[0], this->settings->scope.horizontal.marker[1]) + DIVS_TIME / 2) * this->settings->scope.horizontal.frequencybase;
+	double highFrequency = (qMax(this->settings->scope.horizontal.marker[0], this->settings->scope.horizontal.marker[1]) + DIVS_TIME / 2) * this->settings->scope.horizontal.frequencybase;
+	bool zoomSpectrum = this->settings->scope.spectrumZoom && this->settings->view.zoom;
+	if(this->settings->scope.spectrumWindow != this->analysisWindow) {
+		// The window affects the autocorrelation too
+		this->analysisWindow = this->settings->scope.spectrumWindow;
+		for(int channel = 0; channel < this->computedProducts.count(); channel++)
+			this->computedProducts[channel] &= ~(ANALYSIS_FREQUENCY | ANALYSIS_SPECTRUM | ANALYSIS_HARMONICS);
+	}
+	if(this->settings->scope.spectrumReference != this->analysisReference || this->settings->scope.spectrumLimit != this->analysisLimit || this->settings->scope.spectrumPrecise != this->analysisPrecise || zoomSpectrum != this->analysisZoom || (zoomSpectrum && (lowFrequency != this->analysisLowFrequency || highFrequency != this->analysisHighFrequency))) {
+		this->analysisReference = this->settings->scope.spectrumReference;
+		this->analysisLimit = this->settings->scope.spectrumLimit;
+		this->analysisPrecise = this->settings->scope.spectrumPrecise;
+		this->analysisZoom = zoomSpectrum;
+		this->analysisLowFrequency = lowFrequency;
+		this->analysisHighFrequency = highFrequency;
+		for(int channel = 0; channel < this->computedProducts.count(); channel++)
+			this->computedProducts[channel] &= ~ANALYSIS_SPECTRUM;
+	}
 	
-	// Calculate frequencies, peak-to-peak voltages and spectrums
+	// Calculate frequencies, peak-to-peak voltages, spectrums and distortions that are needed and not cached
 	for(int channel = 0; channel < this->analyzedData.count(); channel++) {
 		if(this->analyzedData[channel]->samples.voltage.sample) {
-			// Calculate new window
-			if(this->lastWindow != this->settings->scope.spectrumWindow || this->lastBufferSize != this->analyzedData[channel]->samples.voltage.count) {
-				if(this->lastBufferSize != this->analyzedData[channel]->samples.voltage.count) {
-					this->lastBufferSize = this->analyzedData[channel]->samples.voltage.count;
+			SampleValues *voltage = &(this->analyzedData[channel]->samples.voltage);
+			SampleValues *spectrum = &(this->analyzedData[channel]->samples.spectrum);
+			int missing = neededProducts[channel] & ~this->computedProducts[channel];
+			
+			// Calculate peak-to-peak voltage
+			if(missing & ANALYSIS_AMPLITUDE) {
+				double minimalVoltage, maximalVoltage;
+				minimalVoltage = maximalVoltage = voltage->sample[0];
+				
+				for(unsigned int position = 1; position < voltage->count; position++) {
+					if(voltage->sample[position] < minimalVoltage)
+						minimalVoltage = voltage->sample[position];
+					else if(voltage->sample[position] > maximalVoltage)
+						maximalVoltage = voltage->sample[position];
+				}
+				
+				this->analyzedData[channel]->amplitude = maximalVoltage - minimalVoltage;
+				this->computedProducts[channel] |= ANALYSIS_AMPLITUDE;
+			}
+			
+			// Frequency, spectrum and distortion share the transformation of the windowed samples
+			if(missing & (ANALYSIS_FREQUENCY | ANALYSIS_SPECTRUM | ANALYSIS_HARMONICS)) {
+				// Calculate new window
+				if(this->lastWindow != this->settings->scope.spectrumWindow || this->lastBufferSize != voltage->count) {
+					if(this->lastBufferSize != voltage->count) {
+						this->lastBufferSize = voltage->count;
+						
+						if(this->window)
+							fftw_free(this->window);
+						this->window = (double *) fftw_malloc(sizeof(double) * this->lastBufferSize);
+					}
 					
-					if(this->window)
-						fftw_free(this->window);
-					this->window = (double *) fftw_malloc(sizeof(double) * this->lastBufferSize);
+					this->lastWindow = this->settings->scope.spectrumWindow;
+					DataAnalyzer::calculateWindow(this->lastWindow, this->window, this->lastBufferSize);
 				}
 				
-				unsigned int windowEnd = this->lastBufferSize - 1;
-				this->lastWindow = this->settings->scope.spectrumWindow;
+				// Plan the transformations once for each buffer size
+				/// \todo Check if buffer size is multiple of 2
+				if(this->fftSize != voltage->count)
+					this->planTransforms(voltage->count);
+				
+				// Apply window and do discrete real to half-complex transformation
+				for(unsigned int position = 0; position < voltage->count; position++)
+					this->fftInput[position] = this->window[position] * voltage->sample[position];
+				fftw_execute(this->fftForwardPlan);
 				
-				switch(this->settings->scope.spectrumWindow) {
-					case Dso::WINDOW_HAMMING:
-						for(unsigned int windowPosition = 0; windowPosition < this->lastBufferSize; windowPosition++)
-							*(this->window + windowPosition) = 0.54 - 0.46 * cos(2.0 * M_PI * windowPosition / windowEnd);
-						break;
-					case Dso::WINDOW_HANN:
-						for(unsigned int windowPosition = 0; windowPosition < this->lastBufferSize; windowPosition++)
-							*(this->window + windowPosition) = 0.5 * (1.0 - cos(2.0 * M_PI * windowPosition / windowEnd));
-						break;
-					case Dso::WINDOW_COSINE:
-						for(unsigned int windowPosition = 0; windowPosition < this->lastBufferSize; windowPosition++)
-							*(this->window + windowPosition) = sin(M_PI * windowPosition / windowEnd);
-						break;
-					case Dso::WINDOW_LANCZOS:
-						for(unsigned int windowPosition = 0; windowPosition < this->lastBufferSize; windowPosition++) {
-							double sincParameter = (2.0 * windowPosition / windowEnd - 1.0) * M_PI;
-							if(sincParameter == 0)
-								*(this->window + windowPosition) = 1;
-							else
-								*(this->window + windowPosition) = sin(sincParameter) / sincParameter;
+				// Number of real/complex samples
+				unsigned int dftLength = voltage->count / 2;
+				
+				if(missing & ANALYSIS_HARMONICS) {
+					// The distortion figures come from the same spectrum
+					this->harmonicAnalysis.analyze(this->fftOutput, voltage->count, 1.0 / voltage->interval, this->settings->scope.spectrumWindow, &this->analyzedData[channel]->harmonics);
+					this->computedProducts[channel] |= ANALYSIS_HARMONICS;
+				}
+				
+				if(missing & ANALYSIS_FREQUENCY) {
+					// Do an autocorrelation to get the frequency of the signal
+					double *conjugateComplex = this->fftInput; // Reuse the input buffer
+					
+					// Real values
+					unsigned int position;
+					double correctionFactor = 1.0 / dftLength / dftLength;
+					conjugateComplex[0] = (this->fftOutput[0] * this->fftOutput[0]) * correctionFactor;
+					for(position = 1; position < dftLength; position++)
+						conjugateComplex[position] = (this->fftOutput[position] * this->fftOutput[position] + this->fftOutput[voltage->count - position] * this->fftOutput[voltage->count - position]) * correctionFactor;
+					// Complex values, all zero for autocorrelation
+					conjugateComplex[dftLength] = (this->fftOutput[dftLength] * this->fftOutput[dftLength]) * correctionFactor;
+					for(position++; position < voltage->count; position++)
+						conjugateComplex[position] = 0;
+					
+					// Do half-complex to real inverse transformation
+					fftw_execute(this->fftBackwardPlan);
+					double *correlation = this->fftCorrelation;
+					
+					// Get the frequency from the correlation results
+					double minimumCorrelation = correlation[0];
+					double peakCorrelation = 0;
+					unsigned int peakPosition = 0;
+					
+					for(unsigned int position = 1; position < voltage->count / 2; position++) {
+						if(correlation[position] > peakCorrelation && correlation[position] > minimumCorrelation * 2) {
+							peakCorrelation = correlation[position];
+							peakPosition = position;
 						}
-						break;
-					case Dso::WINDOW_BARTLETT:
-						for(unsigned int windowPosition = 0; windowPosition < this->lastBufferSize; windowPosition++)
-							*(this->window + windowPosition) = 2.0 / windowEnd * (windowEnd / 2 - abs((int)(windowPosition - windowEnd / 2)));
-						break;
-					case Dso::WINDOW_TRIANGULAR:
-						for(unsigned int windowPosition = 0; windowPosition < this->lastBufferSize; windowPosition++)
-							*(this->window + windowPosition) = 2.0 / this->lastBufferSize * (this->lastBufferSize / 2 - abs((int)(windowPosition - windowEnd / 2)));
-						break;
-					case Dso::WINDOW_GAUSS:
-						{
-							double sigma = 0.4;
-							for(unsigned int windowPosition = 0; windowPosition < this->lastBufferSize; windowPosition++)
-								*(this->window + windowPosition) = exp(-0.5 * pow(((windowPosition - windowEnd / 2) / (sigma * windowEnd / 2)), 2));
+						else if(correlation[position] < minimumCorrelation)
+							minimumCorrelation = correlation[position];
+					}
+					
+					// Calculate the frequency in Hz
+					if(peakPosition)
+						this->analyzedData[channel]->frequency = 1.0 / (voltage->interval * peakPosition);
+					else
+						this->analyzedData[channel]->frequency = 0;
+					this->computedProducts[channel] |= ANALYSIS_FREQUENCY;
+				}
+				
+				if(missing & ANALYSIS_SPECTRUM) {
+					// Set sampling interval
+					spectrum->interval = 1.0 / voltage->interval / voltage->count;
+					
+					// Reallocate memory for samples if the sample count has changed
+					if(spectrum->count != dftLength || !spectrum->sample) {
+						spectrum->count = dftLength;
+						if(spectrum->sample)
+							delete[] spectrum->sample;
+						spectrum->sample = new double[dftLength];
+					}
+					
+					// Convert values into dB (Relative to the reference level)
+					double offset = 60 - this->settings->scope.spectrumReference - 20 * log10(dftLength);
+					double offsetLimit = this->settings->scope.spectrumLimit - this->settings->scope.spectrumReference;
+					Decibel::fromMagnitude(this->fftOutput, spectrum->sample, spectrum->count, offset, offsetLimit, this->settings->scope.spectrumPrecise);
+					
+					// Calculate the narrowband spectrum between the markers for the zoomed scope
+					SampleValues *zoomSpectrumValues = &(this->analyzedData[channel]->samples.zoomSpectrum);
+					if(zoomSpectrum && this->zoomFft->configure(voltage->count, 1.0 / voltage->interval, lowFrequency, highFrequency)) {
+						// Calculate new window for the decimated samples
+						if(this->lastZoomWindow != this->settings->scope.spectrumWindow || this->lastZoomWindowSize != this->zoomFft->decimatedCount()) {
+							if(this->lastZoomWindowSize != this->zoomFft->decimatedCount()) {
+								this->lastZoomWindowSize = this->zoomFft->decimatedCount();
+								
+								if(this->zoomWindow)
+									delete[] this->zoomWindow;
+								this->zoomWindow = new double[this->lastZoomWindowSize];
+							}
+							
+							this->lastZoomWindow = this->settings->scope.spectrumWindow;
+							DataAnalyzer::calculateWindow(this->lastZoomWindow, this->zoomWindow, this->lastZoomWindowSize);
 						}
-						break;
-					case Dso::WINDOW_BARTLETTHANN:
-						for(unsigned int windowPosition = 0; windowPosition < this->lastBufferSize; windowPosition++)
-							*(this->window + windowPosition) = 0.62 - 0.48 * abs(windowPosition / windowEnd - 0.5) - 0.38 * cos(2.0 * M_PI * windowPosition / windowEnd);
-						break;
-					case Dso::WINDOW_BLACKMAN:
-						{
-							double alpha = 0.16;
-							for(unsigned int windowPosition = 0; windowPosition < this->lastBufferSize; windowPosition++)
-								*(this->window + windowPosition) = (1 - alpha) / 2 - 0.5 * cos(2.0 * M_PI * windowPosition / windowEnd) + alpha / 2 * cos(4.0 * M_PI * windowPosition / windowEnd);
+						
+						// Reallocate memory for samples if the bin count has changed
+						if(zoomSpectrumValues->count != this->zoomFft->binCount() || !zoomSpectrumValues->sample) {
+							zoomSpectrumValues->count = this->zoomFft->binCount();
+							if(zoomSpectrumValues->sample)
+								delete[] zoomSpectrumValues->sample;
+							zoomSpectrumValues->sample = new double[zoomSpectrumValues->count];
 						}
-						break;
-					//case WINDOW_KAISER:
-						// TODO
-						//double alpha = 3.0;
-						//for(unsigned int windowPosition = 0; windowPosition < this->lastBufferSize; windowPosition++)
-							//*(this->window + windowPosition) = ;
-						//break;
-					case Dso::WINDOW_NUTTALL:
-						for(unsigned int windowPosition = 0; windowPosition < this->lastBufferSize; windowPosition++)
-							*(this->window + windowPosition) = 0.355768 - 0.487396 * cos(2 * M_PI * windowPosition / windowEnd) + 0.144232 * cos(4 * M_PI * windowPosition / windowEnd) - 0.012604 * cos(6 * M_PI * windowPosition / windowEnd);
-						break;
-					case Dso::WINDOW_BLACKMANHARRIS:
-						for(unsigned int windowPosition = 0; windowPosition < this->lastBufferSize; windowPosition++)
-							*(this->window + windowPosition) = 0.35875 - 0.48829 * cos(2 * M_PI * windowPosition / windowEnd) + 0.14128 * cos(4 * M_PI * windowPosition / windowEnd) - 0.01168 * cos(6 * M_PI * windowPosition / windowEnd);
-						break;
-					case Dso::WINDOW_BLACKMANNUTTALL:
-						for(unsigned int windowPosition = 0; windowPosition < this->lastBufferSize; windowPosition++)
-							*(this->window + windowPosition) = 0.3635819 - 0.4891775 * cos(2 * M_PI * windowPosition / windowEnd) + 0.1365995 * cos(4 * M_PI * windowPosition / windowEnd) - 0.0106411 * cos(6 * M_PI * windowPosition / windowEnd);
-						break;
-					case Dso::WINDOW_FLATTOP:
-						for(unsigned int windowPosition = 0; windowPosition < this->lastBufferSize; windowPosition++)
-							*(this->window + windowPosition) = 1.0 - 1.93 * cos(2 * M_PI * windowPosition / windowEnd) + 1.29 * cos(4 * M_PI * windowPosition / windowEnd) - 0.388 * cos(6 * M_PI * windowPosition / windowEnd) + 0.032 * cos(8 * M_PI * windowPosition / windowEnd);
-						break;
-					default: // Dso::WINDOW_RECTANGULAR
-						for(unsigned int windowPosition = 0; windowPosition < this->lastBufferSize; windowPosition++)
-							*(this->window + windowPosition) = 1.0;
-				}
-			}
-			
-			// Set sampling interval
-			this->analyzedData[channel]->samples.spectrum.interval = 1.0 / this->analyzedData[channel]->samples.voltage.interval / this->analyzedData[channel]->samples.voltage.count;
-			
-			// Number of real/complex samples
-			unsigned int dftLength = this->analyzedData[channel]->samples.voltage.count / 2;
-			
-			// Reallocate memory for samples if the sample count has changed
-			if(this->analyzedData[channel]->samples.spectrum.count != dftLength) {
-				this->analyzedData[channel]->samples.spectrum.count = dftLength;
-				if(this->analyzedData[channel]->samples.spectrum.sample)
-					delete[] this->analyzedData[channel]->samples.spectrum.sample;
-				this->analyzedData[channel]->samples.spectrum.sample = new double[this->analyzedData[channel]->samples.voltage.count];
-			}
-			
-			// Create sample buffer and apply window
-			double *windowedValues = new double[this->analyzedData[channel]->samples.voltage.count];
-			for(unsigned int position = 0; position < this->analyzedData[channel]->samples.voltage.count; position++)
-				windowedValues[position] = this->window[position] * this->analyzedData[channel]->samples.voltage.sample[position];
-			
-			// Do discrete real to half-complex transformation
-			/// \todo Check if buffer size is multiple of 2
-			/// \todo Reuse plan and use FFTW_MEASURE to get fastest algorithm
-			fftw_plan fftPlan = fftw_plan_r2r_1d(this->analyzedData[channel]->samples.voltage.count, windowedValues, this->analyzedData[channel]->samples.spectrum.sample, FFTW_R2HC, FFTW_ESTIMATE);
-			fftw_execute(fftPlan);
-			fftw_destroy_plan(fftPlan);
-			
-			// Do an autocorrelation to get the frequency of the signal
-			double *conjugateComplex = windowedValues; // Reuse the windowedValues buffer
-			
-			// Real values
-			unsigned int position;
-			double correctionFactor = 1.0 / dftLength / dftLength;
-			conjugateComplex[0] = (this->analyzedData[channel]->samples.spectrum.sample[0] * this->analyzedData[channel]->samples.spectrum.sample[0]) * correctionFactor;
-			for(position = 1; position < dftLength; position++)
-				conjugateComplex[position] = (this->analyzedData[channel]->samples.spectrum.sample[position] * this->analyzedData[channel]->samples.spectrum.sample[position] + this->analyzedData[channel]->samples.spectrum.sample[this->analyzedData[channel]->samples.voltage.count - position] * this->analyzedData[channel]->samples.spectrum.sample[this->analyzedData[channel]->samples.voltage.count - position]) * correctionFactor;
-			// Complex values, all zero for autocorrelation
-			conjugateComplex[dftLength] = (this->analyzedData[channel]->samples.spectrum.sample[dftLength] * this->analyzedData[channel]->samples.spectrum.sample[dftLength]) * correctionFactor;
-			for(position++; position < this->analyzedData[channel]->samples.voltage.count; position++)
-				conjugateComplex[position] = 0;
-			
-			// Do half-complex to real inverse transformation
-			double *correlation = new double[this->analyzedData[channel]->samples.voltage.count];
-			fftPlan = fftw_plan_r2r_1d(this->analyzedData[channel]->samples.voltage.count, conjugateComplex, correlation, FFTW_HC2R, FFTW_ESTIMATE);
-			fftw_execute(fftPlan);
-			fftw_destroy_plan(fftPlan);
-			delete[] conjugateComplex;
-			
-			// Calculate peak-to-peak voltage
-			double minimalVoltage, maximalVoltage;
-			minimalVoltage = maximalVoltage = this->analyzedData[channel]->samples.voltage.sample[0];
-			
-			for(unsigned int position = 1; position < this->analyzedData[channel]->samples.voltage.count; position++) {
-				if(this->analyzedData[channel]->samples.voltage.sample[position] < minimalVoltage)
-					minimalVoltage = this->analyzedData[channel]->samples.voltage.sample[position];
-				else if(this->analyzedData[channel]->samples.voltage.sample[position] > maximalVoltage)
-					maximalVoltage = this->analyzedData[channel]->samples.voltage.sample[position];
-			}
-			
-			this->analyzedData[channel]->amplitude = maximalVoltage - minimalVoltage;
-			
-			// Get the frequency from the correlation results
-			double minimumCorrelation = correlation[0];
-			double peakCorrelation = 0;
-			unsigned int peakPosition = 0;
-			
-			for(unsigned int position = 1; position < this->analyzedData[channel]->samples.voltage.count / 2; position++) {
-				if(correlation[position] > peakCorrelation && correlation[position] > minimumCorrelation * 2) {
-					peakCorrelation = correlation[position];
-					peakPosition = position;
+						zoomSpectrumValues->interval = this->zoomFft->frequencyInterval();
+						this->analyzedData[channel]->zoomSpectrumStart = this->zoomFft->firstFrequency();
+						
+						// Same reference as the main spectrum, the power is normalized to the decimated length
+						double zoomOffset = 60 - this->settings->scope.spectrumReference - 20 * log10(this->zoomFft->decimatedCount() / 2.0);
+						this->zoomFft->process(voltage->sample, this->zoomWindow, zoomSpectrumValues->sample, zoomOffset, offsetLimit, this->settings->scope.spectrumPrecise);
+					}
+					else
+						zoomSpectrumValues->count = 0;
+					this->computedProducts[channel] |= ANALYSIS_SPECTRUM;
 				}
-				else if(correlation[position] < minimumCorrelation)
-					minimumCorrelation = correlation[position];
 			}
-			delete[] correlation;
 			
-			// Calculate the frequency in Hz
-			if(peakPosition)
-				this->analyzedData[channel]->frequency = 1.0 / (this->analyzedData[channel]->samples.voltage.interval * peakPosition);
-			else
+			// Values nobody needs aren't valid for these samples
+			if(!(this->computedProducts[channel] & ANALYSIS_AMPLITUDE))
+				this->analyzedData[channel]->amplitude = 0;
+			if(!(this->computedProducts[channel] & ANALYSIS_FREQUENCY))
 				this->analyzedData[channel]->frequency = 0;
-			
-			// Finally calculate the real spectrum if we want it
-			if(this->settings->scope.spectrum[channel].used) {
-				// Convert values into dB (Relative to the reference level)
-				double offset = 60 - this->settings->scope.spectrumReference - 20 * log10(dftLength);
-				double offsetLimit = this->settings->scope.spectrumLimit - this->settings->scope.spectrumReference;
-				for(unsigned int position = 0; position < this->analyzedData[channel]->samples.spectrum.count; position++) {
-					this->analyzedData[channel]->samples.spectrum.sample[position] = 20 * log10(fabs(this->analyzedData[channel]->samples.spectrum.sample[position])) + offset;
-					
-					// Check if this value has to be limited
-					if(offsetLimit > this->analyzedData[channel]->samples.spectrum.sample[position])
-						this->analyzedData[channel]->samples.spectrum.sample[position] = offsetLimit;
-				}
+			if(!(this->computedProducts[channel] & ANALYSIS_HARMONICS))
+				this->analyzedData[channel]->harmonics.valid = false;
+			if(!(this->computedProducts[channel] & ANALYSIS_SPECTRUM)) {
+				spectrum->count = 0;
+				this->analyzedData[channel]->samples.zoomSpectrum.count = 0;
 			}
 		}
 		else if(this->analyzedData[channel]->samples.spectrum.sample) {
@@ -378,6 +654,53 @@ void DataAnalyzer::run() {
 			this->analyzedData[channel]->samples.spectrum.interval = 0;
 			delete[] this->analyzedData[channel]->samples.spectrum.sample;
 			this->analyzedData[channel]->samples.spectrum.sample = 0;
+			this->analyzedData[channel]->samples.zoomSpectrum.count = 0;
+		}
+	}
+	
+	// Append the newest row to the waterfall, the history is kept while the channel and samplerate stay the same
+	unsigned int spectrogramChannel = this->settings->view.spectrogramChannel;
+	if(this->settings->view.spectrogram && spectrogramChannel < (unsigned int) this->analyzedData.count() && this->analyzedData[spectrogramChannel]->samples.voltage.sample) {
+		const SampleValues &voltage = this->analyzedData[spectrogramChannel]->samples.voltage;
+		if(spectrogramChannel != this->lastSpectrogramChannel || voltage.interval != this->lastSpectrogramInterval) {
+			this->lastSpectrogramChannel = spectrogramChannel;
+			this->lastSpectrogramInterval = voltage.interval;
+			this->spectrogramRows->clear();
+		}
+		
+		// The colors cover the same range as the spectrum graph of the channel
+		const DsoSettingsScopeSpectrum &spectrumSettings = this->settings->scope.spectrum[spectrogramChannel];
+		double minimum = (-DIVS_VOLTAGE / 2 - spectrumSettings.offset) * spectrumSettings.magnitude;
+		double maximum = (DIVS_VOLTAGE / 2 - spectrumSettings.offset) * spectrumSettings.magnitude;
+		this->spectrogramRows->append(voltage.sample, voltage.count, this->settings->scope.spectrumWindow, 60 - this->settings->scope.spectrumReference, minimum, maximum, this->settings->scope.spectrumPrecise);
+	}
+	
+	// Compare the channels with the reference, its spectrum is transformed once for all of them
+	unsigned int reference = this->settings->scope.phase.reference;
+	if(reference != this->analysisDelayReference || ((int) reference < changed.count() && changed[reference])) {
+		this->analysisDelayReference = reference;
+		for(int channel = 0; channel < this->computedProducts.count(); channel++)
+			this->computedProducts[channel] &= ~ANALYSIS_DELAY;
+	}
+	const SampleValues *referenceVoltage = (reference < (unsigned int) this->analyzedData.count()) ? &(this->analyzedData[reference]->samples.voltage) : 0;
+	bool referenceTransformed = false;
+	for(int channel = 0; channel < this->analyzedData.count(); channel++) {
+		AnalyzedData *channelData = this->analyzedData[channel];
+		const SampleValues *voltage = &(channelData->samples.voltage);
+		
+		if((neededProducts[channel] & ~this->computedProducts[channel] & ANALYSIS_DELAY) && (unsigned int) channel != reference && referenceVoltage && referenceVoltage->sample && voltage->sample && voltage->count == referenceVoltage->count && voltage->interval == referenceVoltage->interval) {
+			channelData->delay = this->crossCorrelate(referenceVoltage, voltage, referenceTransformed);
+			referenceTransformed = true;
+			
+			// The phase is wrapped into one period of the reference
+			double periods = -channelData->delay * this->analyzedData[reference]->frequency;
+			channelData->phase = 360 * (periods - floor(periods + 0.5));
+			this->computedProducts[channel] |= ANALYSIS_DELAY;
+		}
+		
+		if(!(this->computedProducts[channel] & ANALYSIS_DELAY)) {
+			channelData->delay = 0;
+			channelData->phase = 0;
 		}
 	}
 	
@@ -387,6 +710,109 @@ void DataAnalyzer::run() {
 	this->analyzedDataMutex->unlock();
 }
 
+/// \brief Declares the values a consumer needs for a channel.
+/// Values no consumer needs aren't calculated.
+/// \param consumer The part of the program that uses the values.
+/// \param channel The channel the values are calculated for.
+/// \param products The needed values, a combination of AnalysisProduct flags.
+void DataAnalyzer::setDemand(AnalysisConsumer consumer, unsigned int channel, int products) {
+	this->demandMutex->lock();
+	while((unsigned int) this->demand[consumer].count() <= channel)
+		this->demand[consumer].append(0);
+	this->demand[consumer][channel] = products;
+	this->demandMutex->unlock();
+}
+
+/// \brief Creates the plans and buffers for the transformations of a buffer size.
+/// \param size The number of samples.
+void DataAnalyzer::planTransforms(unsigned int size) {
+	if(this->fftSize) {
+		fftw_destroy_plan(this->fftForwardPlan);
+		fftw_destroy_plan(this->fftBackwardPlan);
+		fftw_free(this->fftInput);
+		fftw_free(this->fftOutput);
+		fftw_free(this->fftCorrelation);
+		fftw_free(this->fftReference);
+	}
+	
+	// The plans are kept, so measuring the fastest algorithm pays off
+	this->fftSize = size;
+	this->fftInput = (double *) fftw_malloc(sizeof(double) * size);
+	this->fftOutput = (double *) fftw_malloc(sizeof(double) * size);
+	this->fftCorrelation = (double *) fftw_malloc(sizeof(double) * size);
+	this->fftReference = (double *) fftw_malloc(sizeof(double) * size);
+	this->fftForwardPlan = fftw_plan_r2r_1d(size, this->fftInput, this->fftOutput, FFTW_R2HC, FFTW_MEASURE);
+	this->fftBackwardPlan = fftw_plan_r2r_1d(size, this->fftInput, this->fftCorrelation, FFTW_HC2R, FFTW_MEASURE);
+}
+
+/// \brief Transforms samples without window and without their mean value.
+/// \param voltage The samples, their count has to be the planned size.
+void DataAnalyzer::transformUnwindowed(const SampleValues *voltage) {
+	double mean = 0;
+	for(unsigned int position = 0; position < voltage->count; position++)
+		mean += voltage->sample[position];
+	mean /= voltage->count;
+	
+	for(unsigned int position = 0; position < voltage->count; position++)
+		this->fftInput[position] = voltage->sample[position] - mean;
+	fftw_execute(this->fftForwardPlan);
+}
+
+/// \brief Measures the delay of a channel with a cross-correlation.
+/// The cross spectrum is transformed back with the plan of the autocorrelation,
+/// the peak of the correlation is interpolated with a parabola.
+/// \param reference The samples of the reference channel.
+/// \param voltage The samples of the compared channel with the same count and interval.
+/// \param referenceTransformed true if fftReference already holds the reference spectrum.
+/// \return The delay of the channel against the reference in s.
+double DataAnalyzer::crossCorrelate(const SampleValues *reference, const SampleValues *voltage, bool referenceTransformed) {
+	unsigned int size = voltage->count;
+	if(size < 3)
+		return 0;
+	
+	if(this->fftSize != size) {
+		this->planTransforms(size);
+		referenceTransformed = false;
+	}
+	if(!referenceTransformed) {
+		this->transformUnwindowed(reference);
+		memcpy(this->fftReference, this->fftOutput, sizeof(double) * size);
+	}
+	this->transformUnwindowed(voltage);
+	
+	// Multiply with the conjugate complex reference spectrum
+	double *crossSpectrum = this->fftInput; // Reuse the input buffer
+	crossSpectrum[0] = this->fftOutput[0] * this->fftReference[0];
+	for(unsigned int position = 1; position < (size + 1) / 2; position++) {
+		double real = this->fftOutput[position];
+		double imaginary = this->fftOutput[size - position];
+		crossSpectrum[position] = real * this->fftReference[position] + imaginary * this->fftReference[size - position];
+		crossSpectrum[size - position] = imaginary * this->fftReference[position] - real * this->fftReference[size - position];
+	}
+	if(size % 2 == 0)
+		crossSpectrum[size / 2] = this->fftOutput[size / 2] * this->fftReference[size / 2];
+	fftw_execute(this->fftBackwardPlan);
+	
+	// The second half of the correlation holds the negative lags
+	double *correlation = this->fftCorrelation;
+	unsigned int peakPosition = 0;
+	for(unsigned int position = 1; position < size; position++) {
+		if(correlation[position] > correlation[peakPosition])
+			peakPosition = position;
+	}
+	
+	double left = correlation[(peakPosition + size - 1) % size];
+	double right = correlation[(peakPosition + 1) % size];
+	double curvature = 2 * correlation[peakPosition] - left - right;
+	double lag = peakPosition;
+	if(curvature > 0)
+		lag += qBound(-0.5, (right - left) / (2 * curvature), 0.5);
+	if(lag >= size / 2.0)
+		lag -= size;
+	
+	return lag * voltage->interval;
+}
+
 /// \brief Starts the analyzing of new input data.
 /// \param data The data arrays with the input data.
 /// \param size The sizes of the data arrays.
@@ -407,3 +833,59 @@ void DataAnalyzer::analyze(const QList<double *> *data, const QList<unsigned int
 	this->waitingDataSamplerate = samplerate;
 	this->start();
 }
+
+
+////////////////////////////////////////////////////////////////////////////////
+// class AnalyzedFrame
+/// \brief Copies the analyzed data, the analyzer has to be locked meanwhile.
+/// \param analyzedData The analyzed data of all channels.
+/// \param sampleCount The maximum sample count of the data.
+AnalyzedFrame::AnalyzedFrame(const QList<AnalyzedData *> &analyzedData, unsigned long int sampleCount) {
+	this->samples = sampleCount;
+	
+	for(int channel = 0; channel < analyzedData.count(); channel++) {
+		AnalyzedData *channelData = new AnalyzedData(*analyzedData[channel]);
+		
+		// The sample arrays belong to the analyzer, the frame needs its own
+		SampleValues *values[] = {&(channelData->samples.voltage), &(channelData->samples.spectrum), &(channelData->samples.zoomSpectrum)};
+		for(unsigned int array = 0; array < sizeof(values) / sizeof(values[0]); array++) {
+			if(!values[array]->sample)
+				continue;
+			
+			double *sample = new double[values[array]->count];
+			memcpy(sample, values[array]->sample, values[array]->count * sizeof(double));
+			values[array]->sample = sample;
+		}
+		
+		this->analyzedData.append(channelData);
+	}
+}
+
+/// \brief Deallocates the copied sample arrays.
+AnalyzedFrame::~AnalyzedFrame() {
+	for(int channel = 0; channel < this->analyzedData.count(); channel++) {
+		if(this->analyzedData[channel]->samples.voltage.sample)
+			delete[] this->analyzedData[channel]->samples.voltage.sample;
+		if(this->analyzedData[channel]->samples.spectrum.sample)
+			delete[] this->analyzedData[channel]->samples.spectrum.sample;
+		if(this->analyzedData[channel]->samples.zoomSpectrum.sample)
+			delete[] this->analyzedData[channel]->samples.zoomSpectrum.sample;
+		delete this->analyzedData[channel];
+	}
+}
+
+/// \brief Returns the copied data.
+/// \param channel Channel, whose data should be returned.
+/// \return Analyzed data as AnalyzedData struct, 0 if there is no such channel.
+const AnalyzedData *AnalyzedFrame::data(int channel) const {
+	if(channel < 0 || channel >= this->analyzedData.count())
+		return 0;
+	
+	return this->analyzedData[channel];
+}
+
+/// \brief Returns the sample count of the copied data.
+/// \return The maximum sample count of the data.
+unsigned long int AnalyzedFrame::sampleCount() const {
+	return this->samples;
+}
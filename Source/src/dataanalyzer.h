@@ -27,17 +27,48 @@
 #define DATAANALYZER_H
 
 
+#include <QSharedPointer>
 #include <QThread>
+#include <QVector>
+
+#include <fftw3.h>
 
 
 #include "dso.h"
+#include "harmonicanalysis.h"
 #include "helper.h"
+#include "protocoldecoder.h"
 
 
+class DigitalFilter;
 class DsoSettings;
 class HantekDSOAThread;
+class MaskTest;
+class MathExpression;
 class QMutex;
+class Spectrogram;
+class ZoomFft;
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// \enum AnalysisProduct                                         dataanalyzer.h
+/// \brief The values that are only calculated if a consumer needs them.
+enum AnalysisProduct {
+	ANALYSIS_AMPLITUDE = 0x01,          ///< The peak-to-peak voltage
+	ANALYSIS_FREQUENCY = 0x02,          ///< The frequency from the autocorrelation
+	ANALYSIS_SPECTRUM = 0x04,           ///< The spectrum and the narrowband spectrum
+	ANALYSIS_HARMONICS = 0x08,          ///< THD, SNR, SINAD, ENOB and SFDR
+	ANALYSIS_DELAY = 0x10               ///< Delay and phase against the reference channel
+};
 
+////////////////////////////////////////////////////////////////////////////////
+/// \enum AnalysisConsumer                                        dataanalyzer.h
+/// \brief The parts of the program that declare which values they need.
+enum AnalysisConsumer {
+	CONSUMER_DISPLAY,                   ///< The scope screens and the data export
+	CONSUMER_MEASUREMENT,               ///< The measurement table and the printout
+	CONSUMER_COUNT                      ///< The total number of consumers
+};
 
 ////////////////////////////////////////////////////////////////////////////////
 /// \struct SampleValues                                          dataanalyzer.h
@@ -54,6 +85,7 @@ struct SampleValues {
 struct SampleData {
 	SampleValues voltage; ///< The time-domain voltage levels (V)
 	SampleValues spectrum; ///< The frequency-domain power levels (dB)
+	SampleValues zoomSpectrum; ///< The power levels between the markers (dB)
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -63,6 +95,33 @@ struct AnalyzedData {
 	SampleData samples; ///< Voltage and spectrum values
 	double frequency; ///< The frequency of the signal
 	double amplitude; ///< The amplitude of the signal
+	double zoomSpectrumStart; ///< The frequency of the first zoom spectrum value
+	HarmonicValues harmonics; ///< The distortion figures from the spectrum
+	double delay; ///< The delay against the reference channel (s)
+	double phase; ///< The phase against the reference channel, positive if leading (deg)
+	QList<ProtocolAnnotation> annotations; ///< The decoded words if this is the data channel
+	QVector<unsigned int> maskViolations; ///< The samples outside of the mask if this channel is tested
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \class AnalyzedFrame                                          dataanalyzer.h
+/// \brief A copy of the analyzed data of all channels.
+/// The frame owns its sample arrays, so it stays valid while the analyzer goes
+/// on with the next samples. It's passed around in a QSharedPointer and freed
+/// when the last consumer is done with it.
+class AnalyzedFrame {
+	public:
+		AnalyzedFrame(const QList<AnalyzedData *> &analyzedData, unsigned long int sampleCount);
+		~AnalyzedFrame();
+		
+		const AnalyzedData *data(int channel) const;
+		unsigned long int sampleCount() const;
+	
+	private:
+		Q_DISABLE_COPY(AnalyzedFrame)
+		
+		QList<AnalyzedData *> analyzedData; ///< The copied data for each channel
+		unsigned long int samples; ///< The maximum sample count of the data
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -80,9 +139,19 @@ class DataAnalyzer : public QThread {
 		const AnalyzedData *data(int channel) const;
 		unsigned long int sampleCount();
 		QMutex *mutex() const;
+		QSharedPointer<AnalyzedFrame> snapshot() const;
+		const MaskTest *maskTest() const;
+		void resetMaskTest();
+		const Spectrogram *spectrogram() const;
+		void setDemand(AnalysisConsumer consumer, unsigned int channel, int products);
+		
+		static void calculateWindow(Dso::WindowFunction windowFunction, double *window, unsigned int length);
 	
 	protected:
 		void run();
+		void planTransforms(unsigned int size);
+		void transformUnwindowed(const SampleValues *voltage);
+		double crossCorrelate(const SampleValues *reference, const SampleValues *voltage, bool referenceTransformed);
 		
 		DsoSettings *settings; ///< The settings provided by the parent class
 		
@@ -94,6 +163,46 @@ class DataAnalyzer : public QThread {
 		Dso::WindowFunction lastWindow; ///< The previously used dft window function
 		double *window; ///< The array for the dft window factors
 		
+		QList<int> demand[CONSUMER_COUNT]; ///< The products each consumer needs for each channel
+		QMutex *demandMutex; ///< A mutex for the demand of the consumers
+		QList<int> computedProducts; ///< The products that are valid for the current samples
+		Dso::WindowFunction analysisWindow; ///< The window function of the cached values
+		double analysisReference; ///< The reference level of the cached spectrums
+		double analysisLimit; ///< The minimum magnitude of the cached spectrums
+		bool analysisPrecise; ///< true if the cached spectrums use the exact logarithm
+		bool analysisZoom; ///< true if the cached spectrums include the narrowband spectrums
+		double analysisLowFrequency; ///< The start of the cached narrowband spectrums
+		double analysisHighFrequency; ///< The end of the cached narrowband spectrums
+		unsigned int analysisDelayReference; ///< The reference channel of the cached delays
+		
+		unsigned int fftSize; ///< The length of the planned transformations
+		double *fftInput; ///< The windowed samples, later the autocorrelation spectrum
+		double *fftOutput; ///< The half-complex spectrum
+		double *fftCorrelation; ///< The autocorrelation or cross-correlation
+		double *fftReference; ///< The unwindowed spectrum of the delay reference channel
+		fftw_plan fftForwardPlan; ///< The plan from fftInput to fftOutput
+		fftw_plan fftBackwardPlan; ///< The plan from fftInput to fftCorrelation
+		
+		QList<DigitalFilter *> filters; ///< The digital filters of the physical channels
+		QVector<double> filterOutput; ///< The filtered samples before they are compared and copied
+		QList<MathExpression *> mathExpressions; ///< The compiled formulas of the math channels
+		
+		ProtocolDecoder *decoder; ///< The serial protocol decoder
+		LogicBits decoderData; ///< The thresholded data channel
+		LogicBits decoderClock; ///< The thresholded clock channel
+		
+		MaskTest *mask; ///< The mask test with its counters
+		HarmonicAnalysis harmonicAnalysis; ///< The distortion measurement
+		
+		Spectrogram *spectrogramRows; ///< The waterfall of one channel
+		unsigned int lastSpectrogramChannel; ///< The channel of the rows in the spectrogram
+		double lastSpectrogramInterval; ///< The sample interval of the rows in the spectrogram
+		
+		ZoomFft *zoomFft; ///< The narrowband transform for the marker range
+		unsigned int lastZoomWindowSize; ///< The size of the previous zoom window
+		Dso::WindowFunction lastZoomWindow; ///< The previously used zoom window function
+		double *zoomWindow; ///< The array for the zoom window factors
+		
 		QList<double *> waitingData; ///< Pointer to input data from device
 		QList<unsigned int> waitingDataSize; ///< Number of input data samples
 		double waitingDataSamplerate; ///< The samplerate of the input data
@@ -104,6 +213,7 @@ class DataAnalyzer : public QThread {
 	
 	signals:
 		void analyzed(unsigned int samples); ///< The data with that much samples has been analyzed
+		void maskFailed(unsigned int violations); ///< A frame had samples outside of the mask
 };
 
 #endif
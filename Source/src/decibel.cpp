@@ -0,0 +1,139 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  OpenHantek
+//  decibel.cpp
+//
+//  This program is free software: you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation, either version 3 of the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <cmath>
+#include <cstring>
+
+#include <QtGlobal>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+
+#include "decibel.h"
+
+
+namespace Decibel {
+	/// \brief Calculates the approximated binary logarithm of a positive value.
+	/// The mantissa is normalized to [sqrt(0.5), sqrt(2)), the series of atanh()
+	/// converges quickly there. fastLog2Pair() does the same for two values.
+	/// \param value The value, the sign bit is ignored.
+	/// \return The binary logarithm of the absolute value.
+	static inline double fastLog2(double value) {
+		quint64 bits;
+		memcpy(&bits, &value, sizeof(bits));
+		bits &= 0x7fffffffffffffffULL;
+		
+		// The exponent relative to sqrt(0.5), taken from the upper word
+		qint32 exponent = (qint32) ((quint32) (bits >> 32) - 0x3fe6a09eU) >> 20;
+		bits -= (quint64) ((quint32) exponent << 20) << 32;
+		double mantissa;
+		memcpy(&mantissa, &bits, sizeof(mantissa));
+		
+		// ln(m) = 2 * atanh((m - 1) / (m + 1))
+		double t = (mantissa - 1) / (mantissa + 1);
+		double square = t * t;
+		double series = 1 + square * (1.0 / 3 + square * (1.0 / 5 + square * (1.0 / 7 + square * (1.0 / 9))));
+		
+		return exponent + t * series * (2 / M_LN2);
+	}
+	
+#ifdef __SSE2__
+	/// \brief Calculates the approximated binary logarithm of two values.
+	/// Gives the same results as fastLog2().
+	/// \param values The values, the sign bits are ignored.
+	/// \return The binary logarithms of the absolute values.
+	static inline __m128d fastLog2Pair(__m128d values) {
+		__m128i bits = _mm_and_si128(_mm_castpd_si128(values), _mm_set_epi32(0x7fffffff, 0xffffffff, 0x7fffffff, 0xffffffff));
+		
+		// The exponents relative to sqrt(0.5) end up in the lower words
+		__m128i exponent = _mm_srai_epi32(_mm_sub_epi32(_mm_srli_epi64(bits, 32), _mm_set1_epi32(0x3fe6a09e)), 20);
+		bits = _mm_sub_epi64(bits, _mm_slli_epi64(_mm_slli_epi32(exponent, 20), 32));
+		__m128d mantissa = _mm_castsi128_pd(bits);
+		
+		__m128d one = _mm_set1_pd(1);
+		__m128d t = _mm_div_pd(_mm_sub_pd(mantissa, one), _mm_add_pd(mantissa, one));
+		__m128d square = _mm_mul_pd(t, t);
+		__m128d series = _mm_add_pd(_mm_set1_pd(1.0 / 7), _mm_mul_pd(square, _mm_set1_pd(1.0 / 9)));
+		series = _mm_add_pd(_mm_set1_pd(1.0 / 5), _mm_mul_pd(square, series));
+		series = _mm_add_pd(_mm_set1_pd(1.0 / 3), _mm_mul_pd(square, series));
+		series = _mm_add_pd(one, _mm_mul_pd(square, series));
+		
+		__m128d exponents = _mm_cvtepi32_pd(_mm_shuffle_epi32(exponent, _MM_SHUFFLE(2, 0, 2, 0)));
+		return _mm_add_pd(exponents, _mm_mul_pd(_mm_mul_pd(t, series), _mm_set1_pd(2 / M_LN2)));
+	}
+#endif
+	
+	/// \brief Converts the values into dB, scale * log10(x) + offset.
+	/// \param input The values that should be converted.
+	/// \param output The array for the dB values, may be the input.
+	/// \param count The number of values.
+	/// \param scale 20 for magnitudes, 10 for powers.
+	/// \param offset The offset that is added to all dB values.
+	/// \param limit The minimum dB value.
+	/// \param precise true if log10() should be used.
+	static void convert(const double *input, double *output, unsigned int count, double scale, double offset, double limit, bool precise) {
+		if(precise) {
+			for(unsigned int position = 0; position < count; position++) {
+				double value = scale * log10(fabs(input[position])) + offset;
+				output[position] = (limit > value) ? limit : value;
+			}
+		}
+		else {
+			double factor = scale * M_LN2 / M_LN10;
+			unsigned int position = 0;
+#ifdef __SSE2__
+			__m128d factors = _mm_set1_pd(factor), offsets = _mm_set1_pd(offset), limits = _mm_set1_pd(limit);
+			for(; position + 2 <= count; position += 2) {
+				__m128d values = _mm_add_pd(_mm_mul_pd(factors, fastLog2Pair(_mm_loadu_pd(input + position))), offsets);
+				_mm_storeu_pd(output + position, _mm_max_pd(limits, values));
+			}
+#endif
+			for(; position < count; position++) {
+				double value = factor * fastLog2(input[position]) + offset;
+				output[position] = (limit > value) ? limit : value;
+			}
+		}
+	}
+	
+	/// \brief Converts magnitudes into dB.
+	/// \param input The magnitudes, the sign is ignored.
+	/// \param output The array for the dB values, may be the input.
+	/// \param count The number of values.
+	/// \param offset The offset that is added to all dB values.
+	/// \param limit The minimum dB value, zero magnitudes end up there.
+	/// \param precise true if log10() should be used.
+	void fromMagnitude(const double *input, double *output, unsigned int count, double offset, double limit, bool precise) {
+		convert(input, output, count, 20, offset, limit, precise);
+	}
+	
+	/// \brief Converts powers into dB.
+	/// \param input The powers.
+	/// \param output The array for the dB values, may be the input.
+	/// \param count The number of values.
+	/// \param offset The offset that is added to all dB values.
+	/// \param limit The minimum dB value, zero powers end up there.
+	/// \param precise true if log10() should be used.
+	void fromPower(const double *input, double *output, unsigned int count, double offset, double limit, bool precise) {
+		convert(input, output, count, 10, offset, limit, precise);
+	}
+}
@@ -0,0 +1,39 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  OpenHantek
+/// \file decibel.h
+/// \brief Declares the conversion of spectrum values into dB.
+//
+//  This program is free software: you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation, either version 3 of the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef DECIBEL_H
+#define DECIBEL_H
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// \namespace Decibel                                                decibel.h
+/// \brief Converts whole spectrums into dB with the offset and limit applied.
+/// The fast conversion approximates the logarithm with a polynomial on the
+/// mantissa, its error stays below 1e-8 dB for normal numbers. The precise
+/// conversion uses log10() from the C library.
+namespace Decibel {
+	void fromMagnitude(const double *input, double *output, unsigned int count, double offset, double limit, bool precise = false);
+	void fromPower(const double *input, double *output, unsigned int count, double offset, double limit, bool precise = false);
+}
+
+
+#endif
@@ -0,0 +1,485 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  OpenHantek
+//  digitalfilter.cpp
+//
+//  This program is free software: you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation, either version 3 of the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <cmath>
+#include <cstring>
+
+#include <QtGlobal>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+
+#include "digitalfilter.h"
+
+
+/// \brief Calculates a Blackman windowed-sinc lowpass with unity DC gain.
+/// \param kernel The array for the coefficients.
+/// \param taps The number of coefficients, should be odd.
+/// \param cutoff The cutoff frequency relative to the samplerate.
+static void windowedSinc(double *kernel, unsigned int taps, double cutoff) {
+	unsigned int end = taps - 1;
+	double sum = 0;
+	for(unsigned int tap = 0; tap < taps; tap++) {
+		double position = (double) tap - end / 2.0;
+		double sinc = (position == 0) ? 2 * cutoff : sin(2 * M_PI * cutoff * position) / (M_PI * position);
+		kernel[tap] = sinc * (0.42 - 0.5 * cos(2 * M_PI * tap / end) + 0.08 * cos(4 * M_PI * tap / end));
+		sum += kernel[tap];
+	}
+	for(unsigned int tap = 0; tap < taps; tap++)
+		kernel[tap] /= sum;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// class DigitalFilter
+/// \brief Initializes a disabled filter.
+DigitalFilter::DigitalFilter() {
+	this->settings.bandwidth = 0;
+	this->settings.design = Dso::FILTERDESIGN_FIR;
+	this->settings.frequency = 0;
+	this->settings.taps = 0;
+	this->settings.type = Dso::FILTERTYPE_OFF;
+	this->samplerate = 0;
+	
+	this->coefficients = 0;
+	this->work = 0;
+	this->tail = 0;
+	this->fftBuffer = 0;
+	this->kernelSpectrum = 0;
+	this->blockSpectrum = 0;
+	this->forwardPlan = 0;
+	this->inversePlan = 0;
+	
+	this->clear();
+}
+
+/// \brief Frees the buffers and the FFTW plans.
+DigitalFilter::~DigitalFilter() {
+	this->clear();
+}
+
+/// \brief Designs the filter for the given settings.
+/// Nothing is recalculated if neither the settings nor the samplerate changed.
+/// \param filter The settings of the filter.
+/// \param samplerate The samplerate of the input in S/s.
+/// \return true if the filter is enabled and could be designed.
+bool DigitalFilter::configure(const DsoSettingsScopeFilter &filter, double samplerate) {
+	if(filter.type == this->settings.type && filter.design == this->settings.design && filter.frequency == this->settings.frequency && filter.bandwidth == this->settings.bandwidth && filter.taps == this->settings.taps && samplerate == this->samplerate)
+		return this->active;
+	
+	this->clear();
+	this->settings = filter;
+	this->samplerate = samplerate;
+	
+	if(filter.type == Dso::FILTERTYPE_OFF || samplerate <= 0)
+		return false;
+	// The frequency has to be below the nyquist frequency, the band shouldn't vanish
+	if(filter.frequency <= 0 || filter.frequency >= samplerate / 2)
+		return false;
+	if((filter.type == Dso::FILTERTYPE_BANDPASS || filter.type == Dso::FILTERTYPE_NOTCH) && filter.bandwidth <= 0)
+		return false;
+	
+	if(filter.design == Dso::FILTERDESIGN_IIR)
+		this->designIir();
+	else
+		this->designFir();
+	
+	this->active = true;
+	this->reset();
+	return true;
+}
+
+/// \brief Check if the filter changes the samples.
+/// \return true if the filter is enabled and valid.
+bool DigitalFilter::isActive() const {
+	return this->active;
+}
+
+/// \brief Get the delay of the filter output.
+/// \return The group delay of the FIR filter in samples, 0 for the IIR filter.
+unsigned int DigitalFilter::delay() const {
+	if(!this->active || this->sectionCount)
+		return 0;
+	
+	return (this->taps - 1) / 2;
+}
+
+/// \brief Sets the state as if the input had been constant for a long time.
+/// \param value The value of the previous input samples.
+void DigitalFilter::reset(double value) {
+	if(!this->active)
+		return;
+	
+	if(this->sectionCount) {
+		// Steady state of each biquad for a constant input
+		for(unsigned int section = 0; section < this->sectionCount; section++) {
+			Biquad &biquad = this->sections[section];
+			double output = value * (biquad.b0 + biquad.b1 + biquad.b2) / (1 + biquad.a1 + biquad.a2);
+			biquad.z2 = biquad.b2 * value - biquad.a2 * output;
+			biquad.z1 = biquad.b1 * value - biquad.a1 * output + biquad.z2;
+			value = output;
+		}
+	}
+	else {
+		for(unsigned int position = 0; position < this->taps - 1; position++)
+			this->work[position] = value;
+	}
+}
+
+/// \brief Filters the next part of a continuous stream.
+/// \param input The new input samples.
+/// \param output The array for the filtered samples, may be the input array.
+/// \param count The number of samples.
+void DigitalFilter::process(const double *input, double *output, unsigned int count) {
+	if(!this->active) {
+		if(output != input)
+			memcpy(output, input, count * sizeof(double));
+		return;
+	}
+	
+	if(this->sectionCount) {
+		this->processBiquads(input, output, count);
+		return;
+	}
+	
+	// Append the new samples to the history
+	unsigned int history = this->taps - 1;
+	if(this->workSize < history + count) {
+		double *newWork = new double[history + count];
+		memcpy(newWork, this->work, history * sizeof(double));
+		delete[] this->work;
+		this->work = newWork;
+		this->workSize = history + count;
+	}
+	memcpy(this->work + history, input, count * sizeof(double));
+	
+	if(this->fftSize)
+		this->processOverlapSave(count, output);
+	else
+		this->processDirect(count, output);
+	
+	memmove(this->work, this->work + count, history * sizeof(double));
+}
+
+/// \brief Filters a record that isn't connected to the previous one.
+/// The state is primed with the first sample to avoid a step response and the
+/// delay of the FIR filter is removed, so the output stays aligned with the
+/// trigger point.
+/// \param input The samples of the record.
+/// \param output The array for the filtered samples, may not be the input array.
+/// \param count The number of samples.
+void DigitalFilter::processFrame(const double *input, double *output, unsigned int count) {
+	if(!count)
+		return;
+	
+	this->reset(input[0]);
+	this->process(input, output, count);
+	
+	unsigned int delay = this->delay();
+	if(!delay)
+		return;
+	
+	// Continue with the last sample to get the outputs that are still missing
+	double *tail = this->tail;
+	for(unsigned int position = 0; position < delay; position++)
+		tail[position] = input[count - 1];
+	this->process(tail, tail + delay, delay);
+	
+	if(count > delay) {
+		memmove(output, output + delay, (count - delay) * sizeof(double));
+		memcpy(output + count - delay, tail + delay, delay * sizeof(double));
+	}
+	else
+		memcpy(output, tail + 2 * delay - count, count * sizeof(double));
+}
+
+/// \brief Frees all buffers and disables the filter.
+void DigitalFilter::clear() {
+	if(this->forwardPlan)
+		fftw_destroy_plan(this->forwardPlan);
+	if(this->inversePlan)
+		fftw_destroy_plan(this->inversePlan);
+	if(this->fftBuffer)
+		fftw_free(this->fftBuffer);
+	if(this->kernelSpectrum)
+		fftw_free(this->kernelSpectrum);
+	if(this->blockSpectrum)
+		fftw_free(this->blockSpectrum);
+	delete[] this->coefficients;
+	delete[] this->work;
+	delete[] this->tail;
+	
+	this->active = false;
+	this->taps = 0;
+	this->coefficients = 0;
+	this->work = 0;
+	this->workSize = 0;
+	this->tail = 0;
+	this->fftSize = 0;
+	this->blockStep = 0;
+	this->fftBuffer = 0;
+	this->kernelSpectrum = 0;
+	this->blockSpectrum = 0;
+	this->forwardPlan = 0;
+	this->inversePlan = 0;
+	this->sectionCount = 0;
+}
+
+/// \brief Designs the windowed-sinc kernel and prepares the convolution.
+void DigitalFilter::designFir() {
+	this->taps = qBound(3u, this->settings.taps, (unsigned int) DIGITALFILTER_MAXIMUM_TAPS) | 1;
+	this->coefficients = new double[this->taps];
+	unsigned int center = (this->taps - 1) / 2;
+	
+	double frequency = this->settings.frequency / this->samplerate;
+	double lowFrequency = qMax(frequency - this->settings.bandwidth / 2 / this->samplerate, 0.0);
+	double highFrequency = qMin(frequency + this->settings.bandwidth / 2 / this->samplerate, 0.5);
+	
+	switch(this->settings.type) {
+		case Dso::FILTERTYPE_LOWPASS:
+			windowedSinc(this->coefficients, this->taps, frequency);
+			break;
+		
+		case Dso::FILTERTYPE_HIGHPASS:
+			// Spectral inversion of the lowpass
+			windowedSinc(this->coefficients, this->taps, frequency);
+			for(unsigned int tap = 0; tap < this->taps; tap++)
+				this->coefficients[tap] = -this->coefficients[tap];
+			this->coefficients[center] += 1;
+			break;
+		
+		case Dso::FILTERTYPE_BANDPASS:
+		case Dso::FILTERTYPE_NOTCH: {
+			// Difference of two lowpasses, the upper one is a pass-through at nyquist
+			double *lowKernel = new double[this->taps];
+			if(lowFrequency > 0)
+				windowedSinc(lowKernel, this->taps, lowFrequency);
+			else
+				memset(lowKernel, 0, this->taps * sizeof(double));
+			if(highFrequency < 0.5)
+				windowedSinc(this->coefficients, this->taps, highFrequency);
+			else {
+				memset(this->coefficients, 0, this->taps * sizeof(double));
+				this->coefficients[center] = 1;
+			}
+			for(unsigned int tap = 0; tap < this->taps; tap++)
+				this->coefficients[tap] -= lowKernel[tap];
+			delete[] lowKernel;
+			
+			if(this->settings.type == Dso::FILTERTYPE_NOTCH) {
+				for(unsigned int tap = 0; tap < this->taps; tap++)
+					this->coefficients[tap] = -this->coefficients[tap];
+				this->coefficients[center] += 1;
+			}
+			break;
+		}
+		
+		default:
+			break;
+	}
+	
+	this->work = new double[this->taps - 1];
+	this->workSize = this->taps - 1;
+	this->tail = new double[this->taps - 1];
+	
+	if(this->taps <= DIGITALFILTER_DIRECT_TAPS)
+		return;
+	
+	// Long kernels are applied in the frequency domain
+	this->fftSize = 256;
+	while(this->fftSize < 4 * this->taps)
+		this->fftSize <<= 1;
+	this->blockStep = this->fftSize - this->taps + 1;
+	this->fftBuffer = (double *) fftw_malloc(sizeof(double) * this->fftSize);
+	this->kernelSpectrum = (fftw_complex *) fftw_malloc(sizeof(fftw_complex) * (this->fftSize / 2 + 1));
+	this->blockSpectrum = (fftw_complex *) fftw_malloc(sizeof(fftw_complex) * (this->fftSize / 2 + 1));
+	this->forwardPlan = fftw_plan_dft_r2c_1d(this->fftSize, this->fftBuffer, this->blockSpectrum, FFTW_MEASURE);
+	this->inversePlan = fftw_plan_dft_c2r_1d(this->fftSize, this->blockSpectrum, this->fftBuffer, FFTW_MEASURE);
+	
+	// Transform the zero padded kernel, the scaling of the inverse transform is included
+	memset(this->fftBuffer, 0, this->fftSize * sizeof(double));
+	memcpy(this->fftBuffer, this->coefficients, this->taps * sizeof(double));
+	fftw_execute(this->forwardPlan);
+	for(unsigned int bin = 0; bin <= this->fftSize / 2; bin++) {
+		this->kernelSpectrum[bin][0] = this->blockSpectrum[bin][0] / this->fftSize;
+		this->kernelSpectrum[bin][1] = this->blockSpectrum[bin][1] / this->fftSize;
+	}
+}
+
+/// \brief Designs the biquad cascade.
+void DigitalFilter::designIir() {
+	switch(this->settings.type) {
+		case Dso::FILTERTYPE_LOWPASS:
+		case Dso::FILTERTYPE_HIGHPASS:
+			// Fourth order Butterworth
+			this->addBiquad(this->settings.type, this->settings.frequency, 0.54119610);
+			this->addBiquad(this->settings.type, this->settings.frequency, 1.30656296);
+			break;
+		
+		case Dso::FILTERTYPE_BANDPASS:
+		case Dso::FILTERTYPE_NOTCH:
+			this->addBiquad(this->settings.type, this->settings.frequency, this->settings.frequency / this->settings.bandwidth);
+			break;
+		
+		default:
+			break;
+	}
+}
+
+/// \brief Appends a second order section to the cascade.
+/// \param type The response of the section.
+/// \param frequency The cutoff or center frequency in Hz.
+/// \param q The quality factor of the section.
+void DigitalFilter::addBiquad(Dso::FilterType type, double frequency, double q) {
+	if(this->sectionCount >= DIGITALFILTER_SECTIONS)
+		return;
+	
+	double omega = 2 * M_PI * frequency / this->samplerate;
+	double cosOmega = cos(omega);
+	double alpha = sin(omega) / (2 * q);
+	double a0 = 1 + alpha;
+	
+	Biquad &biquad = this->sections[this->sectionCount++];
+	switch(type) {
+		case Dso::FILTERTYPE_LOWPASS:
+			biquad.b0 = (1 - cosOmega) / 2;
+			biquad.b1 = 1 - cosOmega;
+			biquad.b2 = (1 - cosOmega) / 2;
+			break;
+		case Dso::FILTERTYPE_HIGHPASS:
+			biquad.b0 = (1 + cosOmega) / 2;
+			biquad.b1 = -(1 + cosOmega);
+			biquad.b2 = (1 + cosOmega) / 2;
+			break;
+		case Dso::FILTERTYPE_BANDPASS:
+			biquad.b0 = alpha;
+			biquad.b1 = 0;
+			biquad.b2 = -alpha;
+			break;
+		default:
+			biquad.b0 = 1;
+			biquad.b1 = -2 * cosOmega;
+			biquad.b2 = 1;
+			break;
+	}
+	biquad.b0 /= a0;
+	biquad.b1 /= a0;
+	biquad.b2 /= a0;
+	biquad.a1 = -2 * cosOmega / a0;
+	biquad.a2 = (1 - alpha) / a0;
+	biquad.z1 = 0;
+	biquad.z2 = 0;
+}
+
+/// \brief Convolves the work buffer with the kernel directly.
+/// With SSE2 four outputs are calculated per pass over the kernel, split into
+/// even and odd taps so that the additions don't wait for each other.
+/// \param count The number of new samples in the work buffer.
+/// \param output The array for the filtered samples.
+void DigitalFilter::processDirect(unsigned int count, double *output) {
+	const double *coefficients = this->coefficients;
+	unsigned int taps = this->taps;
+	unsigned int position = 0;
+	
+#ifdef __SSE2__
+	for(; position + 4 <= count; position += 4) {
+		const double *samples = this->work + position;
+		__m128d evenLow = _mm_setzero_pd(), evenHigh = _mm_setzero_pd();
+		__m128d oddLow = _mm_setzero_pd(), oddHigh = _mm_setzero_pd();
+		unsigned int tap = 0;
+		for(; tap + 2 <= taps; tap += 2) {
+			__m128d coefficient = _mm_set1_pd(coefficients[tap]);
+			evenLow = _mm_add_pd(evenLow, _mm_mul_pd(coefficient, _mm_loadu_pd(samples + tap)));
+			evenHigh = _mm_add_pd(evenHigh, _mm_mul_pd(coefficient, _mm_loadu_pd(samples + tap + 2)));
+			coefficient = _mm_set1_pd(coefficients[tap + 1]);
+			oddLow = _mm_add_pd(oddLow, _mm_mul_pd(coefficient, _mm_loadu_pd(samples + tap + 1)));
+			oddHigh = _mm_add_pd(oddHigh, _mm_mul_pd(coefficient, _mm_loadu_pd(samples + tap + 3)));
+		}
+		if(tap < taps) {
+			__m128d coefficient = _mm_set1_pd(coefficients[tap]);
+			evenLow = _mm_add_pd(evenLow, _mm_mul_pd(coefficient, _mm_loadu_pd(samples + tap)));
+			evenHigh = _mm_add_pd(evenHigh, _mm_mul_pd(coefficient, _mm_loadu_pd(samples + tap + 2)));
+		}
+		_mm_storeu_pd(output + position, _mm_add_pd(evenLow, oddLow));
+		_mm_storeu_pd(output + position + 2, _mm_add_pd(evenHigh, oddHigh));
+	}
+#endif
+	
+	for(; position < count; position++) {
+		const double *samples = this->work + position;
+		double sum = 0;
+		for(unsigned int tap = 0; tap < taps; tap++)
+			sum += coefficients[tap] * samples[tap];
+		output[position] = sum;
+	}
+}
+
+/// \brief Convolves the work buffer with the kernel using FFT overlap-save.
+/// \param count The number of new samples in the work buffer.
+/// \param output The array for the filtered samples.
+void DigitalFilter::processOverlapSave(unsigned int count, double *output) {
+	unsigned int history = this->taps - 1;
+	
+	for(unsigned int position = 0; position < count; position += this->blockStep) {
+		// Fill the transform with the next block, the part after the input is unused
+		unsigned int length = qMin(this->fftSize, history + count - position);
+		memcpy(this->fftBuffer, this->work + position, length * sizeof(double));
+		if(length < this->fftSize)
+			memset(this->fftBuffer + length, 0, (this->fftSize - length) * sizeof(double));
+		
+		fftw_execute(this->forwardPlan);
+		for(unsigned int bin = 0; bin <= this->fftSize / 2; bin++) {
+			double real = this->blockSpectrum[bin][0] * this->kernelSpectrum[bin][0] - this->blockSpectrum[bin][1] * this->kernelSpectrum[bin][1];
+			double imaginary = this->blockSpectrum[bin][0] * this->kernelSpectrum[bin][1] + this->blockSpectrum[bin][1] * this->kernelSpectrum[bin][0];
+			this->blockSpectrum[bin][0] = real;
+			this->blockSpectrum[bin][1] = imaginary;
+		}
+		fftw_execute(this->inversePlan);
+		
+		// The first taps - 1 outputs are wrapped around and have to be discarded
+		memcpy(output + position, this->fftBuffer + history, qMin(this->blockStep, count - position) * sizeof(double));
+	}
+}
+
+/// \brief Runs the samples through the biquad cascade.
+/// \param input The input samples.
+/// \param output The array for the filtered samples, may be the input array.
+/// \param count The number of samples.
+void DigitalFilter::processBiquads(const double *input, double *output, unsigned int count) {
+	for(unsigned int section = 0; section < this->sectionCount; section++) {
+		Biquad biquad = this->sections[section];
+		
+		for(unsigned int position = 0; position < count; position++) {
+			double value = input[position];
+			double result = biquad.b0 * value + biquad.z1;
+			biquad.z1 = biquad.b1 * value - biquad.a1 * result + biquad.z2;
+			biquad.z2 = biquad.b2 * value - biquad.a2 * result;
+			output[position] = result;
+		}
+		
+		this->sections[section].z1 = biquad.z1;
+		this->sections[section].z2 = biquad.z2;
+		// The next section works on the output of this one
+		input = output;
+	}
+}
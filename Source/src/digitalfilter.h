@@ -0,0 +1,104 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  OpenHantek
+/// \file digitalfilter.h
+/// \brief Declares the DigitalFilter class.
+//
+//  This program is free software: you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation, either version 3 of the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef DIGITALFILTER_H
+#define DIGITALFILTER_H
+
+
+#include <fftw3.h>
+
+
+#include "settings.h"
+
+
+#define DIGITALFILTER_DIRECT_TAPS    64 ///< Longer FIR kernels use overlap-save
+#define DIGITALFILTER_MAXIMUM_TAPS 4095 ///< Upper limit for the FIR length
+#define DIGITALFILTER_SECTIONS        2 ///< Biquads for IIR lowpass/highpass
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// \class DigitalFilter                                         digitalfilter.h
+/// \brief A lowpass, highpass, bandpass or notch filter for a channel.
+/// The FIR design is a Blackman windowed-sinc with linear phase. Short kernels
+/// are convolved directly, long ones by FFT overlap-save. The IIR design is a
+/// cascade of biquads (Butterworth for lowpass/highpass). The state is kept
+/// between calls of process(), so a continuous stream can be filtered in
+/// pieces, processFrame() instead treats every call as independent record.
+class DigitalFilter {
+	public:
+		DigitalFilter();
+		~DigitalFilter();
+		
+		bool configure(const DsoSettingsScopeFilter &filter, double samplerate);
+		bool isActive() const;
+		unsigned int delay() const;
+		
+		void reset(double value = 0);
+		void process(const double *input, double *output, unsigned int count);
+		void processFrame(const double *input, double *output, unsigned int count);
+	
+	protected:
+		////////////////////////////////////////////////////////////////////////////
+		/// \struct Biquad                                         digitalfilter.h
+		/// \brief A second order section in transposed direct form II.
+		struct Biquad {
+			double b0, b1, b2; ///< Feedforward coefficients
+			double a1, a2; ///< Feedback coefficients (a0 is normalized to 1)
+			double z1, z2; ///< The state of the section
+		};
+		
+		void clear();
+		void designFir();
+		void designIir();
+		void addBiquad(Dso::FilterType type, double frequency, double q);
+		
+		void processDirect(unsigned int count, double *output);
+		void processOverlapSave(unsigned int count, double *output);
+		void processBiquads(const double *input, double *output, unsigned int count);
+		
+		DsoSettingsScopeFilter settings; ///< The configuration of the filter
+		double samplerate; ///< The samplerate the filter was designed for
+		bool active; ///< true if the filter is designed and enabled
+		
+		// FIR
+		unsigned int taps; ///< Number of FIR coefficients (Always odd)
+		double *coefficients; ///< The symmetric FIR kernel
+		double *work; ///< The last taps - 1 inputs followed by the new samples
+		unsigned int workSize; ///< The allocated size of the work buffer
+		double *tail; ///< The padding and the last outputs of a record
+		
+		// Overlap-save
+		unsigned int fftSize; ///< Length of the transforms
+		unsigned int blockStep; ///< New output samples per transform
+		double *fftBuffer; ///< Real input/output of the transforms
+		fftw_complex *kernelSpectrum; ///< The transformed and scaled kernel
+		fftw_complex *blockSpectrum; ///< The transformed block
+		fftw_plan forwardPlan; ///< Plan for the forward transform
+		fftw_plan inversePlan; ///< Plan for the inverse transform
+		
+		// IIR
+		Biquad sections[DIGITALFILTER_SECTIONS]; ///< The cascaded biquads
+		unsigned int sectionCount; ///< Number of used sections
+};
+
+
+#endif
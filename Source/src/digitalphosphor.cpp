@@ -0,0 +1,245 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  OpenHantek
+//  digitalphosphor.cpp
+//
+//  This program is free software: you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation, either version 3 of the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <cmath>
+
+
+#include "digitalphosphor.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// class DigitalPhosphor
+/// \brief Initializes an empty buffer.
+DigitalPhosphor::DigitalPhosphor() {
+	this->columns = 0;
+	this->rows = 0;
+}
+
+/// \brief Cleans up.
+DigitalPhosphor::~DigitalPhosphor() {
+}
+
+/// \brief Sets the size of the histograms and removes all hits.
+/// Nothing happens if the size doesn't change.
+/// \param width The width of the screen in pixels.
+/// \param height The height of the screen in pixels.
+/// \param graphs The number of graphs.
+void DigitalPhosphor::resize(unsigned int width, unsigned int height, unsigned int graphs) {
+	if(width == this->columns && height == this->rows && graphs == (unsigned int) this->histograms.count())
+		return;
+	
+	this->columns = width;
+	this->rows = height;
+	unsigned int size = width * height;
+	
+	while((unsigned int) this->histograms.count() > graphs)
+		this->histograms.removeLast();
+	while((unsigned int) this->histograms.count() < graphs)
+		this->histograms.append(QVector<float>());
+	for(int graph = 0; graph < this->histograms.count(); graph++)
+		this->histograms[graph].resize(size);
+	this->red.resize(size);
+	this->green.resize(size);
+	this->blue.resize(size);
+	this->texels.resize(size);
+	
+	this->clear();
+}
+
+/// \brief Removes all hits.
+void DigitalPhosphor::clear() {
+	for(int graph = 0; graph < this->histograms.count(); graph++)
+		this->histograms[graph].fill(0);
+}
+
+/// \brief Lets the hits of the previous graphs fade out.
+/// Almost faded hits are set to zero, so there are no slow denormals.
+/// \param factor The factor all hits are multiplied with.
+void DigitalPhosphor::decay(double factor) {
+	const float decayFactor = (float) factor;
+	for(int graph = 0; graph < this->histograms.count(); graph++) {
+		float *hits = this->histograms[graph].data();
+		unsigned int size = this->histograms[graph].size();
+		for(unsigned int position = 0; position < size; position++)
+			hits[position] = (hits[position] > 1e-3f) ? hits[position] * decayFactor : 0;
+	}
+}
+
+/// \brief Rasterizes a graph into its histogram.
+/// \param graph The index of the histogram.
+/// \param vertices The x and y coordinates of the points.
+/// \param count The number of points.
+/// \param lines true if the points are connected.
+/// \param horizontalScale Converts x coordinates into pixels.
+/// \param horizontalOffset The pixel position of x = 0.
+/// \param verticalScale Converts y coordinates into pixels.
+/// \param verticalOffset The pixel position of y = 0.
+void DigitalPhosphor::addGraph(unsigned int graph, const float *vertices, unsigned int count, bool lines, double horizontalScale, double horizontalOffset, double verticalScale, double verticalOffset) {
+	if(graph >= (unsigned int) this->histograms.count() || !vertices || !count || !this->columns || !this->rows)
+		return;
+	
+	float *hits = this->histograms[graph].data();
+	
+	if(!lines || count == 1) {
+		for(unsigned int point = 0; point < count; point++)
+			this->addPoint(hits, vertices[point * 2] * horizontalScale + horizontalOffset, vertices[point * 2 + 1] * verticalScale + verticalOffset);
+		return;
+	}
+	
+	for(unsigned int point = 1; point < count; point++)
+		this->addSegment(hits, vertices[point * 2 - 2] * horizontalScale + horizontalOffset, vertices[point * 2 - 1] * verticalScale + verticalOffset, vertices[point * 2] * horizontalScale + horizontalOffset, vertices[point * 2 + 1] * verticalScale + verticalOffset);
+}
+
+/// \brief Rasterizes a series of values into its histogram.
+/// The x coordinate of a value is its index divided by valuesPerStep.
+/// \param graph The index of the histogram.
+/// \param values The y coordinates of the points.
+/// \param count The number of values.
+/// \param valuesPerStep The number of values with the same x coordinate.
+/// \param lines true if the points are connected.
+/// \param horizontalScale Converts x coordinates into pixels.
+/// \param horizontalOffset The pixel position of x = 0.
+/// \param verticalScale Converts y coordinates into pixels.
+/// \param verticalOffset The pixel position of y = 0.
+void DigitalPhosphor::addSeries(unsigned int graph, const float *values, unsigned int count, unsigned int valuesPerStep, bool lines, double horizontalScale, double horizontalOffset, double verticalScale, double verticalOffset) {
+	if(graph >= (unsigned int) this->histograms.count() || !values || !count || !valuesPerStep || !this->columns || !this->rows)
+		return;
+	
+	float *hits = this->histograms[graph].data();
+	
+	if(!lines || count == 1) {
+		for(unsigned int point = 0; point < count; point++)
+			this->addPoint(hits, (point / valuesPerStep) * horizontalScale + horizontalOffset, values[point] * verticalScale + verticalOffset);
+		return;
+	}
+	
+	for(unsigned int point = 1; point < count; point++)
+		this->addSegment(hits, ((point - 1) / valuesPerStep) * horizontalScale + horizontalOffset, values[point - 1] * verticalScale + verticalOffset, (point / valuesPerStep) * horizontalScale + horizontalOffset, values[point] * verticalScale + verticalOffset);
+}
+
+/// \brief Composes the colored image of all histograms.
+/// \param background The color of the screen.
+/// \param colors The color of each graph.
+/// \return height() * width() RGBA texels, column by column.
+const quint32 *DigitalPhosphor::image(const QColor &background, const QList<QColor> &colors) {
+	unsigned int size = this->columns * this->rows;
+	float *red = this->red.data();
+	float *green = this->green.data();
+	float *blue = this->blue.data();
+	
+	this->red.fill(background.red());
+	this->green.fill(background.green());
+	this->blue.fill(background.blue());
+	
+	// Blend the graphs over the background depending on their intensity
+	for(int graph = 0; graph < this->histograms.count() && graph < colors.count(); graph++) {
+		const float *hits = this->histograms[graph].constData();
+		float graphRed = colors[graph].red();
+		float graphGreen = colors[graph].green();
+		float graphBlue = colors[graph].blue();
+		for(unsigned int position = 0; position < size; position++) {
+			float intensity = hits[position] / (hits[position] + (float) DIGITALPHOSPHOR_KNEE);
+			red[position] += (graphRed - red[position]) * intensity;
+			green[position] += (graphGreen - green[position]) * intensity;
+			blue[position] += (graphBlue - blue[position]) * intensity;
+		}
+	}
+	
+	// Bytes in memory order, so the texels are RGBA on every platform
+	unsigned char *bytes = (unsigned char *) this->texels.data();
+	for(unsigned int position = 0; position < size; position++) {
+		bytes[position * 4] = (unsigned char) (red[position] + 0.5f);
+		bytes[position * 4 + 1] = (unsigned char) (green[position] + 0.5f);
+		bytes[position * 4 + 2] = (unsigned char) (blue[position] + 0.5f);
+		bytes[position * 4 + 3] = 0xff;
+	}
+	
+	return this->texels.constData();
+}
+
+/// \brief Returns the width of the histograms.
+/// \return The number of columns in pixels.
+unsigned int DigitalPhosphor::width() const {
+	return this->columns;
+}
+
+/// \brief Returns the height of the histograms.
+/// \return The number of rows in pixels.
+unsigned int DigitalPhosphor::height() const {
+	return this->rows;
+}
+
+/// \brief Adds a hit to the pixel at a position.
+/// \param hits The histogram.
+/// \param x The horizontal position in pixels.
+/// \param y The vertical position in pixels.
+void DigitalPhosphor::addPoint(float *hits, double x, double y) {
+	x = floor(x);
+	y = floor(y);
+	if(x >= 0 && x < this->columns && y >= 0 && y < this->rows)
+		hits[(unsigned int) x * this->rows + (unsigned int) y] += 1;
+}
+
+/// \brief Adds a hit to the pixels a line segment crosses.
+/// \param hits The histogram.
+/// \param x0 The horizontal position of the first point in pixels.
+/// \param y0 The vertical position of the first point in pixels.
+/// \param x1 The horizontal position of the second point in pixels.
+/// \param y1 The vertical position of the second point in pixels.
+void DigitalPhosphor::addSegment(float *hits, double x0, double y0, double x1, double y1) {
+	if(x0 > x1) {
+		qSwap(x0, x1);
+		qSwap(y0, y1);
+	}
+	if(!(x1 >= 0 && x0 < this->columns && y0 == y0 && y1 == y1))
+		return;
+	
+	// One vertical run for each column the segment crosses
+	int firstColumn = qMax((int) floor(x0), 0);
+	int lastColumn = qMin((int) floor(x1), (int) this->columns - 1);
+	if(firstColumn == lastColumn || x1 == x0) {
+		this->addRun(hits, firstColumn, qMin(y0, y1), qMax(y0, y1));
+		return;
+	}
+	double slope = (y1 - y0) / (x1 - x0);
+	for(int column = firstColumn; column <= lastColumn; column++) {
+		double enter = y0 + (qMax((double) column, x0) - x0) * slope;
+		double leave = y0 + (qMin((double) column + 1, x1) - x0) * slope;
+		this->addRun(hits, column, qMin(enter, leave), qMax(enter, leave));
+	}
+}
+
+/// \brief Adds a hit to the pixels of a column between two heights.
+/// The pixels of a column are contiguous, so the loop can be vectorized.
+/// \param hits The histogram.
+/// \param column The column of the run.
+/// \param bottom The lower end of the run in pixels.
+/// \param top The upper end of the run in pixels.
+void DigitalPhosphor::addRun(float *hits, int column, double bottom, double top) {
+	if(!(top >= 0 && bottom < this->rows))
+		return;
+	
+	int firstRow = qMax((int) floor(bottom), 0);
+	int lastRow = qMin((int) floor(top), (int) this->rows - 1);
+	float *columnHits = hits + column * this->rows;
+	for(int row = firstRow; row <= lastRow; row++)
+		columnHits[row] += 1;
+}
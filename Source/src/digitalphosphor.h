@@ -0,0 +1,70 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  OpenHantek
+/// \file digitalphosphor.h
+/// \brief Declares the DigitalPhosphor class.
+//
+//  This program is free software: you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation, either version 3 of the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef DIGITALPHOSPHOR_H
+#define DIGITALPHOSPHOR_H
+
+
+#include <QColor>
+#include <QList>
+#include <QVector>
+
+
+#define DIGITALPHOSPHOR_KNEE       0.25 ///< Hits that give half of the full intensity
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// \class DigitalPhosphor                                     digitalphosphor.h
+/// \brief Intensity graded persistence buffer for the graphs of a scope.
+/// Every graph has a histogram of hits with one counter per screen pixel. New
+/// graphs are rasterized into it, old hits decay exponentially. The histograms
+/// are stored column by column, so the vertical runs of the rasterizer are
+/// contiguous. The image is built the same way and has to be drawn transposed.
+class DigitalPhosphor {
+	public:
+		DigitalPhosphor();
+		~DigitalPhosphor();
+		
+		void resize(unsigned int width, unsigned int height, unsigned int graphs);
+		void clear();
+		void decay(double factor);
+		void addGraph(unsigned int graph, const float *vertices, unsigned int count, bool lines, double horizontalScale, double horizontalOffset, double verticalScale, double verticalOffset);
+		void addSeries(unsigned int graph, const float *values, unsigned int count, unsigned int valuesPerStep, bool lines, double horizontalScale, double horizontalOffset, double verticalScale, double verticalOffset);
+		const quint32 *image(const QColor &background, const QList<QColor> &colors);
+		
+		unsigned int width() const;
+		unsigned int height() const;
+	
+	protected:
+		void addPoint(float *hits, double x, double y);
+		void addSegment(float *hits, double x0, double y0, double x1, double y1);
+		void addRun(float *hits, int column, double bottom, double top);
+		
+		unsigned int columns; ///< The width of the histograms in pixels
+		unsigned int rows; ///< The height of the histograms in pixels
+		QList<QVector<float> > histograms; ///< The decayed hit counts of each graph
+		QVector<float> red, green, blue; ///< The color components while composing
+		QVector<quint32> texels; ///< The composed RGBA image
+};
+
+
+#endif
@@ -27,12 +27,14 @@
 #include <QComboBox>
 #include <QDockWidget>
 #include <QLabel>
+#include <QLineEdit>
 
 
 #include "dockwindows.h"
 
 #include "settings.h"
 #include "helper.h"
+#include "mathexpression.h"
 
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -474,15 +476,21 @@ VoltageDock::VoltageDock(DsoSettings *settings, QWidget *parent, Qt::WindowFlags
 		this->gainComboBox[channel]->addItems(this->gainStrings);
 		
 		this->usedCheckBox.append(new QCheckBox(this->settings->scope.voltage[channel].name));
+		
+		if (channel >= (int) this->settings->scope.physicalChannels)
+			this->expressionLineEdit.append(new QLineEdit());
 	}
 	
 	this->dockLayout = new QGridLayout();
 	this->dockLayout->setColumnMinimumWidth(0, 64);
 	this->dockLayout->setColumnStretch(1, 1);
+	int row = 0;
 	for (int channel = 0; channel < this->settings->scope.voltage.count(); channel++) {
-		this->dockLayout->addWidget(this->usedCheckBox[channel], channel * 2, 0);
-		this->dockLayout->addWidget(this->gainComboBox[channel], channel * 2, 1);
-		this->dockLayout->addWidget(this->miscComboBox[channel], channel * 2 + 1, 1);
+		this->dockLayout->addWidget(this->usedCheckBox[channel], row, 0);
+		this->dockLayout->addWidget(this->gainComboBox[channel], row++, 1);
+		this->dockLayout->addWidget(this->miscComboBox[channel], row++, 1);
+		if (channel >= (int) this->settings->scope.physicalChannels)
+			this->dockLayout->addWidget(this->expressionLineEdit[channel - this->settings->scope.physicalChannels], row++, 0, 1, 2);
 	}
 
 	this->setAllowedAreas(Qt::LeftDockWidgetArea | Qt::RightDockWidgetArea);
@@ -497,13 +505,17 @@ VoltageDock::VoltageDock(DsoSettings *settings, QWidget *parent, Qt::WindowFlags
 		connect(this->miscComboBox[channel], SIGNAL(currentIndexChanged(int)), this, SLOT(miscSelected(int)));
 		connect(this->usedCheckBox[channel], SIGNAL(toggled(bool)), this, SLOT(usedSwitched(bool)));
 	}
+	for (int mathChannel = 0; mathChannel < this->expressionLineEdit.count(); mathChannel++)
+		connect(this->expressionLineEdit[mathChannel], SIGNAL(editingFinished()), this, SLOT(expressionEdited()));
 	
 	// Set values
 	for (int channel = 0; channel < this->settings->scope.voltage.count(); channel++) {
 		if (channel < (int) this->settings->scope.physicalChannels)
 			this->setCoupling(channel, (Dso::Coupling) this->settings->scope.voltage[channel].misc);
-		else
-			this->setMode((Dso::MathMode) this->settings->scope.voltage[channel].misc);
+		else {
+			this->setExpression(channel, this->settings->scope.voltage[channel].expression);
+			this->setMode(channel, (Dso::MathMode) this->settings->scope.voltage[channel].misc);
+		}
 		this->setGain(channel, this->settings->scope.voltage[channel].gain);
 		this->setUsed(channel, this->settings->scope.voltage[channel].used);
 	}
@@ -550,12 +562,30 @@ int VoltageDock::setGain(int channel, double gain) {
 	return index;
 }
 
-/// \brief Sets the mode for the math channel.
+/// \brief Sets the formula for a math channel.
+/// \param channel The math channel, whose formula should be set.
+/// \param expression The formula that is used in expression mode.
+/// \return Index of the math channel, -1 on error.
+int VoltageDock::setExpression(int channel, const QString &expression) {
+	int mathChannel = channel - this->settings->scope.physicalChannels;
+	if (mathChannel < 0 || mathChannel >= this->expressionLineEdit.count())
+		return -1;
+	
+	this->expressionLineEdit[mathChannel]->setText(expression);
+	return mathChannel;
+}
+
+/// \brief Sets the mode for a math channel.
+/// \param channel The math channel, whose mode should be set.
 /// \param mode The math-mode.
 /// \return Index of math-mode, -1 on error.
-int VoltageDock::setMode(Dso::MathMode mode) {
-	if (mode >= Dso::MATHMODE_1ADD2 && mode <= Dso::MATHMODE_2SUB1) {
-		this->miscComboBox[this->settings->scope.physicalChannels]->setCurrentIndex(mode);
+int VoltageDock::setMode(int channel, Dso::MathMode mode) {
+	if (channel < (int) this->settings->scope.physicalChannels || channel >= this->settings->scope.voltage.count())
+		return -1;
+	
+	if (mode >= Dso::MATHMODE_1ADD2 && mode <= Dso::MATHMODE_EXPRESSION) {
+		this->miscComboBox[channel]->setCurrentIndex(mode);
+		this->expressionLineEdit[channel - this->settings->scope.physicalChannels]->setEnabled(mode == Dso::MATHMODE_EXPRESSION);
 		return mode;
 	}
 	
@@ -608,8 +638,36 @@ void VoltageDock::miscSelected(int index) {
 		this->settings->scope.voltage[channel].misc = index;
 		if (channel < (int) this->settings->scope.physicalChannels)
 			emit couplingChanged(channel, (Dso::Coupling) this->settings->scope.voltage[channel].misc);
-		else
-			emit modeChanged((Dso::MathMode) this->settings->scope.voltage[channel].misc);
+		else {
+			this->expressionLineEdit[channel - this->settings->scope.physicalChannels]->setEnabled(index == Dso::MATHMODE_EXPRESSION);
+			emit modeChanged(channel, (Dso::MathMode) this->settings->scope.voltage[channel].misc);
+		}
+	}
+}
+
+/// \brief Called when the formula of a math channel has been edited.
+void VoltageDock::expressionEdited() {
+	int mathChannel;
+	
+	// Which line edit was it?
+	for (mathChannel = 0; mathChannel < this->expressionLineEdit.count(); mathChannel++)
+		if (this->sender() == this->expressionLineEdit[mathChannel])
+			break;
+	
+	// Send signal if it was one of the line edits
+	if (mathChannel < this->expressionLineEdit.count()) {
+		unsigned int channel = this->settings->scope.physicalChannels + mathChannel;
+		if (this->settings->scope.voltage[channel].expression == this->expressionLineEdit[mathChannel]->text())
+			return;
+		
+		this->settings->scope.voltage[channel].expression = this->expressionLineEdit[mathChannel]->text();
+		
+		// Show compilation errors as tooltip
+		MathExpression expression;
+		expression.compile(this->settings->scope.voltage[channel].expression, this->settings->scope.physicalChannels);
+		this->expressionLineEdit[mathChannel]->setToolTip(expression.error());
+		
+		emit expressionChanged(channel, this->settings->scope.voltage[channel].expression);
 	}
 }
 
@@ -38,6 +38,7 @@
 class QLabel;
 class QCheckBox;
 class QComboBox;
+class QLineEdit;
 
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -147,7 +148,8 @@ class VoltageDock : public QDockWidget {
 		
 		int setCoupling(int channel, Dso::Coupling coupling);
 		int setGain(int channel, double gain);
-		int setMode(Dso::MathMode mode);
+		int setExpression(int channel, const QString &expression);
+		int setMode(int channel, Dso::MathMode mode);
 		int setUsed(int channel, bool used);
 	
 	protected:
@@ -158,6 +160,7 @@ class VoltageDock : public QDockWidget {
 		QList<QCheckBox *> usedCheckBox; ///< Enable/disable a specific channel
 		QList<QComboBox *> gainComboBox; ///< Select the vertical gain for the channels
 		QList<QComboBox *> miscComboBox; ///< Select coupling for real and mode for math channels
+		QList<QLineEdit *> expressionLineEdit; ///< The formulas for the math channels
 		
 		DsoSettings *settings; ///< The settings provided by the parent class
 		
@@ -167,14 +170,16 @@ class VoltageDock : public QDockWidget {
 		QStringList gainStrings; ///< String representations for the gain steps
 	
 	protected slots:
+		void expressionEdited();
 		void gainSelected(int index);
 		void miscSelected(int index);
 		void usedSwitched(bool checked);
 	
 	signals:
 		void couplingChanged(unsigned int channel, Dso::Coupling coupling); ///< A coupling has been selected
+		void expressionChanged(unsigned int channel, const QString &expression); ///< The formula of a math channel has been changed
 		void gainChanged(unsigned int channel, double gain); ///< A gain has been selected
-		void modeChanged(Dso::MathMode mode); ///< The mode for the math channels has been changed
+		void modeChanged(unsigned int channel, Dso::MathMode mode); ///< The mode for a math channel has been changed
 		void usedChanged(unsigned int channel, bool used); ///< A channel has been enabled/disabled
 };
 
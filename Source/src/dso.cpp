@@ -84,6 +84,8 @@ namespace Dso {
 				return QApplication::tr("CH1 - CH2");
 			case MATHMODE_2SUB1:
 				return QApplication::tr("CH2 - CH1");
+			case MATHMODE_EXPRESSION:
+				return QApplication::tr("Expression");
 			default:
 				return QString();
 		}
@@ -174,4 +176,72 @@ namespace Dso {
 				return QString();
 		}
 	}
+	
+	/// \brief Return string representation of the given filter type.
+	/// \param type The #FilterType that should be returned as string.
+	/// \return The string that should be used in labels etc.
+	QString filterTypeString(FilterType type) {
+		switch(type) {
+			case FILTERTYPE_OFF:
+				return QApplication::tr("Off");
+			case FILTERTYPE_LOWPASS:
+				return QApplication::tr("Lowpass");
+			case FILTERTYPE_HIGHPASS:
+				return QApplication::tr("Highpass");
+			case FILTERTYPE_BANDPASS:
+				return QApplication::tr("Bandpass");
+			case FILTERTYPE_NOTCH:
+				return QApplication::tr("Notch");
+			default:
+				return QString();
+		}
+	}
+	
+	/// \brief Return string representation of the given filter design.
+	/// \param design The #FilterDesign that should be returned as string.
+	/// \return The string that should be used in labels etc.
+	QString filterDesignString(FilterDesign design) {
+		switch(design) {
+			case FILTERDESIGN_FIR:
+				return QApplication::tr("FIR");
+			case FILTERDESIGN_IIR:
+				return QApplication::tr("IIR");
+			default:
+				return QString();
+		}
+	}
+	
+	/// \brief Return string representation of the given serial protocol.
+	/// \param protocol The #Protocol that should be returned as string.
+	/// \return The string that should be used in labels etc.
+	QString protocolString(Protocol protocol) {
+		switch(protocol) {
+			case PROTOCOL_OFF:
+				return QApplication::tr("Off");
+			case PROTOCOL_UART:
+				return QApplication::tr("UART");
+			case PROTOCOL_SPI:
+				return QApplication::tr("SPI");
+			case PROTOCOL_I2C:
+				return QApplication::tr("I2C");
+			default:
+				return QString();
+		}
+	}
+	
+	/// \brief Return string representation of the given parity mode.
+	/// \param parity The #Parity that should be returned as string.
+	/// \return The string that should be used in labels etc.
+	QString parityString(Parity parity) {
+		switch(parity) {
+			case PARITY_NONE:
+				return QApplication::tr("None");
+			case PARITY_ODD:
+				return QApplication::tr("Odd");
+			case PARITY_EVEN:
+				return QApplication::tr("Even");
+			default:
+				return QString();
+		}
+	}
 }
@@ -31,6 +31,7 @@
 
 
 #define MARKER_COUNT                  2 ///< Number of markers
+#define MATH_CHANNELS                 2 ///< Number of math channels
 
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -72,6 +73,7 @@ namespace Dso {
 		MATHMODE_1ADD2,                     ///< Add the values of the channels
 		MATHMODE_1SUB2,                     ///< Subtract CH2 from CH1
 		MATHMODE_2SUB1,                     ///< Subtract CH1 from CH2
+		MATHMODE_EXPRESSION,                ///< User defined formula
 		MATHMODE_COUNT                      ///< The total number of math modes
 	};
 	
@@ -128,6 +130,48 @@ namespace Dso {
 		INTERPOLATION_COUNT                 ///< Total number of interpolation modes
 	};
 	
+	//////////////////////////////////////////////////////////////////////////////
+	/// \enum FilterType                                                     dso.h
+	/// \brief The response of the digital filter of a channel.
+	enum FilterType {
+		FILTERTYPE_OFF,                     ///< The samples aren't filtered
+		FILTERTYPE_LOWPASS,                 ///< Attenuates above the cutoff frequency
+		FILTERTYPE_HIGHPASS,                ///< Attenuates below the cutoff frequency
+		FILTERTYPE_BANDPASS,                ///< Passes only the band around the frequency
+		FILTERTYPE_NOTCH,                   ///< Removes the band around the frequency
+		FILTERTYPE_COUNT                    ///< Total number of filter types
+	};
+	
+	//////////////////////////////////////////////////////////////////////////////
+	/// \enum FilterDesign                                                   dso.h
+	/// \brief The implementation of the digital filter.
+	enum FilterDesign {
+		FILTERDESIGN_FIR,                   ///< Windowed-sinc, linear phase
+		FILTERDESIGN_IIR,                   ///< Cascaded biquads, cheaper but not linear phase
+		FILTERDESIGN_COUNT                  ///< Total number of filter designs
+	};
+	
+	//////////////////////////////////////////////////////////////////////////////
+	/// \enum Protocol                                                       dso.h
+	/// \brief The serial protocols that can be decoded.
+	enum Protocol {
+		PROTOCOL_OFF,                       ///< No decoding
+		PROTOCOL_UART,                      ///< Asynchronous serial, idle high
+		PROTOCOL_SPI,                       ///< Clock and one data line
+		PROTOCOL_I2C,                       ///< SCL and SDA
+		PROTOCOL_COUNT                      ///< Total number of protocols
+	};
+	
+	//////////////////////////////////////////////////////////////////////////////
+	/// \enum Parity                                                         dso.h
+	/// \brief The parity bit of UART frames.
+	enum Parity {
+		PARITY_NONE,                        ///< No parity bit
+		PARITY_ODD,                         ///< Odd number of ones including parity
+		PARITY_EVEN,                        ///< Even number of ones including parity
+		PARITY_COUNT                        ///< Total number of parity modes
+	};
+	
 	QString channelModeString(ChannelMode mode);
 	QString graphFormatString(GraphFormat format);
 	QString couplingString(Coupling coupling);
@@ -136,6 +180,10 @@ namespace Dso {
 	QString slopeString(Slope slope);
 	QString windowFunctionString(WindowFunction window);
 	QString interpolationModeString(InterpolationMode interpolation);
+	QString filterTypeString(FilterType type);
+	QString filterDesignString(FilterDesign design);
+	QString protocolString(Protocol protocol);
+	QString parityString(Parity parity);
 }
 
 
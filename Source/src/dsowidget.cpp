@@ -25,6 +25,7 @@
 #include <cmath>
 
 #include <QGridLayout>
+#include <QMutex>
 #include <QTimer>
 
 
@@ -33,9 +34,12 @@
 #include "dataanalyzer.h"
 #include "dso.h"
 #include "exporter.h"
+#include "framepacer.h"
 #include "glscope.h"
+#include "glspectrogram.h"
 #include "helper.h"
 #include "levelslider.h"
+#include "masktest.h"
 #include "settings.h"
 
 
@@ -63,6 +67,17 @@ DsoWidget::DsoWidget(DsoSettings *settings, DataAnalyzer *dataAnalyzer, QWidget
 	this->zoomScope = new GlScope(this->settings);
 	this->zoomScope->setGenerator(this->generator);
 	this->zoomScope->setZoomMode(true);
+	this->spectrogramScope = new GlSpectrogram(this->settings, this->dataAnalyzer);
+	
+	// All redraws of the screens go through the pacer
+	this->framePacer = new FramePacer(this->settings, this);
+	this->connect(this->mainScope, SIGNAL(invalidated()), this->framePacer, SLOT(requestUpdate()));
+	this->connect(this->zoomScope, SIGNAL(invalidated()), this->framePacer, SLOT(requestUpdate()));
+	// New samples are drawn when their vertex arrays are ready, not when they are analyzed
+	this->connect(this->generator, SIGNAL(graphsGenerated()), this->framePacer, SLOT(requestUpdate()));
+	this->connect(this->framePacer, SIGNAL(update()), this->mainScope, SLOT(updateGL()));
+	this->connect(this->framePacer, SIGNAL(update()), this->zoomScope, SLOT(updateGL()));
+	this->connect(this->framePacer, SIGNAL(update()), this->spectrogramScope, SLOT(updateGL()));
 	
 	// The offset sliders for all possible channels
 	this->offsetSlider = new LevelSlider(Qt::RightArrow);
@@ -115,6 +130,8 @@ DsoWidget::DsoWidget(DsoSettings *settings, DataAnalyzer *dataAnalyzer, QWidget
 	// The table for the settings
 	this->settingsTriggerLabel = new QLabel();
 	this->settingsTriggerLabel->setMinimumWidth(160);
+	this->settingsMaskLabel = new QLabel();
+	this->settingsMaskLabel->setPalette(palette);
 	this->settingsBufferLabel = new QLabel();
 	this->settingsBufferLabel->setAlignment(Qt::AlignRight);
 	this->settingsBufferLabel->setPalette(palette);
@@ -127,12 +144,18 @@ DsoWidget::DsoWidget(DsoSettings *settings, DataAnalyzer *dataAnalyzer, QWidget
 	this->settingsFrequencybaseLabel = new QLabel();
 	this->settingsFrequencybaseLabel->setAlignment(Qt::AlignRight);
 	this->settingsFrequencybaseLabel->setPalette(palette);
+	this->settingsFrameRateLabel = new QLabel();
+	this->settingsFrameRateLabel->setAlignment(Qt::AlignRight);
+	this->settingsFrameRateLabel->setPalette(palette);
+	this->settingsFrameRateLabel->setToolTip(tr("Displayed and acquired frames per second"));
 	this->settingsLayout = new QHBoxLayout();
 	this->settingsLayout->addWidget(this->settingsTriggerLabel);
+	this->settingsLayout->addWidget(this->settingsMaskLabel, 1);
 	this->settingsLayout->addWidget(this->settingsBufferLabel, 1);
 	this->settingsLayout->addWidget(this->settingsRateLabel, 1);
 	this->settingsLayout->addWidget(this->settingsTimebaseLabel, 1);
 	this->settingsLayout->addWidget(this->settingsFrequencybaseLabel, 1);
+	this->settingsLayout->addWidget(this->settingsFrameRateLabel, 1);
 	
 	// The table for the marker details
 	this->markerInfoLabel = new QLabel();
@@ -166,6 +189,8 @@ DsoWidget::DsoWidget(DsoSettings *settings, DataAnalyzer *dataAnalyzer, QWidget
 	this->measurementLayout->setColumnStretch(3, 2);
 	this->measurementLayout->setColumnStretch(4, 3);
 	this->measurementLayout->setColumnStretch(5, 3);
+	this->measurementLayout->setColumnStretch(6, 4);
+	this->measurementLayout->setColumnStretch(7, 8);
 	for(int channel = 0; channel < this->settings->scope.voltage.count(); channel++) {
 		tablePalette.setColor(QPalette::WindowText, this->settings->view.color.screen.voltage[channel]);
 		this->measurementNameLabel.append(new QLabel(this->settings->scope.voltage[channel].name));
@@ -185,6 +210,12 @@ DsoWidget::DsoWidget(DsoSettings *settings, DataAnalyzer *dataAnalyzer, QWidget
 		this->measurementFrequencyLabel.append(new QLabel());
 		this->measurementFrequencyLabel[channel]->setAlignment(Qt::AlignRight);
 		this->measurementFrequencyLabel[channel]->setPalette(palette);
+		this->measurementPhaseLabel.append(new QLabel());
+		this->measurementPhaseLabel[channel]->setAlignment(Qt::AlignRight);
+		this->measurementPhaseLabel[channel]->setPalette(palette);
+		this->measurementHarmonicsLabel.append(new QLabel());
+		this->measurementHarmonicsLabel[channel]->setAlignment(Qt::AlignRight);
+		this->measurementHarmonicsLabel[channel]->setPalette(palette);
 		this->setMeasurementVisible(channel, this->settings->scope.voltage[channel].used);
 		this->measurementLayout->addWidget(this->measurementNameLabel[channel], channel, 0);
 		this->measurementLayout->addWidget(this->measurementMiscLabel[channel], channel, 1);
@@ -192,10 +223,12 @@ DsoWidget::DsoWidget(DsoSettings *settings, DataAnalyzer *dataAnalyzer, QWidget
 		this->measurementLayout->addWidget(this->measurementMagnitudeLabel[channel], channel, 3);
 		this->measurementLayout->addWidget(this->measurementAmplitudeLabel[channel], channel, 4);
 		this->measurementLayout->addWidget(this->measurementFrequencyLabel[channel], channel, 5);
+		this->measurementLayout->addWidget(this->measurementPhaseLabel[channel], channel, 6);
+		this->measurementLayout->addWidget(this->measurementHarmonicsLabel[channel], channel, 7);
 		if((unsigned int) channel < this->settings->scope.physicalChannels)
 			this->updateVoltageCoupling(channel);
 		else
-			this->updateMathMode();
+			this->updateMathMode(channel);
 		this->updateVoltageDetails(channel);
 		this->updateSpectrumDetails(channel);
 	}
@@ -216,6 +249,7 @@ DsoWidget::DsoWidget(DsoSettings *settings, DataAnalyzer *dataAnalyzer, QWidget
 	this->mainLayout->setSpacing(0);
 	this->mainLayout->addLayout(this->settingsLayout, 0, 0, 1, 5);
 	this->mainLayout->addWidget(this->mainScope, 3, 2);
+	this->mainLayout->addWidget(this->spectrogramScope, 3, 5);
 	this->mainLayout->addWidget(this->offsetSlider, 2, 0, 3, 2, Qt::AlignRight);
 	this->mainLayout->addWidget(this->triggerPositionSlider, 1, 1, 2, 3, Qt::AlignBottom);
 	this->mainLayout->addWidget(this->triggerLevelSlider, 2, 3, 3, 2, Qt::AlignLeft);
@@ -230,6 +264,10 @@ DsoWidget::DsoWidget(DsoSettings *settings, DataAnalyzer *dataAnalyzer, QWidget
 	this->updateFrequencybase();
 	this->updateTimebase();
 	this->updateZoom(this->settings->view.zoom);
+	this->updateSpectrogram(this->settings->view.spectrogram);
+	this->updateMaskDetails();
+	for(int channel = 0; channel < this->settings->scope.voltage.count(); channel++)
+		this->updateAnalysisDemand(channel);
 	
 	// The widget itself
 	this->setPalette(palette);
@@ -239,15 +277,17 @@ DsoWidget::DsoWidget(DsoSettings *settings, DataAnalyzer *dataAnalyzer, QWidget
 	
 	// Connect change-signals of sliders
 	this->connect(this->offsetSlider, SIGNAL(valueChanged(int, double)), this, SLOT(updateOffset(int, double)));
+	this->connect(this->offsetSlider, SIGNAL(valueChanged(int, double)), this->framePacer, SLOT(requestUpdate()));
 	this->connect(this->triggerPositionSlider, SIGNAL(valueChanged(int, double)), this, SLOT(updateTriggerPosition(int, double)));
 	this->connect(this->triggerLevelSlider, SIGNAL(valueChanged(int, double)), this, SLOT(updateTriggerLevel(int, double)));
 	this->connect(this->markerSlider, SIGNAL(valueChanged(int, double)), this, SLOT(updateMarker(int, double)));
-	this->connect(this->markerSlider, SIGNAL(valueChanged(int, double)), this->mainScope, SLOT(updateGL()));
-	this->connect(this->markerSlider, SIGNAL(valueChanged(int, double)), this->zoomScope, SLOT(updateGL()));
+	this->connect(this->markerSlider, SIGNAL(valueChanged(int, double)), this->framePacer, SLOT(requestUpdate()));
 	
 	// Connect other signals
 	this->connect(this->dataAnalyzer, SIGNAL(analyzed(unsigned int)), this, SLOT(dataAnalyzed()));
 	this->connect(this->dataAnalyzer, SIGNAL(analyzed(unsigned int)), this, SLOT(updateBufferSize(unsigned int)));
+	this->connect(this->dataAnalyzer, SIGNAL(analyzed(unsigned int)), this->framePacer, SLOT(countAcquisition()));
+	this->connect(this->framePacer, SIGNAL(ratesChanged(double, double)), this, SLOT(updateFrameRates(double, double)));
 }
 
 /// \brief Stops the oscilloscope thread and the timer.
@@ -268,14 +308,37 @@ void DsoWidget::setMeasurementVisible(unsigned int channel, bool visible) {
 	this->measurementMagnitudeLabel[channel]->setVisible(visible);
 	this->measurementAmplitudeLabel[channel]->setVisible(visible);
 	this->measurementFrequencyLabel[channel]->setVisible(visible);
+	this->measurementPhaseLabel[channel]->setVisible(visible && this->settings->scope.phase.enabled && channel != this->settings->scope.phase.reference);
+	this->measurementHarmonicsLabel[channel]->setVisible(visible && this->settings->scope.spectrumHarmonics);
 	if(!visible) {
 		this->measurementGainLabel[channel]->setText(QString());
 		this->measurementMagnitudeLabel[channel]->setText(QString());
 		this->measurementAmplitudeLabel[channel]->setText(QString());
 		this->measurementFrequencyLabel[channel]->setText(QString());
+		this->measurementPhaseLabel[channel]->setText(QString());
+		this->measurementHarmonicsLabel[channel]->setText(QString());
 	}
 }
 
+/// \brief Tell the data analyzer which values are shown for a channel.
+/// \param channel The channel whose graphs or measurements have been toggled.
+void DsoWidget::updateAnalysisDemand(unsigned int channel) {
+	bool measured = this->settings->scope.voltage[channel].used || this->settings->scope.spectrum[channel].used;
+	int products = 0;
+	if(measured) {
+		products = ANALYSIS_AMPLITUDE | ANALYSIS_FREQUENCY;
+		if(this->settings->scope.spectrumHarmonics)
+			products |= ANALYSIS_HARMONICS;
+		if(this->settings->scope.phase.enabled && channel != this->settings->scope.phase.reference)
+			products |= ANALYSIS_DELAY;
+	}
+	// The phase is calculated from the frequency of the reference
+	if(this->settings->scope.phase.enabled && channel == this->settings->scope.phase.reference)
+		products |= ANALYSIS_FREQUENCY;
+	this->dataAnalyzer->setDemand(CONSUMER_MEASUREMENT, channel, products);
+	this->dataAnalyzer->setDemand(CONSUMER_DISPLAY, channel, this->settings->scope.spectrum[channel].used ? ANALYSIS_SPECTRUM : 0);
+}
+
 /// \brief Update the label about the marker measurements
 void DsoWidget::updateMarkerDetails() {
 	double divs = fabs(this->settings->scope.horizontal.marker[1] - this->settings->scope.horizontal.marker[0]);
@@ -290,6 +353,16 @@ void DsoWidget::updateMarkerDetails() {
 	this->markerFrequencyLabel->setText(Helper::valueToString(1.0 / time, Helper::UNIT_HERTZ, 4));
 }
 
+/// \brief Update the label with the mask test counters.
+void DsoWidget::updateMaskDetails() {
+	this->settingsMaskLabel->setVisible(this->settings->scope.mask.enabled);
+	if(!this->settings->scope.mask.enabled)
+		return;
+	
+	const MaskTest *maskTest = this->dataAnalyzer->maskTest();
+	this->settingsMaskLabel->setText(tr("Mask: %L1 passed, %L2 failed, %L3 violations").arg(maskTest->passedCount()).arg(maskTest->failedCount()).arg(maskTest->violationCount()));
+}
+
 /// \brief Update the label about the trigger settings
 void DsoWidget::updateSpectrumDetails(unsigned int channel) {
 	this->setMeasurementVisible(channel, this->settings->scope.voltage[channel].used || this->settings->scope.spectrum[channel].used);
@@ -329,6 +402,8 @@ void DsoWidget::updateVoltageDetails(unsigned int channel) {
 /// \brief Handles frequencybaseChanged signal from the horizontal dock.
 void DsoWidget::updateFrequencybase() {
 	this->settingsFrequencybaseLabel->setText(Helper::valueToString(this->settings->scope.horizontal.frequencybase, Helper::UNIT_HERTZ, 0) + tr("/div"));
+	
+	this->framePacer->requestUpdate();
 }
 
 /// \brief Updates the sample rate field after changing the sample rate.
@@ -341,12 +416,17 @@ void DsoWidget::updateTimebase() {
 	this->settingsTimebaseLabel->setText(Helper::valueToString(this->settings->scope.horizontal.timebase, Helper::UNIT_SECONDS, 0) + tr("/div"));
 	
 	this->updateMarkerDetails();
+	
+	// The graphs only contain the samples of the old timebase
+	this->generator->generateGraphs();
 }
 
 /// \brief Handles magnitudeChanged signal from the spectrum dock.
 /// \param channel The channel whose magnitude was changed.
 void DsoWidget::updateSpectrumMagnitude(unsigned int channel) {
 	this->updateSpectrumDetails(channel);
+	
+	this->framePacer->requestUpdate();
 }
 
 /// \brief Handles usedChanged signal from the spectrum dock.
@@ -359,6 +439,7 @@ void DsoWidget::updateSpectrumUsed(unsigned int channel, bool used) {
 	this->offsetSlider->setVisible(this->settings->scope.voltage.count() + channel, used);
 	
 	this->updateSpectrumDetails(channel);
+	this->updateAnalysisDemand(channel);
 }
 
 /// \brief Handles modeChanged signal from the trigger dock.
@@ -394,9 +475,16 @@ void DsoWidget::updateVoltageCoupling(unsigned int channel) {
 	this->measurementMiscLabel[channel]->setText(Dso::couplingString((Dso::Coupling) this->settings->scope.voltage[channel].misc));
 }
 
-/// \brief Handles modeChanged signal from the voltage dock.
-void DsoWidget::updateMathMode() {
-	this->measurementMiscLabel[this->settings->scope.physicalChannels]->setText(Dso::mathModeString((Dso::MathMode) this->settings->scope.voltage[this->settings->scope.physicalChannels].misc));
+/// \brief Handles modeChanged and expressionChanged signals from the voltage dock.
+/// \param channel The math channel whose mode or formula was changed.
+void DsoWidget::updateMathMode(unsigned int channel) {
+	if(channel < this->settings->scope.physicalChannels || channel >= (unsigned int) this->settings->scope.voltage.count())
+		return;
+	
+	if(this->settings->scope.voltage[channel].misc == Dso::MATHMODE_EXPRESSION)
+		this->measurementMiscLabel[channel]->setText(this->settings->scope.voltage[channel].expression);
+	else
+		this->measurementMiscLabel[channel]->setText(Dso::mathModeString((Dso::MathMode) this->settings->scope.voltage[channel].misc));
 }
 
 /// \brief Handles gainChanged signal from the voltage dock.
@@ -409,6 +497,8 @@ void DsoWidget::updateVoltageGain(unsigned int channel) {
 		this->adaptTriggerLevelSlider(channel);
 	
 	this->updateVoltageDetails(channel);
+	
+	this->framePacer->requestUpdate();
 }
 
 /// \brief Handles usedChanged signal from the voltage dock.
@@ -423,6 +513,7 @@ void DsoWidget::updateVoltageUsed(unsigned int channel, bool used) {
 	this->setMeasurementVisible(channel, this->settings->scope.voltage[channel].used);
 	
 	this->updateVoltageDetails(channel);
+	this->updateAnalysisDemand(channel);
 }
 
 /// \brief Change the buffer size.
@@ -446,24 +537,75 @@ bool DsoWidget::exportAs() {
 	if(fileDialog.exec() != QDialog::Accepted)
 		return false;
 	
-	Exporter exporter(this->settings, this->dataAnalyzer, (QWidget *) this->parent());
-	exporter.setFilename(fileDialog.selectedFiles().first());
+	Exporter *exporter = this->createExporter();
+	exporter->setFilename(fileDialog.selectedFiles().first());
 #if (QT_VERSION >= 0x050000)
-	exporter.setFormat((ExportFormat) (EXPORT_FORMAT_PDF + filters.indexOf(fileDialog.selectedNameFilter())));
+	exporter->setFormat((ExportFormat) (EXPORT_FORMAT_PDF + filters.indexOf(fileDialog.selectedNameFilter())));
 #else
-	exporter.setFormat((ExportFormat) (EXPORT_FORMAT_PDF + filters.indexOf(fileDialog.selectedNameFilter())));
+	exporter->setFormat((ExportFormat) (EXPORT_FORMAT_PDF + filters.indexOf(fileDialog.selectedNameFilter())));
 #endif
 	
-	return exporter.doExport();
+	if(!exporter->doExport()) {
+		delete exporter;
+		return false;
+	}
+	
+	return true;
 }
 
 /// \brief Print the oscilloscope screen.
-/// \return true if the document was sent to the printer successfully.
+/// \return true if the printing has been started.
 bool DsoWidget::print() {
-	Exporter exporter(this->settings, this->dataAnalyzer, (QWidget *) this->parent());
-	exporter.setFormat(EXPORT_FORMAT_PRINTER);
+	Exporter *exporter = this->createExporter();
+	exporter->setFormat(EXPORT_FORMAT_PRINTER);
+	
+	if(!exporter->doExport()) {
+		delete exporter;
+		return false;
+	}
 	
-	return exporter.doExport();
+	return true;
+}
+
+/// \brief Creates an exporter that reports to this widget.
+/// The exporter runs in the background and deletes itself when it's done.
+/// \return The new exporter.
+Exporter *DsoWidget::createExporter() {
+	Exporter *exporter = new Exporter(this->settings, this->dataAnalyzer, (QWidget *) this->parent());
+	connect(exporter, SIGNAL(progress(int)), this, SLOT(exportProgress(int)));
+	connect(exporter, SIGNAL(exported(bool)), this, SLOT(exportFinished(bool)));
+	connect(exporter, SIGNAL(finished()), exporter, SLOT(deleteLater()));
+	
+	return exporter;
+}
+
+/// \brief Create the mask around the current waveform of the tested channel.
+/// \return true if there was a waveform the mask could be created from.
+bool DsoWidget::createMask() {
+	DsoSettingsScopeMask &mask = this->settings->scope.mask;
+	if(mask.channel >= (unsigned int) this->settings->scope.voltage.count())
+		return false;
+	
+	// The analyzer thread reads the mask while it holds the mutex
+	this->dataAnalyzer->mutex()->lock();
+	const AnalyzedData *data = this->dataAnalyzer->data(mask.channel);
+	bool available = data && data->samples.voltage.sample;
+	if(available) {
+		MaskTest::create(mask, data->samples.voltage.sample, data->samples.voltage.count, data->samples.voltage.interval, mask.toleranceTime * this->settings->scope.horizontal.timebase, mask.toleranceVoltage * this->settings->scope.voltage[mask.channel].gain);
+		mask.enabled = true;
+	}
+	this->dataAnalyzer->mutex()->unlock();
+	
+	if(available)
+		this->resetMaskTest();
+	
+	return available;
+}
+
+/// \brief Set the counters of the mask test to zero.
+void DsoWidget::resetMaskTest() {
+	this->dataAnalyzer->resetMaskTest();
+	this->updateMaskDetails();
 }
 
 /// \brief Stop the oscilloscope.
@@ -480,10 +622,20 @@ void DsoWidget::updateZoom(bool enabled) {
 		this->updateMarkerDetails();
 	else
 		this->markerInfoLabel->setText(tr("Marker 1/2"));
+	this->generator->generateGraphs();
 	
 	this->repaint();
 }
 
+/// \brief Show/hide the spectrogram waterfall next to the main scope.
+/// \param enabled true if the waterfall should be shown.
+void DsoWidget::updateSpectrogram(bool enabled) {
+	// The scope keeps two thirds of the width
+	this->mainLayout->setColumnStretch(2, enabled ? 2 : 1);
+	this->mainLayout->setColumnStretch(5, enabled ? 1 : 0);
+	this->spectrogramScope->setVisible(enabled);
+}
+
 /// \brief Prints analyzed data.
 void DsoWidget::dataAnalyzed() {
 	for(int channel = 0; channel < this->settings->scope.voltage.count(); channel++) {
@@ -493,7 +645,53 @@ void DsoWidget::dataAnalyzed() {
 			// Frequency string representation (5 significant digits)
 			this->measurementFrequencyLabel[channel]->setText(Helper::valueToString(this->dataAnalyzer->data(channel)->frequency, Helper::UNIT_HERTZ, 5));
 		}
+		
+		// Delay and phase against the reference channel
+		const AnalyzedData *data = this->dataAnalyzer->data(channel);
+		if(this->settings->scope.phase.enabled && (unsigned int) channel != this->settings->scope.phase.reference)
+			this->measurementPhaseLabel[channel]->setText(tr("%1%2, %L3%4").arg((data->delay < 0) ? "-" : "").arg(Helper::valueToString(fabs(data->delay), Helper::UNIT_SECONDS, 4)).arg(data->phase, 0, 'f', 1).arg(QString::fromUtf8("\u00b0")));
+		else
+			this->measurementPhaseLabel[channel]->setText(QString());
+		
+		// Distortion figures (3 significant digits)
+		const HarmonicValues &harmonics = data->harmonics;
+		if(this->settings->scope.spectrumHarmonics && harmonics.valid)
+			this->measurementHarmonicsLabel[channel]->setText(tr("THD %1, THD+N %2, SNR %3, SINAD %4, ENOB %L5, SFDR %6").arg(Helper::valueToString(harmonics.thd, Helper::UNIT_DECIBEL, 3), Helper::valueToString(harmonics.thdNoise, Helper::UNIT_DECIBEL, 3), Helper::valueToString(harmonics.snr, Helper::UNIT_DECIBEL, 3), Helper::valueToString(harmonics.sinad, Helper::UNIT_DECIBEL, 3)).arg(harmonics.enob, 0, 'f', 2).arg(Helper::valueToString(harmonics.sfdr, Helper::UNIT_DECIBEL, 3)));
+		else
+			this->measurementHarmonicsLabel[channel]->setText(QString());
 	}
+	
+	this->updateMaskDetails();
+}
+
+/// \brief Shows or hides the optional measurements after the settings changed.
+void DsoWidget::updateMeasurements() {
+	for(int channel = 0; channel < this->settings->scope.voltage.count(); channel++) {
+		this->setMeasurementVisible(channel, this->settings->scope.voltage[channel].used || this->settings->scope.spectrum[channel].used);
+		this->updateAnalysisDemand(channel);
+	}
+}
+
+/// \brief Shows the achieved display rate next to the acquisition rate.
+/// \param displayRate The screen updates per second.
+/// \param acquisitionRate The acquisitions per second.
+void DsoWidget::updateFrameRates(double displayRate, double acquisitionRate) {
+	this->settingsFrameRateLabel->setText(tr("%L1/%L2 fps").arg(displayRate, 0, 'f', 0).arg(acquisitionRate, 0, 'f', 0));
+}
+
+/// \brief Shows the progress of a background export.
+/// \param percent The finished part of the export.
+void DsoWidget::exportProgress(int percent) {
+	emit statusMessage(tr("Exporting... %1%").arg(percent), 0);
+}
+
+/// \brief Shows the result of a background export.
+/// \param success true if the export has been written.
+void DsoWidget::exportFinished(bool success) {
+	if(success)
+		emit statusMessage(tr("Export finished"), 3000);
+	else
+		emit statusMessage(tr("Export failed"), 3000);
 }
 
 /// \brief Handles valueChanged signal from the offset sliders.
@@ -545,5 +743,9 @@ void DsoWidget::updateMarker(int marker, double value) {
 	
 	this->updateMarkerDetails();
 	
+	// The magnified scope only gets the samples between the markers
+	if(this->settings->view.zoom)
+		this->generator->generateGraphs();
+	
 	emit markerChanged(marker, value);
 }
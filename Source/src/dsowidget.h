@@ -36,6 +36,9 @@
 
 class DataAnalyzer;
 class DsoSettings;
+class Exporter;
+class FramePacer;
+class GlSpectrogram;
 class QGridLayout;
 
 
@@ -52,16 +55,21 @@ class DsoWidget : public QWidget {
 	
 	protected:
 		void adaptTriggerLevelSlider(unsigned int channel);
+		void updateAnalysisDemand(unsigned int channel);
 		void setMeasurementVisible(unsigned int channel, bool visible);
 		void updateMarkerDetails();
+		void updateMaskDetails();
 		void updateSpectrumDetails(unsigned int channel);
 		void updateTriggerDetails();
 		void updateVoltageDetails(unsigned int channel);
+		Exporter *createExporter();
 		
 		QGridLayout *mainLayout; ///< The main layout for this widget
 		GlGenerator *generator; ///< The generator for the OpenGL vertex arrays
 		GlScope *mainScope; ///< The main scope screen
 		GlScope *zoomScope; ///< The optional magnified scope screen
+		GlSpectrogram *spectrogramScope; ///< The optional waterfall next to the scope
+		FramePacer *framePacer; ///< Limits the redraws of the screens
 		LevelSlider *offsetSlider; ///< The sliders for the graph offsets
 		LevelSlider *triggerPositionSlider; ///< The slider for the pretrigger
 		LevelSlider *triggerLevelSlider; ///< The sliders for the trigger level
@@ -69,10 +77,12 @@ class DsoWidget : public QWidget {
 		
 		QHBoxLayout *settingsLayout; ///< The table for the settings info
 		QLabel *settingsTriggerLabel; ///< The trigger details
+		QLabel *settingsMaskLabel; ///< The mask test counters
 		QLabel *settingsBufferLabel; ///< The buffer size
 		QLabel *settingsRateLabel; ///< The samplerate
 		QLabel *settingsTimebaseLabel; ///< The timebase of the main scope
 		QLabel *settingsFrequencybaseLabel; ///< The frequencybase of the main scope
+		QLabel *settingsFrameRateLabel; ///< The display and acquisition rates
 		
 		QHBoxLayout *markerLayout; ///< The table for the marker details
 		QLabel *markerInfoLabel; ///< The info about the zoom factor
@@ -88,6 +98,8 @@ class DsoWidget : public QWidget {
 		QList<QLabel *> measurementMiscLabel; ///< Coupling or math mode
 		QList<QLabel *> measurementAmplitudeLabel; ///< Amplitude of the signal (V)
 		QList<QLabel *> measurementFrequencyLabel; ///< Frequency of the signal (Hz)
+		QList<QLabel *> measurementPhaseLabel; ///< Delay and phase against the reference
+		QList<QLabel *> measurementHarmonicsLabel; ///< Distortion figures of the signal
 		
 		DsoSettings *settings; ///< The settings provided by the main window
 		
@@ -111,7 +123,7 @@ class DsoWidget : public QWidget {
 		
 		// Vertical axis
     void updateVoltageCoupling(unsigned int channel);
-		void updateMathMode();
+		void updateMathMode(unsigned int channel);
 		void updateVoltageGain(unsigned int channel);
 		void updateVoltageUsed(unsigned int channel, bool used);
 		
@@ -122,11 +134,18 @@ class DsoWidget : public QWidget {
 		bool exportAs();
 		bool print();
 		
+		// Mask test
+		bool createMask();
+		void resetMaskTest();
+		
 		// Scope control
 		void updateZoom(bool enabled);
+		void updateSpectrogram(bool enabled);
 		
 		// Data analyzer
 		void dataAnalyzed();
+		void updateMeasurements();
+		void updateFrameRates(double displayRate, double acquisitionRate);
 	
 	protected slots:
 		// Sliders
@@ -134,6 +153,10 @@ class DsoWidget : public QWidget {
 		void updateTriggerPosition(int index, double value);
 		void updateTriggerLevel(int channel, double value);
 		void updateMarker(int marker, double value);
+		
+		// Export
+		void exportProgress(int percent);
+		void exportFinished(bool success);
 	
 	signals:
 		// Sliders
@@ -141,6 +164,9 @@ class DsoWidget : public QWidget {
 		void triggerPositionChanged(double value); ///< The pretrigger has been changed
 		void triggerLevelChanged(unsigned int channel, double value); ///< A trigger level has been changed
 		void markerChanged(unsigned int marker, double value); ///< A marker position has been changed
+		
+		// Export
+		void statusMessage(const QString &message, int timeout); ///< Reports the progress of a background export
 };
 
 
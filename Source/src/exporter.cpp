@@ -26,35 +26,49 @@
 
 #include <QFile>
 #include <QImage>
-#include <QMutex>
 #include <QPainter>
-#include <QPixmap>
 #include <QPrintDialog>
 #include <QPrinter>
-#include <QTextStream>
+#include <QStringList>
+#include <QVector>
 
 
 #include "exporter.h"
 
+#include "csvwriter.h"
 #include "dataanalyzer.h"
 #include "dso.h"
 #include "glgenerator.h"
 #include "helper.h"
+#include "minmaxpyramid.h"
 #include "settings.h"
 
 
 ////////////////////////////////////////////////////////////////////////////////
 // class HorizontalDock
 /// \brief Initializes the printer object.
-Exporter::Exporter(DsoSettings *settings, DataAnalyzer *dataAnalyzer, QWidget *parent) : QObject(parent) {
-	this->settings = settings;
+/// \param settings The settings, the exporter keeps a copy of them.
+/// \param dataAnalyzer The analyzer the data is taken from.
+/// \param parent The parent widget for the printing dialog.
+Exporter::Exporter(DsoSettings *settings, DataAnalyzer *dataAnalyzer, QWidget *parent) : QThread(parent) {
+	// The user may change the settings while the export is running
+	this->settings = new DsoSettings();
+	this->settings->options = settings->options;
+	this->settings->scope = settings->scope;
+	this->settings->view = settings->view;
 	this->dataAnalyzer = dataAnalyzer;
+	this->printer = 0;
 	
 	this->format = EXPORT_FORMAT_PRINTER;
 }
 
 /// \brief Cleans up everything.
 Exporter::~Exporter() {
+	this->wait();
+	
+	if(this->printer)
+		delete this->printer;
+	delete this->settings;
 }
 
 /// \brief Set the filename of the output file (Not used for printing).
@@ -69,330 +83,470 @@ void Exporter::setFormat(ExportFormat format) {
 		this->format = format;
 }
 
-/// \brief Print the document (May be a file too)
+/// \brief Starts the export of the current data (Printing too).
+/// The printing dialog is shown first, then the data is copied and the export
+/// continues in the background. The result is reported by exported().
+/// \return true if the export has been started.
 bool Exporter::doExport() {
-	if(this->format < EXPORT_FORMAT_CSV) {
-		// Choose the color values we need
-		DsoSettingsColorValues *colorValues;
-		if(this->format == EXPORT_FORMAT_IMAGE && this->settings->view.screenColorImages)
-			colorValues = &(this->settings->view.color.screen);
-		else
-			colorValues = &(this->settings->view.color.print);
-		
-		QPaintDevice *paintDevice;
+	if(this->isRunning())
+		return false;
+	
+	if(this->format < EXPORT_FORMAT_IMAGE) {
+		// We need a QPrinter for printing, pdf- and ps-export
+		if(this->printer)
+			delete this->printer;
+		this->printer = new QPrinter(QPrinter::HighResolution);
+		this->printer->setOrientation(this->settings->view.zoom ? QPrinter::Portrait : QPrinter::Landscape);
+		this->printer->setPageMargins(20, 20, 20, 20, QPrinter::Millimeter);
 		
-		if(this->format < EXPORT_FORMAT_IMAGE) {
-			// We need a QPrinter for printing, pdf- and ps-export
-			paintDevice = new QPrinter(QPrinter::HighResolution);
-			((QPrinter *) paintDevice)->setOrientation(this->settings->view.zoom ? QPrinter::Portrait : QPrinter::Landscape);
-			((QPrinter *) paintDevice)->setPageMargins(20, 20, 20, 20, QPrinter::Millimeter);
-			
-			if(this->format == EXPORT_FORMAT_PRINTER) {
-				// Show the printing dialog
-				QPrintDialog *dialog = new QPrintDialog((QPrinter *) paintDevice, (QWidget *) this->parent());
-				dialog->setWindowTitle(tr("Print oscillograph"));
-				if(dialog->exec() != QDialog::Accepted)
-					return false;
-			}
-			else {
-				// Configure the QPrinter
-				((QPrinter *) paintDevice)->setOutputFileName(this->filename);
-				((QPrinter *) paintDevice)->setOutputFormat((this->format == EXPORT_FORMAT_PDF) ? QPrinter::PdfFormat : QPrinter::NativeFormat);
-			}
+		if(this->format == EXPORT_FORMAT_PRINTER) {
+			// Show the printing dialog, it has to be done in the gui thread
+			QPrintDialog *dialog = new QPrintDialog(this->printer, (QWidget *) this->parent());
+			dialog->setWindowTitle(tr("Print oscillograph"));
+			bool accepted = dialog->exec() == QDialog::Accepted;
+			delete dialog;
+			if(!accepted)
+				return false;
 		}
 		else {
-			// We need a QPixmap for image-export
-			paintDevice = new QPixmap(this->settings->options.imageSize);
-			((QPixmap *) paintDevice)->fill(colorValues->background);
-		}
-		
-		// Create a painter for our device
-		QPainter painter(paintDevice);
-		
-		// Get line height
-		QFont font;
-		QFontMetrics fontMetrics(font, paintDevice);
-		double lineHeight = fontMetrics.height();
-		
-		painter.setBrush(Qt::SolidPattern);
-		
-		this->dataAnalyzer->mutex()->lock();
-		
-		// Draw the settings table
-		double stretchBase = (double) (paintDevice->width() - lineHeight * 10) / 4;
-		
-		// Print trigger details
-		painter.setPen(colorValues->voltage[this->settings->scope.trigger.source]);
-		QString levelString = Helper::valueToString(this->settings->scope.voltage[this->settings->scope.trigger.source].trigger, Helper::UNIT_VOLTS, 3);
-		QString pretriggerString = tr("%L1%").arg((int) (this->settings->scope.trigger.position * 100 + 0.5));
-		painter.drawText(QRectF(0, 0, lineHeight * 10, lineHeight), tr("%1  %2  %3  %4").arg(this->settings->scope.voltage[this->settings->scope.trigger.source].name, Dso::slopeString(this->settings->scope.trigger.slope), levelString, pretriggerString));
-		
-		// Print sample count
-		painter.setPen(colorValues->text);
-		painter.drawText(QRectF(lineHeight * 10, 0, stretchBase, lineHeight), tr("%1 S").arg(this->dataAnalyzer->sampleCount()), QTextOption(Qt::AlignRight));
-		// Print samplerate
-		painter.drawText(QRectF(lineHeight * 10 + stretchBase, 0, stretchBase, lineHeight), Helper::valueToString(this->settings->scope.horizontal.samplerate, Helper::UNIT_SAMPLES) + tr("/s"), QTextOption(Qt::AlignRight));
-		// Print timebase
-		painter.drawText(QRectF(lineHeight * 10 + stretchBase * 2, 0, stretchBase, lineHeight), Helper::valueToString(this->settings->scope.horizontal.timebase, Helper::UNIT_SECONDS, 0) + tr("/div"), QTextOption(Qt::AlignRight));
-		// Print frequencybase
-		painter.drawText(QRectF(lineHeight * 10 + stretchBase * 3, 0, stretchBase, lineHeight), Helper::valueToString(this->settings->scope.horizontal.frequencybase, Helper::UNIT_HERTZ, 0) + tr("/div"), QTextOption(Qt::AlignRight));
-		
-		// Draw the measurement table
-		stretchBase = (double) (paintDevice->width() - lineHeight * 6) / 10;
-		int channelCount = 0;
-		for(int channel = this->settings->scope.voltage.count() - 1; channel >= 0; channel--) {
-			if(this->settings->scope.voltage[channel].used || this->settings->scope.spectrum[channel].used) {
-				channelCount++;
-				double top = (double) paintDevice->height() - channelCount * lineHeight;
-				
-				// Print label
-				painter.setPen(colorValues->voltage[channel]);
-				painter.drawText(QRectF(0, top, lineHeight * 4, lineHeight), this->settings->scope.voltage[channel].name);
-				// Print coupling/math mode
-				if((unsigned int) channel < this->settings->scope.physicalChannels)
-					painter.drawText(QRectF(lineHeight * 4, top, lineHeight * 2, lineHeight), Dso::couplingString((Dso::Coupling) this->settings->scope.voltage[channel].misc));
-				else
-					painter.drawText(QRectF(lineHeight * 4, top, lineHeight * 2, lineHeight), Dso::mathModeString((Dso::MathMode) this->settings->scope.voltage[channel].misc));
-				
-				// Print voltage gain
-				painter.drawText(QRectF(lineHeight * 6, top, stretchBase * 2, lineHeight), Helper::valueToString(this->settings->scope.voltage[channel].gain, Helper::UNIT_VOLTS, 0) + tr("/div"), QTextOption(Qt::AlignRight));
-				// Print spectrum magnitude
-				painter.setPen(colorValues->spectrum[channel]);
-				painter.drawText(QRectF(lineHeight * 6 + stretchBase * 2, top, stretchBase * 2, lineHeight), Helper::valueToString(this->settings->scope.spectrum[channel].magnitude, Helper::UNIT_DECIBEL, 0) + tr("/div"), QTextOption(Qt::AlignRight));
-				
-				// Amplitude string representation (4 significant digits)
-				painter.setPen(colorValues->text);
-				painter.drawText(QRectF(lineHeight * 6 + stretchBase * 4, top, stretchBase * 3, lineHeight), Helper::valueToString(this->dataAnalyzer->data(channel)->amplitude, Helper::UNIT_VOLTS, 4), QTextOption(Qt::AlignRight));
-				// Frequency string representation (5 significant digits)
-				painter.drawText(QRectF(lineHeight * 6 + stretchBase * 7, top, stretchBase * 3, lineHeight), Helper::valueToString(this->dataAnalyzer->data(channel)->frequency, Helper::UNIT_HERTZ, 5), QTextOption(Qt::AlignRight));
-			}
+			// Configure the QPrinter
+			this->printer->setOutputFileName(this->filename);
+			this->printer->setOutputFormat((this->format == EXPORT_FORMAT_PDF) ? QPrinter::PdfFormat : QPrinter::NativeFormat);
 		}
-		
-		// Draw the marker table
-		double scopeHeight;
-		stretchBase = (double) (paintDevice->width() - lineHeight * 10) / 4;
-		painter.setPen(colorValues->text);
-		
-		// Calculate variables needed for zoomed scope
-		double divs = fabs(this->settings->scope.horizontal.marker[1] - this->settings->scope.horizontal.marker[0]);
-		double time = divs * this->settings->scope.horizontal.timebase;
-		double zoomFactor = DIVS_TIME / divs;
-		double zoomOffset = (this->settings->scope.horizontal.marker[0] + this->settings->scope.horizontal.marker[1]) / 2;
-		
-		if(this->settings->view.zoom) {
-			scopeHeight = (double) (paintDevice->height() - (channelCount + 5) * lineHeight) / 2;
-			double top = 2.5 * lineHeight + scopeHeight;
-			
-			painter.drawText(QRectF(0, top, stretchBase, lineHeight), tr("Zoom x%L1").arg(DIVS_TIME / divs, -1, 'g', 3));
-			
-			painter.drawText(QRectF(lineHeight * 10, top, stretchBase, lineHeight), Helper::valueToString(time, Helper::UNIT_SECONDS, 4), QTextOption(Qt::AlignRight));
-			painter.drawText(QRectF(lineHeight * 10 + stretchBase, top, stretchBase, lineHeight), Helper::valueToString(1.0 / time, Helper::UNIT_HERTZ, 4), QTextOption(Qt::AlignRight));
+	}
+	
+	// The analyzer is only locked while the data is copied
+	this->frame = this->dataAnalyzer->snapshot();
+	if(!this->frame->data(this->settings->scope.voltage.count() - 1)) {
+		qWarning("No analyzed data to export");
+		this->frame.clear();
+		return false;
+	}
+	
+	this->start(QThread::LowPriority);
+	return true;
+}
+
+/// \brief Exports the copied data.
+void Exporter::run() {
+	bool success;
+	if(this->format < EXPORT_FORMAT_CSV)
+		success = this->exportGraphs();
+	else
+		success = this->exportCsv();
+	
+	// Free the copy as soon as possible, it can be large
+	this->frame.clear();
+	
+	emit exported(success);
+}
+
+/// \brief Draws the screen on the printer or into an image file.
+/// \return true if the document has been written.
+bool Exporter::exportGraphs() {
+	// Choose the color values we need
+	DsoSettingsColorValues *colorValues;
+	if(this->format == EXPORT_FORMAT_IMAGE && this->settings->view.screenColorImages)
+		colorValues = &(this->settings->view.color.screen);
+	else
+		colorValues = &(this->settings->view.color.print);
+	
+	QPaintDevice *paintDevice;
+	QImage *image = 0;
+	if(this->format < EXPORT_FORMAT_IMAGE) {
+		paintDevice = this->printer;
+	}
+	else {
+		// We need a QImage for image-export, pixmaps are only available in the gui thread
+		image = new QImage(this->settings->options.imageSize, QImage::Format_ARGB32);
+		image->fill(colorValues->background.rgba());
+		paintDevice = image;
+	}
+	
+	// Create a painter for our device
+	QPainter painter;
+	if(!painter.begin(paintDevice)) {
+		if(image)
+			delete image;
+		return false;
+	}
+	
+	// Get line height
+	QFont font;
+	QFontMetrics fontMetrics(font, paintDevice);
+	double lineHeight = fontMetrics.height();
+	
+	painter.setBrush(Qt::SolidPattern);
+	
+	// Draw the settings table
+	double stretchBase = (double) (paintDevice->width() - lineHeight * 10) / 4;
+	
+	// Print trigger details
+	painter.setPen(colorValues->voltage[this->settings->scope.trigger.source]);
+	QString levelString = Helper::valueToString(this->settings->scope.voltage[this->settings->scope.trigger.source].trigger, Helper::UNIT_VOLTS, 3);
+	QString pretriggerString = tr("%L1%").arg((int) (this->settings->scope.trigger.position * 100 + 0.5));
+	painter.drawText(QRectF(0, 0, lineHeight * 10, lineHeight), tr("%1  %2  %3  %4").arg(this->settings->scope.voltage[this->settings->scope.trigger.source].name, Dso::slopeString(this->settings->scope.trigger.slope), levelString, pretriggerString));
+	
+	// Print sample count
+	painter.setPen(colorValues->text);
+	painter.drawText(QRectF(lineHeight * 10, 0, stretchBase, lineHeight), tr("%1 S").arg(this->frame->sampleCount()), QTextOption(Qt::AlignRight));
+	// Print samplerate
+	painter.drawText(QRectF(lineHeight * 10 + stretchBase, 0, stretchBase, lineHeight), Helper::valueToString(this->settings->scope.horizontal.samplerate, Helper::UNIT_SAMPLES) + tr("/s"), QTextOption(Qt::AlignRight));
+	// Print timebase
+	painter.drawText(QRectF(lineHeight * 10 + stretchBase * 2, 0, stretchBase, lineHeight), Helper::valueToString(this->settings->scope.horizontal.timebase, Helper::UNIT_SECONDS, 0) + tr("/div"), QTextOption(Qt::AlignRight));
+	// Print frequencybase
+	painter.drawText(QRectF(lineHeight * 10 + stretchBase * 3, 0, stretchBase, lineHeight), Helper::valueToString(this->settings->scope.horizontal.frequencybase, Helper::UNIT_HERTZ, 0) + tr("/div"), QTextOption(Qt::AlignRight));
+	
+	// Draw the measurement table
+	stretchBase = (double) (paintDevice->width() - lineHeight * 6) / 10;
+	int channelCount = 0;
+	for(int channel = this->settings->scope.voltage.count() - 1; channel >= 0; channel--) {
+		if(this->settings->scope.voltage[channel].used || this->settings->scope.spectrum[channel].used) {
+			channelCount++;
+			double top = (double) paintDevice->height() - channelCount * lineHeight;
 			
-			painter.drawText(QRectF(lineHeight * 10 + stretchBase * 2, top, stretchBase, lineHeight), Helper::valueToString(time / DIVS_TIME, Helper::UNIT_SECONDS, 3) + tr("/div"), QTextOption(Qt::AlignRight));
-			painter.drawText(QRectF(lineHeight * 10 + stretchBase * 3, top, stretchBase, lineHeight), Helper::valueToString(divs  * this->settings->scope.horizontal.frequencybase / DIVS_TIME, Helper::UNIT_HERTZ, 3) + tr("/div"), QTextOption(Qt::AlignRight));
-		}
-		else {
-			scopeHeight = (double) paintDevice->height() - (channelCount + 4) * lineHeight;
-			double top = 2.5 * lineHeight + scopeHeight;
+			// Print label
+			painter.setPen(colorValues->voltage[channel]);
+			painter.drawText(QRectF(0, top, lineHeight * 4, lineHeight), this->settings->scope.voltage[channel].name);
+			// Print coupling/math mode
+			if((unsigned int) channel < this->settings->scope.physicalChannels)
+				painter.drawText(QRectF(lineHeight * 4, top, lineHeight * 2, lineHeight), Dso::couplingString((Dso::Coupling) this->settings->scope.voltage[channel].misc));
+			else if(this->settings->scope.voltage[channel].misc == Dso::MATHMODE_EXPRESSION)
+				painter.drawText(QRectF(lineHeight * 4, top, lineHeight * 2, lineHeight), this->settings->scope.voltage[channel].expression);
+			else
+				painter.drawText(QRectF(lineHeight * 4, top, lineHeight * 2, lineHeight), Dso::mathModeString((Dso::MathMode) this->settings->scope.voltage[channel].misc));
 			
-			painter.drawText(QRectF(0, top, stretchBase, lineHeight), tr("Marker 1/2"));
+			// Print voltage gain
+			painter.drawText(QRectF(lineHeight * 6, top, stretchBase * 2, lineHeight), Helper::valueToString(this->settings->scope.voltage[channel].gain, Helper::UNIT_VOLTS, 0) + tr("/div"), QTextOption(Qt::AlignRight));
+			// Print spectrum magnitude
+			painter.setPen(colorValues->spectrum[channel]);
+			painter.drawText(QRectF(lineHeight * 6 + stretchBase * 2, top, stretchBase * 2, lineHeight), Helper::valueToString(this->settings->scope.spectrum[channel].magnitude, Helper::UNIT_DECIBEL, 0) + tr("/div"), QTextOption(Qt::AlignRight));
 			
-			painter.drawText(QRectF(lineHeight * 10, top, stretchBase * 2, lineHeight), Helper::valueToString(time, Helper::UNIT_SECONDS, 4), QTextOption(Qt::AlignRight));
-			painter.drawText(QRectF(lineHeight * 10 + stretchBase * 2, top, stretchBase * 2, lineHeight), Helper::valueToString(1.0 / time, Helper::UNIT_HERTZ, 4), QTextOption(Qt::AlignRight));
+			// Amplitude string representation (4 significant digits)
+			painter.setPen(colorValues->text);
+			painter.drawText(QRectF(lineHeight * 6 + stretchBase * 4, top, stretchBase * 3, lineHeight), Helper::valueToString(this->frame->data(channel)->amplitude, Helper::UNIT_VOLTS, 4), QTextOption(Qt::AlignRight));
+			// Frequency string representation (5 significant digits)
+			painter.drawText(QRectF(lineHeight * 6 + stretchBase * 7, top, stretchBase * 3, lineHeight), Helper::valueToString(this->frame->data(channel)->frequency, Helper::UNIT_HERTZ, 5), QTextOption(Qt::AlignRight));
 		}
+	}
+	
+	// Draw the marker table
+	double scopeHeight;
+	stretchBase = (double) (paintDevice->width() - lineHeight * 10) / 4;
+	painter.setPen(colorValues->text);
+	
+	// Calculate variables needed for zoomed scope
+	double divs = fabs(this->settings->scope.horizontal.marker[1] - this->settings->scope.horizontal.marker[0]);
+	double time = divs * this->settings->scope.horizontal.timebase;
+	double zoomFactor = DIVS_TIME / divs;
+	double zoomOffset = (this->settings->scope.horizontal.marker[0] + this->settings->scope.horizontal.marker[1]) / 2;
+	
+	if(this->settings->view.zoom) {
+		scopeHeight = (double) (paintDevice->height() - (channelCount + 5) * lineHeight) / 2;
+		double top = 2.5 * lineHeight + scopeHeight;
 		
-		// Set DIVS_TIME x DIVS_VOLTAGE matrix for oscillograph
-		painter.setMatrix(QMatrix((paintDevice->width() - 1) / DIVS_TIME, 0, 0, -(scopeHeight - 1) / DIVS_VOLTAGE, (double) (paintDevice->width() - 1) / 2, (scopeHeight - 1) / 2 + lineHeight * 1.5), false);
+		painter.drawText(QRectF(0, top, stretchBase, lineHeight), tr("Zoom x%L1").arg(DIVS_TIME / divs, -1, 'g', 3));
+		
+		painter.drawText(QRectF(lineHeight * 10, top, stretchBase, lineHeight), Helper::valueToString(time, Helper::UNIT_SECONDS, 4), QTextOption(Qt::AlignRight));
+		painter.drawText(QRectF(lineHeight * 10 + stretchBase, top, stretchBase, lineHeight), Helper::valueToString(1.0 / time, Helper::UNIT_HERTZ, 4), QTextOption(Qt::AlignRight));
+		
+		painter.drawText(QRectF(lineHeight * 10 + stretchBase * 2, top, stretchBase, lineHeight), Helper::valueToString(time / DIVS_TIME, Helper::UNIT_SECONDS, 3) + tr("/div"), QTextOption(Qt::AlignRight));
+		painter.drawText(QRectF(lineHeight * 10 + stretchBase * 3, top, stretchBase, lineHeight), Helper::valueToString(divs  * this->settings->scope.horizontal.frequencybase / DIVS_TIME, Helper::UNIT_HERTZ, 3) + tr("/div"), QTextOption(Qt::AlignRight));
+	}
+	else {
+		scopeHeight = (double) paintDevice->height() - (channelCount + 4) * lineHeight;
+		double top = 2.5 * lineHeight + scopeHeight;
+		
+		painter.drawText(QRectF(0, top, stretchBase, lineHeight), tr("Marker 1/2"));
 		
-		// Draw the graphs
-		painter.setRenderHint(QPainter::Antialiasing);
-		painter.setBrush(Qt::NoBrush);
+		painter.drawText(QRectF(lineHeight * 10, top, stretchBase * 2, lineHeight), Helper::valueToString(time, Helper::UNIT_SECONDS, 4), QTextOption(Qt::AlignRight));
+		painter.drawText(QRectF(lineHeight * 10 + stretchBase * 2, top, stretchBase * 2, lineHeight), Helper::valueToString(1.0 / time, Helper::UNIT_HERTZ, 4), QTextOption(Qt::AlignRight));
+	}
+	
+	// Set DIVS_TIME x DIVS_VOLTAGE matrix for oscillograph
+	painter.setMatrix(QMatrix((paintDevice->width() - 1) / DIVS_TIME, 0, 0, -(scopeHeight - 1) / DIVS_VOLTAGE, (double) (paintDevice->width() - 1) / 2, (scopeHeight - 1) / 2 + lineHeight * 1.5), false);
+	
+	// Draw the graphs
+	painter.setRenderHint(QPainter::Antialiasing);
+	painter.setBrush(Qt::NoBrush);
+	
+	// The graphs take most of the time, the progress is counted in graphs
+	int scopeCount = this->settings->view.zoom ? 2 : 1;
+	int graphCount = scopeCount * (this->settings->scope.voltage.count() + this->settings->scope.spectrum.count());
+	int graph = 0;
+	for(int zoomed = 0; zoomed < scopeCount; zoomed++) {
+		// The graphs don't need more points than the device has pixels
+		double pixelsPerDiv = (paintDevice->width() - 1) / DIVS_TIME * (zoomed ? zoomFactor : 1);
 		
-		for(int zoomed = 0; zoomed < (this->settings->view.zoom ? 2 : 1); zoomed++) {
-			switch(this->settings->scope.horizontal.format) {
-				case Dso::GRAPHFORMAT_TY:
-					// Add graphs for channels
-					for(int channel = 0 ; channel < this->settings->scope.voltage.count(); channel++) {
-						if(this->settings->scope.voltage[channel].used) {
-							painter.setPen(colorValues->voltage[channel]);
-							
-							// What's the horizontal distance between sampling points?
-							double horizontalFactor = this->dataAnalyzer->data(channel)->samples.voltage.interval / this->settings->scope.horizontal.timebase;
-							// How many samples are visible?
-							double centerPosition, centerOffset;
-							if(zoomed) {
-								centerPosition = (zoomOffset + DIVS_TIME / 2) / horizontalFactor;
-								centerOffset = DIVS_TIME / horizontalFactor / zoomFactor / 2;
-							}
-							else {
-								centerPosition = DIVS_TIME / 2 / horizontalFactor;
-								centerOffset = DIVS_TIME / horizontalFactor / 2;
-							}
-							unsigned int firstPosition = qMax((int) (centerPosition - centerOffset), 0);
-							unsigned int lastPosition = qMin((int) (centerPosition + centerOffset), (int) this->dataAnalyzer->data(channel)->samples.voltage.count - 1);
-							
-							// Draw graph
-							QPointF *graph = new QPointF[lastPosition - firstPosition + 1];
-							for(unsigned int position = firstPosition; position <= lastPosition; position++)
-								graph[position - firstPosition] = QPointF(position * horizontalFactor - DIVS_TIME / 2, this->dataAnalyzer->data(channel)->samples.voltage.sample[position] / this->settings->scope.voltage[channel].gain + this->settings->scope.voltage[channel].offset);
-							painter.drawPolyline(graph, lastPosition - firstPosition + 1);
+		switch(this->settings->scope.horizontal.format) {
+			case Dso::GRAPHFORMAT_TY:
+				// Add graphs for channels
+				for(int channel = 0 ; channel < this->settings->scope.voltage.count(); channel++) {
+					emit progress(90 * graph++ / graphCount);
+					
+					if(this->settings->scope.voltage[channel].used) {
+						painter.setPen(colorValues->voltage[channel]);
+						
+						// What's the horizontal distance between sampling points?
+						double horizontalFactor = this->frame->data(channel)->samples.voltage.interval / this->settings->scope.horizontal.timebase;
+						// How many samples are visible?
+						double centerPosition, centerOffset;
+						if(zoomed) {
+							centerPosition = (zoomOffset + DIVS_TIME / 2) / horizontalFactor;
+							centerOffset = DIVS_TIME / horizontalFactor / zoomFactor / 2;
 						}
-					}
-				
-					// Add spectrum graphs
-					for (int channel = 0; channel < this->settings->scope.spectrum.count(); channel++) {
-						if(this->settings->scope.spectrum[channel].used) {
-							painter.setPen(colorValues->spectrum[channel]);
-							
-							// What's the horizontal distance between sampling points?
-							double horizontalFactor = this->dataAnalyzer->data(channel)->samples.spectrum.interval / this->settings->scope.horizontal.frequencybase;
-							// How many samples are visible?
-							double centerPosition, centerOffset;
-							if(zoomed) {
-								centerPosition = (zoomOffset + DIVS_TIME / 2) / horizontalFactor;
-								centerOffset = DIVS_TIME / horizontalFactor / zoomFactor / 2;
-							}
-							else {
-								centerPosition = DIVS_TIME / 2 / horizontalFactor;
-								centerOffset = DIVS_TIME / horizontalFactor / 2;
-							}
-							unsigned int firstPosition = qMax((int) (centerPosition - centerOffset), 0);
-							unsigned int lastPosition = qMin((int) (centerPosition + centerOffset), (int) this->dataAnalyzer->data(channel)->samples.spectrum.count - 1);
-							
-							// Draw graph
-							QPointF *graph = new QPointF[lastPosition - firstPosition + 1];
-							for(unsigned int position = firstPosition; position <= lastPosition; position++)
-								graph[position - firstPosition] = QPointF(position * horizontalFactor - DIVS_TIME / 2, this->dataAnalyzer->data(channel)->samples.spectrum.sample[position] / this->settings->scope.spectrum[channel].magnitude + this->settings->scope.spectrum[channel].offset);
-							painter.drawPolyline(graph, lastPosition - firstPosition + 1);
+						else {
+							centerPosition = DIVS_TIME / 2 / horizontalFactor;
+							centerOffset = DIVS_TIME / horizontalFactor / 2;
 						}
+						unsigned int firstPosition = qMax((int) (centerPosition - centerOffset), 0);
+						unsigned int lastPosition = qMin((int) (centerPosition + centerOffset), (int) this->frame->data(channel)->samples.voltage.count - 1);
+						
+						// Draw graph
+						this->drawGraph(&painter, &(this->frame->data(channel)->samples.voltage), horizontalFactor, this->settings->scope.voltage[channel].gain, this->settings->scope.voltage[channel].offset, firstPosition, lastPosition, 1.0 / (horizontalFactor * pixelsPerDiv));
 					}
-					break;
+				}
+			
+				// Add spectrum graphs
+				for (int channel = 0; channel < this->settings->scope.spectrum.count(); channel++) {
+					emit progress(90 * graph++ / graphCount);
 					
-				case Dso::GRAPHFORMAT_XY:
-					break;
+					if(this->settings->scope.spectrum[channel].used) {
+						painter.setPen(colorValues->spectrum[channel]);
+						
+						// What's the horizontal distance between sampling points?
+						double horizontalFactor = this->frame->data(channel)->samples.spectrum.interval / this->settings->scope.horizontal.frequencybase;
+						// How many samples are visible?
+						double centerPosition, centerOffset;
+						if(zoomed) {
+							centerPosition = (zoomOffset + DIVS_TIME / 2) / horizontalFactor;
+							centerOffset = DIVS_TIME / horizontalFactor / zoomFactor / 2;
+						}
+						else {
+							centerPosition = DIVS_TIME / 2 / horizontalFactor;
+							centerOffset = DIVS_TIME / horizontalFactor / 2;
+						}
+						unsigned int firstPosition = qMax((int) (centerPosition - centerOffset), 0);
+						unsigned int lastPosition = qMin((int) (centerPosition + centerOffset), (int) this->frame->data(channel)->samples.spectrum.count - 1);
+						
+						// Draw graph
+						this->drawGraph(&painter, &(this->frame->data(channel)->samples.spectrum), horizontalFactor, this->settings->scope.spectrum[channel].magnitude, this->settings->scope.spectrum[channel].offset, firstPosition, lastPosition, 1.0 / (horizontalFactor * pixelsPerDiv));
+					}
+				}
+				break;
 				
-				default:
-					break;
-			}
+			case Dso::GRAPHFORMAT_XY:
+				break;
 			
-			// Set DIVS_TIME / zoomFactor x DIVS_VOLTAGE matrix for zoomed oscillograph
-			painter.setMatrix(QMatrix((paintDevice->width() - 1) / DIVS_TIME * zoomFactor, 0, 0, -(scopeHeight - 1) / DIVS_VOLTAGE, (double) (paintDevice->width() - 1) / 2 - zoomOffset * zoomFactor * (paintDevice->width() - 1) / DIVS_TIME, (scopeHeight - 1) * 1.5 + lineHeight * 4), false);
+			default:
+				break;
 		}
 		
-		this->dataAnalyzer->mutex()->unlock();
-		
-		// Draw grids
-		painter.setRenderHint(QPainter::Antialiasing, false);
-		for(int zoomed = 0; zoomed < (this->settings->view.zoom ? 2 : 1); zoomed++) {
-			// Set DIVS_TIME x DIVS_VOLTAGE matrix for oscillograph
-			painter.setMatrix(QMatrix((paintDevice->width() - 1) / DIVS_TIME, 0, 0, -(scopeHeight - 1) / DIVS_VOLTAGE, (double) (paintDevice->width() - 1) / 2, (scopeHeight - 1) * (zoomed + 0.5) + lineHeight * 1.5 + lineHeight * 2.5 * zoomed), false);
-			
-			// Grid lines
-			painter.setPen(colorValues->grid);
-			
-			if(this->format < EXPORT_FORMAT_IMAGE) {
-				// Draw vertical lines
-				for(int div = 1; div < DIVS_TIME / 2; div++) {
-					for(int dot = 1; dot < DIVS_VOLTAGE / 2 * 5; dot++) {
-						painter.drawLine(QPointF((double) -div - 0.02, (double) -dot / 5), QPointF((double) -div + 0.02, (double) -dot / 5));
-						painter.drawLine(QPointF((double) -div - 0.02, (double) dot / 5), QPointF((double) -div + 0.02, (double) dot / 5));
-						painter.drawLine(QPointF((double) div - 0.02, (double) -dot / 5), QPointF((double) div + 0.02, (double) -dot / 5));
-						painter.drawLine(QPointF((double) div - 0.02, (double) dot / 5), QPointF((double) div + 0.02, (double) dot / 5));
-					}
-				}
-				// Draw horizontal lines
-				for(int div = 1; div < DIVS_VOLTAGE / 2; div++) {
-					for(int dot = 1; dot < DIVS_TIME / 2 * 5; dot++) {
-						painter.drawLine(QPointF((double) -dot / 5, (double) -div - 0.02), QPointF((double) -dot / 5, (double) -div + 0.02));
-						painter.drawLine(QPointF((double) dot / 5, (double) -div - 0.02), QPointF((double) dot / 5, (double) -div + 0.02));
-						painter.drawLine(QPointF((double) -dot / 5, (double) div - 0.02), QPointF((double) -dot / 5, (double) div + 0.02));
-						painter.drawLine(QPointF((double) dot / 5, (double) div - 0.02), QPointF((double) dot / 5, (double) div + 0.02));
-					}
-				}
+		// Set DIVS_TIME / zoomFactor x DIVS_VOLTAGE matrix for zoomed oscillograph
+		painter.setMatrix(QMatrix((paintDevice->width() - 1) / DIVS_TIME * zoomFactor, 0, 0, -(scopeHeight - 1) / DIVS_VOLTAGE, (double) (paintDevice->width() - 1) / 2 - zoomOffset * zoomFactor * (paintDevice->width() - 1) / DIVS_TIME, (scopeHeight - 1) * 1.5 + lineHeight * 4), false);
+	}
+	
+	// The grid is the same for both scopes, collect it once and draw it in batches
+	QVector<QLineF> gridLines;
+	QVector<QPointF> gridPoints;
+	if(this->format < EXPORT_FORMAT_IMAGE) {
+		// Draw vertical lines
+		for(int div = 1; div < DIVS_TIME / 2; div++) {
+			for(int dot = 1; dot < DIVS_VOLTAGE / 2 * 5; dot++) {
+				gridLines.append(QLineF((double) -div - 0.02, (double) -dot / 5, (double) -div + 0.02, (double) -dot / 5));
+				gridLines.append(QLineF((double) -div - 0.02, (double) dot / 5, (double) -div + 0.02, (double) dot / 5));
+				gridLines.append(QLineF((double) div - 0.02, (double) -dot / 5, (double) div + 0.02, (double) -dot / 5));
+				gridLines.append(QLineF((double) div - 0.02, (double) dot / 5, (double) div + 0.02, (double) dot / 5));
 			}
-			else {
-				// Draw vertical lines
-				for(int div = 1; div < DIVS_TIME / 2; div++) {
-					for(int dot = 1; dot < DIVS_VOLTAGE / 2 * 5; dot++) {
-						painter.drawPoint(QPointF(-div, (double) -dot / 5));
-						painter.drawPoint(QPointF(-div, (double) dot / 5));
-						painter.drawPoint(QPointF(div, (double) -dot / 5));
-						painter.drawPoint(QPointF(div, (double) dot / 5));
-					}
-				}
-				// Draw horizontal lines
-				for(int div = 1; div < DIVS_VOLTAGE / 2; div++) {
-					for(int dot = 1; dot < DIVS_TIME / 2 * 5; dot++) {
-						if(dot % 5 == 0)
-							continue;                       // Already done by vertical lines
-						painter.drawPoint(QPointF((double) -dot / 5, -div));
-						painter.drawPoint(QPointF((double) dot / 5, -div));
-						painter.drawPoint(QPointF((double) -dot / 5, div));
-						painter.drawPoint(QPointF((double) dot / 5, div));
-					}
-				}
+		}
+		// Draw horizontal lines
+		for(int div = 1; div < DIVS_VOLTAGE / 2; div++) {
+			for(int dot = 1; dot < DIVS_TIME / 2 * 5; dot++) {
+				gridLines.append(QLineF((double) -dot / 5, (double) -div - 0.02, (double) -dot / 5, (double) -div + 0.02));
+				gridLines.append(QLineF((double) dot / 5, (double) -div - 0.02, (double) dot / 5, (double) -div + 0.02));
+				gridLines.append(QLineF((double) -dot / 5, (double) div - 0.02, (double) -dot / 5, (double) div + 0.02));
+				gridLines.append(QLineF((double) dot / 5, (double) div - 0.02, (double) dot / 5, (double) div + 0.02));
 			}
-				
-			// Axes
-			painter.setPen(colorValues->axes);
-			painter.drawLine(QPointF(-DIVS_TIME / 2, 0), QPointF(DIVS_TIME / 2, 0));
-			painter.drawLine(QPointF(0, -DIVS_VOLTAGE / 2), QPointF(0, DIVS_VOLTAGE / 2));
-			for(double div = 0.2; div <= DIVS_TIME / 2; div += 0.2) {
-				painter.drawLine(QPointF(div, -0.05), QPointF(div, 0.05));
-				painter.drawLine(QPointF(-div, -0.05), QPointF(-div, 0.05));
+		}
+	}
+	else {
+		// Draw vertical lines
+		for(int div = 1; div < DIVS_TIME / 2; div++) {
+			for(int dot = 1; dot < DIVS_VOLTAGE / 2 * 5; dot++) {
+				gridPoints.append(QPointF(-div, (double) -dot / 5));
+				gridPoints.append(QPointF(-div, (double) dot / 5));
+				gridPoints.append(QPointF(div, (double) -dot / 5));
+				gridPoints.append(QPointF(div, (double) dot / 5));
 			}
-			for(double div = 0.2; div <= DIVS_VOLTAGE / 2; div += 0.2) {
-				painter.drawLine(QPointF(-0.05, div), QPointF(0.05, div));
-				painter.drawLine(QPointF(-0.05, -div), QPointF(0.05, -div));
+		}
+		// Draw horizontal lines
+		for(int div = 1; div < DIVS_VOLTAGE / 2; div++) {
+			for(int dot = 1; dot < DIVS_TIME / 2 * 5; dot++) {
+				if(dot % 5 == 0)
+					continue;                       // Already done by vertical lines
+				gridPoints.append(QPointF((double) -dot / 5, -div));
+				gridPoints.append(QPointF((double) dot / 5, -div));
+				gridPoints.append(QPointF((double) -dot / 5, div));
+				gridPoints.append(QPointF((double) dot / 5, div));
 			}
-			
-			// Borders
-			painter.setPen(colorValues->border);
-			painter.drawRect(QRectF(-DIVS_TIME / 2, -DIVS_VOLTAGE / 2, DIVS_TIME, DIVS_VOLTAGE));
 		}
+	}
+	
+	// Axes
+	QVector<QLineF> axisLines;
+	axisLines.append(QLineF(-DIVS_TIME / 2, 0, DIVS_TIME / 2, 0));
+	axisLines.append(QLineF(0, -DIVS_VOLTAGE / 2, 0, DIVS_VOLTAGE / 2));
+	for(double div = 0.2; div <= DIVS_TIME / 2; div += 0.2) {
+		axisLines.append(QLineF(div, -0.05, div, 0.05));
+		axisLines.append(QLineF(-div, -0.05, -div, 0.05));
+	}
+	for(double div = 0.2; div <= DIVS_VOLTAGE / 2; div += 0.2) {
+		axisLines.append(QLineF(-0.05, div, 0.05, div));
+		axisLines.append(QLineF(-0.05, -div, 0.05, -div));
+	}
+	
+	// Draw grids
+	painter.setRenderHint(QPainter::Antialiasing, false);
+	for(int zoomed = 0; zoomed < scopeCount; zoomed++) {
+		// Set DIVS_TIME x DIVS_VOLTAGE matrix for oscillograph
+		painter.setMatrix(QMatrix((paintDevice->width() - 1) / DIVS_TIME, 0, 0, -(scopeHeight - 1) / DIVS_VOLTAGE, (double) (paintDevice->width() - 1) / 2, (scopeHeight - 1) * (zoomed + 0.5) + lineHeight * 1.5 + lineHeight * 2.5 * zoomed), false);
 		
-		painter.end();
+		// Grid lines
+		painter.setPen(colorValues->grid);
+		if(!gridLines.isEmpty())
+			painter.drawLines(gridLines);
+		if(!gridPoints.isEmpty())
+			painter.drawPoints(gridPoints.constData(), gridPoints.count());
 		
-		if(this->format == EXPORT_FORMAT_IMAGE)
-			((QPixmap *) paintDevice)->save(this->filename);
+		// Axes
+		painter.setPen(colorValues->axes);
+		painter.drawLines(axisLines);
 		
-		return true;
+		// Borders
+		painter.setPen(colorValues->border);
+		painter.drawRect(QRectF(-DIVS_TIME / 2, -DIVS_VOLTAGE / 2, DIVS_TIME, DIVS_VOLTAGE));
+	}
+	
+	painter.end();
+	emit progress(100);
+	
+	bool success = true;
+	if(image) {
+		success = image->save(this->filename);
+		delete image;
+	}
+	
+	return success;
+}
+
+/// \brief Writes the sample values as comma-separated values.
+/// Every series starts with its name and the interval between its values,
+/// either in one row per series or in one column per series.
+/// \return true if the file has been written.
+bool Exporter::exportCsv() {
+	QFile csvFile(this->filename);
+	if(!csvFile.open(QIODevice::WriteOnly | QIODevice::Text))
+		return false;
+	
+	// Collect the exported series, voltage in volts and magnitudes in dB
+	QStringList names;
+	QList<const SampleValues *> series;
+	for(int channel = 0 ; channel < this->settings->scope.voltage.count(); channel++) {
+		if(this->settings->scope.voltage[channel].used) {
+			names.append(this->settings->scope.voltage[channel].name);
+			series.append(&(this->frame->data(channel)->samples.voltage));
+		}
+		if(this->settings->scope.spectrum[channel].used) {
+			names.append(this->settings->scope.spectrum[channel].name);
+			series.append(&(this->frame->data(channel)->samples.spectrum));
+		}
+	}
+	
+	CsvWriter csvWriter(&csvFile, this->settings->options.csvPrecision);
+	
+	if(!this->settings->options.csvColumns) {
+		for(int index = 0; index < series.count(); index++) {
+			emit progress(index * 100 / series.count());
+			
+			// Start with the name and the sample interval, then all values
+			csvWriter.writeText(names[index]);
+			csvWriter.writeValue(series[index]->interval);
+			for(unsigned int position = 0; position < series[index]->count; position++)
+				csvWriter.writeValue(series[index]->sample[position]);
+			csvWriter.endRow();
+		}
 	}
 	else {
-		QFile csvFile(this->filename);
-		if(!csvFile.open(QIODevice::WriteOnly | QIODevice::Text))
-			return false;
-		
-		QTextStream csvStream(&csvFile);
+		// The names and the intervals are the first two rows
+		unsigned int rowCount = 0;
+		for(int index = 0; index < series.count(); index++) {
+			csvWriter.writeText(names[index]);
+			rowCount = qMax(rowCount, series[index]->count);
+		}
+		csvWriter.endRow();
+		for(int index = 0; index < series.count(); index++)
+			csvWriter.writeValue(series[index]->interval);
+		csvWriter.endRow();
 		
-		for(int channel = 0 ; channel < this->settings->scope.voltage.count(); channel++) {
-			if(this->settings->scope.voltage[channel].used) {
-				// Start with channel name and the sample interval
-				csvStream << "\"" << this->settings->scope.voltage[channel].name << "\"," << this->dataAnalyzer->data(channel)->samples.voltage.interval;
-				
-				// And now all sample values in volts
-				for(unsigned int position = 0; position < this->dataAnalyzer->data(channel)->samples.voltage.count; position++)
-					csvStream << "," << this->dataAnalyzer->data(channel)->samples.voltage.sample[position];
-				
-				// Finally a newline
-				csvStream << '\n';
-			}
+		// Shorter series are padded with empty fields
+		for(unsigned int position = 0; position < rowCount; position++) {
+			if(position % EXPORTER_PROGRESSROWS == 0)
+				emit progress((qint64) position * 100 / rowCount);
 			
-			if(this->settings->scope.spectrum[channel].used) {
-				// Start with channel name and the sample interval
-				csvStream << "\"" << this->settings->scope.spectrum[channel].name << "\"," << this->dataAnalyzer->data(channel)->samples.spectrum.interval;
-				
-				// And now all magnitudes in dB
-				for(unsigned int position = 0; position < this->dataAnalyzer->data(channel)->samples.spectrum.count; position++)
-					csvStream << "," << this->dataAnalyzer->data(channel)->samples.spectrum.sample[position];
-				
-				// Finally a newline
-				csvStream << '\n';
+			for(int index = 0; index < series.count(); index++) {
+				if(position < series[index]->count)
+					csvWriter.writeValue(series[index]->sample[position]);
+				else
+					csvWriter.writeEmpty();
 			}
+			csvWriter.endRow();
 		}
-		
-		csvFile.close();
-		
-		return true;
 	}
+	
+	bool success = csvWriter.flush();
+	csvFile.close();
+	emit progress(100);
+	
+	return success;
+}
+
+/// \brief Draws the visible part of a graph at the resolution of the device.
+/// Buffers with more samples than device pixels are reduced to the minimum and
+/// maximum of each block, so the output size doesn't grow with the buffer.
+/// \param painter The painter with the DIVS_TIME x DIVS_VOLTAGE matrix.
+/// \param values The samples of the graph.
+/// \param horizontalFactor The distance between two samples in divs.
+/// \param gain The vertical scale in units per div.
+/// \param offset The vertical offset in divs.
+/// \param firstPosition The first visible sample.
+/// \param lastPosition The last visible sample.
+/// \param samplesPerPixel The number of samples per device pixel.
+void Exporter::drawGraph(QPainter *painter, const SampleValues *values, double horizontalFactor, double gain, double offset, unsigned int firstPosition, unsigned int lastPosition, double samplesPerPixel) {
+	if(!values->sample || !values->count || firstPosition > lastPosition || lastPosition >= values->count)
+		return;
+	
+	QVector<QPointF> graph;
+	unsigned int level = MinMaxPyramid::levelForDensity(samplesPerPixel);
+	if(!level) {
+		graph.reserve(lastPosition - firstPosition + 1);
+		for(unsigned int position = firstPosition; position <= lastPosition; position++)
+			graph.append(QPointF(position * horizontalFactor - DIVS_TIME / 2, values->sample[position] / gain + offset));
+	}
+	else {
+		// A vertical line from the minimum to the maximum of each block
+		MinMaxPyramid pyramid;
+		pyramid.setSamples(values->sample, values->count);
+		const double *minimum = pyramid.minimum(level);
+		const double *maximum = pyramid.maximum(level);
+		unsigned int firstBlock = firstPosition >> level;
+		unsigned int lastBlock = lastPosition >> level;
+		graph.reserve((lastBlock - firstBlock + 1) * 2);
+		for(unsigned int block = firstBlock; block <= lastBlock; block++) {
+			double x = (double) (block << level) * horizontalFactor - DIVS_TIME / 2;
+			graph.append(QPointF(x, minimum[block] / gain + offset));
+			graph.append(QPointF(x, maximum[block] / gain + offset));
+		}
+	}
+	
+	painter->drawPolyline(graph.constData(), graph.count());
 }
@@ -27,12 +27,20 @@
 #define EXPORTER_H
 
 
-#include <QObject>
+#include <QSharedPointer>
 #include <QSize>
+#include <QThread>
 
 
+class AnalyzedFrame;
 class DsoSettings;
 class DataAnalyzer;
+class QPainter;
+class QPrinter;
+struct SampleValues;
+
+
+#define EXPORTER_PROGRESSROWS     65536 ///< CSV rows between two progress reports
 
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -48,7 +56,9 @@ enum ExportFormat {
 ////////////////////////////////////////////////////////////////////////////////
 /// \class Exporter                                                   exporter.h
 /// \brief Exports the oscilloscope screen to a file or prints it.
-class Exporter : public QObject {
+/// The export works on a copy of the analyzed data and the settings in its own
+/// thread, so the analysis and the screen aren't stalled by long exports.
+class Exporter : public QThread {
 	Q_OBJECT
 	
 	public:
@@ -60,13 +70,25 @@ class Exporter : public QObject {
 		
 		bool doExport();
 	
+	protected:
+		void run();
+		bool exportGraphs();
+		bool exportCsv();
+		void drawGraph(QPainter *painter, const SampleValues *values, double horizontalFactor, double gain, double offset, unsigned int firstPosition, unsigned int lastPosition, double samplesPerPixel);
+	
 	private:
 		DataAnalyzer *dataAnalyzer;
-		DsoSettings *settings;
+		DsoSettings *settings; ///< A copy of the settings when the exporter was created
+		QSharedPointer<AnalyzedFrame> frame; ///< The analyzed data when the export was started
+		QPrinter *printer; ///< The printer for printing, pdf- and ps-export
 		
 		QString filename;
 		ExportFormat format;
 		QSize size;
+	
+	signals:
+		void progress(int percent); ///< The given part of the export is done
+		void exported(bool success); ///< The export has been finished
 };
 
 
@@ -0,0 +1,279 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  OpenHantek
+//  framehistory.cpp
+//
+//  This program is free software: you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation, either version 3 of the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+
+#include <cmath>
+
+#include <QDateTime>
+#include <QMutex>
+#include <QMutexLocker>
+
+
+#include "framehistory.h"
+
+
+/// \brief Quantizes samples into 8 bit codes.
+/// \param samples The sample values.
+/// \param count The number of samples.
+/// \param offset The value of the code 0.
+/// \param scale The value difference of neighbouring codes.
+/// \param codes The array for the codes.
+/// \return The largest difference between a sample and its code in codes.
+static double quantize(const double *samples, unsigned int count, double offset, double scale, uchar *codes) {
+	double factor = 1 / scale;
+	double deviation = 0;
+	for(unsigned int position = 0; position < count; position++) {
+		double value = (samples[position] - offset) * factor;
+		double code = qBound(0.0, floor(value + 0.5), 255.0);
+		codes[position] = (uchar) code;
+		deviation = qMax(deviation, fabs(value - code));
+	}
+	
+	return deviation;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// class FrameHistory
+/// \brief Initializes the history with the default limits.
+/// \param parent The parent object.
+FrameHistory::FrameHistory(QObject *parent) : QObject(parent) {
+	this->memory = 0;
+	this->maxFrames = FRAMEHISTORY_FRAMES;
+	this->maxMemory = FRAMEHISTORY_MEMORY;
+	this->paused = false;
+	this->framesMutex = new QMutex();
+	this->samplesMutex = new QMutex();
+}
+
+/// \brief Frees the kept frames and the samples.
+FrameHistory::~FrameHistory() {
+	for(int channel = 0; channel < this->samples.count(); channel++)
+		delete[] this->samples[channel];
+	delete this->samplesMutex;
+	delete this->framesMutex;
+}
+
+/// \brief Sets the limits, the oldest frames are dropped if they are exceeded.
+/// \param frames The maximum number of kept frames.
+/// \param memory The maximum memory for the kept frames in bytes.
+void FrameHistory::setLimits(int frames, qint64 memory) {
+	QMutexLocker locker(this->framesMutex);
+	
+	this->maxFrames = qMax(frames, 1);
+	this->maxMemory = qMax(memory, (qint64) 0);
+	this->trim();
+}
+
+/// \brief Returns the number of kept frames.
+/// \return The frame count, the newest frame has the highest index.
+int FrameHistory::frameCount() const {
+	QMutexLocker locker(this->framesMutex);
+	
+	return this->frames.count();
+}
+
+/// \brief Returns the memory used by the kept frames.
+/// \return The size of the frames in bytes.
+qint64 FrameHistory::memoryUsed() const {
+	QMutexLocker locker(this->framesMutex);
+	
+	return this->memory;
+}
+
+/// \brief Returns the time a kept frame was acquired.
+/// \param frame The index of the frame.
+/// \return The time in milliseconds since the epoch, -1 if there is no such frame.
+qint64 FrameHistory::frameTime(int frame) const {
+	QMutexLocker locker(this->framesMutex);
+	if(frame < 0 || frame >= this->frames.count())
+		return -1;
+	
+	return this->frames[frame].time;
+}
+
+/// \brief Tells if new frames are ignored.
+/// \return true if the history is paused.
+bool FrameHistory::isPaused() const {
+	QMutexLocker locker(this->framesMutex);
+	
+	return this->paused;
+}
+
+/// \brief Keeps a new frame of the oscilloscope.
+/// Called directly by the acquisition thread.
+/// \param data The sample values of the channels.
+/// \param size The sample count of each channel.
+/// \param samplerate The samplerate of the samples.
+/// \param mutex The mutex for the sample data.
+void FrameHistory::addFrame(const QList<double *> *data, const QList<unsigned int> *size, double samplerate, QMutex *mutex) {
+	HistoryFrame frame;
+	
+	mutex->lock();
+	int channelCount = qMin(data->count(), size->count());
+	qint64 required = 0;
+	for(int channel = 0; channel < channelCount; channel++)
+		required += (data->at(channel) ? size->at(channel) : 0) + FRAMEHISTORY_OVERHEAD;
+	
+	this->framesMutex->lock();
+	if(this->paused || required > this->maxMemory) {
+		this->framesMutex->unlock();
+		mutex->unlock();
+		return;
+	}
+	// The buffers of the oldest frame are reused if it would be dropped anyway
+	if(!this->frames.isEmpty() && (this->frames.count() >= this->maxFrames || this->memory + required > this->maxMemory)) {
+		frame = this->frames.takeFirst();
+		this->memory -= frameMemory(frame);
+	}
+	this->framesMutex->unlock();
+	
+	while(frame.channels.count() > channelCount)
+		frame.channels.removeLast();
+	while(frame.channels.count() < channelCount)
+		frame.channels.append(HistoryChannel());
+	for(int channel = 0; channel < channelCount; channel++)
+		encodeChannel(data->at(channel), data->at(channel) ? size->at(channel) : 0, &(frame.channels[channel]));
+	mutex->unlock();
+	
+	frame.samplerate = samplerate;
+	frame.time = QDateTime::currentMSecsSinceEpoch();
+	
+	QMutexLocker locker(this->framesMutex);
+	if(this->paused)
+		return;
+	this->frames.append(frame);
+	this->memory += frameMemory(frame);
+	this->trim();
+}
+
+/// \brief Stops or continues keeping new frames.
+/// \param paused true keeps the frames as they are, so they can be shown.
+void FrameHistory::setPaused(bool paused) {
+	QMutexLocker locker(this->framesMutex);
+	
+	this->paused = paused;
+}
+
+/// \brief Passes a kept frame on like the oscilloscope would.
+/// \param frame The index of the frame, the newest frame has the highest index.
+void FrameHistory::showFrame(int frame) {
+	this->framesMutex->lock();
+	if(frame < 0 || frame >= this->frames.count()) {
+		this->framesMutex->unlock();
+		return;
+	}
+	HistoryFrame historyFrame = this->frames[frame];
+	this->framesMutex->unlock();
+	
+	this->samplesMutex->lock();
+	while(this->samples.count() > historyFrame.channels.count()) {
+		delete[] this->samples.takeLast();
+		this->samplesSize.removeLast();
+	}
+	while(this->samples.count() < historyFrame.channels.count()) {
+		this->samples.append(0);
+		this->samplesSize.append(0);
+	}
+	
+	for(int channel = 0; channel < historyFrame.channels.count(); channel++) {
+		const HistoryChannel &historyChannel = historyFrame.channels[channel];
+		unsigned int count = historyChannel.codes.size();
+		if(this->samplesSize[channel] != count || !this->samples[channel]) {
+			delete[] this->samples[channel];
+			this->samples[channel] = new double[qMax(count, 1u)];
+			this->samplesSize[channel] = count;
+		}
+		
+		const uchar *codes = (const uchar *) historyChannel.codes.constData();
+		double *channelSamples = this->samples[channel];
+		for(unsigned int position = 0; position < count; position++)
+			channelSamples[position] = codes[position] * historyChannel.scale + historyChannel.offset;
+	}
+	this->samplesMutex->unlock();
+	
+	emit frameChanged(frame, historyFrame.time);
+	emit samplesAvailable(&(this->samples), &(this->samplesSize), historyFrame.samplerate, this->samplesMutex);
+}
+
+/// \brief Drops all kept frames.
+void FrameHistory::clear() {
+	QMutexLocker locker(this->framesMutex);
+	
+	this->frames.clear();
+	this->memory = 0;
+}
+
+/// \brief Returns the memory a kept frame uses.
+/// \param frame The frame.
+/// \return The size of the frame in bytes.
+qint64 FrameHistory::frameMemory(const HistoryFrame &frame) {
+	qint64 size = 0;
+	for(int channel = 0; channel < frame.channels.count(); channel++)
+		size += frame.channels[channel].codes.size() + FRAMEHISTORY_OVERHEAD;
+	
+	return size;
+}
+
+/// \brief Quantizes the samples of a channel into one byte per sample.
+/// The samples of the oscilloscope are multiples of the step of its ADC, if
+/// there are at most 256 steps they are kept exactly.
+/// \param samples The sample values.
+/// \param count The number of samples.
+/// \param channel The kept channel, its codes are reused.
+void FrameHistory::encodeChannel(const double *samples, unsigned int count, HistoryChannel *channel) {
+	double minimum = 0, maximum = 0, step = 0;
+	if(count) {
+		minimum = maximum = samples[0];
+		for(unsigned int position = 1; position < count; position++) {
+			if(samples[position] < minimum)
+				minimum = samples[position];
+			else if(samples[position] > maximum)
+				maximum = samples[position];
+			
+			double difference = fabs(samples[position] - samples[position - 1]);
+			if(difference > 0 && (step == 0 || difference < step))
+				step = difference;
+		}
+	}
+	
+	channel->codes.resize(count);
+	channel->offset = minimum;
+	uchar *codes = (uchar *) channel->codes.data();
+	if(step > 0 && (maximum - minimum) / step < 255.5) {
+		channel->scale = step;
+		if(quantize(samples, count, minimum, step, codes) < 1e-3)
+			return;
+	}
+	
+	channel->scale = (maximum - minimum) / 255;
+	if(channel->scale <= 0)
+		channel->scale = 1;
+	quantize(samples, count, minimum, channel->scale, codes);
+}
+
+/// \brief Drops the oldest frames until the limits are kept.
+void FrameHistory::trim() {
+	while(!this->frames.isEmpty() && (this->frames.count() > this->maxFrames || this->memory > this->maxMemory)) {
+		this->memory -= frameMemory(this->frames.first());
+		this->frames.removeFirst();
+	}
+}
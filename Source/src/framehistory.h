@@ -0,0 +1,109 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  OpenHantek
+/// \file framehistory.h
+/// \brief Declares the FrameHistory class.
+//
+//  This program is free software: you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation, either version 3 of the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef FRAMEHISTORY_H
+#define FRAMEHISTORY_H
+
+
+#include <QByteArray>
+#include <QList>
+#include <QObject>
+
+
+class QMutex;
+
+
+#define FRAMEHISTORY_FRAMES        1000 ///< Default number of kept frames
+#define FRAMEHISTORY_MEMORY    67108864 ///< Default memory for the kept frames in bytes
+#define FRAMEHISTORY_OVERHEAD        64 ///< Memory counted for the headers of a channel
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// \struct HistoryChannel                                        framehistory.h
+/// \brief The samples of a channel in a kept frame.
+/// The sample value is code * scale + offset.
+struct HistoryChannel {
+	QByteArray codes; ///< One byte per sample
+	double offset; ///< The value of the code 0
+	double scale; ///< The value difference of neighbouring codes
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \struct HistoryFrame                                          framehistory.h
+/// \brief A kept frame with the time it was acquired.
+struct HistoryFrame {
+	QList<HistoryChannel> channels; ///< The samples of each channel
+	double samplerate; ///< The samplerate of the samples
+	qint64 time; ///< The time in milliseconds since the epoch
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \class FrameHistory                                           framehistory.h
+/// \brief Keeps the last frames of the oscilloscope to scroll back through.
+/// The frames are taken directly in the acquisition thread and stored with
+/// one byte per sample. The 8 bit samples of the oscilloscope are kept
+/// exactly, others are reduced to 256 levels. The oldest frames are dropped
+/// when the number of frames or the memory exceeds the limits. While paused,
+/// a kept frame is emitted like DsoControl::samplesAvailable, so the analysis
+/// and the screens run on it again.
+class FrameHistory : public QObject {
+	Q_OBJECT
+	
+	public:
+		FrameHistory(QObject *parent = 0);
+		~FrameHistory();
+		
+		void setLimits(int frames, qint64 memory);
+		int frameCount() const;
+		qint64 memoryUsed() const;
+		qint64 frameTime(int frame) const;
+		bool isPaused() const;
+	
+	public slots:
+		void addFrame(const QList<double *> *data, const QList<unsigned int> *size, double samplerate, QMutex *mutex);
+		void setPaused(bool paused);
+		void showFrame(int frame);
+		void clear();
+	
+	private:
+		static qint64 frameMemory(const HistoryFrame &frame);
+		static void encodeChannel(const double *samples, unsigned int count, HistoryChannel *channel);
+		void trim();
+		
+		QList<HistoryFrame> frames; ///< The kept frames, the oldest one first
+		qint64 memory; ///< The memory used by the kept frames
+		int maxFrames; ///< The maximum number of kept frames
+		qint64 maxMemory; ///< The maximum memory for the kept frames
+		bool paused; ///< true if no new frames are kept
+		QMutex *framesMutex; ///< Protects the frames and the limits
+		
+		QList<double *> samples; ///< The sample values of the shown frame
+		QList<unsigned int> samplesSize; ///< The sample count of each channel
+		QMutex *samplesMutex; ///< Protects the samples while they are replaced
+	
+	signals:
+		void samplesAvailable(const QList<double *> *data, const QList<unsigned int> *size, double samplerate, QMutex *mutex); ///< A kept frame is shown
+		void frameChanged(int frame, qint64 time); ///< Another kept frame is shown now
+};
+
+
+#endif
@@ -0,0 +1,110 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  OpenHantek
+//  framepacer.cpp
+//
+//  This program is free software: you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation, either version 3 of the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <QTimer>
+
+
+#include "framepacer.h"
+
+#include "settings.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// class FramePacer
+/// \brief Initializes the timers.
+/// \param settings The settings with the maximum frame rate.
+/// \param parent The parent object.
+FramePacer::FramePacer(DsoSettings *settings, QObject *parent) : QObject(parent) {
+	this->settings = settings;
+	
+	this->frameTimer = new QTimer(this);
+	this->frameTimer->setSingleShot(true);
+	this->connect(this->frameTimer, SIGNAL(timeout()), this, SLOT(emitUpdate()));
+	this->lastFrame.start();
+	
+	this->frameCount = 0;
+	this->acquisitionCount = 0;
+	this->frameRate = 0;
+	this->dataRate = 0;
+	this->rateTimer = new QTimer(this);
+	this->connect(this->rateTimer, SIGNAL(timeout()), this, SLOT(calculateRates()));
+	this->rateTimer->start(FRAMEPACER_RATEINTERVAL);
+	this->rateTime.start();
+}
+
+/// \brief Cleans up.
+FramePacer::~FramePacer() {
+}
+
+/// \brief Returns the achieved display rate.
+/// \return The updates per second during the last rate interval.
+double FramePacer::displayRate() const {
+	return this->frameRate;
+}
+
+/// \brief Returns the acquisition rate.
+/// \return The acquisitions per second during the last rate interval.
+double FramePacer::acquisitionRate() const {
+	return this->dataRate;
+}
+
+/// \brief Requests a redraw of the screen.
+/// The update is emitted when the frame interval since the last one is over,
+/// all requests until then are handled by the same update.
+void FramePacer::requestUpdate() {
+	if(this->frameTimer->isActive())
+		return;
+	
+	int interval = 1000 / qMax(this->settings->view.frameRate, 1);
+	int elapsed = this->lastFrame.elapsed();
+	// elapsed() wraps around at midnight
+	if(elapsed < 0 || elapsed >= interval)
+		this->frameTimer->start(0);
+	else
+		this->frameTimer->start(interval - elapsed);
+}
+
+/// \brief Counts a new acquisition for the acquisition rate.
+void FramePacer::countAcquisition() {
+	this->acquisitionCount++;
+}
+
+/// \brief Emits the update for all requests since the last one.
+void FramePacer::emitUpdate() {
+	this->lastFrame.restart();
+	this->frameCount++;
+	
+	emit update();
+}
+
+/// \brief Calculates the rates from the counters and resets them.
+void FramePacer::calculateRates() {
+	int elapsed = this->rateTime.restart();
+	if(elapsed <= 0)
+		return;
+	
+	this->frameRate = this->frameCount * 1000.0 / elapsed;
+	this->dataRate = this->acquisitionCount * 1000.0 / elapsed;
+	this->frameCount = 0;
+	this->acquisitionCount = 0;
+	
+	emit ratesChanged(this->frameRate, this->dataRate);
+}
@@ -0,0 +1,81 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  OpenHantek
+/// \file framepacer.h
+/// \brief Declares the FramePacer class.
+//
+//  This program is free software: you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation, either version 3 of the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef FRAMEPACER_H
+#define FRAMEPACER_H
+
+
+#include <QObject>
+#include <QTime>
+
+
+class DsoSettings;
+class QTimer;
+
+
+#define FRAMEPACER_RATEINTERVAL  1000 ///< Milliseconds between the rate updates
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// \class FramePacer                                               framepacer.h
+/// \brief Coalesces the redraw requests of the scopes.
+/// All sources that invalidate the screen request an update, the pacer emits
+/// at most one update per frame interval. The acquisitions are counted, so the
+/// achieved display rate can be compared with the acquisition rate.
+class FramePacer : public QObject {
+	Q_OBJECT
+	
+	public:
+		FramePacer(DsoSettings *settings, QObject *parent = 0);
+		~FramePacer();
+		
+		double displayRate() const;
+		double acquisitionRate() const;
+	
+	public slots:
+		void requestUpdate();
+		void countAcquisition();
+	
+	private:
+		DsoSettings *settings;
+		
+		QTimer *frameTimer; ///< Delays the update until the frame interval is over
+		QTime lastFrame; ///< Started when the last update was emitted
+		
+		QTimer *rateTimer; ///< Calculates the rates periodically
+		QTime rateTime; ///< Started when the counters were reset
+		unsigned int frameCount; ///< Updates since the last rate calculation
+		unsigned int acquisitionCount; ///< Acquisitions since the last rate calculation
+		double frameRate; ///< The achieved display rate in frames per second
+		double dataRate; ///< The acquisition rate in frames per second
+	
+	private slots:
+		void emitUpdate();
+		void calculateRates();
+	
+	signals:
+		void update(); ///< The screen should be redrawn now
+		void ratesChanged(double displayRate, double acquisitionRate); ///< The measured rates have been updated
+};
+
+
+#endif
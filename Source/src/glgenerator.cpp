@@ -22,6 +22,8 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 
+#include <cmath>
+
 #include <QGLWidget>
 #include <QMutex>
 
@@ -29,7 +31,9 @@
 #include "glgenerator.h"
 
 #include "dataanalyzer.h"
+#include "minmaxpyramid.h"
 #include "settings.h"
+#include "sincinterpolator.h"
 
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -48,7 +52,7 @@ GlArray::~GlArray() {
 
 /// \brief Get the size of the array.
 /// \return Number of array elements.
-unsigned long int GlArray::getSize() {
+unsigned long int GlArray::getSize() const {
 	return this->size;
 }
 
@@ -75,18 +79,43 @@ void GlArray::setSize(unsigned long int size) {
 /// \brief Initializes the scope widget.
 /// \param settings The target settings object.
 /// \param parent The parent widget.
-GlGenerator::GlGenerator(DsoSettings *settings, QObject *parent) : QObject(parent) {
+GlGenerator::GlGenerator(DsoSettings *settings, QObject *parent) : QThread(parent) {
 	this->settings = settings;
 	
 	this->dataAnalyzer = 0;
-	this->digitalPhosphorDepth = 0;
+	this->frontFrame = 0;
+	this->frames[0].serial = 0;
+	this->frames[1].serial = 0;
+	this->frameSerial = 0;
+	this->frontFrameMutex = new QMutex();
+	this->pending = false;
+	this->sincInterpolator = new SincInterpolator();
+	this->viewportWidth[0] = 0;
+	this->viewportWidth[1] = 0;
 	
 	this->generateGrid();
+	
+	connect(this, SIGNAL(finished()), this, SLOT(generationFinished()));
 }
 
 /// \brief Deletes OpenGL objects.
 GlGenerator::~GlGenerator() {
-//	delete[] this->vaChannel;
+	this->wait();
+	
+	for(int frameId = 0; frameId < 2; frameId++) {
+		for(int mode = Dso::CHANNELMODE_VOLTAGE; mode < Dso::CHANNELMODE_COUNT; mode++) {
+			for(int channel = 0; channel < this->frames[frameId].vaChannel[mode].count(); channel++)
+				delete this->frames[frameId].vaChannel[mode][channel];
+		}
+		for(int channel = 0; channel < this->frames[frameId].vaZoomSpectrum.count(); channel++)
+			delete this->frames[frameId].vaZoomSpectrum[channel];
+		for(int channel = 0; channel < this->frames[frameId].vaZoomVoltage.count(); channel++)
+			delete this->frames[frameId].vaZoomVoltage[channel];
+	}
+	for(int channel = 0; channel < this->pyramids.count(); channel++)
+		delete this->pyramids[channel];
+	delete this->sincInterpolator;
+	delete this->frontFrameMutex;
 }
 
 /// \brief Set the data analyzer whose data will be drawn.
@@ -98,130 +127,230 @@ void GlGenerator::setDataAnalyzer(DataAnalyzer *dataAnalyzer) {
 	connect(this->dataAnalyzer, SIGNAL(finished()), this, SLOT(generateGraphs()));
 }
 
-/// \brief Prepare arrays for drawing the data we get from the data analyzer.
+/// \brief Set the width of a scope, large buffers are reduced to it.
+/// \param width The width of the drawing area in pixels.
+/// \param zoomed true if it's the width of the zoomed scope.
+void GlGenerator::setViewportWidth(int width, bool zoomed) {
+	this->viewportWidth[zoomed ? 1 : 0] = width;
+}
+
+/// \brief Get the mutex that has to be locked while the front frame is used.
+/// \return The mutex for the front frame.
+QMutex *GlGenerator::frameMutex() const {
+	return this->frontFrameMutex;
+}
+
+/// \brief Get the newest complete frame.
+/// \return The front frame, only valid while frameMutex() is locked.
+const GlFrame *GlGenerator::frame() const {
+	return &this->frames[this->frontFrame];
+}
+
+/// \brief Start generating the graphs for the newest analyzed data.
+/// If the worker is still busy, it starts again as soon as it's done.
 void GlGenerator::generateGraphs() {
-	if(!this->dataAnalyzer)
+	// Nothing to draw before the first analysis
+	if(!this->dataAnalyzer || !this->dataAnalyzer->data(this->settings->scope.voltage.count() - 1))
+		return;
+	
+	if(this->isRunning())
+		this->pending = true;
+	else
+		this->start();
+}
+
+/// \brief Restart the worker if data arrived while it was busy.
+void GlGenerator::generationFinished() {
+	if(!this->pending)
 		return;
 	
+	// The thread may still be returning from run()
+	this->pending = false;
+	this->wait();
+	this->start();
+}
+
+/// \brief Prepare arrays for drawing the data we get from the data analyzer.
+void GlGenerator::run() {
+	// Fill the back frame, the scopes draw the front frame meanwhile
+	GlFrame *frame = &this->frames[1 - this->frontFrame];
+	
 	// Adapt the number of graphs
 	for(int mode = Dso::CHANNELMODE_VOLTAGE; mode < Dso::CHANNELMODE_COUNT; mode++) {
-		for(int channel = this->vaChannel[mode].count(); channel < this->settings->scope.voltage.count(); channel++)
-			this->vaChannel[mode].append(QList<GlArray *>());
-		for(int channel = this->settings->scope.voltage.count(); channel < this->vaChannel[mode].count(); channel++)
-			this->vaChannel[mode].removeLast();
+		for(int channel = frame->vaChannel[mode].count(); channel < this->settings->scope.voltage.count(); channel++)
+			frame->vaChannel[mode].append(new GlGraph());
+		for(int channel = this->settings->scope.voltage.count(); channel < frame->vaChannel[mode].count(); channel++) {
+			delete frame->vaChannel[mode].last();
+			frame->vaChannel[mode].removeLast();
+		}
+	}
+	for(int channel = frame->vaZoomSpectrum.count(); channel < this->settings->scope.voltage.count(); channel++)
+		frame->vaZoomSpectrum.append(new GlGraph());
+	for(int channel = this->settings->scope.voltage.count(); channel < frame->vaZoomSpectrum.count(); channel++) {
+		delete frame->vaZoomSpectrum.last();
+		frame->vaZoomSpectrum.removeLast();
+	}
+	for(int channel = frame->vaZoomVoltage.count(); channel < this->settings->scope.voltage.count(); channel++)
+		frame->vaZoomVoltage.append(new GlGraph());
+	for(int channel = this->settings->scope.voltage.count(); channel < frame->vaZoomVoltage.count(); channel++) {
+		delete frame->vaZoomVoltage.last();
+		frame->vaZoomVoltage.removeLast();
+	}
+	for(int channel = this->pyramids.count(); channel < this->settings->scope.voltage.count(); channel++)
+		this->pyramids.append(new MinMaxPyramid());
+	for(int channel = this->settings->scope.voltage.count(); channel < this->pyramids.count(); channel++) {
+		delete this->pyramids.last();
+		this->pyramids.removeLast();
 	}
 	
-	// Set digital phosphor depth to one if we don't use it
-	if(this->settings->view.digitalPhosphor)
-		this->digitalPhosphorDepth = this->settings->view.digitalPhosphorDepth;
-	else
-		this->digitalPhosphorDepth = 1;
+	this->dataAnalyzer->mutex()->lock();
 	
-	// Handle all digital phosphor related list manipulations
-	for(int mode = Dso::CHANNELMODE_VOLTAGE; mode < Dso::CHANNELMODE_COUNT; mode++) {
-		for(int channel = 0; channel < this->vaChannel[mode].count(); channel++) {
-			// Resize lists for vector array if the digital phosphor depth has changed
-			if(this->vaChannel[mode][channel].count() != this->digitalPhosphorDepth)
-			for(int index = this->vaChannel[mode][channel].count(); index < this->digitalPhosphorDepth; index++)
-				this->vaChannel[mode][channel].append(new GlArray());
-			for(int index = this->digitalPhosphorDepth; index < this->vaChannel[mode][channel].count(); index++) {
-				delete this->vaChannel[mode][channel].last();
-				this->vaChannel[mode][channel].removeLast();
-			}
-			
-			// Move the last list element to the front
-			this->vaChannel[mode][channel].move(this->digitalPhosphorDepth -1, 0);
+	// Copy the decoded words, the scopes draw them as text
+	frame->annotations.clear();
+	frame->annotationFactors.clear();
+	for(int channel = 0; channel < this->settings->scope.voltage.count(); channel++) {
+		const AnalyzedData *analyzedData = this->dataAnalyzer->data(channel);
+		if(analyzedData && this->settings->scope.horizontal.format == Dso::GRAPHFORMAT_TY) {
+			frame->annotations.append(analyzedData->annotations);
+			frame->annotationFactors.append(analyzedData->samples.voltage.interval / this->settings->scope.horizontal.timebase);
+		}
+		else {
+			frame->annotations.append(QList<ProtocolAnnotation>());
+			frame->annotationFactors.append(0);
 		}
 	}
 	
-	this->dataAnalyzer->mutex()->lock();
+	// The outline of the mask and the samples violating it
+	const DsoSettingsScopeMask &mask = this->settings->scope.mask;
+	if(mask.enabled && mask.channel < (unsigned int) this->settings->scope.voltage.count() && this->settings->scope.horizontal.format == Dso::GRAPHFORMAT_TY) {
+		const DsoSettingsScopeVoltage &voltage = this->settings->scope.voltage[mask.channel];
+		for(int limitId = 0; limitId < 2; limitId++) {
+			const QList<QPointF> &limit = limitId ? mask.upper : mask.lower;
+			frame->vaMask[limitId].setSize(limit.count() * 2);
+			unsigned int arrayPosition = 0;
+			for(int point = 0; point < limit.count(); point++) {
+				frame->vaMask[limitId].data[arrayPosition++] = limit[point].x() / this->settings->scope.horizontal.timebase - DIVS_TIME / 2;
+				frame->vaMask[limitId].data[arrayPosition++] = limit[point].y() / voltage.gain + voltage.offset;
+			}
+		}
+		
+		const AnalyzedData *analyzedData = this->dataAnalyzer->data(mask.channel);
+		if(analyzedData && !analyzedData->maskViolations.isEmpty()) {
+			double horizontalFactor = analyzedData->samples.voltage.interval / this->settings->scope.horizontal.timebase;
+			frame->vaMaskViolations.setSize(analyzedData->maskViolations.count() * 2);
+			unsigned int arrayPosition = 0;
+			for(int index = 0; index < analyzedData->maskViolations.count(); index++) {
+				unsigned int position = analyzedData->maskViolations[index];
+				frame->vaMaskViolations.data[arrayPosition++] = position * horizontalFactor - DIVS_TIME / 2;
+				frame->vaMaskViolations.data[arrayPosition++] = analyzedData->samples.voltage.sample[position] / voltage.gain + voltage.offset;
+			}
+		}
+		else
+			frame->vaMaskViolations.setSize(0);
+	}
+	else {
+		frame->vaMask[0].setSize(0);
+		frame->vaMask[1].setSize(0);
+		frame->vaMaskViolations.setSize(0);
+	}
 	
 	switch(this->settings->scope.horizontal.format) {
 		case Dso::GRAPHFORMAT_TY:
 			// Add graphs for channels
 			for(int mode = Dso::CHANNELMODE_VOLTAGE; mode < Dso::CHANNELMODE_COUNT; mode++) {
 				for(int channel = 0; channel < this->settings->scope.voltage.count(); channel++) {
+					GlGraph *graph = frame->vaChannel[mode][channel];
+					graph->pairs = false;
+					graph->valuesPerStep = 1;
+					graph->start = 0;
+					
 					// Check if this channel is used and available at the data analyzer
 					if(((mode == Dso::CHANNELMODE_VOLTAGE) ? this->settings->scope.voltage[channel].used : this->settings->scope.spectrum[channel].used) && this->dataAnalyzer->data(channel)->samples.voltage.sample) {
-						// Check if the sample count has changed
-						unsigned int neededSize = ((mode == Dso::CHANNELMODE_VOLTAGE) ? this->dataAnalyzer->data(channel)->samples.voltage.count : this->dataAnalyzer->data(channel)->samples.spectrum.count) * 2;
-						for(int index = 0; index < this->digitalPhosphorDepth; index++) {
-							if(this->vaChannel[mode][channel][index]->getSize() != neededSize)
-								this->vaChannel[mode][channel][index]->setSize(0);
-						}
-						
-						// Check if the array is allocated
-						if(!this->vaChannel[mode][channel].first()->data)
-							this->vaChannel[mode][channel].first()->setSize(neededSize);
-						
-						GLfloat *vaNewChannel = this->vaChannel[mode][channel].first()->data;
-						
-						// What's the horizontal distance between sampling points?
-						double horizontalFactor;
-						if(mode == Dso::CHANNELMODE_VOLTAGE)
-							horizontalFactor = this->dataAnalyzer->data(channel)->samples.voltage.interval / this->settings->scope.horizontal.timebase;
-						else
-							horizontalFactor = this->dataAnalyzer->data(channel)->samples.spectrum.interval / this->settings->scope.horizontal.frequencybase;
-						
-						// Fill vector array
-						unsigned int arrayPosition = 0;
 						if(mode == Dso::CHANNELMODE_VOLTAGE) {
-							for(unsigned int position = 0; position < this->dataAnalyzer->data(channel)->samples.voltage.count; position++) {
-								vaNewChannel[arrayPosition++] = position * horizontalFactor - DIVS_TIME / 2;
-								vaNewChannel[arrayPosition++] = this->dataAnalyzer->data(channel)->samples.voltage.sample[position] / this->settings->scope.voltage[channel].gain + this->settings->scope.voltage[channel].offset;
-							}
+							// The levels are built once for both scopes
+							const SampleValues *voltage = &(this->dataAnalyzer->data(channel)->samples.voltage);
+							this->pyramids[channel]->setSamples(voltage->sample, voltage->count);
+							this->generateVoltageGraph(graph, channel, -DIVS_TIME / 2, DIVS_TIME / 2, this->viewportWidth[0]);
 						}
 						else {
-							for(unsigned int position = 0; position < this->dataAnalyzer->data(channel)->samples.spectrum.count; position++) {
-								vaNewChannel[arrayPosition++] = position * horizontalFactor - DIVS_TIME / 2;
-								vaNewChannel[arrayPosition++] = this->dataAnalyzer->data(channel)->samples.spectrum.sample[position] / this->settings->scope.spectrum[channel].magnitude + this->settings->scope.spectrum[channel].offset;
-							}
+							// Fill the array with the raw values, the scopes place them on the screen
+							const SampleValues *spectrum = &(this->dataAnalyzer->data(channel)->samples.spectrum);
+							graph->values.setSize(spectrum->count);
+							graph->step = spectrum->interval;
+							for(unsigned int position = 0; position < spectrum->count; position++)
+								graph->values.data[position] = spectrum->sample[position];
 						}
 					}
 					else {
-						// Delete all vector arrays
-						for(int index = 0; index < this->digitalPhosphorDepth; index++)
-							this->vaChannel[mode][channel][index]->setSize(0);
+						// Delete the vector array
+						graph->values.setSize(0);
 					}
 				}
 			}
+			
+			// Add the samples between the markers for the zoomed scope
+			for(int channel = 0; channel < this->settings->scope.voltage.count(); channel++) {
+				GlGraph *graph = frame->vaZoomVoltage[channel];
+				graph->pairs = false;
+				graph->valuesPerStep = 1;
+				graph->start = 0;
+				double left = qMin(this->settings->scope.horizontal.marker[0], this->settings->scope.horizontal.marker[1]);
+				double right = qMax(this->settings->scope.horizontal.marker[0], this->settings->scope.horizontal.marker[1]);
+				if(this->settings->view.zoom && right > left && this->settings->scope.voltage[channel].used && this->dataAnalyzer->data(channel)->samples.voltage.sample)
+					this->generateVoltageGraph(graph, channel, left, right, this->viewportWidth[1]);
+				else
+					graph->values.setSize(0);
+			}
+			
+			// Add the narrowband spectrums for the zoomed scope
+			for(int channel = 0; channel < this->settings->scope.voltage.count(); channel++) {
+				const SampleValues *zoomSpectrum = &(this->dataAnalyzer->data(channel)->samples.zoomSpectrum);
+				GlGraph *graph = frame->vaZoomSpectrum[channel];
+				graph->pairs = false;
+				graph->valuesPerStep = 1;
+				if(this->settings->scope.spectrum[channel].used && zoomSpectrum->count) {
+					// Same horizontal scale as the main spectrum, the first value isn't at 0 Hz
+					graph->values.setSize(zoomSpectrum->count);
+					graph->start = this->dataAnalyzer->data(channel)->zoomSpectrumStart;
+					graph->step = zoomSpectrum->interval;
+					for(unsigned int position = 0; position < zoomSpectrum->count; position++)
+						graph->values.data[position] = zoomSpectrum->sample[position];
+				}
+				else
+					graph->values.setSize(0);
+			}
 			break;
 			
 		case Dso::GRAPHFORMAT_XY:
 			for(int channel = 0; channel < this->settings->scope.voltage.count(); channel ++) {
+				GlGraph *graph = frame->vaChannel[Dso::CHANNELMODE_VOLTAGE][channel];
+				graph->pairs = true;
+				graph->valuesPerStep = 1;
+				graph->start = 0;
+				graph->step = 0;
+				
 				// For even channel numbers check if this channel is used and this and the following channel are available at the data analyzer
 				if(channel % 2 == 0 && channel + 1 < this->settings->scope.voltage.count() && this->settings->scope.voltage[channel].used && this->dataAnalyzer->data(channel)->samples.voltage.sample && this->dataAnalyzer->data(channel + 1)->samples.voltage.sample) {
-					// Check if the sample count has changed
-					unsigned int neededSize = qMin(this->dataAnalyzer->data(channel)->samples.voltage.count, this->dataAnalyzer->data(channel + 1)->samples.voltage.count) * 2;
-					for(int index = 0; index < this->digitalPhosphorDepth; index++) {
-						if(this->vaChannel[Dso::CHANNELMODE_VOLTAGE][channel][index]->getSize() != neededSize)
-							this->vaChannel[Dso::CHANNELMODE_VOLTAGE][channel][index]->setSize(0);
-					}
-					
-					// Check if the array is allocated
-					if(!this->vaChannel[Dso::CHANNELMODE_VOLTAGE][channel].first()->data)
-						this->vaChannel[Dso::CHANNELMODE_VOLTAGE][channel].first()->setSize(neededSize);
-					
-					GLfloat *vaNewChannel = this->vaChannel[Dso::CHANNELMODE_VOLTAGE][channel].first()->data;
-					
-					// Fill vector array
+					// Pairs of raw values, the x channel first
+					const SampleValues *xVoltage = &(this->dataAnalyzer->data(channel)->samples.voltage);
+					const SampleValues *yVoltage = &(this->dataAnalyzer->data(channel + 1)->samples.voltage);
+					unsigned int count = qMin(xVoltage->count, yVoltage->count);
+					graph->values.setSize(count * 2);
 					unsigned int arrayPosition = 0;
-					unsigned int xChannel = channel;
-					unsigned int yChannel = channel + 1;
-					for(unsigned int position = 0; position < this->dataAnalyzer->data(channel)->samples.voltage.count; position++) {
-						vaNewChannel[arrayPosition++] = this->dataAnalyzer->data(xChannel)->samples.voltage.sample[position] / this->settings->scope.voltage[xChannel].gain + this->settings->scope.voltage[xChannel].offset;
-						vaNewChannel[arrayPosition++] = this->dataAnalyzer->data(yChannel)->samples.voltage.sample[position] / this->settings->scope.voltage[yChannel].gain + this->settings->scope.voltage[yChannel].offset;
+					for(unsigned int position = 0; position < count; position++) {
+						graph->values.data[arrayPosition++] = xVoltage->sample[position];
+						graph->values.data[arrayPosition++] = yVoltage->sample[position];
 					}
 				}
 				else {
-					// Delete all vector arrays
-					for(int index = 0; index < this->digitalPhosphorDepth; index++)
-						this->vaChannel[Dso::CHANNELMODE_VOLTAGE][channel][index]->setSize(0);
+					// Delete the vector array
+					graph->values.setSize(0);
 				}
 				
-				// Delete all spectrum graphs
-				for(int index = 0; index < this->digitalPhosphorDepth; index++)
-					this->vaChannel[Dso::CHANNELMODE_SPECTRUM][channel][index]->setSize(0);
+				// Delete the spectrum graph
+				frame->vaChannel[Dso::CHANNELMODE_SPECTRUM][channel]->values.setSize(0);
+				frame->vaZoomSpectrum[channel]->values.setSize(0);
+				frame->vaZoomVoltage[channel]->values.setSize(0);
 			}
 			break;
 		
@@ -229,11 +358,88 @@ void GlGenerator::generateGraphs() {
 			break;
 	}
 	
+	frame->serial = ++this->frameSerial;
+	
 	this->dataAnalyzer->mutex()->unlock();
 	
+	// Show the new frame
+	this->frontFrameMutex->lock();
+	this->frontFrame = 1 - this->frontFrame;
+	this->frontFrameMutex->unlock();
+	
 	emit graphsGenerated();
 }
 
+/// \brief Fill a graph with the voltage samples inside a time window.
+/// Only the samples between the edges are used, at the resolution the width of
+/// the viewport needs. The pyramid of the channel has to be set to its samples.
+/// \param graph The graph that should be filled.
+/// \param channel The channel whose samples are used.
+/// \param left The left edge of the window in divs.
+/// \param right The right edge of the window in divs.
+/// \param width The width of the scope that shows the graph in pixels.
+void GlGenerator::generateVoltageGraph(GlGraph *graph, int channel, double left, double right, int width) {
+	const SampleValues *voltage = &(this->dataAnalyzer->data(channel)->samples.voltage);
+	if(!voltage->count) {
+		graph->values.setSize(0);
+		return;
+	}
+	
+	// The visible samples and one more on each side, so the lines reach the edges
+	double horizontalFactor = voltage->interval / this->settings->scope.horizontal.timebase;
+	double firstVisible = floor((left + DIVS_TIME / 2) / horizontalFactor) - 1;
+	double lastVisible = ceil((right + DIVS_TIME / 2) / horizontalFactor) + 1;
+	if(lastVisible < 0 || firstVisible > voltage->count - 1) {
+		graph->values.setSize(0);
+		return;
+	}
+	unsigned int first = (unsigned int) qMax(firstVisible, 0.0);
+	unsigned int last = (unsigned int) qMin(lastVisible, (double) voltage->count - 1);
+	
+	// Sinc interpolation upsamples, the min/max pyramid reduces windows with more samples than pixels
+	double visibleSamples = (right - left) / horizontalFactor;
+	unsigned int ratio = 1;
+	unsigned int level = 0;
+	if(this->settings->view.interpolation == Dso::INTERPOLATION_SINC)
+		ratio = SincInterpolator::ratioForVisible(visibleSamples);
+	if(ratio == 1 && width > 0)
+		level = MinMaxPyramid::levelForDensity(visibleSamples / width);
+	
+	// Fill the array with the raw values, the scopes place them on the screen
+	if(ratio > 1) {
+		const double *interpolated = this->sincInterpolator->process(voltage->sample, voltage->count, first, last, ratio);
+		graph->values.setSize(this->sincInterpolator->outputCount());
+		graph->start = first * voltage->interval;
+		graph->step = voltage->interval / ratio;
+		for(unsigned int position = 0; position < this->sincInterpolator->outputCount(); position++)
+			graph->values.data[position] = interpolated[position];
+	}
+	else if(level) {
+		// Draw a vertical line from the minimum to the maximum of each block
+		MinMaxPyramid *pyramid = this->pyramids[channel];
+		const double *minimum = pyramid->minimum(level);
+		const double *maximum = pyramid->maximum(level);
+		unsigned int firstBlock = first >> level;
+		unsigned int lastBlock = last >> level;
+		graph->values.setSize((lastBlock - firstBlock + 1) * 2);
+		graph->valuesPerStep = 2;
+		graph->step = voltage->interval * (1 << level);
+		graph->start = firstBlock * graph->step;
+		unsigned int arrayPosition = 0;
+		for(unsigned int block = firstBlock; block <= lastBlock; block++) {
+			graph->values.data[arrayPosition++] = minimum[block];
+			graph->values.data[arrayPosition++] = maximum[block];
+		}
+	}
+	else {
+		graph->values.setSize(last - first + 1);
+		graph->start = first * voltage->interval;
+		graph->step = voltage->interval;
+		for(unsigned int position = first; position <= last; position++)
+			graph->values.data[position - first] = voltage->sample[position];
+	}
+}
+
 /// \brief Create the needed OpenGL vertex arrays for the grid.
 void GlGenerator::generateGrid() {
 	// Grid
@@ -31,10 +31,11 @@
 
 #include <QGLWidget>
 #include <QList>
-#include <QObject>
+#include <QThread>
 
 
 #include "dso.h"
+#include "protocoldecoder.h"
 
 
 #define DIVS_TIME                  10.0 ///< Number of horizontal screen divs
@@ -45,6 +46,9 @@
 class DataAnalyzer;
 class DsoSettings;
 class GlScope;
+class MinMaxPyramid;
+class QMutex;
+class SincInterpolator;
 
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -55,7 +59,7 @@ class GlArray {
 		GlArray();
 		~GlArray();
 		
-		unsigned long int getSize();
+		unsigned long int getSize() const;
 		void setSize(unsigned long int size);
 		
 		GLfloat *data; ///< Pointer to the array
@@ -64,10 +68,41 @@ class GlArray {
 		unsigned long int size; ///< The array size (Number of GLfloat values)
 };
 
+////////////////////////////////////////////////////////////////////////////////
+/// \struct GlGraph                                                glgenerator.h
+/// \brief The raw values of a graph and how they are placed on the screen.
+/// The gain, offset and timebase aren't applied yet, so the scopes can change
+/// them without waiting for new vertex arrays. The x coordinate of a series
+/// follows from the index of the value.
+struct GlGraph {
+	GlArray values; ///< The raw values, x and y pairs for XY graphs
+	bool pairs; ///< true if the values are x and y pairs
+	unsigned int valuesPerStep; ///< 2 if each position has a minimum and a maximum
+	double start; ///< The horizontal position of the first value in s or Hz
+	double step; ///< The horizontal distance between two positions in s or Hz
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \struct GlFrame                                                glgenerator.h
+/// \brief The vertex arrays of one complete frame.
+struct GlFrame {
+	unsigned long int serial; ///< Increases with every generated frame
+	QList<GlGraph *> vaChannel[Dso::CHANNELMODE_COUNT]; ///< The graphs of each channel
+	QList<GlGraph *> vaZoomSpectrum; ///< The narrowband spectrums of each channel
+	QList<GlGraph *> vaZoomVoltage; ///< The samples between the markers of each channel
+	QList<QList<ProtocolAnnotation> > annotations; ///< The decoded words of each channel
+	QList<double> annotationFactors; ///< The width of a sample in divs for each channel
+	GlArray vaMask[2]; ///< The lower and upper limit of the mask
+	GlArray vaMaskViolations; ///< The samples outside of the mask
+};
+
 ////////////////////////////////////////////////////////////////////////////////
 /// \class GlGenerator                                             glgenerator.h
 /// \brief Generates the vertex arrays for the GlScope classes.
-class GlGenerator : public QObject {
+/// The arrays are filled by a worker thread. It writes into a back frame and
+/// swaps it with the front frame when it's complete, so the scopes can draw
+/// the front frame without waiting for the data analyzer.
+class GlGenerator : public QThread {
 	Q_OBJECT
 	
 	friend class GlScope;
@@ -77,22 +112,37 @@ class GlGenerator : public QObject {
 		~GlGenerator();
 		
 		void setDataAnalyzer(DataAnalyzer *dataAnalyzer);
+		void setViewportWidth(int width, bool zoomed = false);
+		
+		QMutex *frameMutex() const;
+		const GlFrame *frame() const;
 	
 	protected:
+		void run();
+		void generateVoltageGraph(GlGraph *graph, int channel, double left, double right, int width);
 		void generateGrid();
 	
 	private:
 		DataAnalyzer *dataAnalyzer;
 		DsoSettings *settings;
 		
-		QList<QList<GlArray *> > vaChannel[Dso::CHANNELMODE_COUNT];
 		GlArray vaGrid[3];
+		GlFrame frames[2]; ///< The front and the back frame
+		int frontFrame; ///< The index of the frame that is drawn
+		unsigned long int frameSerial; ///< The serial of the newest frame
+		QMutex *frontFrameMutex; ///< Locked while the front frame is drawn or swapped
+		bool pending; ///< true if new data arrived while generating
 		
-		int digitalPhosphorDepth;
+		SincInterpolator *sincInterpolator; ///< Upsamples the visible samples for sinc interpolation
+		QList<MinMaxPyramid *> pyramids; ///< Reduces large buffers to the screen resolution
+		int viewportWidth[2]; ///< The width of the normal and the zoomed scope in pixels
 	
 	public slots:
 		void generateGraphs();
 	
+	private slots:
+		void generationFinished();
+	
 	signals:
 		void graphsGenerated(); ///< The graphs are ready to be drawn
 };
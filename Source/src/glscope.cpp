@@ -27,11 +27,13 @@
 #include <cmath>
 
 #include <QColor>
+#include <QFontMetrics>
 
 
 #include "glscope.h"
 
 #include "dataanalyzer.h"
+#include "digitalphosphor.h"
 #include "glgenerator.h"
 #include "settings.h"
 
@@ -46,10 +48,31 @@ GlScope::GlScope(DsoSettings *settings, QWidget *parent) : QGLWidget(parent) {
 	
 	this->generator = 0;
 	this->zoomed = false;
+	
+	this->graphProgram = 0;
+	
+	this->digitalPhosphor = new DigitalPhosphor();
+	this->phosphorHorizontalScale = 0;
+	this->phosphorHorizontalOffset = 0;
+	this->phosphorFormat = Dso::GRAPHFORMAT_TY;
+	this->phosphorChanged = false;
+	this->phosphorTexture = 0;
+	this->phosphorTextureWidth = 0;
+	this->phosphorTextureHeight = 0;
 }
 
 /// \brief Deletes OpenGL objects.
 GlScope::~GlScope() {
+	this->makeCurrent();
+	if(this->phosphorTexture)
+		glDeleteTextures(1, &this->phosphorTexture);
+	for(int slot = 0; slot < this->graphBuffers.count(); slot++)
+		delete this->graphBuffers[slot];
+	for(int slot = 0; slot < this->graphVertices.count(); slot++)
+		delete this->graphVertices[slot];
+	if(this->graphProgram)
+		delete this->graphProgram;
+	delete this->digitalPhosphor;
 }
 
 /// \brief Initializes OpenGL output.
@@ -66,6 +89,53 @@ void GlScope::initializeGL() {
 	glLineStipple(1, 0x3333);
 	
 	glEnableClientState(GL_VERTEX_ARRAY);
+	
+	// The texture for the digital phosphor, allocated when it's drawn first
+	glGenTextures(1, &this->phosphorTexture);
+	glBindTexture(GL_TEXTURE_2D, this->phosphorTexture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	this->phosphorTextureWidth = 0;
+	this->phosphorTextureHeight = 0;
+	this->phosphorChanged = true;
+	
+	// The shader needs gl_VertexID, without it the matrix places the graphs
+	if(this->graphProgram) {
+		delete this->graphProgram;
+		this->graphProgram = 0;
+	}
+	if((QGLFormat::openGLVersionFlags() & QGLFormat::OpenGL_Version_3_0) && QGLShaderProgram::hasOpenGLShaderPrograms(this->context())) {
+		this->graphProgram = new QGLShaderProgram(this->context(), this);
+		bool compiled = this->graphProgram->addShaderFromSourceCode(QGLShader::Vertex,
+			"#version 130\n"
+			"in vec2 vertex;\n"
+			"uniform bool pairs;\n"
+			"uniform int valuesPerStep;\n"
+			"uniform vec2 scale;\n"
+			"uniform vec2 offset;\n"
+			"void main() {\n"
+			"	vec2 position = pairs ? vertex : vec2(float(gl_VertexID / valuesPerStep), vertex.x);\n"
+			"	gl_Position = gl_ModelViewProjectionMatrix * vec4(position * scale + offset, 0.0, 1.0);\n"
+			"}\n");
+		compiled = compiled && this->graphProgram->addShaderFromSourceCode(QGLShader::Fragment,
+			"#version 130\n"
+			"uniform vec4 color;\n"
+			"void main() {\n"
+			"	gl_FragColor = color;\n"
+			"}\n");
+		this->graphProgram->bindAttributeLocation("vertex", 0);
+		if(!compiled || !this->graphProgram->link()) {
+			qWarning("GlScope: Using the fixed function pipeline, the graph shader failed: %s", this->graphProgram->log().toLocal8Bit().constData());
+			delete this->graphProgram;
+			this->graphProgram = 0;
+		}
+	}
+	
+	// The buffers belong to the old context
+	for(int slot = 0; slot < this->graphBuffers.count(); slot++)
+		delete this->graphBuffers[slot];
+	this->graphBuffers.clear();
+	this->graphSerials.clear();
 }
 
 /// \brief Draw the graphs and the grid.
@@ -78,7 +148,11 @@ void GlScope::paintGL() {
     glLineWidth(2);
 	
 	// Draw the graphs
-	if(this->generator && this->generator->digitalPhosphorDepth > 0) {
+	if(this->generator) {
+		// The digital phosphor contains all graphs already transformed
+		if(this->settings->view.digitalPhosphor)
+			this->drawDigitalPhosphor();
+		
 		if(this->settings->view.antialiasing) {
 			glEnable(GL_POINT_SMOOTH);
 			glEnable(GL_LINE_SMOOTH);
@@ -93,60 +167,22 @@ void GlScope::paintGL() {
 			glTranslatef(-(this->settings->scope.horizontal.marker[0] + this->settings->scope.horizontal.marker[1]) / 2, 0.0, 0.0);
 		}
 		
-		// Values we need for the fading of the digital phosphor
-		double *fadingFactor = new double[this->generator->digitalPhosphorDepth];
-		fadingFactor[0] = 100;
-		double fadingRatio = pow(10.0, 2.0 / this->generator->digitalPhosphorDepth);
-		for(int index = 1; index < this->generator->digitalPhosphorDepth; index++)
-			fadingFactor[index] = fadingFactor[index - 1] * fadingRatio;
+		// The generator doesn't swap the frames while we draw the front frame
+		this->generator->frameMutex()->lock();
+		const GlFrame *frame = this->generator->frame();
 		
-		switch(this->settings->scope.horizontal.format) {
-			case Dso::GRAPHFORMAT_TY:
-				// Real and virtual channels
-				for(int mode = Dso::CHANNELMODE_VOLTAGE; mode < Dso::CHANNELMODE_COUNT; mode++) {
-					for(int channel = 0; channel < this->settings->scope.voltage.count(); channel++) {
-						if((mode == Dso::CHANNELMODE_VOLTAGE) ? this->settings->scope.voltage[channel].used : this->settings->scope.spectrum[channel].used) {
-							// Draw graph for all available depths
-							for(int index = this->generator->digitalPhosphorDepth - 1; index >= 0; index--) {
-								if(this->generator->vaChannel[mode][channel][index]->data) {
-									if(mode == Dso::CHANNELMODE_VOLTAGE)
-										this->qglColor(this->settings->view.color.screen.voltage[channel].darker(fadingFactor[index]));
-									else
-										this->qglColor(this->settings->view.color.screen.spectrum[channel].darker(fadingFactor[index]));
-									glVertexPointer(2, GL_FLOAT, 0, this->generator->vaChannel[mode][channel][index]->data);
-                                    glDrawArrays((this->settings->view.interpolation == Dso::INTERPOLATION_OFF) ? GL_POINTS : GL_LINE_STRIP, 0, this->generator->vaChannel[mode][channel][index]->getSize() / 2);
-								}
-							}
-						}
-					}
-				}
-				break;
-			
-			case Dso::GRAPHFORMAT_XY:
-				// Real and virtual channels
-				for(int channel = 0; channel < this->settings->scope.voltage.count() - 1; channel += 2) {
-					if(this->settings->scope.voltage[channel].used) {
-						// Draw graph for all available depths
-                        for(int index = this->generator->digitalPhosphorDepth - 1; index >= 0; index--) {
-							if(this->generator->vaChannel[Dso::CHANNELMODE_VOLTAGE][channel][index]->data) {
-								this->qglColor(this->settings->view.color.screen.voltage[channel].darker(fadingFactor[index]));
-								glVertexPointer(2, GL_FLOAT, 0, this->generator->vaChannel[Dso::CHANNELMODE_VOLTAGE][channel][index]->data);
-                                glDrawArrays((this->settings->view.interpolation == Dso::INTERPOLATION_OFF) ? GL_POINTS : GL_LINE_STRIP, 0, this->generator->vaChannel[Dso::CHANNELMODE_VOLTAGE][channel][index]->getSize() / 2);
-							}
-						}
-					}
-				}
-				break;
-			
-			default:
-				break;
-		}
-		
-		delete[] fadingFactor;
+		if(!this->settings->view.digitalPhosphor)
+			this->drawGraphs(frame);
 		
 		glDisable(GL_POINT_SMOOTH);
 		glDisable(GL_LINE_SMOOTH);
 		
+		// The mask and the text use the same transformation as the graphs
+		this->drawMask(frame);
+		this->drawAnnotations(frame);
+		
+		this->generator->frameMutex()->unlock();
+		
 		if(this->zoomed)
 			glPopMatrix();
 	}
@@ -191,21 +227,133 @@ void GlScope::resizeGL(int width, int height) {
 	glLoadIdentity();
 	glOrtho(-DIVS_TIME / 2, DIVS_TIME / 2, -DIVS_VOLTAGE / 2, DIVS_VOLTAGE / 2, -1.0, 1.0);
 	glMatrixMode(GL_MODELVIEW);
+	
+	// Large buffers are reduced to the screen resolution
+	if(this->generator)
+		this->generator->setViewportWidth(width, this->zoomed);
 }
 
 /// \brief Set the generator that provides the vertex arrays.
 /// \param generator Pointer to the GlGenerator class.
 void GlScope::setGenerator(GlGenerator *generator) {
 	if(this->generator)
-		disconnect(this->generator, SIGNAL(graphsGenerated()), this, SLOT(updateGL()));
+		disconnect(this->generator, SIGNAL(graphsGenerated()), this, SLOT(accumulateGraphs()));
 	this->generator = generator;
-	connect(this->generator, SIGNAL(graphsGenerated()), this, SLOT(updateGL()));
+	connect(this->generator, SIGNAL(graphsGenerated()), this, SLOT(accumulateGraphs()));
+	this->generator->setViewportWidth(this->width(), this->zoomed);
 }
 
 /// \brief Set the zoom mode for this GlScope.
 /// \param zoomed true magnifies the area between the markers.
 void GlScope::setZoomMode(bool zoomed) {
 	this->zoomed = zoomed;
+	if(this->generator)
+		this->generator->setViewportWidth(this->width(), this->zoomed);
+}
+
+/// \brief Get the graph of a channel if the scope shows it.
+/// \param frame The frame with the vertex arrays.
+/// \param mode The channel mode of the graph.
+/// \param channel The channel of the graph.
+/// \param slot Set to the index of the graph in the buffers, if not 0.
+/// \return The graph, 0 if it isn't shown or empty.
+const GlGraph *GlScope::visibleGraph(const GlFrame *frame, int mode, int channel, int *slot) {
+	int channelCount = this->settings->scope.voltage.count();
+	const GlGraph *graph = 0;
+	int graphSlot = mode * channelCount + channel;
+	
+	if(this->settings->scope.horizontal.format == Dso::GRAPHFORMAT_XY) {
+		// One graph for each pair of channels
+		if(mode == Dso::CHANNELMODE_VOLTAGE && channel % 2 == 0 && channel + 1 < channelCount && this->settings->scope.voltage[channel].used)
+			graph = frame->vaChannel[mode].value(channel);
+	}
+	else if((mode == Dso::CHANNELMODE_VOLTAGE) ? this->settings->scope.voltage[channel].used : this->settings->scope.spectrum[channel].used) {
+		// The zoomed scope shows the samples between the markers and the narrowband spectrum if they are there
+		if(this->zoomed && mode == Dso::CHANNELMODE_VOLTAGE && channel < frame->vaZoomVoltage.count() && frame->vaZoomVoltage[channel]->values.data) {
+			graph = frame->vaZoomVoltage[channel];
+			graphSlot = (Dso::CHANNELMODE_COUNT + 1) * channelCount + channel;
+		}
+		else if(this->zoomed && mode == Dso::CHANNELMODE_SPECTRUM && channel < frame->vaZoomSpectrum.count() && frame->vaZoomSpectrum[channel]->values.data) {
+			graph = frame->vaZoomSpectrum[channel];
+			graphSlot = Dso::CHANNELMODE_COUNT * channelCount + channel;
+		}
+		else
+			graph = frame->vaChannel[mode].value(channel);
+	}
+	
+	if(!graph || !graph->values.data)
+		return 0;
+	if(slot)
+		*slot = graphSlot;
+	return graph;
+}
+
+/// \brief Calculate how the raw values of a graph are placed on the screen.
+/// The screen position in divs is value * scale + offset for both axes, the x
+/// value of a series is the index of its position.
+/// \param graph The graph.
+/// \param mode The channel mode of the graph.
+/// \param channel The channel of the graph.
+/// \param scale Set to the horizontal and vertical scale.
+/// \param offset Set to the horizontal and vertical offset.
+void GlScope::graphTransform(const GlGraph *graph, int mode, int channel, double *scale, double *offset) {
+	if(graph->pairs) {
+		// The voltages of both channels
+		scale[0] = 1.0 / this->settings->scope.voltage[channel].gain;
+		offset[0] = this->settings->scope.voltage[channel].offset;
+		scale[1] = 1.0 / this->settings->scope.voltage[channel + 1].gain;
+		offset[1] = this->settings->scope.voltage[channel + 1].offset;
+	}
+	else if(mode == Dso::CHANNELMODE_VOLTAGE) {
+		scale[0] = graph->step / this->settings->scope.horizontal.timebase;
+		offset[0] = graph->start / this->settings->scope.horizontal.timebase - DIVS_TIME / 2;
+		scale[1] = 1.0 / this->settings->scope.voltage[channel].gain;
+		offset[1] = this->settings->scope.voltage[channel].offset;
+	}
+	else {
+		scale[0] = graph->step / this->settings->scope.horizontal.frequencybase;
+		offset[0] = graph->start / this->settings->scope.horizontal.frequencybase - DIVS_TIME / 2;
+		scale[1] = 1.0 / this->settings->scope.spectrum[channel].magnitude;
+		offset[1] = this->settings->scope.spectrum[channel].offset;
+	}
+}
+
+/// \brief Copy the raw values of a graph into its vertex buffer.
+/// Nothing is done if the buffer already holds the graph of this frame. Without
+/// shaders the series are expanded into x and y pairs instead.
+/// \param frame The frame with the vertex arrays.
+/// \param graph The graph that should be uploaded.
+/// \param slot The index of the graph in the buffers.
+void GlScope::uploadGraph(const GlFrame *frame, const GlGraph *graph, int slot) {
+	while(this->graphBuffers.count() <= slot)
+		this->graphBuffers.append(0);
+	while(this->graphVertices.count() <= slot)
+		this->graphVertices.append(new GlArray());
+	while(this->graphSerials.count() <= slot)
+		this->graphSerials.append(0);
+	
+	if(this->graphSerials[slot] == frame->serial)
+		return;
+	this->graphSerials[slot] = frame->serial;
+	
+	if(this->graphProgram) {
+		if(!this->graphBuffers[slot]) {
+			this->graphBuffers[slot] = new QGLBuffer(QGLBuffer::VertexBuffer);
+			this->graphBuffers[slot]->setUsagePattern(QGLBuffer::StreamDraw);
+			this->graphBuffers[slot]->create();
+		}
+		this->graphBuffers[slot]->bind();
+		this->graphBuffers[slot]->allocate(graph->values.data, graph->values.getSize() * sizeof(GLfloat));
+		this->graphBuffers[slot]->release();
+	}
+	else if(!graph->pairs) {
+		GlArray *vertices = this->graphVertices[slot];
+		vertices->setSize(graph->values.getSize() * 2);
+		for(unsigned long int index = 0; index < graph->values.getSize(); index++) {
+			vertices->data[index * 2] = index / graph->valuesPerStep;
+			vertices->data[index * 2 + 1] = graph->values.data[index];
+		}
+	}
 }
 
 /// \brief Draw the grid.
@@ -228,3 +376,224 @@ void GlScope::drawGrid() {
     glVertexPointer(2, GL_FLOAT, 0, this->generator->vaGrid[2].data);
 	glDrawArrays(GL_LINE_LOOP, 0, this->generator->vaGrid[2].getSize() / 2);
 }
+
+/// \brief Draw the newest graphs of all channels.
+/// \param frame The frame with the vertex arrays.
+void GlScope::drawGraphs(const GlFrame *frame) {
+	GLenum graphMode = (this->settings->view.interpolation == Dso::INTERPOLATION_OFF) ? GL_POINTS : GL_LINE_STRIP;
+	
+	if(this->graphProgram) {
+		glDisableClientState(GL_VERTEX_ARRAY);
+		this->graphProgram->bind();
+		this->graphProgram->enableAttributeArray(0);
+	}
+	
+	for(int mode = Dso::CHANNELMODE_VOLTAGE; mode < Dso::CHANNELMODE_COUNT; mode++) {
+		for(int channel = 0; channel < this->settings->scope.voltage.count(); channel++) {
+			int slot;
+			const GlGraph *graph = this->visibleGraph(frame, mode, channel, &slot);
+			if(!graph)
+				continue;
+			
+			const QColor &color = (mode == Dso::CHANNELMODE_VOLTAGE) ? this->settings->view.color.screen.voltage[channel] : this->settings->view.color.screen.spectrum[channel];
+			double scale[2], offset[2];
+			this->graphTransform(graph, mode, channel, scale, offset);
+			
+			// Only the uniforms change when the gain, offset or timebase do
+			this->uploadGraph(frame, graph, slot);
+			
+			if(this->graphProgram) {
+				this->graphBuffers[slot]->bind();
+				this->graphProgram->setAttributeBuffer(0, GL_FLOAT, 0, graph->pairs ? 2 : 1);
+				this->graphProgram->setUniformValue("pairs", graph->pairs);
+				this->graphProgram->setUniformValue("valuesPerStep", (GLint) graph->valuesPerStep);
+				this->graphProgram->setUniformValue("scale", (GLfloat) scale[0], (GLfloat) scale[1]);
+				this->graphProgram->setUniformValue("offset", (GLfloat) offset[0], (GLfloat) offset[1]);
+				this->graphProgram->setUniformValue("color", color);
+				glDrawArrays(graphMode, 0, graph->pairs ? graph->values.getSize() / 2 : graph->values.getSize());
+				this->graphBuffers[slot]->release();
+			}
+			else {
+				// The matrix does the same transformation
+				const GlArray *vertices = graph->pairs ? &graph->values : this->graphVertices[slot];
+				this->qglColor(color);
+				glPushMatrix();
+				glTranslated(offset[0], offset[1], 0.0);
+				glScaled(scale[0], scale[1], 1.0);
+				glVertexPointer(2, GL_FLOAT, 0, vertices->data);
+				glDrawArrays(graphMode, 0, vertices->getSize() / 2);
+				glPopMatrix();
+			}
+		}
+	}
+	
+	if(this->graphProgram) {
+		this->graphProgram->disableAttributeArray(0);
+		this->graphProgram->release();
+		glEnableClientState(GL_VERTEX_ARRAY);
+	}
+}
+
+/// \brief Draw the digital phosphor as one textured quad over the whole screen.
+void GlScope::drawDigitalPhosphor() {
+	int rows = this->digitalPhosphor->height();
+	int columns = this->digitalPhosphor->width();
+	if(!rows || !columns || !this->phosphorTexture)
+		return;
+	
+	glBindTexture(GL_TEXTURE_2D, this->phosphorTexture);
+	if(this->phosphorChanged) {
+		// The image is stored column by column, so the texture is transposed
+		if(rows > this->phosphorTextureWidth || columns > this->phosphorTextureHeight) {
+			for(this->phosphorTextureWidth = 1; this->phosphorTextureWidth < rows; this->phosphorTextureWidth <<= 1);
+			for(this->phosphorTextureHeight = 1; this->phosphorTextureHeight < columns; this->phosphorTextureHeight <<= 1);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, this->phosphorTextureWidth, this->phosphorTextureHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+		}
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, rows, columns, GL_RGBA, GL_UNSIGNED_BYTE, this->digitalPhosphor->image(this->settings->view.color.screen.background, this->phosphorColors));
+		this->phosphorChanged = false;
+	}
+	
+	GLfloat top = (GLfloat) rows / this->phosphorTextureWidth;
+	GLfloat right = (GLfloat) columns / this->phosphorTextureHeight;
+	GLfloat vertices[] = {-DIVS_TIME / 2, -DIVS_VOLTAGE / 2, DIVS_TIME / 2, -DIVS_VOLTAGE / 2, DIVS_TIME / 2, DIVS_VOLTAGE / 2, -DIVS_TIME / 2, DIVS_VOLTAGE / 2};
+	GLfloat coordinates[] = {0, 0, 0, right, top, right, top, 0};
+	
+	glDisable(GL_BLEND);
+	glEnable(GL_TEXTURE_2D);
+	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+	glColor4f(1, 1, 1, 1);
+	glVertexPointer(2, GL_FLOAT, 0, vertices);
+	glTexCoordPointer(2, GL_FLOAT, 0, coordinates);
+	glDrawArrays(GL_QUADS, 0, 4);
+	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+	glDisable(GL_TEXTURE_2D);
+	glEnable(GL_BLEND);
+}
+
+/// \brief Draw the decoded words below the zero line of their channel.
+/// \param frame The frame with the decoded words.
+void GlScope::drawAnnotations(const GlFrame *frame) {
+	// The visible time range in divs
+	double left = -DIVS_TIME / 2;
+	double right = DIVS_TIME / 2;
+	if(this->zoomed) {
+		left = qMin(this->settings->scope.horizontal.marker[0], this->settings->scope.horizontal.marker[1]);
+		right = qMax(this->settings->scope.horizontal.marker[0], this->settings->scope.horizontal.marker[1]);
+	}
+	if(right <= left)
+		return;
+	double divsPerPixel = (right - left) / qMax(this->width(), 1);
+	QFontMetrics fontMetrics(this->font());
+	
+	for(int channel = 0; channel < frame->annotations.count(); channel++) {
+		if(!this->settings->scope.voltage[channel].used || frame->annotations[channel].isEmpty())
+			continue;
+		
+		this->qglColor(this->settings->view.color.screen.voltage[channel]);
+		double level = this->settings->scope.voltage[channel].offset - 0.4;
+		double factor = frame->annotationFactors[channel];
+		
+		// Skip words that would overlap the text of the previous one
+		double textEnd = left;
+		for(int index = 0; index < frame->annotations[channel].count(); index++) {
+			const ProtocolAnnotation &annotation = frame->annotations[channel][index];
+			double position = annotation.start * factor - DIVS_TIME / 2;
+			if(position < textEnd)
+				continue;
+			if(position > right)
+				break;
+			
+			this->renderText(position, level, 0.0, annotation.text);
+			textEnd = position + (fontMetrics.width(annotation.text) + 4) * divsPerPixel;
+		}
+	}
+}
+
+/// \brief Draw the limits of the mask and mark the samples violating it.
+/// \param frame The frame with the mask arrays.
+void GlScope::drawMask(const GlFrame *frame) {
+	this->qglColor(this->settings->view.color.screen.mask);
+	
+	// Limits
+	glLineWidth(1);
+	for(int limitId = 0; limitId < 2; limitId++) {
+		if(!frame->vaMask[limitId].data)
+			continue;
+		glVertexPointer(2, GL_FLOAT, 0, frame->vaMask[limitId].data);
+		glDrawArrays(GL_LINE_STRIP, 0, frame->vaMask[limitId].getSize() / 2);
+	}
+	
+	// Violating samples
+	if(frame->vaMaskViolations.data) {
+		glPointSize(3);
+		glVertexPointer(2, GL_FLOAT, 0, frame->vaMaskViolations.data);
+		glDrawArrays(GL_POINTS, 0, frame->vaMaskViolations.getSize() / 2);
+		glPointSize(1);
+	}
+}
+
+/// \brief Adds the new graphs to the digital phosphor and requests a redraw.
+void GlScope::accumulateGraphs() {
+	if(!this->settings->view.digitalPhosphor || !this->generator || !this->isVisible()) {
+		// Free the buffer, it starts empty when it's enabled again
+		this->digitalPhosphor->resize(0, 0, 0);
+		emit invalidated();
+		return;
+	}
+	
+	int channelCount = this->settings->scope.voltage.count();
+	this->digitalPhosphor->resize(this->width(), this->height(), Dso::CHANNELMODE_COUNT * channelCount);
+	
+	// The graphs are transformed like the zoom matrix in paintGL() does it
+	double horizontalScale = this->width() / DIVS_TIME;
+	double horizontalOffset = this->width() / 2.0;
+	if(this->zoomed) {
+		double zoomFactor = DIVS_TIME / fabs(this->settings->scope.horizontal.marker[1] - this->settings->scope.horizontal.marker[0]);
+		horizontalOffset -= (this->settings->scope.horizontal.marker[0] + this->settings->scope.horizontal.marker[1]) / 2 * zoomFactor * horizontalScale;
+		horizontalScale *= zoomFactor;
+	}
+	double verticalScale = this->height() / DIVS_VOLTAGE;
+	double verticalOffset = this->height() / 2.0;
+	
+	// Old hits don't fit a different transformation
+	if(horizontalScale != this->phosphorHorizontalScale || horizontalOffset != this->phosphorHorizontalOffset || this->settings->scope.horizontal.format != this->phosphorFormat) {
+		this->phosphorHorizontalScale = horizontalScale;
+		this->phosphorHorizontalOffset = horizontalOffset;
+		this->phosphorFormat = this->settings->scope.horizontal.format;
+		this->digitalPhosphor->clear();
+	}
+	
+	// Hits fade to 1 % within the depth, a depth of 0 keeps them forever
+	if(this->settings->view.digitalPhosphorDepth > 0)
+		this->digitalPhosphor->decay(pow(10.0, -2.0 / this->settings->view.digitalPhosphorDepth));
+	
+	bool lines = this->settings->view.interpolation != Dso::INTERPOLATION_OFF;
+	this->generator->frameMutex()->lock();
+	const GlFrame *frame = this->generator->frame();
+	this->phosphorColors.clear();
+	for(int mode = Dso::CHANNELMODE_VOLTAGE; mode < Dso::CHANNELMODE_COUNT; mode++) {
+		for(int channel = 0; channel < channelCount; channel++) {
+			this->phosphorColors.append((mode == Dso::CHANNELMODE_VOLTAGE) ? this->settings->view.color.screen.voltage[channel] : this->settings->view.color.screen.spectrum[channel]);
+			
+			// The same graphs drawGraphs() would draw
+			const GlGraph *graph = this->visibleGraph(frame, mode, channel);
+			if(!graph)
+				continue;
+			
+			double scale[2], offset[2];
+			this->graphTransform(graph, mode, channel, scale, offset);
+			double graphHorizontalScale = scale[0] * horizontalScale;
+			double graphHorizontalOffset = offset[0] * horizontalScale + horizontalOffset;
+			double graphVerticalScale = scale[1] * verticalScale;
+			double graphVerticalOffset = offset[1] * verticalScale + verticalOffset;
+			if(graph->pairs)
+				this->digitalPhosphor->addGraph(mode * channelCount + channel, graph->values.data, graph->values.getSize() / 2, lines, graphHorizontalScale, graphHorizontalOffset, graphVerticalScale, graphVerticalOffset);
+			else
+				this->digitalPhosphor->addSeries(mode * channelCount + channel, graph->values.data, graph->values.getSize(), graph->valuesPerStep, lines, graphHorizontalScale, graphHorizontalOffset, graphVerticalScale, graphVerticalOffset);
+		}
+	}
+	this->generator->frameMutex()->unlock();
+	this->phosphorChanged = true;
+	
+	emit invalidated();
+}
@@ -37,6 +37,7 @@
 
 
 class DataAnalyzer;
+class DigitalPhosphor;
 class DsoSettings;
 
 
@@ -58,7 +59,15 @@ class GlScope : public QGLWidget {
 		void paintGL();
 		void resizeGL(int width, int height);
 		
+		const GlGraph *visibleGraph(const GlFrame *frame, int mode, int channel, int *slot = 0);
+		void graphTransform(const GlGraph *graph, int mode, int channel, double *scale, double *offset);
+		void uploadGraph(const GlFrame *frame, const GlGraph *graph, int slot);
+		
 		void drawGrid();
+		void drawGraphs(const GlFrame *frame);
+		void drawAnnotations(const GlFrame *frame);
+		void drawMask(const GlFrame *frame);
+		void drawDigitalPhosphor();
 	
 	private:
 		GlGenerator *generator;
@@ -66,6 +75,27 @@ class GlScope : public QGLWidget {
 		
 		GlArray vaMarker[2];
 		bool zoomed;
+		
+		QGLShaderProgram *graphProgram; ///< Places the raw values on the screen, 0 if not supported
+		QList<QGLBuffer *> graphBuffers; ///< The raw values of each graph in video memory
+		QList<GlArray *> graphVertices; ///< The expanded vertices of each series without shaders
+		QList<unsigned long int> graphSerials; ///< The serial of the frame each graph was uploaded from
+		
+		DigitalPhosphor *digitalPhosphor; ///< The persistence buffer for the graphs
+		QList<QColor> phosphorColors; ///< The colors of the graphs in the buffer
+		double phosphorHorizontalScale; ///< The pixels per div of the graphs in the buffer
+		double phosphorHorizontalOffset; ///< The pixel position of x = 0 in the buffer
+		Dso::GraphFormat phosphorFormat; ///< The graph format of the buffer
+		bool phosphorChanged; ///< true if the texture has to be updated
+		GLuint phosphorTexture; ///< The texture the buffer is drawn with
+		int phosphorTextureWidth; ///< The allocated width of the texture
+		int phosphorTextureHeight; ///< The allocated height of the texture
+	
+	private slots:
+		void accumulateGraphs();
+	
+	signals:
+		void invalidated(); ///< The scope has to be redrawn
 };
 
 
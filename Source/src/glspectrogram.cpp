@@ -0,0 +1,134 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  OpenHantek
+//  glspectrogram.cpp
+//
+//  This program is free software: you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation, either version 3 of the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <QMutex>
+
+
+#include "glspectrogram.h"
+
+#include "dataanalyzer.h"
+#include "settings.h"
+#include "spectrogram.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// class GlSpectrogram
+/// \brief Initializes the waterfall widget.
+/// \param settings The settings that should be used.
+/// \param dataAnalyzer The data analyzer that calculates the spectrogram.
+/// \param parent The parent widget.
+GlSpectrogram::GlSpectrogram(DsoSettings *settings, DataAnalyzer *dataAnalyzer, QWidget *parent) : QGLWidget(parent) {
+	this->settings = settings;
+	this->dataAnalyzer = dataAnalyzer;
+	
+	this->texture = 0;
+	this->uploadedRows = 0;
+	this->newestRow = SPECTROGRAM_ROWS - 1;
+}
+
+/// \brief Deletes the texture.
+GlSpectrogram::~GlSpectrogram() {
+	if(this->texture) {
+		this->makeCurrent();
+		glDeleteTextures(1, &this->texture);
+	}
+}
+
+/// \brief Creates the texture with the current content of the ring buffer.
+void GlSpectrogram::initializeGL() {
+	glDisable(GL_DEPTH_TEST);
+	glDisable(GL_BLEND);
+	
+	qglClearColor(this->settings->view.color.screen.background);
+	
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+	
+	glGenTextures(1, &this->texture);
+	glBindTexture(GL_TEXTURE_2D, this->texture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	
+	const Spectrogram *spectrogram = this->dataAnalyzer->spectrogram();
+	this->dataAnalyzer->mutex()->lock();
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, SPECTROGRAM_BINS, SPECTROGRAM_ROWS, 0, GL_RGBA, GL_UNSIGNED_BYTE, spectrogram->row(0));
+	this->uploadedRows = spectrogram->appendedRows();
+	this->newestRow = spectrogram->newestRow();
+	this->dataAnalyzer->mutex()->unlock();
+}
+
+/// \brief Draws the waterfall, the newest row at the top.
+void GlSpectrogram::paintGL() {
+	if(!this->isVisible())
+		return;
+	
+	glClear(GL_COLOR_BUFFER_BIT);
+	this->uploadRows();
+	
+	// The texture repeats vertically, so the ring is drawn in one piece
+	GLfloat top = (GLfloat) (this->newestRow + 1) / SPECTROGRAM_ROWS;
+	GLfloat vertices[] = {0, 0, 1, 0, 1, 1, 0, 1};
+	GLfloat coordinates[] = {0, top - 1, 1, top - 1, 1, top, 0, top};
+	
+	glEnable(GL_TEXTURE_2D);
+	glBindTexture(GL_TEXTURE_2D, this->texture);
+	glColor4f(1, 1, 1, 1);
+	glVertexPointer(2, GL_FLOAT, 0, vertices);
+	glTexCoordPointer(2, GL_FLOAT, 0, coordinates);
+	glDrawArrays(GL_QUADS, 0, 4);
+	glDisable(GL_TEXTURE_2D);
+}
+
+/// \brief Sets the projection, the waterfall fills the whole widget.
+/// \param width The new width of the widget.
+/// \param height The new height of the widget.
+void GlSpectrogram::resizeGL(int width, int height) {
+	glViewport(0, 0, (GLint) width, (GLint) height);
+	glMatrixMode(GL_PROJECTION);
+	glLoadIdentity();
+	glOrtho(0.0, 1.0, 0.0, 1.0, -1.0, 1.0);
+	glMatrixMode(GL_MODELVIEW);
+}
+
+/// \brief Copies the rows appended since the last paint into the texture.
+void GlSpectrogram::uploadRows() {
+	const Spectrogram *spectrogram = this->dataAnalyzer->spectrogram();
+	
+	this->dataAnalyzer->mutex()->lock();
+	unsigned long int appendedRows = spectrogram->appendedRows();
+	glBindTexture(GL_TEXTURE_2D, this->texture);
+	if(appendedRows - this->uploadedRows >= SPECTROGRAM_ROWS) {
+		// Cleared or more new rows than the ring holds
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, SPECTROGRAM_BINS, SPECTROGRAM_ROWS, GL_RGBA, GL_UNSIGNED_BYTE, spectrogram->row(0));
+	}
+	else {
+		// Usually just the newest row
+		for(unsigned long int row = this->uploadedRows; row < appendedRows; row++) {
+			unsigned int index = (spectrogram->newestRow() + SPECTROGRAM_ROWS - (unsigned int) (appendedRows - 1 - row)) % SPECTROGRAM_ROWS;
+			glTexSubImage2D(GL_TEXTURE_2D, 0, 0, index, SPECTROGRAM_BINS, 1, GL_RGBA, GL_UNSIGNED_BYTE, spectrogram->row(index));
+		}
+	}
+	this->uploadedRows = appendedRows;
+	this->newestRow = spectrogram->newestRow();
+	this->dataAnalyzer->mutex()->unlock();
+}
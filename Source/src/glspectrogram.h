@@ -0,0 +1,64 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  OpenHantek
+/// \file glspectrogram.h
+/// \brief Declares the GlSpectrogram class.
+//
+//  This program is free software: you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation, either version 3 of the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef GLSPECTROGRAM_H
+#define GLSPECTROGRAM_H
+
+
+#include <QtOpenGL>
+
+
+class DataAnalyzer;
+class DsoSettings;
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// \class GlSpectrogram                                         glspectrogram.h
+/// \brief OpenGL widget that shows the spectrogram as scrolling waterfall.
+/// The ring buffer of the spectrogram is mirrored in a texture that repeats
+/// vertically. Only the rows appended since the last paint are uploaded, the
+/// scrolling is done by shifting the texture coordinates.
+class GlSpectrogram : public QGLWidget {
+	Q_OBJECT
+	
+	public:
+		GlSpectrogram(DsoSettings *settings, DataAnalyzer *dataAnalyzer, QWidget *parent = 0);
+		~GlSpectrogram();
+	
+	protected:
+		void initializeGL();
+		void paintGL();
+		void resizeGL(int width, int height);
+		
+		void uploadRows();
+	
+	private:
+		DsoSettings *settings;
+		DataAnalyzer *dataAnalyzer;
+		
+		GLuint texture; ///< The mirror of the ring buffer
+		unsigned long int uploadedRows; ///< The number of rows in the texture
+		unsigned int newestRow; ///< The ring index of the newest uploaded row
+};
+
+
+#endif
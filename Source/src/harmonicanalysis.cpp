@@ -0,0 +1,223 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  OpenHantek
+//  harmonicanalysis.cpp
+//
+//  This program is free software: you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation, either version 3 of the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <cmath>
+
+#include <QtGlobal>
+
+
+#include "harmonicanalysis.h"
+
+
+/// \brief Converts a power ratio into dB without running into log10(0).
+static double powerRatio(double numerator, double denominator) {
+	return 10 * log10(qMax(numerator, 1e-300) / qMax(denominator, 1e-300));
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// class HarmonicAnalysis
+/// \brief Initializes the analysis without buffers.
+HarmonicAnalysis::HarmonicAnalysis() {
+}
+
+/// \brief Returns the half width of the main lobe of a window.
+/// \param window The window function the samples were multiplied with.
+/// \return The number of bins on each side of a peak that belong to it.
+unsigned int HarmonicAnalysis::leakageBins(Dso::WindowFunction window) {
+	switch(window) {
+		case Dso::WINDOW_RECTANGULAR:
+			return 1;
+		case Dso::WINDOW_GAUSS:
+		case Dso::WINDOW_BLACKMAN:
+			return 3;
+		case Dso::WINDOW_NUTTALL:
+		case Dso::WINDOW_BLACKMANHARRIS:
+		case Dso::WINDOW_BLACKMANNUTTALL:
+			return 4;
+		case Dso::WINDOW_FLATTOP:
+			return 5;
+		default:
+			return 2;
+	}
+}
+
+/// \brief Calculates the distortion figures of a signal.
+/// The fundamental is the strongest bin outside of the DC lobe. Harmonics above
+/// the nyquist frequency are searched where they alias to. Bins that don't
+/// belong to DC, the fundamental or a harmonic are noise, the noise density is
+/// also subtracted from the lobes and added for the bins they cover.
+/// \param spectrum The half-complex output of the real to half-complex dft.
+/// \param size The length of the dft.
+/// \param samplerate The samplerate of the transformed samples in S/s.
+/// \param window The window function the samples were multiplied with.
+/// \param values The figures are written into this struct.
+/// \return true if a fundamental was found.
+bool HarmonicAnalysis::analyze(const double *spectrum, unsigned int size, double samplerate, Dso::WindowFunction window, HarmonicValues *values) {
+	values->valid = false;
+	
+	unsigned int bins = size / 2 + 1;
+	unsigned int width = HarmonicAnalysis::leakageBins(window);
+	if(!spectrum || bins < 4 * width + 4)
+		return false;
+	
+	// Power of the bins from the half-complex layout
+	this->power.resize(bins);
+	this->assigned.fill(false, bins);
+	this->power[0] = spectrum[0] * spectrum[0];
+	for(unsigned int bin = 1; bin < (size + 1) / 2; bin++)
+		this->power[bin] = spectrum[bin] * spectrum[bin] + spectrum[size - bin] * spectrum[size - bin];
+	if(size % 2 == 0)
+		this->power[size / 2] = spectrum[size / 2] * spectrum[size / 2];
+	
+	// The DC offset is neither signal nor noise
+	unsigned int dcBins = 0;
+	this->sumLobe(0, width, &dcBins);
+	
+	// The fundamental is the strongest remaining bin
+	unsigned int peakBin = 0;
+	double peakPower = 0;
+	for(unsigned int bin = width + 1; bin < bins; bin++) {
+		if(this->power[bin] > peakPower) {
+			peakPower = this->power[bin];
+			peakBin = bin;
+		}
+	}
+	if(!peakBin)
+		return false;
+	
+	double position = peakBin + this->interpolatePeak(peakBin, window != Dso::WINDOW_RECTANGULAR);
+	unsigned int signalBins = 0;
+	double signalPower = this->sumLobe(peakBin, width, &signalBins);
+	
+	// The largest spur can be a harmonic or any other tone
+	double spurPower = 0;
+	for(unsigned int bin = 0; bin < bins; bin++) {
+		if(!this->assigned[bin] && this->power[bin] > spurPower)
+			spurPower = this->power[bin];
+	}
+	
+	// Sum up the harmonics where they appear after aliasing
+	unsigned int harmonicBins = 0;
+	double harmonicPower = 0;
+	for(unsigned int harmonic = 2; harmonic <= HARMONICANALYSIS_HARMONICS; harmonic++) {
+		double alias = fmod(harmonic * position, (double) size);
+		if(alias > size / 2.0)
+			alias = size - alias;
+		int expected = (int) floor(alias + 0.5);
+		
+		// The leakage may move the peak within the main lobe
+		int harmonicBin = -1;
+		for(int bin = qMax(expected - (int) width, 0); bin <= qMin(expected + (int) width, (int) bins - 1); bin++) {
+			if(!this->assigned[bin] && (harmonicBin < 0 || this->power[bin] > this->power[harmonicBin]))
+				harmonicBin = bin;
+		}
+		if(harmonicBin >= 0)
+			harmonicPower += this->sumLobe(harmonicBin, width, &harmonicBins);
+	}
+	
+	// Everything else is noise
+	unsigned int noiseBins = 0;
+	double noisePower = 0;
+	for(unsigned int bin = 0; bin < bins; bin++) {
+		if(!this->assigned[bin]) {
+			noisePower += this->power[bin];
+			noiseBins++;
+		}
+	}
+	double noiseDensity = noiseBins ? noisePower / noiseBins : 0;
+	signalPower -= noiseDensity * signalBins;
+	harmonicPower = qMax(harmonicPower - noiseDensity * harmonicBins, 0.0);
+	noisePower = noiseDensity * (bins - dcBins);
+	if(signalPower <= 0)
+		return false;
+	
+	values->fundamental = position * samplerate / size;
+	values->thd = powerRatio(harmonicPower, signalPower);
+	values->thdNoise = powerRatio(harmonicPower + noisePower, signalPower);
+	values->snr = powerRatio(signalPower, noisePower);
+	values->sinad = powerRatio(signalPower, harmonicPower + noisePower);
+	values->enob = (values->sinad - 1.76) / 6.02;
+	values->sfdr = powerRatio(peakPower, spurPower);
+	values->valid = true;
+	
+	return true;
+}
+
+/// \brief Estimates the position of a peak between the bins.
+/// Windowed peaks are close to a gaussian, so a parabola through the logarithms
+/// of the powers fits them well. The sinc shaped peaks without window are
+/// interpolated with a parabola through the magnitudes.
+/// \param bin The bin with the highest power of the peak.
+/// \param gaussian true for gaussian, false for parabolic interpolation.
+/// \return The offset of the peak from the bin, between -0.5 and 0.5.
+double HarmonicAnalysis::interpolatePeak(unsigned int bin, bool gaussian) const {
+	if(bin == 0 || bin + 1 >= (unsigned int) this->power.count())
+		return 0;
+	
+	double left = this->power[bin - 1];
+	double center = this->power[bin];
+	double right = this->power[bin + 1];
+	if(gaussian && left > 0 && right > 0) {
+		left = log(left);
+		center = log(center);
+		right = log(right);
+	}
+	else {
+		left = sqrt(left);
+		center = sqrt(center);
+		right = sqrt(right);
+	}
+	
+	double curvature = 2 * center - left - right;
+	if(curvature <= 0)
+		return 0;
+	
+	return qBound(-0.5, (right - left) / (2 * curvature), 0.5);
+}
+
+/// \brief Sums up the power of a peak and assigns its bins.
+/// Besides the main lobe the side lobes are added as long as the power keeps
+/// falling, so the leakage of a strong peak isn't counted as noise.
+/// \param center The bin of the peak.
+/// \param width The number of bins on each side that are always added.
+/// \param bins Incremented by the number of newly assigned bins.
+/// \return The power of the bins that weren't assigned before.
+double HarmonicAnalysis::sumLobe(unsigned int center, unsigned int width, unsigned int *bins) {
+	int last = this->power.count() - 1;
+	int first = qMax((int) center - (int) width, 0);
+	int end = qMin((int) (center + width), last);
+	while(first > 0 && this->power[first - 1] < this->power[first])
+		first--;
+	while(end < last && this->power[end + 1] < this->power[end])
+		end++;
+	
+	double sum = 0;
+	for(int bin = first; bin <= end; bin++) {
+		if(!this->assigned[bin]) {
+			sum += this->power[bin];
+			this->assigned[bin] = true;
+			(*bins)++;
+		}
+	}
+	
+	return sum;
+}
@@ -0,0 +1,74 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  OpenHantek
+/// \file harmonicanalysis.h
+/// \brief Declares the HarmonicAnalysis class.
+//
+//  This program is free software: you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation, either version 3 of the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef HARMONICANALYSIS_H
+#define HARMONICANALYSIS_H
+
+
+#include <QVector>
+
+
+#include "dso.h"
+
+
+#define HARMONICANALYSIS_HARMONICS   10 ///< Highest harmonic that is summed up
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// \struct HarmonicValues                                    harmonicanalysis.h
+/// \brief The distortion figures of a channel.
+struct HarmonicValues {
+	bool valid; ///< false if no fundamental was found
+	double fundamental; ///< The interpolated frequency of the fundamental (Hz)
+	double thd; ///< Total harmonic distortion (dB)
+	double thdNoise; ///< Total harmonic distortion plus noise (dB)
+	double snr; ///< Signal to noise ratio without harmonics (dB)
+	double sinad; ///< Signal to noise and distortion ratio (dB)
+	double enob; ///< Effective number of bits from the SINAD
+	double sfdr; ///< Spurious free dynamic range (dB)
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \class HarmonicAnalysis                                   harmonicanalysis.h
+/// \brief Measures the harmonic distortion from a half-complex spectrum.
+/// The powers of the fundamental, the harmonics and the noise are sums over
+/// bins, so the noise bandwidth of the window scales all of them alike and
+/// cancels out of the ratios. The window only decides how many bins around a
+/// peak belong to its main lobe.
+class HarmonicAnalysis {
+	public:
+		HarmonicAnalysis();
+		
+		static unsigned int leakageBins(Dso::WindowFunction window);
+		
+		bool analyze(const double *spectrum, unsigned int size, double samplerate, Dso::WindowFunction window, HarmonicValues *values);
+	
+	protected:
+		double interpolatePeak(unsigned int bin, bool gaussian) const;
+		double sumLobe(unsigned int center, unsigned int width, unsigned int *bins);
+		
+		QVector<double> power; ///< The power of each bin
+		QVector<bool> assigned; ///< true if the bin belongs to DC, the fundamental or a harmonic
+};
+
+
+#endif
@@ -25,6 +25,7 @@
 #include <QApplication>
 #include <QLibraryInfo>
 #include <QLocale>
+#include <QStringList>
 #include <QTranslator>
 
 
@@ -48,5 +49,13 @@ int main(int argc, char *argv[]) {
 	OpenHantekMainWindow *openHantekMainWindow = new OpenHantekMainWindow();
 	openHantekMainWindow->show();
 
+	// Unattended recordings start with "--record FILE"
+	QStringList arguments = openHantekApplication.arguments();
+	int recordIndex = arguments.indexOf("--record");
+	if(recordIndex >= 0 && recordIndex + 1 < arguments.count()) {
+		if(!openHantekMainWindow->startRecording(arguments[recordIndex + 1]))
+			qWarning("Can't start the recording to %s", qPrintable(arguments[recordIndex + 1]));
+	}
+
 	return openHantekApplication.exec();
 }
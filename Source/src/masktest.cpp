@@ -0,0 +1,211 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  OpenHantek
+//  masktest.cpp
+//
+//  This program is free software: you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation, either version 3 of the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+
+#include <cmath>
+
+#include <QtGlobal>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+
+#include "masktest.h"
+
+#include "settings.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// class MaskTest
+/// \brief Initializes the test without a mask.
+MaskTest::MaskTest() {
+	this->interval = 0;
+	
+	this->resetCounters();
+}
+
+/// \brief Creates a mask around a golden waveform.
+/// The samples are split into MASKTEST_SEGMENTS segments, each one is limited
+/// by the extremes of the samples within the horizontal tolerance around it.
+/// \param mask The mask settings that get the new limits.
+/// \param samples The golden waveform.
+/// \param count The number of samples.
+/// \param interval The interval between two samples in s.
+/// \param toleranceTime The allowed horizontal deviation in s.
+/// \param toleranceVoltage The allowed vertical deviation in V.
+void MaskTest::create(DsoSettingsScopeMask &mask, const double *samples, unsigned int count, double interval, double toleranceTime, double toleranceVoltage) {
+	mask.lower.clear();
+	mask.upper.clear();
+	if(!samples || !count || interval <= 0)
+		return;
+	
+	unsigned int spread = (unsigned int) qMin(floor(toleranceTime / interval + 0.5), (double) count);
+	unsigned int segments = qMin(count, (unsigned int) MASKTEST_SEGMENTS);
+	for(unsigned int segment = 0; segment < segments; segment++) {
+		unsigned int first = (unsigned long long) segment * count / segments;
+		unsigned int last = (unsigned long long) (segment + 1) * count / segments - 1;
+		
+		// Extremes within the horizontal tolerance
+		unsigned int from = (first > spread) ? first - spread : 0;
+		unsigned int to = qMin(last + spread, count - 1);
+		double minimum = samples[from];
+		double maximum = samples[from];
+		for(unsigned int position = from + 1; position <= to; position++) {
+			minimum = qMin(minimum, samples[position]);
+			maximum = qMax(maximum, samples[position]);
+		}
+		
+		// Flat steps, so the limit never cuts into the tolerance area
+		mask.lower.append(QPointF(first * interval, minimum - toleranceVoltage));
+		mask.upper.append(QPointF(first * interval, maximum + toleranceVoltage));
+		if(last != first) {
+			mask.lower.append(QPointF(last * interval, minimum - toleranceVoltage));
+			mask.upper.append(QPointF(last * interval, maximum + toleranceVoltage));
+		}
+	}
+}
+
+/// \brief Calculates the limit tables if the mask or the samplerate changed.
+/// \param mask The mask settings.
+/// \param count The number of samples of the tested frames.
+/// \param interval The interval between two samples in s.
+/// \return true if there is a mask the frames can be tested against.
+bool MaskTest::prepare(const DsoSettingsScopeMask &mask, unsigned int count, double interval) {
+	if(mask.lower.isEmpty() && mask.upper.isEmpty())
+		return false;
+	
+	if(count == (unsigned int) this->lowerLimits.count() && interval == this->interval && mask.lower == this->lower && mask.upper == this->upper)
+		return true;
+	
+	this->lower = mask.lower;
+	this->upper = mask.upper;
+	this->interval = interval;
+	MaskTest::rasterize(this->lower, count, interval, -HUGE_VAL, this->lowerLimits);
+	MaskTest::rasterize(this->upper, count, interval, HUGE_VAL, this->upperLimits);
+	
+	return true;
+}
+
+/// \brief Tests a frame against the prepared mask and updates the counters.
+/// \param samples The samples of the frame.
+/// \param count The number of samples.
+/// \param violations Gets the positions of the violating samples if not 0.
+/// \return The number of samples outside of the mask.
+unsigned int MaskTest::test(const double *samples, unsigned int count, QVector<unsigned int> *violations) {
+	count = qMin(count, (unsigned int) this->lowerLimits.count());
+	const double *lowerLimits = this->lowerLimits.constData();
+	const double *upperLimits = this->upperLimits.constData();
+	
+	// Count first, this loop has no branches
+	unsigned int violating = 0;
+	unsigned int position = 0;
+#ifdef __SSE2__
+	for(; position + 2 <= count; position += 2) {
+		__m128d values = _mm_loadu_pd(samples + position);
+		__m128d outside = _mm_or_pd(_mm_cmplt_pd(values, _mm_loadu_pd(lowerLimits + position)), _mm_cmpgt_pd(values, _mm_loadu_pd(upperLimits + position)));
+		int mask = _mm_movemask_pd(outside);
+		violating += (mask & 1) + (mask >> 1);
+	}
+#endif
+	for(; position < count; position++)
+		violating += (samples[position] < lowerLimits[position]) | (samples[position] > upperLimits[position]);
+	
+	if(violations) {
+		violations->clear();
+		if(violating) {
+			violations->reserve(violating);
+			for(unsigned int position = 0; position < count; position++) {
+				if(samples[position] < lowerLimits[position] || samples[position] > upperLimits[position])
+					violations->append(position);
+			}
+		}
+	}
+	
+	if(violating)
+		this->failed++;
+	else
+		this->passed++;
+	this->violations += violating;
+	
+	return violating;
+}
+
+/// \brief Get the number of frames that passed the test.
+/// \return The number of frames without violation since the last reset.
+unsigned long int MaskTest::passedCount() const {
+	return this->passed;
+}
+
+/// \brief Get the number of frames that failed the test.
+/// \return The number of frames with violations since the last reset.
+unsigned long int MaskTest::failedCount() const {
+	return this->failed;
+}
+
+/// \brief Get the total number of violating samples.
+/// \return The number of samples outside of the mask since the last reset.
+unsigned long int MaskTest::violationCount() const {
+	return this->violations;
+}
+
+/// \brief Sets all counters to zero.
+void MaskTest::resetCounters() {
+	this->passed = 0;
+	this->failed = 0;
+	this->violations = 0;
+}
+
+/// \brief Calculates the limit for each sample by linear interpolation.
+/// \param limit The polyline, sorted by time.
+/// \param count The number of samples.
+/// \param interval The interval between two samples in s.
+/// \param outside The limit for samples that aren't covered by the polyline.
+/// \param table The array that gets the limits.
+void MaskTest::rasterize(const QList<QPointF> &limit, unsigned int count, double interval, double outside, QVector<double> &table) {
+	table.resize(count);
+	double *values = table.data();
+	
+	int segment = 0;
+	for(unsigned int position = 0; position < count; position++) {
+		double time = position * interval;
+		if(limit.isEmpty() || time < limit.first().x() || time > limit.last().x()) {
+			values[position] = outside;
+			continue;
+		}
+		
+		// Both the samples and the points are sorted, so the segment only moves forward
+		while(segment + 1 < limit.count() && limit[segment + 1].x() < time)
+			segment++;
+		if(segment + 1 >= limit.count()) {
+			values[position] = limit[segment].y();
+			continue;
+		}
+		
+		const QPointF &start = limit[segment];
+		const QPointF &end = limit[segment + 1];
+		double width = end.x() - start.x();
+		if(width <= 0)
+			values[position] = end.y();
+		else
+			values[position] = start.y() + (end.y() - start.y()) * (time - start.x()) / width;
+	}
+}
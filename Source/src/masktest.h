@@ -0,0 +1,75 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  OpenHantek
+/// \file masktest.h
+/// \brief Declares the MaskTest class.
+//
+//  This program is free software: you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation, either version 3 of the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef MASKTEST_H
+#define MASKTEST_H
+
+
+#include <QList>
+#include <QPointF>
+#include <QVector>
+
+
+struct DsoSettingsScopeMask;
+
+
+#define MASKTEST_SEGMENTS           200 ///< Segments of masks created from a waveform
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// \class MaskTest                                                   masktest.h
+/// \brief Tests frames against the lower and upper limit of a mask.
+/// The limit polylines are rasterized once into a table with the lower and
+/// upper limit for each sample, it's only calculated again when the mask or the
+/// samplerate changes. Testing a frame is then a branchless compare of every
+/// sample with its limits, two samples at a time with SSE2, the positions of the
+/// violating samples are only searched if there are any.
+class MaskTest {
+	public:
+		MaskTest();
+		
+		static void create(DsoSettingsScopeMask &mask, const double *samples, unsigned int count, double interval, double toleranceTime, double toleranceVoltage);
+		
+		bool prepare(const DsoSettingsScopeMask &mask, unsigned int count, double interval);
+		unsigned int test(const double *samples, unsigned int count, QVector<unsigned int> *violations = 0);
+		
+		unsigned long int passedCount() const;
+		unsigned long int failedCount() const;
+		unsigned long int violationCount() const;
+		void resetCounters();
+	
+	protected:
+		static void rasterize(const QList<QPointF> &limit, unsigned int count, double interval, double outside, QVector<double> &table);
+		
+		QList<QPointF> lower; ///< The lower limit the table was calculated for
+		QList<QPointF> upper; ///< The upper limit the table was calculated for
+		double interval; ///< The sample interval the tables were calculated for
+		QVector<double> lowerLimits; ///< The lowest allowed voltage for each sample
+		QVector<double> upperLimits; ///< The highest allowed voltage for each sample
+		
+		unsigned long int passed; ///< Number of frames without violation
+		unsigned long int failed; ///< Number of frames with violations
+		unsigned long int violations; ///< Number of violating samples in all frames
+};
+
+
+#endif
@@ -0,0 +1,545 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  OpenHantek
+//  mathexpression.cpp
+//
+//  This program is free software: you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation, either version 3 of the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <cmath>
+
+#include <QApplication>
+
+
+#include "mathexpression.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// class MathExpression
+/// \brief Initializes an empty, invalid expression.
+MathExpression::MathExpression() {
+	this->valid = false;
+	this->stackDepth = 0;
+	this->stack = 0;
+	
+	this->maximumChannel = 0;
+	this->position = 0;
+	this->depth = 0;
+}
+
+/// \brief Frees the stack.
+MathExpression::~MathExpression() {
+	if(this->stack)
+		delete[] this->stack;
+}
+
+/// \brief Compiles the given formula.
+/// \param expression The formula, see the class description for the syntax.
+/// \param channels The number of channels that can be referenced.
+/// \return true if the formula was compiled successfully.
+bool MathExpression::compile(const QString &expression, unsigned int channels) {
+	this->text = expression;
+	this->errorString.clear();
+	this->valid = false;
+	this->usedChannels.clear();
+	this->program.clear();
+	this->stackDepth = 0;
+	
+	this->maximumChannel = channels;
+	this->position = 0;
+	this->depth = 0;
+	
+	if(!this->parseSum())
+		return false;
+	this->skipWhitespace();
+	if(this->position < this->text.length())
+		return this->fail(QApplication::tr("Unexpected '%1'").arg(this->text[this->position]));
+	
+	// Allocate the blocks for the intermediate results
+	if(this->stack)
+		delete[] this->stack;
+	this->stack = new double[this->stackDepth * MATHEXPRESSION_BLOCK];
+	
+	this->valid = true;
+	return true;
+}
+
+/// \brief Returns whether the expression can be evaluated.
+/// \return true if the last compilation was successful.
+bool MathExpression::isValid() const {
+	return this->valid;
+}
+
+/// \brief Returns the source of the expression.
+/// \return The formula that was compiled last.
+const QString &MathExpression::expression() const {
+	return this->text;
+}
+
+/// \brief Returns the description of the compilation error.
+/// \return The error message, empty if the expression is valid.
+const QString &MathExpression::error() const {
+	return this->errorString;
+}
+
+/// \brief Returns the channels that are used by the expression.
+/// \return List with the indices of all referenced channels.
+const QList<unsigned int> &MathExpression::channels() const {
+	return this->usedChannels;
+}
+
+/// \brief Calculates the expression for all samples.
+/// \param inputs The sample arrays of all channels, only the used ones have to be set.
+/// \param count The number of samples that should be calculated.
+/// \param interval The time between two samples in seconds.
+/// \param output The array for the results.
+void MathExpression::evaluate(const QList<const double *> &inputs, unsigned int count, double interval, double *output) {
+	if(!this->valid)
+		return;
+	
+	for(unsigned int start = 0; start < count; start += MATHEXPRESSION_BLOCK) {
+		unsigned int length = qMin(count - start, (unsigned int) MATHEXPRESSION_BLOCK);
+		double *top = this->stack - MATHEXPRESSION_BLOCK; // Topmost block
+		
+		for(int index = 0; index < this->program.count(); index++) {
+			Instruction *instruction = &(this->program[index]);
+			double *operand = top; // Second operand for binary operations
+			
+			switch(instruction->operation) {
+				case OPERATION_CHANNEL:
+					{
+						top += MATHEXPRESSION_BLOCK;
+						const double *input = inputs[instruction->channel] + start;
+						for(unsigned int sample = 0; sample < length; sample++)
+							top[sample] = input[sample];
+					}
+					break;
+				case OPERATION_CONSTANT:
+					top += MATHEXPRESSION_BLOCK;
+					for(unsigned int sample = 0; sample < length; sample++)
+						top[sample] = instruction->value;
+					break;
+				case OPERATION_ADD:
+					top -= MATHEXPRESSION_BLOCK;
+					for(unsigned int sample = 0; sample < length; sample++)
+						top[sample] += operand[sample];
+					break;
+				case OPERATION_SUBTRACT:
+					top -= MATHEXPRESSION_BLOCK;
+					for(unsigned int sample = 0; sample < length; sample++)
+						top[sample] -= operand[sample];
+					break;
+				case OPERATION_MULTIPLY:
+					top -= MATHEXPRESSION_BLOCK;
+					for(unsigned int sample = 0; sample < length; sample++)
+						top[sample] *= operand[sample];
+					break;
+				case OPERATION_DIVIDE:
+					top -= MATHEXPRESSION_BLOCK;
+					for(unsigned int sample = 0; sample < length; sample++)
+						top[sample] /= operand[sample];
+					break;
+				case OPERATION_POWER:
+					top -= MATHEXPRESSION_BLOCK;
+					for(unsigned int sample = 0; sample < length; sample++)
+						top[sample] = pow(top[sample], operand[sample]);
+					break;
+				case OPERATION_NEGATE:
+					for(unsigned int sample = 0; sample < length; sample++)
+						top[sample] = -top[sample];
+					break;
+				case OPERATION_ABS:
+					for(unsigned int sample = 0; sample < length; sample++)
+						top[sample] = fabs(top[sample]);
+					break;
+				case OPERATION_SQRT:
+					for(unsigned int sample = 0; sample < length; sample++)
+						top[sample] = sqrt(top[sample]);
+					break;
+				case OPERATION_DIFF:
+					{
+						// The first sample has no predecessor, use a zero slope
+						double previous = (start == 0) ? top[0] : instruction->state;
+						for(unsigned int sample = 0; sample < length; sample++) {
+							double value = top[sample];
+							top[sample] = (value - previous) / interval;
+							previous = value;
+						}
+						instruction->state = previous;
+					}
+					break;
+				case OPERATION_INTEG:
+					{
+						// Trapezoidal rule, the integral starts with zero at the first sample
+						double sum = instruction->sum;
+						double previous = instruction->state;
+						unsigned int first = 0;
+						if(start == 0) {
+							sum = 0;
+							previous = top[0];
+							top[0] = 0;
+							first = 1;
+						}
+						for(unsigned int sample = first; sample < length; sample++) {
+							double value = top[sample];
+							sum += (value + previous) * interval / 2;
+							top[sample] = sum;
+							previous = value;
+						}
+						instruction->sum = sum;
+						instruction->state = previous;
+					}
+					break;
+				case OPERATION_LOWPASS:
+				case OPERATION_HIGHPASS:
+					{
+						double factor = 1.0 - exp(-2 * M_PI * instruction->value * interval);
+						double filtered = (start == 0) ? top[0] : instruction->state;
+						if(instruction->operation == OPERATION_LOWPASS) {
+							for(unsigned int sample = 0; sample < length; sample++) {
+								filtered += factor * (top[sample] - filtered);
+								top[sample] = filtered;
+							}
+						}
+						else {
+							for(unsigned int sample = 0; sample < length; sample++) {
+								filtered += factor * (top[sample] - filtered);
+								top[sample] -= filtered;
+							}
+						}
+						instruction->state = filtered;
+					}
+					break;
+			}
+		}
+		
+		for(unsigned int sample = 0; sample < length; sample++)
+			output[start + sample] = this->stack[sample];
+	}
+}
+
+/// \brief Returns the formula for one of the fixed math modes.
+/// \param mode The #Dso::MathMode.
+/// \return The formula that calculates the same values, empty for MATHMODE_EXPRESSION.
+QString MathExpression::modeExpression(Dso::MathMode mode) {
+	switch(mode) {
+		case Dso::MATHMODE_1ADD2:
+			return "CH1 + CH2";
+		case Dso::MATHMODE_1SUB2:
+			return "CH1 - CH2";
+		case Dso::MATHMODE_2SUB1:
+			return "CH2 - CH1";
+		default:
+			return QString();
+	}
+}
+
+/// \brief Appends an instruction to the program.
+/// \param operation The operation of the instruction.
+/// \param value The constant value or the cutoff frequency.
+/// \param channel The channel index for OPERATION_CHANNEL.
+void MathExpression::addInstruction(Operation operation, double value, unsigned int channel) {
+	Instruction instruction;
+	instruction.operation = operation;
+	instruction.channel = channel;
+	instruction.value = value;
+	instruction.state = 0;
+	instruction.sum = 0;
+	this->program.append(instruction);
+	
+	if(operation == OPERATION_CHANNEL || operation == OPERATION_CONSTANT) {
+		this->depth++;
+		if(this->depth > this->stackDepth)
+			this->stackDepth = this->depth;
+	}
+}
+
+/// \brief Appends a binary operator, constant operands are folded.
+/// \param operation The operation of the operator.
+void MathExpression::addOperator(Operation operation) {
+	int count = this->program.count();
+	if(count >= 2 && this->program[count - 2].operation == OPERATION_CONSTANT && this->program[count - 1].operation == OPERATION_CONSTANT) {
+		double first = this->program[count - 2].value;
+		double second = this->program[count - 1].value;
+		double result;
+		switch(operation) {
+			case OPERATION_ADD:
+				result = first + second;
+				break;
+			case OPERATION_SUBTRACT:
+				result = first - second;
+				break;
+			case OPERATION_MULTIPLY:
+				result = first * second;
+				break;
+			case OPERATION_DIVIDE:
+				result = first / second;
+				break;
+			default:
+				result = pow(first, second);
+				break;
+		}
+		this->program.removeLast();
+		this->program.last().value = result;
+	}
+	else
+		this->addInstruction(operation);
+	
+	this->depth--;
+}
+
+/// \brief Skips spaces in the expression.
+void MathExpression::skipWhitespace() {
+	while(this->position < this->text.length() && this->text[this->position].isSpace())
+		this->position++;
+}
+
+/// \brief Sets the error message.
+/// \param message The description of the error.
+/// \return Always false.
+bool MathExpression::fail(const QString &message) {
+	this->errorString = QApplication::tr("%1 at position %2").arg(message).arg(this->position + 1);
+	return false;
+}
+
+/// \brief Parses additions and subtractions.
+/// \return true on success.
+bool MathExpression::parseSum() {
+	if(!this->parseProduct())
+		return false;
+	
+	forever {
+		this->skipWhitespace();
+		if(this->position >= this->text.length())
+			return true;
+		
+		QChar character = this->text[this->position];
+		if(character != '+' && character != '-')
+			return true;
+		this->position++;
+		
+		if(!this->parseProduct())
+			return false;
+		this->addOperator((character == '+') ? OPERATION_ADD : OPERATION_SUBTRACT);
+	}
+}
+
+/// \brief Parses multiplications and divisions.
+/// \return true on success.
+bool MathExpression::parseProduct() {
+	if(!this->parseUnary())
+		return false;
+	
+	forever {
+		this->skipWhitespace();
+		if(this->position >= this->text.length())
+			return true;
+		
+		QChar character = this->text[this->position];
+		if(character != '*' && character != '/')
+			return true;
+		this->position++;
+		
+		if(!this->parseUnary())
+			return false;
+		this->addOperator((character == '*') ? OPERATION_MULTIPLY : OPERATION_DIVIDE);
+	}
+}
+
+/// \brief Parses signs.
+/// \return true on success.
+bool MathExpression::parseUnary() {
+	this->skipWhitespace();
+	if(this->position < this->text.length()) {
+		if(this->text[this->position] == '+') {
+			this->position++;
+			return this->parseUnary();
+		}
+		if(this->text[this->position] == '-') {
+			this->position++;
+			if(!this->parseUnary())
+				return false;
+			
+			if(this->program.last().operation == OPERATION_CONSTANT)
+				this->program.last().value = -this->program.last().value;
+			else
+				this->addInstruction(OPERATION_NEGATE);
+			return true;
+		}
+	}
+	
+	return this->parsePower();
+}
+
+/// \brief Parses powers, they are right associative.
+/// \return true on success.
+bool MathExpression::parsePower() {
+	if(!this->parsePrimary())
+		return false;
+	
+	this->skipWhitespace();
+	if(this->position < this->text.length() && this->text[this->position] == '^') {
+		this->position++;
+		if(!this->parseUnary())
+			return false;
+		this->addOperator(OPERATION_POWER);
+	}
+	
+	return true;
+}
+
+/// \brief Parses numbers, channels, functions and brackets.
+/// \return true on success.
+bool MathExpression::parsePrimary() {
+	this->skipWhitespace();
+	if(this->position >= this->text.length())
+		return this->fail(QApplication::tr("Unexpected end of expression"));
+	
+	QChar character = this->text[this->position];
+	
+	// Brackets
+	if(character == '(') {
+		this->position++;
+		if(!this->parseSum())
+			return false;
+		this->skipWhitespace();
+		if(this->position >= this->text.length() || this->text[this->position] != ')')
+			return this->fail(QApplication::tr("Missing ')'"));
+		this->position++;
+		return true;
+	}
+	
+	// Numbers, with optional exponent
+	if(character.isDigit() || character == '.') {
+		int start = this->position;
+		while(this->position < this->text.length() && (this->text[this->position].isDigit() || this->text[this->position] == '.'))
+			this->position++;
+		if(this->position < this->text.length() && this->text[this->position].toLower() == 'e') {
+			int exponent = this->position + 1;
+			if(exponent < this->text.length() && (this->text[exponent] == '+' || this->text[exponent] == '-'))
+				exponent++;
+			if(exponent < this->text.length() && this->text[exponent].isDigit()) {
+				this->position = exponent;
+				while(this->position < this->text.length() && this->text[this->position].isDigit())
+					this->position++;
+			}
+		}
+		
+		bool ok;
+		double value = this->text.mid(start, this->position - start).toDouble(&ok);
+		if(!ok) {
+			this->position = start;
+			return this->fail(QApplication::tr("Invalid number"));
+		}
+		this->addInstruction(OPERATION_CONSTANT, value);
+		return true;
+	}
+	
+	// Channels, constants and functions
+	if(character.isLetter()) {
+		int start = this->position;
+		while(this->position < this->text.length() && this->text[this->position].isLetterOrNumber())
+			this->position++;
+		QString name = this->text.mid(start, this->position - start).toLower();
+		
+		if(name.startsWith("ch") && name.length() > 2) {
+			bool ok;
+			unsigned int channel = name.mid(2).toUInt(&ok);
+			if(!ok || channel < 1 || channel > this->maximumChannel) {
+				this->position = start;
+				return this->fail(QApplication::tr("Unknown channel %1").arg(this->text.mid(start, name.length())));
+			}
+			if(!this->usedChannels.contains(channel - 1))
+				this->usedChannels.append(channel - 1);
+			this->addInstruction(OPERATION_CHANNEL, 0, channel - 1);
+			return true;
+		}
+		if(name == "pi") {
+			this->addInstruction(OPERATION_CONSTANT, M_PI);
+			return true;
+		}
+		
+		this->skipWhitespace();
+		if(this->position >= this->text.length() || this->text[this->position] != '(') {
+			this->position = start;
+			return this->fail(QApplication::tr("Unknown name %1").arg(this->text.mid(start, name.length())));
+		}
+		this->position++;
+		
+		return this->parseFunction(name);
+	}
+	
+	return this->fail(QApplication::tr("Unexpected '%1'").arg(character));
+}
+
+/// \brief Parses the arguments of a function, the opening bracket is already consumed.
+/// \param name The lowercase name of the function.
+/// \return true on success.
+bool MathExpression::parseFunction(const QString &name) {
+	Operation operation;
+	bool frequencyArgument = false;
+	if(name == "abs")
+		operation = OPERATION_ABS;
+	else if(name == "sqrt")
+		operation = OPERATION_SQRT;
+	else if(name == "diff")
+		operation = OPERATION_DIFF;
+	else if(name == "integ")
+		operation = OPERATION_INTEG;
+	else if(name == "lowpass" || name == "highpass") {
+		operation = (name == "lowpass") ? OPERATION_LOWPASS : OPERATION_HIGHPASS;
+		frequencyArgument = true;
+	}
+	else
+		return this->fail(QApplication::tr("Unknown function %1").arg(name));
+	
+	if(!this->parseSum())
+		return false;
+	
+	// The filters need a constant cutoff frequency as second argument
+	double frequency = 0;
+	if(frequencyArgument) {
+		this->skipWhitespace();
+		if(this->position >= this->text.length() || this->text[this->position] != ',')
+			return this->fail(QApplication::tr("%1 needs a cutoff frequency").arg(name));
+		this->position++;
+		
+		if(!this->parseSum())
+			return false;
+		if(this->program.last().operation != OPERATION_CONSTANT || this->program.last().value <= 0)
+			return this->fail(QApplication::tr("The cutoff frequency has to be a positive constant"));
+		frequency = this->program.last().value;
+		this->program.removeLast();
+		this->depth--;
+	}
+	
+	this->skipWhitespace();
+	if(this->position >= this->text.length() || this->text[this->position] != ')')
+		return this->fail(QApplication::tr("Missing ')'"));
+	this->position++;
+	
+	// Functions of constants are calculated right away
+	if(!frequencyArgument && operation != OPERATION_DIFF && operation != OPERATION_INTEG && this->program.last().operation == OPERATION_CONSTANT) {
+		if(operation == OPERATION_ABS)
+			this->program.last().value = fabs(this->program.last().value);
+		else
+			this->program.last().value = sqrt(this->program.last().value);
+		return true;
+	}
+	
+	this->addInstruction(operation, frequency);
+	return true;
+}
@@ -0,0 +1,124 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  OpenHantek
+/// \file mathexpression.h
+/// \brief Declares the MathExpression class.
+//
+//  This program is free software: you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation, either version 3 of the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef MATHEXPRESSION_H
+#define MATHEXPRESSION_H
+
+
+#include <QList>
+#include <QString>
+#include <QVector>
+
+
+#include "dso.h"
+
+
+#define MATHEXPRESSION_BLOCK        256 ///< Number of samples evaluated at once
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// \class MathExpression                                       mathexpression.h
+/// \brief A compiled formula for a math channel.
+/// The formula is parsed once into a program for a stack machine. Every
+/// instruction of the program is applied to a whole block of samples before
+/// the next one is executed, so there is no per-sample dispatch.
+///
+/// Supported are the channels CH1 to CHn, numbers, pi, the operators + - * / ^
+/// and the functions abs(x), sqrt(x), diff(x) (derivative in 1/s),
+/// integ(x) (integral in s), lowpass(x, f) and highpass(x, f) (first order
+/// filters with the cutoff frequency f in Hz).
+class MathExpression {
+	public:
+		MathExpression();
+		~MathExpression();
+		
+		bool compile(const QString &expression, unsigned int channels);
+		bool isValid() const;
+		const QString &expression() const;
+		const QString &error() const;
+		const QList<unsigned int> &channels() const;
+		
+		void evaluate(const QList<const double *> &inputs, unsigned int count, double interval, double *output);
+		
+		static QString modeExpression(Dso::MathMode mode);
+	
+	protected:
+		////////////////////////////////////////////////////////////////////////////
+		/// \enum Operation                                       mathexpression.h
+		/// \brief The instructions of the stack machine.
+		enum Operation {
+			OPERATION_CHANNEL,                ///< Push the samples of a channel
+			OPERATION_CONSTANT,               ///< Push a constant value
+			OPERATION_ADD,                    ///< Add the two topmost blocks
+			OPERATION_SUBTRACT,               ///< Subtract the topmost block
+			OPERATION_MULTIPLY,               ///< Multiply the two topmost blocks
+			OPERATION_DIVIDE,                 ///< Divide by the topmost block
+			OPERATION_POWER,                  ///< Raise to the power of the topmost block
+			OPERATION_NEGATE,                 ///< Negate the topmost block
+			OPERATION_ABS,                    ///< Absolute value
+			OPERATION_SQRT,                   ///< Square root
+			OPERATION_DIFF,                   ///< Derivative over time
+			OPERATION_INTEG,                  ///< Integral over time
+			OPERATION_LOWPASS,                ///< First order lowpass filter
+			OPERATION_HIGHPASS                ///< First order highpass filter
+		};
+		
+		////////////////////////////////////////////////////////////////////////////
+		/// \struct Instruction                                   mathexpression.h
+		/// \brief A single instruction of the stack machine.
+		struct Instruction {
+			Operation operation; ///< What this instruction does
+			unsigned int channel; ///< The channel for OPERATION_CHANNEL
+			double value; ///< The constant or the cutoff frequency
+			double state; ///< The previous sample for the stateful operations
+			double sum; ///< The running sum for OPERATION_INTEG
+		};
+		
+		void addInstruction(Operation operation, double value = 0, unsigned int channel = 0);
+		void addOperator(Operation operation);
+		void skipWhitespace();
+		bool fail(const QString &message);
+		
+		bool parseSum();
+		bool parseProduct();
+		bool parseUnary();
+		bool parsePower();
+		bool parsePrimary();
+		bool parseFunction(const QString &name);
+		
+		QString text; ///< The source of the expression
+		QString errorString; ///< Description of the compilation error
+		bool valid; ///< true if the expression has been compiled successfully
+		QList<unsigned int> usedChannels; ///< The channels read by the program
+		
+		QVector<Instruction> program; ///< The compiled instructions
+		unsigned int stackDepth; ///< Maximum number of blocks on the stack
+		double *stack; ///< The blocks for the intermediate results
+		
+		// Parser state
+		unsigned int maximumChannel; ///< The number of channels that can be used
+		int position; ///< The current position in the expression
+		unsigned int depth; ///< The current stack depth while compiling
+};
+
+
+#endif
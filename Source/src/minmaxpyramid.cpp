@@ -0,0 +1,139 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  OpenHantek
+//  minmaxpyramid.cpp
+//
+//  This program is free software: you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation, either version 3 of the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <QtGlobal>
+
+
+#include "minmaxpyramid.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// class MinMaxPyramid
+/// \brief Initializes an empty pyramid.
+MinMaxPyramid::MinMaxPyramid() {
+	this->samples = 0;
+	this->count = 0;
+	this->validLevels = 0;
+}
+
+/// \brief Frees the levels.
+MinMaxPyramid::~MinMaxPyramid() {
+	for(int index = 0; index < this->minimumLevels.count(); index++) {
+		delete[] this->minimumLevels[index];
+		delete[] this->maximumLevels[index];
+	}
+}
+
+/// \brief Sets the samples for the next frame.
+/// The levels of the previous samples are invalidated, their memory is reused.
+/// \param samples The samples, they have to stay valid while the pyramid is used.
+/// \param count The number of samples.
+void MinMaxPyramid::setSamples(const double *samples, unsigned int count) {
+	this->samples = samples;
+	this->count = count;
+	this->validLevels = 0;
+}
+
+/// \brief Chooses the level that gives at most one block per pixel.
+/// \param samplesPerPixel The number of visible samples per pixel.
+/// \return The lowest level whose blocks aren't smaller than a pixel, 0 if the samples can be drawn directly.
+unsigned int MinMaxPyramid::levelForDensity(double samplesPerPixel) {
+	unsigned int level = 0;
+	while(level < MINMAXPYRAMID_LEVELS && (double) (1u << level) < samplesPerPixel)
+		level++;
+	
+	return level;
+}
+
+/// \brief Get the number of blocks in a level.
+/// \param level The level.
+/// \return The number of minimum/maximum pairs, the last block may be incomplete.
+unsigned int MinMaxPyramid::blockCount(unsigned int level) const {
+	if(!level)
+		return this->count;
+	
+	return ((this->count - 1) >> level) + 1;
+}
+
+/// \brief Get the minimums of a level, it's built if needed.
+/// \param level The level.
+/// \return blockCount(level) minimums.
+const double *MinMaxPyramid::minimum(unsigned int level) {
+	if(!level)
+		return this->samples;
+	
+	this->build(level);
+	return this->minimumLevels[level - 1];
+}
+
+/// \brief Get the maximums of a level, it's built if needed.
+/// \param level The level.
+/// \return blockCount(level) maximums.
+const double *MinMaxPyramid::maximum(unsigned int level) {
+	if(!level)
+		return this->samples;
+	
+	this->build(level);
+	return this->maximumLevels[level - 1];
+}
+
+/// \brief Builds all missing levels up to the given one.
+/// \param level The highest level that is needed.
+void MinMaxPyramid::build(unsigned int level) {
+	level = qMin(level, (unsigned int) MINMAXPYRAMID_LEVELS);
+	
+	for(unsigned int current = this->validLevels + 1; current <= level; current++) {
+		unsigned int size = this->blockCount(current);
+		
+		// Reuse the memory of the previous frames
+		if((unsigned int) this->minimumLevels.count() < current) {
+			this->minimumLevels.append(0);
+			this->maximumLevels.append(0);
+			this->levelSizes.append(0);
+		}
+		if(this->levelSizes[current - 1] < size) {
+			delete[] this->minimumLevels[current - 1];
+			delete[] this->maximumLevels[current - 1];
+			this->minimumLevels[current - 1] = new double[size];
+			this->maximumLevels[current - 1] = new double[size];
+			this->levelSizes[current - 1] = size;
+		}
+		
+		// Each block combines two blocks of the level below
+		const double *sourceMinimum = (current == 1) ? this->samples : this->minimumLevels[current - 2];
+		const double *sourceMaximum = (current == 1) ? this->samples : this->maximumLevels[current - 2];
+		unsigned int sourceCount = this->blockCount(current - 1);
+		double *minimum = this->minimumLevels[current - 1];
+		double *maximum = this->maximumLevels[current - 1];
+		
+		unsigned int pairs = sourceCount / 2;
+		for(unsigned int block = 0; block < pairs; block++) {
+			minimum[block] = qMin(sourceMinimum[2 * block], sourceMinimum[2 * block + 1]);
+			maximum[block] = qMax(sourceMaximum[2 * block], sourceMaximum[2 * block + 1]);
+		}
+		if(sourceCount % 2) {
+			minimum[pairs] = sourceMinimum[sourceCount - 1];
+			maximum[pairs] = sourceMaximum[sourceCount - 1];
+		}
+		
+		this->validLevels = current;
+	}
+}
@@ -0,0 +1,65 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  OpenHantek
+/// \file minmaxpyramid.h
+/// \brief Declares the MinMaxPyramid class.
+//
+//  This program is free software: you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation, either version 3 of the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef MINMAXPYRAMID_H
+#define MINMAXPYRAMID_H
+
+
+#include <QList>
+
+
+#define MINMAXPYRAMID_LEVELS         24 ///< Highest level, blocks of 2^24 samples
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// \class MinMaxPyramid                                         minmaxpyramid.h
+/// \brief Minimum and maximum of the samples at multiple resolutions.
+/// Level n holds the extremes of blocks of 2^n samples, level 0 are the samples
+/// themselves. The levels are only built when they are requested, each one
+/// from the previous level, so a frame costs at most one pass over the samples
+/// no matter how many resolutions are drawn. Single sample glitches survive
+/// every level.
+class MinMaxPyramid {
+	public:
+		MinMaxPyramid();
+		~MinMaxPyramid();
+		
+		void setSamples(const double *samples, unsigned int count);
+		
+		static unsigned int levelForDensity(double samplesPerPixel);
+		unsigned int blockCount(unsigned int level) const;
+		const double *minimum(unsigned int level);
+		const double *maximum(unsigned int level);
+	
+	protected:
+		void build(unsigned int level);
+		
+		const double *samples; ///< The samples at level 0
+		unsigned int count; ///< The number of samples
+		QList<double *> minimumLevels; ///< The minimums, the index is the level - 1
+		QList<double *> maximumLevels; ///< The maximums, the index is the level - 1
+		QList<unsigned int> levelSizes; ///< The allocated sizes of the levels
+		unsigned int validLevels; ///< The number of levels built for these samples
+};
+
+
+#endif
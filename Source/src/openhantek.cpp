@@ -25,23 +25,31 @@
 #include <QAction>
 #include <QActionGroup>
 #include <QApplication>
+#include <QDateTime>
 #include <QDir>
 #include <QFileDialog>
+#include <QFileInfo>
+#include <QLabel>
 #include <QMainWindow>
 #include <QMenu>
 #include <QMenuBar>
 #include <QMessageBox>
+#include <QSlider>
 #include <QToolBar>
 #include <QStatusBar>
 
 
 #include "openhantek.h"
 
+#include "capturefile.h"
+#include "captureplayer.h"
 #include "configdialog.h"
 #include "dataanalyzer.h"
 #include "dockwindows.h"
 #include "dsocontrol.h"
 #include "dsowidget.h"
+#include "framehistory.h"
+#include "protocoldecoder.h"
 #include "settings.h"
 #include "hantek/hantek_control.h"
 #include "buudai/buudai_control.h"
@@ -85,6 +93,14 @@ OpenHantekMainWindow::OpenHantekMainWindow(QWidget *parent, Qt::WindowFlags flag
 	// The data analyzer
 	this->dataAnalyzer = new DataAnalyzer(this->settings);
 	
+	// Recording and playback of the acquired frames
+	this->captureWriter = new CaptureWriter(this);
+	this->capturePlayer = new CapturePlayer(this);
+	
+	// The last frames to scroll back through while stopped, the slider is created with the toolbars
+	this->frameHistory = new FrameHistory(this);
+	this->historySlider = 0;
+	
 	// Central oscilloscope widget
 	this->dsoWidget = new DsoWidget(this->settings, this->dataAnalyzer);
 	this->setCentralWidget(this->dsoWidget);
@@ -106,7 +122,19 @@ OpenHantekMainWindow::OpenHantekMainWindow(QWidget *parent, Qt::WindowFlags flag
 	connect(this, SIGNAL(settingsChanged()), this, SLOT(applySettings()));
 	//connect(this->dsoWidget, SIGNAL(stopped()), this, SLOT(stopped()));
 	connect(this->dsoControl, SIGNAL(statusMessage(QString, int)), this->statusBar(), SLOT(showMessage(QString, int)));
+	connect(this->dsoWidget, SIGNAL(statusMessage(QString, int)), this->statusBar(), SLOT(showMessage(QString, int)));
 	connect(this->dsoControl, SIGNAL(samplesAvailable(const QList<double *> *, const QList<unsigned int> *, double, QMutex *)), this->dataAnalyzer, SLOT(analyze(const QList<double *> *, const QList<unsigned int> *, double, QMutex *)));
+	connect(this->capturePlayer, SIGNAL(samplesAvailable(const QList<double *> *, const QList<unsigned int> *, double, QMutex *)), this->dataAnalyzer, SLOT(analyze(const QList<double *> *, const QList<unsigned int> *, double, QMutex *)));
+	connect(this->capturePlayer, SIGNAL(frameChanged(int, qint64)), this, SLOT(recordingFrameChanged(int, qint64)));
+	connect(this->capturePlayer, SIGNAL(finished()), this, SLOT(recordingFinished()));
+	connect(this->captureWriter, SIGNAL(statisticsChanged(double, double, unsigned int)), this, SLOT(recorderStatisticsChanged(double, double, unsigned int)));
+	connect(this->captureWriter, SIGNAL(fileWritten(QString, double)), this, SLOT(recorderFileWritten(QString, double)));
+	connect(this->captureWriter, SIGNAL(recordingFailed(QString)), this, SLOT(recorderFailed(QString)));
+	// The acquisition thread keeps the frames, a busy gui doesn't lose them
+	connect(this->dsoControl, SIGNAL(samplesAvailable(const QList<double *> *, const QList<unsigned int> *, double, QMutex *)), this->frameHistory, SLOT(addFrame(const QList<double *> *, const QList<unsigned int> *, double, QMutex *)), Qt::DirectConnection);
+	connect(this->frameHistory, SIGNAL(samplesAvailable(const QList<double *> *, const QList<unsigned int> *, double, QMutex *)), this->dataAnalyzer, SLOT(analyze(const QList<double *> *, const QList<unsigned int> *, double, QMutex *)));
+	connect(this->frameHistory, SIGNAL(frameChanged(int, qint64)), this, SLOT(historyFrameChanged(int, qint64)));
+	connect(this->historySlider, SIGNAL(valueChanged(int)), this->frameHistory, SLOT(showFrame(int)));
 	
 	// Connect signals to DSO controller and widget
 	//connect(this->horizontalDock, SIGNAL(formatChanged(HorizontalFormat)), this->dsoWidget, SLOT(horizontalFormatChanged(HorizontalFormat)));
@@ -128,7 +156,8 @@ OpenHantekMainWindow::OpenHantekMainWindow(QWidget *parent, Qt::WindowFlags flag
 	connect(this->voltageDock, SIGNAL(usedChanged(unsigned int, bool)), this->dsoWidget, SLOT(updateVoltageUsed(unsigned int, bool)));
 	connect(this->voltageDock, SIGNAL(couplingChanged(unsigned int, Dso::Coupling)), this->dsoControl, SLOT(setCoupling(unsigned int, Dso::Coupling)));
 	connect(this->voltageDock, SIGNAL(couplingChanged(unsigned int, Dso::Coupling)), this->dsoWidget, SLOT(updateVoltageCoupling(unsigned int)));
-	connect(this->voltageDock, SIGNAL(modeChanged(Dso::MathMode)), this->dsoWidget, SLOT(updateMathMode()));
+	connect(this->voltageDock, SIGNAL(modeChanged(unsigned int, Dso::MathMode)), this->dsoWidget, SLOT(updateMathMode(unsigned int)));
+	connect(this->voltageDock, SIGNAL(expressionChanged(unsigned int, const QString &)), this->dsoWidget, SLOT(updateMathMode(unsigned int)));
 	connect(this->voltageDock, SIGNAL(gainChanged(unsigned int, double)), this, SLOT(updateVoltageGain(unsigned int)));
 	connect(this->voltageDock, SIGNAL(gainChanged(unsigned int, double)), this->dsoWidget, SLOT(updateVoltageGain(unsigned int)));
 	connect(this->dsoWidget, SIGNAL(offsetChanged(unsigned int, double)), this, SLOT(updateOffset(unsigned int)));
@@ -136,10 +165,12 @@ OpenHantekMainWindow::OpenHantekMainWindow(QWidget *parent, Qt::WindowFlags flag
 	connect(this->spectrumDock, SIGNAL(usedChanged(unsigned int, bool)), this, SLOT(updateUsed(unsigned int)));
 	connect(this->spectrumDock, SIGNAL(usedChanged(unsigned int, bool)), this->dsoWidget, SLOT(updateSpectrumUsed(unsigned int, bool)));
 	connect(this->spectrumDock, SIGNAL(magnitudeChanged(unsigned int, double)), this->dsoWidget, SLOT(updateSpectrumMagnitude(unsigned int)));
+	connect(this, SIGNAL(settingsChanged()), this->dsoWidget, SLOT(updateMeasurements()));
 	
 	// Started/stopped signals from oscilloscope	
 	connect(this->dsoControl, SIGNAL(samplingStarted()), this, SLOT(started()));
 	connect(this->dsoControl, SIGNAL(samplingStopped()), this, SLOT(stopped()));
+	connect(this->dataAnalyzer, SIGNAL(maskFailed(unsigned int)), this, SLOT(maskFailed(unsigned int)));
 	
 	// Set up the oscilloscope
 	this->dsoControl->connectDevice();
@@ -171,6 +202,9 @@ void OpenHantekMainWindow::closeEvent(QCloseEvent *event) {
 	if(this->settings->options.alwaysSave)
 		this->writeSettings();
 	
+	// Write the index of a running recording
+	this->recordAction->setChecked(false);
+	
 	QMainWindow::closeEvent(event);
 }
 
@@ -200,6 +234,20 @@ void OpenHantekMainWindow::createActions() {
 	this->exportAsAction->setStatusTip(tr("Export the oscilloscope data to a file"));
 	connect(this->exportAsAction, SIGNAL(triggered()), this->dsoWidget, SLOT(exportAs()));
 
+	this->decodeCsvAction = new QAction(tr("&Decode CSV..."), this);
+	this->decodeCsvAction->setStatusTip(tr("Decode the serial protocol in exported CSV data"));
+	connect(this->decodeCsvAction, SIGNAL(triggered()), this, SLOT(decodeCsv()));
+
+	this->recordAction = new QAction(tr("&Record..."), this);
+	this->recordAction->setCheckable(true);
+	this->recordAction->setStatusTip(tr("Record the acquired frames into a capture file"));
+	connect(this->recordAction, SIGNAL(toggled(bool)), this, SLOT(record(bool)));
+
+	this->playRecordingAction = new QAction(tr("P&lay recording..."), this);
+	this->playRecordingAction->setCheckable(true);
+	this->playRecordingAction->setStatusTip(tr("Show the frames of a capture file instead of the oscilloscope"));
+	connect(this->playRecordingAction, SIGNAL(toggled(bool)), this, SLOT(playRecording(bool)));
+
 	this->exitAction = new QAction(tr("E&xit"), this);
 	this->exitAction->setShortcut(tr("Ctrl+Q"));
 	this->exitAction->setStatusTip(tr("Exit the application"));
@@ -214,6 +262,14 @@ void OpenHantekMainWindow::createActions() {
 	this->startStopAction->setShortcut(tr("Space"));
 	this->stopped();
 	
+	this->createMaskAction = new QAction(tr("Create &mask"), this);
+	this->createMaskAction->setStatusTip(tr("Create the mask for the mask test around the current waveform"));
+	connect(this->createMaskAction, SIGNAL(triggered()), this, SLOT(createMask()));
+	
+	this->resetMaskAction = new QAction(tr("&Reset mask counters"), this);
+	this->resetMaskAction->setStatusTip(tr("Set the passed and failed frame counters of the mask test to zero"));
+	connect(this->resetMaskAction, SIGNAL(triggered()), this->dsoWidget, SLOT(resetMaskTest()));
+	
     this->bufferSizeActionGroup = new QActionGroup(this);
     connect(this->bufferSizeActionGroup, SIGNAL(triggered(QAction *)), this, SLOT(bufferSizeTriggered(QAction *)));
 
@@ -243,6 +299,13 @@ void OpenHantekMainWindow::createActions() {
 	connect(this->zoomAction, SIGNAL(toggled(bool)), this, SLOT(zoom(bool)));
 	connect(this->zoomAction, SIGNAL(toggled(bool)), this->dsoWidget, SLOT(updateZoom(bool)));
 	
+	this->spectrogramAction = new QAction(tr("&Spectrogram"), this);
+	this->spectrogramAction->setCheckable(true);
+	this->spectrogramAction->setChecked(this->settings->view.spectrogram);
+	this->spectrogram(this->settings->view.spectrogram);
+	connect(this->spectrogramAction, SIGNAL(toggled(bool)), this, SLOT(spectrogram(bool)));
+	connect(this->spectrogramAction, SIGNAL(toggled(bool)), this->dsoWidget, SLOT(updateSpectrogram(bool)));
+	
 	this->aboutAction = new QAction(tr("&About"), this);
 	this->aboutAction->setStatusTip(tr("Show information about this program"));
 	connect(this->aboutAction, SIGNAL(triggered()), this, SLOT(about()));
@@ -266,12 +329,17 @@ void OpenHantekMainWindow::createMenus() {
 	this->fileMenu->addSeparator();
 	this->fileMenu->addAction(this->printAction);
 	this->fileMenu->addAction(this->exportAsAction);
+	this->fileMenu->addAction(this->decodeCsvAction);
+	this->fileMenu->addSeparator();
+	this->fileMenu->addAction(this->recordAction);
+	this->fileMenu->addAction(this->playRecordingAction);
 	this->fileMenu->addSeparator();
 	this->fileMenu->addAction(this->exitAction);
 	
 	this->viewMenu = this->menuBar()->addMenu(tr("&View"));
 	this->viewMenu->addAction(this->digitalPhosphorAction);
 	this->viewMenu->addAction(this->zoomAction);
+	this->viewMenu->addAction(this->spectrogramAction);
 	this->viewMenu->addSeparator();
 	this->dockMenu = this->viewMenu->addMenu(tr("&Docking windows"));
 	this->dockMenu->addAction(this->horizontalDock->toggleViewAction());
@@ -287,6 +355,9 @@ void OpenHantekMainWindow::createMenus() {
 	this->oscilloscopeMenu->addAction(this->configAction);
 	this->oscilloscopeMenu->addSeparator();
 	this->oscilloscopeMenu->addAction(this->startStopAction);
+	this->oscilloscopeMenu->addSeparator();
+	this->oscilloscopeMenu->addAction(this->createMaskAction);
+	this->oscilloscopeMenu->addAction(this->resetMaskAction);
 #ifdef DEBUG
 	this->oscilloscopeMenu->addAction(this->commandAction);
 #endif
@@ -317,6 +388,11 @@ void OpenHantekMainWindow::createToolBars() {
 	
 	this->oscilloscopeToolBar = new QToolBar(tr("Oscilloscope"));
 	this->oscilloscopeToolBar->addAction(this->startStopAction);
+	this->historySlider = new QSlider(Qt::Horizontal);
+	this->historySlider->setMaximumWidth(200);
+	this->historySlider->setEnabled(false);
+	this->historySlider->setStatusTip(tr("Scroll back through the previous frames while stopped"));
+	this->oscilloscopeToolBar->addWidget(this->historySlider);
 	
 	this->viewToolBar = new QToolBar(tr("View"));
 	this->viewToolBar->addAction(this->digitalPhosphorAction);
@@ -325,6 +401,12 @@ void OpenHantekMainWindow::createToolBars() {
 
 /// \brief Create the status bar.
 void OpenHantekMainWindow::createStatusBar() {
+	// Write rate of a running recording
+	this->recorderLabel = new QLabel();
+	this->recorderLabel->hide();
+	
+	this->statusBar()->addPermanentWidget(this->recorderLabel);
+	
 #ifdef DEBUG
 	// Command field inside the status bar
 	this->commandEdit = new QLineEdit();
@@ -423,6 +505,161 @@ int OpenHantekMainWindow::saveAs() {
 	return status;
 }
 
+/// \brief Decode the serial protocol in a file written by the CSV export.
+/// \return 0 on success, 1 on user abort, negative on error.
+int OpenHantekMainWindow::decodeCsv() {
+	if(this->settings->scope.decoder.protocol == Dso::PROTOCOL_OFF) {
+		QMessageBox::information(this, tr("Decode CSV"), tr("Select the protocol in the analysis settings first."));
+		return 1;
+	}
+	
+	QString inputName = QFileDialog::getOpenFileName(this, tr("Decode CSV"), "", tr("Comma-Separated Values (*.csv)"));
+	if(inputName.isEmpty())
+		return 1;
+	QString outputName = QFileDialog::getSaveFileName(this, tr("Save decoded words"), "", tr("Comma-Separated Values (*.csv)"));
+	if(outputName.isEmpty())
+		return 1;
+	
+	int decoded = ProtocolDecoder::decodeCsv(inputName, outputName, this->settings->scope);
+	switch(decoded) {
+		case -1:
+			QMessageBox::warning(this, tr("Decode CSV"), tr("Couldn't read %1.").arg(inputName));
+			break;
+		case -2:
+			QMessageBox::warning(this, tr("Decode CSV"), tr("The file doesn't contain the decoded channels."));
+			break;
+		case -3:
+			QMessageBox::warning(this, tr("Decode CSV"), tr("Couldn't write %1.").arg(outputName));
+			break;
+		default:
+			this->statusBar()->showMessage(tr("%1 words decoded").arg(decoded));
+			return 0;
+	}
+	
+	return decoded;
+}
+
+/// \brief Starts or stops recording the acquired frames.
+/// \param enabled true asks for the file and starts the recording.
+void OpenHantekMainWindow::record(bool enabled) {
+	if(enabled) {
+		// Already started by startRecording()
+		if(this->captureWriter->isOpen())
+			return;
+		
+		QString fileName = QFileDialog::getSaveFileName(this, tr("Record"), "", tr("OpenHantek capture (*.ohc)"));
+		if(fileName.isEmpty() || !this->startRecording(fileName)) {
+			if(!fileName.isEmpty())
+				QMessageBox::warning(this, tr("Record"), tr("Couldn't create %1.").arg(fileName));
+			this->recordAction->setChecked(false);
+			return;
+		}
+	}
+	else if(this->captureWriter->isOpen()) {
+		disconnect(this->dsoControl, SIGNAL(samplesAvailable(const QList<double *> *, const QList<unsigned int> *, double, QMutex *)), this->captureWriter, SLOT(addFrame(const QList<double *> *, const QList<unsigned int> *, double, QMutex *)));
+		
+		bool complete = this->captureWriter->close();
+		this->recorderLabel->hide();
+		if(complete)
+			this->statusBar()->showMessage(tr("%L1 frames recorded, %L2 dropped, compressed %3:1").arg(this->captureWriter->frameCount()).arg(this->captureWriter->droppedFrames()).arg(this->captureWriter->compressionRatio(), 0, 'f', 1), 3000);
+		else
+			this->statusBar()->showMessage(tr("The recording is incomplete"), 3000);
+	}
+}
+
+/// \brief Starts recording the acquired frames without asking for the file.
+/// \param fileName The name of the capture file.
+/// \return true if the recording has been started.
+bool OpenHantekMainWindow::startRecording(const QString &fileName) {
+	if(this->captureWriter->isOpen())
+		return false;
+	
+	this->captureWriter->setLimits((qint64) this->settings->options.recorder.fileSize << 20, (qint64) this->settings->options.recorder.fileDuration * 60000, (qint64) this->settings->options.recorder.backlog << 20);
+	if(!this->captureWriter->open(fileName, this->settings, this->dsoControl->getChannelCount()))
+		return false;
+	
+	// The frames are queued in the acquisition thread, a busy gui doesn't delay them
+	connect(this->dsoControl, SIGNAL(samplesAvailable(const QList<double *> *, const QList<unsigned int> *, double, QMutex *)), this->captureWriter, SLOT(addFrame(const QList<double *> *, const QList<unsigned int> *, double, QMutex *)), Qt::DirectConnection);
+	this->recordAction->setChecked(true);
+	this->recorderLabel->setText(tr("Recording"));
+	this->recorderLabel->show();
+	this->statusBar()->showMessage(tr("Recording to %1").arg(fileName), 3000);
+	
+	return true;
+}
+
+/// \brief Shows the sustained write rate of the recording.
+/// \param writeRate The written bytes per second.
+/// \param backlog The bytes waiting for the writer.
+/// \param droppedFrames The number of frames dropped since the start.
+void OpenHantekMainWindow::recorderStatisticsChanged(double writeRate, double backlog, unsigned int droppedFrames) {
+	if(!this->captureWriter->isOpen())
+		return;
+	
+	this->recorderLabel->setText(tr("REC %1 MiB/s, backlog %2 MiB, %L3 dropped").arg(writeRate / 1048576, 0, 'f', 1).arg(backlog / 1048576, 0, 'f', 1).arg(droppedFrames));
+}
+
+/// \brief Reports a complete file of the recording.
+/// \param fileName The name of the capture file.
+/// \param compressionRatio The uncompressed size of the frames divided by the stored size.
+void OpenHantekMainWindow::recorderFileWritten(const QString &fileName, double compressionRatio) {
+	this->statusBar()->showMessage(tr("%1 written, compressed %2:1").arg(QFileInfo(fileName).fileName()).arg(compressionRatio, 0, 'f', 1), 3000);
+}
+
+/// \brief Stops the recording after a capture file couldn't be written.
+/// \param fileName The name of the capture file.
+void OpenHantekMainWindow::recorderFailed(const QString &fileName) {
+	disconnect(this->dsoControl, SIGNAL(samplesAvailable(const QList<double *> *, const QList<unsigned int> *, double, QMutex *)), this->captureWriter, SLOT(addFrame(const QList<double *> *, const QList<unsigned int> *, double, QMutex *)));
+	this->captureWriter->close();
+	this->recorderLabel->hide();
+	this->recordAction->setChecked(false);
+	
+	QMessageBox::warning(this, tr("Record"), tr("Couldn't write %1, the recording has been stopped after %L2 frames.").arg(fileName).arg(this->captureWriter->frameCount()));
+}
+
+/// \brief Starts or pauses the playback of a capture file.
+/// \param enabled true asks for the file and starts the playback.
+void OpenHantekMainWindow::playRecording(bool enabled) {
+	if(enabled) {
+		QString fileName = QFileDialog::getOpenFileName(this, tr("Play recording"), "", tr("OpenHantek capture (*.ohc)"));
+		if(fileName.isEmpty()) {
+			this->playRecordingAction->setChecked(false);
+			return;
+		}
+		if(!this->capturePlayer->open(fileName)) {
+			QMessageBox::warning(this, tr("Play recording"), tr("%1 is no valid capture file.").arg(fileName));
+			this->playRecordingAction->setChecked(false);
+			return;
+		}
+		
+		// The frames of the oscilloscope would be mixed into the recording
+		this->dsoControl->stopSampling();
+		this->capturePlayer->play();
+		this->statusBar()->showMessage(tr("%1 opened, compressed %2:1").arg(QFileInfo(fileName).fileName()).arg(this->capturePlayer->reader()->compressionRatio(), 0, 'f', 1), 3000);
+	}
+	else
+		this->capturePlayer->pause();
+}
+
+/// \brief Shows the position of the playback.
+/// \param frame The index of the shown frame.
+/// \param time The time the frame was acquired.
+void OpenHantekMainWindow::recordingFrameChanged(int frame, qint64 time) {
+	this->statusBar()->showMessage(tr("Frame %L1 of %L2, %3").arg(frame + 1).arg(this->capturePlayer->reader()->frameCount()).arg(QDateTime::fromMSecsSinceEpoch(time).toString(Qt::ISODate)));
+}
+
+/// \brief The last frame of the capture file has been shown.
+void OpenHantekMainWindow::recordingFinished() {
+	this->playRecordingAction->setChecked(false);
+}
+
+/// \brief Shows which kept frame is shown.
+/// \param frame The index of the frame.
+/// \param time The time the frame was acquired.
+void OpenHantekMainWindow::historyFrameChanged(int frame, qint64 time) {
+	this->statusBar()->showMessage(tr("Frame %L1 of %L2, %3").arg(frame + 1).arg(this->frameHistory->frameCount()).arg(QDateTime::fromMSecsSinceEpoch(time).toString("hh:mm:ss.zzz")));
+}
+
 /// \brief The oscilloscope started sampling.
 void OpenHantekMainWindow::started() {
 	this->startStopAction->setText(tr("&Stop"));
@@ -431,6 +668,10 @@ void OpenHantekMainWindow::started() {
 	
 	disconnect(this->startStopAction, SIGNAL(triggered()), this->dsoControl, SLOT(startSampling()));
 	connect(this->startStopAction, SIGNAL(triggered()), this->dsoControl, SLOT(stopSampling()));
+	
+	this->frameHistory->setPaused(false);
+	if(this->historySlider)
+		this->historySlider->setEnabled(false);
 }
 
 /// \brief The oscilloscope stopped sampling.
@@ -441,6 +682,35 @@ void OpenHantekMainWindow::stopped() {
 	
 	disconnect(this->startStopAction, SIGNAL(triggered()), this->dsoControl, SLOT(stopSampling()));
 	connect(this->startStopAction, SIGNAL(triggered()), this->dsoControl, SLOT(startSampling()));
+	
+	// The kept frames stay as they are while the user scrolls through them
+	this->frameHistory->setPaused(true);
+	if(!this->historySlider)
+		return;
+	int frames = this->frameHistory->frameCount();
+	this->historySlider->blockSignals(true);
+	this->historySlider->setRange(0, qMax(frames - 1, 0));
+	this->historySlider->setValue(frames - 1);
+	this->historySlider->blockSignals(false);
+	this->historySlider->setEnabled(frames > 1);
+}
+
+/// \brief Create the mask around the current waveform.
+void OpenHantekMainWindow::createMask() {
+	if(this->dsoWidget->createMask())
+		this->statusBar()->showMessage(tr("Mask created for %1").arg(this->settings->scope.voltage[this->settings->scope.mask.channel].name), 3000);
+	else
+		this->statusBar()->showMessage(tr("No waveform for the mask available"), 3000);
+}
+
+/// \brief A frame failed the mask test, stop the sampling if wanted.
+/// \param violations The number of samples outside of the mask.
+void OpenHantekMainWindow::maskFailed(unsigned int violations) {
+	if(!this->settings->scope.mask.stopOnFailure)
+		return;
+	
+	this->dsoControl->stopSampling();
+	this->statusBar()->showMessage(tr("Mask test failed with %L1 violations").arg(violations));
 }
 
 /// \brief Configure the oscilloscope.
@@ -462,6 +732,16 @@ void OpenHantekMainWindow::digitalPhosphor(bool enabled) {
 		this->digitalPhosphorAction->setStatusTip(tr("Enable fading of previous graphs"));
 }
 
+/// \brief Show/hide the spectrogram waterfall.
+void OpenHantekMainWindow::spectrogram(bool enabled) {
+	this->settings->view.spectrogram = enabled;
+	
+	if(this->settings->view.spectrogram)
+		this->spectrogramAction->setStatusTip(tr("Hide spectrogram waterfall"));
+	else
+		this->spectrogramAction->setStatusTip(tr("Show spectrogram waterfall"));
+}
+
 /// \brief Show/hide the magnified scope.
 void OpenHantekMainWindow::zoom(bool enabled) {
 	this->settings->view.zoom = enabled;
@@ -572,6 +852,9 @@ void OpenHantekMainWindow::applySettings() {
 	// Put the docked toolbars into the main window
 	for(int position = 0; position < dockedToolbars.size(); position++)
 		this->addToolBar(toolbars[dockedToolbars[position]]);
+	
+	// Frame history
+	this->frameHistory->setLimits(this->settings->options.history.frames, (qint64) this->settings->options.history.memory << 20);
 }
 
 /// \brief Update the window layout in the settings.
@@ -651,13 +934,15 @@ void OpenHantekMainWindow::updateUsed(unsigned int channel) {
 	if(channel >= (unsigned int) this->settings->scope.voltage.count())
 		return;
 	
-	bool mathUsed = this->settings->scope.voltage[this->settings->scope.physicalChannels].used | this->settings->scope.spectrum[this->settings->scope.physicalChannels].used;
+	bool mathUsed = false;
+	for(int mathChannel = this->settings->scope.physicalChannels; mathChannel < this->settings->scope.voltage.count(); mathChannel++)
+		mathUsed |= this->settings->scope.voltage[mathChannel].used | this->settings->scope.spectrum[mathChannel].used;
 	
-	// Normal channel, check if voltage/spectrum or math channel is used
+	// Normal channel, check if voltage/spectrum or a math channel is used
 	if(channel < this->settings->scope.physicalChannels)
 		this->dsoControl->setChannelUsed(channel, mathUsed | this->settings->scope.voltage[channel].used | this->settings->scope.spectrum[channel].used);
 	// Math channel, update all channels
-	else if(channel == this->settings->scope.physicalChannels) {
+	else {
 		for(unsigned int channelCounter = 0; channelCounter < this->settings->scope.physicalChannels; channelCounter++)
 			this->dsoControl->setChannelUsed(channelCounter, mathUsed | this->settings->scope.voltage[channelCounter].used | this->settings->scope.spectrum[channelCounter].used);
 	}
@@ -31,12 +31,17 @@
 
 
 class QActionGroup;
+class QLabel;
 class QLineEdit;
+class QSlider;
 
+class CapturePlayer;
+class CaptureWriter;
 class DataAnalyzer;
 class DsoControl;
 class DsoSettings;
 class DsoWidget;
+class FrameHistory;
 class HorizontalDock;
 class TriggerDock;
 class SpectrumDock;
@@ -54,6 +59,8 @@ class OpenHantekMainWindow : public QMainWindow {
 	public:
 		OpenHantekMainWindow(QWidget *parent = 0, Qt::WindowFlags flags = 0);
 		~OpenHantekMainWindow();
+		
+		bool startRecording(const QString &fileName);
 
 	protected:
 		void closeEvent(QCloseEvent *event);
@@ -76,14 +83,16 @@ class OpenHantekMainWindow : public QMainWindow {
 
 		// Actions
 		QAction *newAction, *openAction, *saveAction, *saveAsAction;
-		QAction *printAction, *exportAsAction;
+		QAction *printAction, *exportAsAction, *decodeCsvAction;
+		QAction *recordAction, *playRecordingAction;
 		QAction *exitAction;
 		
 		QAction *configAction;
 		QAction *startStopAction;
+		QAction *createMaskAction, *resetMaskAction;
 		QActionGroup *bufferSizeActionGroup;
 		QAction *bufferSizeSmallAction, *bufferSizeLargeAction;
-		QAction *digitalPhosphorAction, *zoomAction;
+		QAction *digitalPhosphorAction, *spectrogramAction, *zoomAction;
 		
 		QAction *aboutAction, *aboutQtAction;
 		
@@ -110,6 +119,8 @@ class OpenHantekMainWindow : public QMainWindow {
 		DsoWidget *dsoWidget;
 		
 		// Other widgets
+		QLabel *recorderLabel;
+		QSlider *historySlider;
 #ifdef DEBUG
 		QLineEdit *commandEdit;
 #endif
@@ -117,6 +128,9 @@ class OpenHantekMainWindow : public QMainWindow {
 		// Data handling classes
 		DataAnalyzer *dataAnalyzer;
 		DsoControl *dsoControl;
+		CaptureWriter *captureWriter;
+		CapturePlayer *capturePlayer;
+		FrameHistory *frameHistory;
 		
 		// Other variables
 		QString currentFile;
@@ -129,12 +143,24 @@ class OpenHantekMainWindow : public QMainWindow {
 		int open();
 		int save();
 		int saveAs();
+		int decodeCsv();
+		void record(bool enabled);
+		void playRecording(bool enabled);
+		void recordingFrameChanged(int frame, qint64 time);
+		void recordingFinished();
+		void recorderStatisticsChanged(double writeRate, double backlog, unsigned int droppedFrames);
+		void recorderFileWritten(const QString &fileName, double compressionRatio);
+		void recorderFailed(const QString &fileName);
 		// View
 		void digitalPhosphor(bool enabled);
+		void spectrogram(bool enabled);
 		void zoom(bool enabled);
 		// Oscilloscope control
 		void started();
 		void stopped();
+		void createMask();
+		void maskFailed(unsigned int violations);
+		void historyFrameChanged(int frame, qint64 time);
 		// Other
 		void config();
 		void about();
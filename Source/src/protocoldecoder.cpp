@@ -0,0 +1,516 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  OpenHantek
+//  protocoldecoder.cpp
+//
+//  This program is free software: you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation, either version 3 of the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <QFile>
+#include <QStringList>
+#include <QTextStream>
+
+
+#include "protocoldecoder.h"
+
+
+/// \brief Returns the index of the lowest set bit.
+/// \param word A word with at least one bit set.
+/// \return The number of trailing zero bits.
+static inline unsigned int lowestBit(quint64 word) {
+#ifdef __GNUC__
+	return __builtin_ctzll(word);
+#else
+	unsigned int bit = 0;
+	while(!(word & 1)) {
+		word >>= 1;
+		bit++;
+	}
+	return bit;
+#endif
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// class LogicBits
+/// \brief Initializes an empty bit stream.
+LogicBits::LogicBits() {
+	this->size = 0;
+	this->lastLevel = false;
+}
+
+/// \brief Converts the samples into levels and edges.
+/// \param samples The voltages.
+/// \param count The number of samples.
+/// \param level Samples above this voltage are high.
+/// \param continued true if the samples follow the ones of the previous call, an edge at the first sample is detected then.
+void LogicBits::threshold(const double *samples, unsigned int count, double level, bool continued) {
+	unsigned int words = (count + 63) / 64;
+	this->levels.resize(words);
+	this->edges.resize(words);
+	this->size = count;
+	if(!count)
+		return;
+	
+	// Pack 64 comparisons into each word
+	for(unsigned int word = 0; word < words; word++) {
+		const double *block = samples + word * 64;
+		unsigned int length = qMin(64u, count - word * 64);
+		quint64 bits = 0;
+		for(unsigned int bit = 0; bit < length; bit++)
+			bits |= (quint64) (block[bit] > level) << bit;
+		this->levels[word] = bits;
+	}
+	
+	// The edges are the differences to the levels shifted by one sample
+	quint64 carry = (continued ? this->lastLevel : (samples[0] > level)) ? 1 : 0;
+	for(unsigned int word = 0; word < words; word++) {
+		quint64 bits = this->levels[word];
+		this->edges[word] = bits ^ ((bits << 1) | carry);
+		carry = bits >> 63;
+	}
+	if(count % 64)
+		this->edges[words - 1] &= ((quint64) 1 << (count % 64)) - 1;
+	
+	this->lastLevel = this->level(count - 1);
+}
+
+/// \brief Get the number of samples.
+/// \return The number of samples.
+unsigned int LogicBits::count() const {
+	return this->size;
+}
+
+/// \brief Get the level of a sample.
+/// \param position The index of the sample.
+/// \return true if the sample is above the threshold.
+bool LogicBits::level(unsigned int position) const {
+	return (this->levels[position >> 6] >> (position & 63)) & 1;
+}
+
+/// \brief Searches the next edge.
+/// \param position The first sample that is checked.
+/// \return The index of the first sample with a new level, count() if there is none.
+unsigned int LogicBits::nextEdge(unsigned int position) const {
+	if(position >= this->size)
+		return this->size;
+	
+	unsigned int word = position >> 6;
+	quint64 bits = this->edges[word] & (~(quint64) 0 << (position & 63));
+	while(!bits) {
+		if(++word >= (unsigned int) this->edges.count())
+			return this->size;
+		bits = this->edges[word];
+	}
+	
+	return (word << 6) + lowestBit(bits);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// class ProtocolDecoder
+/// \brief Stores the settings.
+/// \param settings The protocol options.
+/// \param samplerate The samplerate of the data in S/s.
+ProtocolDecoder::ProtocolDecoder(const DsoSettingsScopeDecoder &settings, double samplerate) {
+	this->settings = settings;
+	this->samplerate = samplerate;
+	this->position = 0;
+}
+
+/// \brief Cleans up.
+ProtocolDecoder::~ProtocolDecoder() {
+}
+
+/// \brief Creates the decoder for the configured protocol.
+/// \param settings The protocol options.
+/// \param samplerate The samplerate of the data in S/s.
+/// \return The new decoder, 0 if the decoder is turned off.
+ProtocolDecoder *ProtocolDecoder::create(const DsoSettingsScopeDecoder &settings, double samplerate) {
+	switch(settings.protocol) {
+		case Dso::PROTOCOL_UART:
+			return new UartDecoder(settings, samplerate);
+		case Dso::PROTOCOL_SPI:
+			return new SpiDecoder(settings, samplerate);
+		case Dso::PROTOCOL_I2C:
+			return new I2cDecoder(settings, samplerate);
+		default:
+			return 0;
+	}
+}
+
+/// \brief Decodes the channels in a file written by the CSV export.
+/// \param inputName The exported CSV file.
+/// \param outputName The file the decoded words are written to.
+/// \param scope The scope settings with the decoder options and channel names.
+/// \return Number of decoded words, -1 if the input can't be read, -2 if a channel is missing, -3 if the output can't be written.
+int ProtocolDecoder::decodeCsv(const QString &inputName, const QString &outputName, const DsoSettingsScope &scope) {
+	if(scope.decoder.data >= (unsigned int) scope.voltage.count() || scope.decoder.clock >= (unsigned int) scope.voltage.count())
+		return -2;
+	
+	QFile inputFile(inputName);
+	if(!inputFile.open(QIODevice::ReadOnly | QIODevice::Text))
+		return -1;
+	
+	// Every line holds the quoted channel name, the sample interval and the samples
+	QVector<double> channelSamples[2];
+	double interval = 0;
+	QString channelNames[2] = {scope.voltage[scope.decoder.data].name, scope.voltage[scope.decoder.clock].name};
+	QTextStream inputStream(&inputFile);
+	while(!inputStream.atEnd()) {
+		QStringList values = inputStream.readLine().split(',');
+		if(values.count() < 3)
+			continue;
+		QString name = values[0].trimmed();
+		if(name.startsWith('"') && name.endsWith('"'))
+			name = name.mid(1, name.length() - 2);
+		
+		for(int index = 0; index < 2; index++) {
+			if(name != channelNames[index] || !channelSamples[index].isEmpty())
+				continue;
+			interval = values[1].toDouble();
+			channelSamples[index].resize(values.count() - 2);
+			for(int position = 2; position < values.count(); position++)
+				channelSamples[index][position - 2] = values[position].toDouble();
+		}
+	}
+	inputFile.close();
+	
+	bool needsClock = scope.decoder.protocol != Dso::PROTOCOL_UART;
+	if(channelSamples[0].isEmpty() || (needsClock && channelSamples[1].isEmpty()) || interval <= 0)
+		return -2;
+	
+	ProtocolDecoder *decoder = ProtocolDecoder::create(scope.decoder, 1.0 / interval);
+	if(!decoder)
+		return -2;
+	
+	// Decode in chunks, like a continuous acquisition
+	LogicBits data, clock;
+	unsigned int count = channelSamples[0].count();
+	if(needsClock)
+		count = qMin(count, (unsigned int) channelSamples[1].count());
+	for(unsigned int offset = 0; offset < count; offset += PROTOCOLDECODER_CHUNK) {
+		unsigned int length = qMin((unsigned int) PROTOCOLDECODER_CHUNK, count - offset);
+		data.threshold(channelSamples[0].constData() + offset, length, scope.decoder.threshold, offset > 0);
+		if(needsClock)
+			clock.threshold(channelSamples[1].constData() + offset, length, scope.decoder.threshold, offset > 0);
+		decoder->decode(data, clock);
+	}
+	
+	QFile outputFile(outputName);
+	if(!outputFile.open(QIODevice::WriteOnly | QIODevice::Text)) {
+		delete decoder;
+		return -3;
+	}
+	
+	QTextStream outputStream(&outputFile);
+	outputStream << "\"Start\",\"End\",\"Value\"\n";
+	const QList<ProtocolAnnotation> &annotations = decoder->annotations();
+	for(int index = 0; index < annotations.count(); index++)
+		outputStream << annotations[index].start * interval << "," << annotations[index].end * interval << ",\"" << annotations[index].text << "\"\n";
+	outputFile.close();
+	
+	int decoded = annotations.count();
+	delete decoder;
+	return decoded;
+}
+
+/// \brief Checks if the decoder can be used for these settings.
+/// \param settings The protocol options.
+/// \param samplerate The samplerate of the data in S/s.
+/// \return true if nothing has been changed.
+bool ProtocolDecoder::isConfiguredFor(const DsoSettingsScopeDecoder &settings, double samplerate) const {
+	return settings.protocol == this->settings.protocol && settings.baudrate == this->settings.baudrate && settings.bits == this->settings.bits && settings.msbFirst == this->settings.msbFirst && settings.parity == this->settings.parity && settings.spiMode == this->settings.spiMode && samplerate == this->samplerate;
+}
+
+/// \brief Get the decoded words.
+/// \return The annotations since the last reset.
+const QList<ProtocolAnnotation> &ProtocolDecoder::annotations() const {
+	return this->annotationList;
+}
+
+/// \brief Removes the annotations without changing the decoder state.
+void ProtocolDecoder::clearAnnotations() {
+	this->annotationList.clear();
+}
+
+/// \brief Starts a new stream.
+void ProtocolDecoder::reset() {
+	this->position = 0;
+	this->annotationList.clear();
+}
+
+/// \brief Adds a decoded word.
+/// \param start The first sample of the word.
+/// \param end The last sample of the word.
+/// \param text The decoded value.
+void ProtocolDecoder::annotate(unsigned long int start, unsigned long int end, const QString &text) {
+	ProtocolAnnotation annotation;
+	annotation.start = start;
+	annotation.end = end;
+	annotation.text = text;
+	this->annotationList.append(annotation);
+}
+
+/// \brief Formats a value as hexadecimal number.
+/// \param value The value.
+/// \param bits The number of valid bits.
+/// \return The value with the 0x prefix and leading zeros.
+QString ProtocolDecoder::hexString(unsigned int value, unsigned int bits) {
+	return "0x" + QString("%1").arg(value, (bits + 3) / 4, 16, QChar('0')).toUpper();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// class UartDecoder
+/// \brief Prepares the bit timing.
+/// \param settings The protocol options.
+/// \param samplerate The samplerate of the data in S/s.
+UartDecoder::UartDecoder(const DsoSettingsScopeDecoder &settings, double samplerate) : ProtocolDecoder(settings, samplerate) {
+	this->samplesPerBit = samplerate / qMax(settings.baudrate, 1u);
+	this->frameBits = 1 + settings.bits + ((settings.parity == Dso::PARITY_NONE) ? 0 : 1) + 1;
+	this->reset();
+}
+
+/// \brief Starts a new stream.
+void UartDecoder::reset() {
+	ProtocolDecoder::reset();
+	
+	this->receiving = false;
+	this->searchPosition = 0;
+}
+
+/// \brief Decodes the next samples.
+/// \param data The RX line.
+/// \param clock Unused.
+void UartDecoder::decode(const LogicBits &data, const LogicBits &clock) {
+	Q_UNUSED(clock);
+	
+	unsigned long int end = this->position + data.count();
+	
+	forever {
+		if(!this->receiving) {
+			// Wait for the falling edge of the start bit
+			unsigned int edge = data.nextEdge((this->searchPosition > this->position) ? this->searchPosition - this->position : 0);
+			while(edge < data.count() && data.level(edge))
+				edge = data.nextEdge(edge + 1);
+			if(edge >= data.count())
+				break;
+			
+			this->receiving = true;
+			this->frameStart = this->position + edge;
+			this->bitIndex = 0;
+			this->value = 0;
+			this->ones = 0;
+		}
+		
+		// Sample each bit in its middle
+		unsigned long int sample = 0;
+		while(this->bitIndex < this->frameBits) {
+			sample = (unsigned long int) (this->frameStart + (this->bitIndex + 0.5) * this->samplesPerBit);
+			if(sample >= end)
+				break;
+			bool bit = data.level(sample - this->position);
+			
+			if(this->bitIndex == 0) {
+				// A start bit that isn't low anymore was a glitch
+				if(bit) {
+					this->receiving = false;
+					this->searchPosition = sample;
+					break;
+				}
+			}
+			else if(this->bitIndex <= this->settings.bits) {
+				if(bit) {
+					this->value |= 1 << (this->bitIndex - 1);
+					this->ones++;
+				}
+			}
+			else if(this->bitIndex < this->frameBits - 1) {
+				if(bit)
+					this->ones++;
+			}
+			else
+				this->stopBit = bit;
+			this->bitIndex++;
+		}
+		if(!this->receiving)
+			continue;
+		if(this->bitIndex < this->frameBits)
+			break;
+		
+		QString text = hexString(this->value, this->settings.bits);
+		if((this->settings.parity == Dso::PARITY_ODD && this->ones % 2 == 0) || (this->settings.parity == Dso::PARITY_EVEN && this->ones % 2 == 1))
+			text += " PE";
+		if(!this->stopBit)
+			text += " FE";
+		this->annotate((unsigned long int) this->frameStart, (unsigned long int) (this->frameStart + this->frameBits * this->samplesPerBit), text);
+		
+		// The next start bit can follow the middle of the stop bit
+		this->receiving = false;
+		this->searchPosition = sample;
+	}
+	
+	this->position = end;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// class SpiDecoder
+/// \brief Initializes the decoder.
+/// \param settings The protocol options.
+/// \param samplerate The samplerate of the data in S/s.
+SpiDecoder::SpiDecoder(const DsoSettingsScopeDecoder &settings, double samplerate) : ProtocolDecoder(settings, samplerate) {
+	this->reset();
+}
+
+/// \brief Starts a new stream.
+void SpiDecoder::reset() {
+	ProtocolDecoder::reset();
+	
+	this->bitCount = 0;
+	this->value = 0;
+	this->wordStart = 0;
+	this->lastEdge = 0;
+	this->period = 0;
+}
+
+/// \brief Decodes the next samples.
+/// \param data The MOSI or MISO line.
+/// \param clock The SCLK line.
+void SpiDecoder::decode(const LogicBits &data, const LogicBits &clock) {
+	// Data is sampled on the rising edge for the modes 0 and 3
+	bool samplingLevel = (this->settings.spiMode == 0 || this->settings.spiMode == 3);
+	unsigned int count = qMin(data.count(), clock.count());
+	
+	for(unsigned int edge = clock.nextEdge(0); edge < count; edge = clock.nextEdge(edge + 1)) {
+		if(clock.level(edge) != samplingLevel)
+			continue;
+		unsigned long int sample = this->position + edge;
+		
+		// A pause of the clock ends an incomplete word
+		if(this->bitCount) {
+			unsigned long int distance = sample - this->lastEdge;
+			if(this->period && distance > PROTOCOLDECODER_SPI_GAP * this->period)
+				this->bitCount = 0;
+			else
+				this->period = distance;
+		}
+		if(!this->bitCount) {
+			this->wordStart = sample;
+			this->value = 0;
+			this->period = 0;
+		}
+		
+		unsigned int bit = data.level(edge) ? 1 : 0;
+		if(this->settings.msbFirst)
+			this->value = (this->value << 1) | bit;
+		else
+			this->value |= bit << this->bitCount;
+		this->bitCount++;
+		this->lastEdge = sample;
+		
+		if(this->bitCount >= this->settings.bits) {
+			this->annotate(this->wordStart, sample, hexString(this->value, this->settings.bits));
+			this->bitCount = 0;
+		}
+	}
+	
+	this->position += count;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// class I2cDecoder
+/// \brief Initializes the decoder.
+/// \param settings The protocol options.
+/// \param samplerate The samplerate of the data in S/s.
+I2cDecoder::I2cDecoder(const DsoSettingsScopeDecoder &settings, double samplerate) : ProtocolDecoder(settings, samplerate) {
+	this->reset();
+}
+
+/// \brief Starts a new stream.
+void I2cDecoder::reset() {
+	ProtocolDecoder::reset();
+	
+	this->started = false;
+	this->address = false;
+	this->bitCount = 0;
+	this->value = 0;
+	this->byteStart = 0;
+}
+
+/// \brief Decodes the next samples.
+/// \param data The SDA line.
+/// \param clock The SCL line.
+void I2cDecoder::decode(const LogicBits &data, const LogicBits &clock) {
+	unsigned int count = qMin(data.count(), clock.count());
+	unsigned int sclEdge = clock.nextEdge(0);
+	unsigned int sdaEdge = data.nextEdge(0);
+	
+	// Handle the edges of both lines in order
+	while(sclEdge < count || sdaEdge < count) {
+		if(sdaEdge < sclEdge) {
+			// SDA changing while SCL is high is a start or stop condition
+			if(clock.level(sdaEdge)) {
+				unsigned long int sample = this->position + sdaEdge;
+				if(!data.level(sdaEdge)) {
+					this->annotate(sample, sample, this->started ? "Sr" : "S");
+					this->started = true;
+					this->address = true;
+				}
+				else {
+					this->annotate(sample, sample, "P");
+					this->started = false;
+				}
+				this->bitCount = 0;
+				this->value = 0;
+			}
+			sdaEdge = data.nextEdge(sdaEdge + 1);
+			continue;
+		}
+		
+		// SDA is sampled on the rising edge of SCL, the ninth bit is the acknowledge
+		if(this->started && clock.level(sclEdge)) {
+			unsigned long int sample = this->position + sclEdge;
+			bool bit = data.level(sclEdge);
+			if(!this->bitCount)
+				this->byteStart = sample;
+			
+			if(this->bitCount < 8)
+				this->value = (this->value << 1) | (bit ? 1 : 0);
+			this->bitCount++;
+			
+			if(this->bitCount == 9) {
+				QString text;
+				if(this->address)
+					text = hexString(this->value >> 1, 7) + ((this->value & 1) ? " R" : " W");
+				else
+					text = hexString(this->value, 8);
+				if(bit)
+					text += " NAK";
+				this->annotate(this->byteStart, sample, text);
+				
+				this->address = false;
+				this->bitCount = 0;
+				this->value = 0;
+			}
+		}
+		sclEdge = clock.nextEdge(sclEdge + 1);
+	}
+	
+	this->position += count;
+}
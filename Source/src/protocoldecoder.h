@@ -0,0 +1,162 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  OpenHantek
+/// \file protocoldecoder.h
+/// \brief Declares the serial protocol decoders.
+//
+//  This program is free software: you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation, either version 3 of the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef PROTOCOLDECODER_H
+#define PROTOCOLDECODER_H
+
+
+#include <QList>
+#include <QString>
+#include <QVector>
+
+
+#include "settings.h"
+
+
+#define PROTOCOLDECODER_CHUNK     65536 ///< Samples decoded at once from files
+#define PROTOCOLDECODER_SPI_GAP       4 ///< Clock periods without edge that end a SPI word
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// \struct ProtocolAnnotation                                 protocoldecoder.h
+/// \brief A decoded word or condition.
+struct ProtocolAnnotation {
+	unsigned long int start; ///< The first sample of the word
+	unsigned long int end; ///< The last sample of the word
+	QString text; ///< The decoded value
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \class LogicBits                                           protocoldecoder.h
+/// \brief Thresholded samples, packed into 64 bit words.
+/// Besides the levels the edges are stored as bits too, so the decoders can skip
+/// 64 samples without any transition at once.
+class LogicBits {
+	public:
+		LogicBits();
+		
+		void threshold(const double *samples, unsigned int count, double level, bool continued = false);
+		
+		unsigned int count() const;
+		bool level(unsigned int position) const;
+		unsigned int nextEdge(unsigned int position) const;
+	
+	protected:
+		QVector<quint64> levels; ///< One bit per sample, set if above the threshold
+		QVector<quint64> edges; ///< One bit per sample, set if the level changed
+		unsigned int size; ///< The number of samples
+		bool lastLevel; ///< The level of the last sample for continued streams
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \class ProtocolDecoder                                     protocoldecoder.h
+/// \brief Base class of the decoders.
+/// The data is decoded in a single pass, a frame that isn't complete at the end
+/// of the samples is continued with the next call of decode(). The positions of
+/// the annotations count from the first sample after the last reset().
+class ProtocolDecoder {
+	public:
+		ProtocolDecoder(const DsoSettingsScopeDecoder &settings, double samplerate);
+		virtual ~ProtocolDecoder();
+		
+		static ProtocolDecoder *create(const DsoSettingsScopeDecoder &settings, double samplerate);
+		static int decodeCsv(const QString &inputName, const QString &outputName, const DsoSettingsScope &scope);
+		
+		bool isConfiguredFor(const DsoSettingsScopeDecoder &settings, double samplerate) const;
+		const QList<ProtocolAnnotation> &annotations() const;
+		void clearAnnotations();
+		
+		virtual void reset();
+		virtual void decode(const LogicBits &data, const LogicBits &clock) = 0;
+	
+	protected:
+		void annotate(unsigned long int start, unsigned long int end, const QString &text);
+		static QString hexString(unsigned int value, unsigned int bits);
+		
+		DsoSettingsScopeDecoder settings; ///< The protocol options
+		double samplerate; ///< The samplerate of the decoded data
+		unsigned long int position; ///< The index of the first sample of this call
+		QList<ProtocolAnnotation> annotationList; ///< The decoded words
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \class UartDecoder                                         protocoldecoder.h
+/// \brief Decodes asynchronous serial frames on the data channel.
+class UartDecoder : public ProtocolDecoder {
+	public:
+		UartDecoder(const DsoSettingsScopeDecoder &settings, double samplerate);
+		
+		void reset();
+		void decode(const LogicBits &data, const LogicBits &clock);
+	
+	protected:
+		double samplesPerBit; ///< Length of one bit in samples
+		unsigned int frameBits; ///< Start, data, parity and stop bits
+		
+		bool receiving; ///< true while a frame is being received
+		double frameStart; ///< The position of the falling edge of the start bit
+		unsigned int bitIndex; ///< The next bit of the frame that is sampled
+		unsigned int value; ///< The data bits received so far
+		unsigned int ones; ///< Number of set data and parity bits
+		bool stopBit; ///< The level of the stop bit
+		unsigned long int searchPosition; ///< Where the next start bit is searched
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \class SpiDecoder                                          protocoldecoder.h
+/// \brief Decodes SPI words from the clock and one data channel.
+/// Without chip select a pause of the clock starts the next word.
+class SpiDecoder : public ProtocolDecoder {
+	public:
+		SpiDecoder(const DsoSettingsScopeDecoder &settings, double samplerate);
+		
+		void reset();
+		void decode(const LogicBits &data, const LogicBits &clock);
+	
+	protected:
+		unsigned int bitCount; ///< The number of bits received for this word
+		unsigned int value; ///< The bits received so far
+		unsigned long int wordStart; ///< The first clock edge of the word
+		unsigned long int lastEdge; ///< The previous sampling edge
+		unsigned long int period; ///< The distance of the last two sampling edges
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \class I2cDecoder                                          protocoldecoder.h
+/// \brief Decodes I2C conditions, addresses and data bytes from SCL and SDA.
+class I2cDecoder : public ProtocolDecoder {
+	public:
+		I2cDecoder(const DsoSettingsScopeDecoder &settings, double samplerate);
+		
+		void reset();
+		void decode(const LogicBits &data, const LogicBits &clock);
+	
+	protected:
+		bool started; ///< true between start and stop condition
+		bool address; ///< true if the next byte is the address
+		unsigned int bitCount; ///< The number of bits received for this byte
+		unsigned int value; ///< The bits received so far
+		unsigned long int byteStart; ///< The first clock of the byte
+};
+
+
+#endif
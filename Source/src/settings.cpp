@@ -30,6 +30,7 @@
 
 #include "dso.h"
 #include "dsowidget.h"
+#include "mathexpression.h"
 
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -39,6 +40,13 @@ DsoSettings::DsoSettings(QWidget *parent) : QObject(parent) {
 	// Options
 	this->options.alwaysSave = true;
 	this->options.imageSize = QSize(640, 480);
+	this->options.csvPrecision = 6;
+	this->options.csvColumns = false;
+	this->options.history.frames = 1000;
+	this->options.history.memory = 64;
+	this->options.recorder.backlog = 256;
+	this->options.recorder.fileDuration = 0;
+	this->options.recorder.fileSize = 0;
 	// Main window
 	this->options.window.position = QPoint();
 	this->options.window.size = QSize(800, 600);
@@ -58,6 +66,16 @@ DsoSettings::DsoSettings(QWidget *parent) : QObject(parent) {
 	}
 	
 	// Oscilloscope settings
+	// Protocol decoder
+	this->scope.decoder.baudrate = 9600;
+	this->scope.decoder.bits = 8;
+	this->scope.decoder.clock = 0;
+	this->scope.decoder.data = 1;
+	this->scope.decoder.msbFirst = true;
+	this->scope.decoder.parity = Dso::PARITY_NONE;
+	this->scope.decoder.protocol = Dso::PROTOCOL_OFF;
+	this->scope.decoder.spiMode = 0;
+	this->scope.decoder.threshold = 1.5;
 	// Horizontal axis
 	this->scope.horizontal.format = Dso::GRAPHFORMAT_TY;
 	this->scope.horizontal.frequencybase = 1e3;
@@ -66,6 +84,15 @@ DsoSettings::DsoSettings(QWidget *parent) : QObject(parent) {
 	this->scope.horizontal.timebase = 1e-3;
     this->scope.horizontal.samples = 2048; // Buudai::BUFFER_SMALL;
     this->scope.horizontal.samplerate = 240e3;
+	// Mask test
+	this->scope.mask.channel = 0;
+	this->scope.mask.enabled = false;
+	this->scope.mask.stopOnFailure = false;
+	this->scope.mask.toleranceTime = 0.1;
+	this->scope.mask.toleranceVoltage = 0.2;
+	// Phase
+	this->scope.phase.enabled = false;
+	this->scope.phase.reference = 0;
 	// Trigger
 	this->scope.trigger.filter = true;
 	this->scope.trigger.mode = Dso::TRIGGERMODE_NORMAL;
@@ -78,6 +105,9 @@ DsoSettings::DsoSettings(QWidget *parent) : QObject(parent) {
 	this->scope.spectrumLimit = -20.0;
 	this->scope.spectrumReference = 0.0;
 	this->scope.spectrumWindow = Dso::WINDOW_HANN;
+	this->scope.spectrumZoom = false;
+	this->scope.spectrumHarmonics = false;
+	this->scope.spectrumPrecise = false;
 	
 	
 	// View
@@ -88,6 +118,7 @@ DsoSettings::DsoSettings(QWidget *parent) : QObject(parent) {
 	this->view.color.screen.border = QColor(0xff, 0xff, 0xff, 0xff);
 	this->view.color.screen.grid = QColor(0xff, 0xff, 0xff, 0x3f);
 	this->view.color.screen.markers = QColor(0xff, 0xff, 0xff, 0xbf);
+	this->view.color.screen.mask = QColor(0xff, 0x3f, 0x3f, 0xbf);
 	this->view.color.screen.text = QColor(0xff, 0xff, 0xff, 0xff);
 	// Print
 	this->view.color.print.axes = QColor(0x00, 0x00, 0x00, 0xbf);
@@ -95,13 +126,17 @@ DsoSettings::DsoSettings(QWidget *parent) : QObject(parent) {
 	this->view.color.print.border = QColor(0x00, 0x00, 0x00, 0xff);
 	this->view.color.print.grid = QColor(0x00, 0x00, 0x00, 0x7f);
 	this->view.color.print.markers = QColor(0x00, 0x00, 0x00, 0xef);
+	this->view.color.print.mask = QColor(0xbf, 0x00, 0x00, 0xbf);
 	this->view.color.print.text = QColor(0x00, 0x00, 0x00, 0xff);
 	// Other view settings
 	this->view.antialiasing = true;
 	this->view.digitalPhosphor = false;
 	this->view.digitalPhosphorDepth = 8;
+	this->view.frameRate = 60;
 	this->view.interpolation = Dso::INTERPOLATION_LINEAR;
 	this->view.screenColorImages = false;
+	this->view.spectrogram = false;
+	this->view.spectrogramChannel = 0;
 	this->view.zoom = false;
 }
 
@@ -113,23 +148,19 @@ DsoSettings::~DsoSettings() {
 /// \param channels The new channel count, that will be applied to lists.
 void DsoSettings::setChannelCount(unsigned int channels) {
 	this->scope.physicalChannels = channels;
-	// Always put the math channel at the end of the list
+	// Always put the math channels at the end of the list
 	
 	// Remove list items for removed channels
-	for(int channel = this->scope.spectrum.count() - 2; channel >= (int) channels; channel--)
+	for(int channel = this->scope.spectrum.count() - MATH_CHANNELS - 1; channel >= (int) channels; channel--)
 		this->scope.spectrum.removeAt(channel);
-	for(int channel = this->scope.voltage.count() - 2; channel >= (int) channels; channel--)
+	for(int channel = this->scope.voltage.count() - MATH_CHANNELS - 1; channel >= (int) channels; channel--)
 		this->scope.voltage.removeAt(channel);
-	for(int channel = this->scope.spectrum.count() - 2; channel >= (int) channels; channel--)
-		this->scope.spectrum.removeAt(channel);
-	for(int channel = this->scope.spectrum.count() - 2; channel >= (int) channels; channel--)
-		this->scope.spectrum.removeAt(channel);
 	
 	// Add new channels to the list
 	for(int channel = 0; channel < (int) channels; channel++) {
 		// Oscilloscope settings
 		// Spectrum
-		if(this->scope.spectrum.count() <= channel + 1) {
+		if(this->scope.spectrum.count() <= channel + MATH_CHANNELS) {
 			DsoSettingsScopeSpectrum newSpectrum;
 			newSpectrum.magnitude = 20.0;
 			newSpectrum.name = QApplication::tr("SP%1").arg(channel + 1);
@@ -138,8 +169,13 @@ void DsoSettings::setChannelCount(unsigned int channels) {
 			this->scope.spectrum.insert(channel, newSpectrum);
 		}
 		// Voltage
-		if(this->scope.voltage.count() <= channel + 1) {
+		if(this->scope.voltage.count() <= channel + MATH_CHANNELS) {
 			DsoSettingsScopeVoltage newVoltage;
+			newVoltage.filter.bandwidth = 1e3;
+			newVoltage.filter.design = Dso::FILTERDESIGN_FIR;
+			newVoltage.filter.frequency = 1e3;
+			newVoltage.filter.taps = 63;
+			newVoltage.filter.type = Dso::FILTERTYPE_OFF;
 			newVoltage.gain = 1.0;
 			newVoltage.misc = Dso::COUPLING_DC;
 			newVoltage.name = QApplication::tr("CH%1").arg(channel + 1);
@@ -152,44 +188,55 @@ void DsoSettings::setChannelCount(unsigned int channels) {
 		// View
 		// Colors
 		// Screen
-		if(this->view.color.screen.voltage.count() <= channel + 1)
+		if(this->view.color.screen.voltage.count() <= channel + MATH_CHANNELS)
 			this->view.color.screen.voltage.insert(channel, QColor::fromHsv(channel * 60, 0xff, 0xff));
-		if(this->view.color.screen.spectrum.count() <= channel + 1)
+		if(this->view.color.screen.spectrum.count() <= channel + MATH_CHANNELS)
 			this->view.color.screen.spectrum.insert(channel, this->view.color.screen.voltage[channel].lighter());
 		// Print
-		if(this->view.color.print.voltage.count() <= channel + 1)
+		if(this->view.color.print.voltage.count() <= channel + MATH_CHANNELS)
 			this->view.color.print.voltage.insert(channel, this->view.color.screen.voltage[channel].darker(120));
-		if(this->view.color.print.spectrum.count() <= channel + 1)
+		if(this->view.color.print.spectrum.count() <= channel + MATH_CHANNELS)
 			this->view.color.print.spectrum.insert(channel, this->view.color.screen.voltage[channel].darker());
 	}
 	
-	// Check if the math channel is missing
-	if(this->scope.spectrum.count() <= (int) channels) {
-		DsoSettingsScopeSpectrum newSpectrum;
-		newSpectrum.magnitude = 20.0;
-		newSpectrum.name = QApplication::tr("SPM");
-		newSpectrum.offset = 0.0;
-		newSpectrum.used = false;
-		this->scope.spectrum.append(newSpectrum);
-	}
-	if(this->scope.voltage.count() <= (int) channels) {
-		DsoSettingsScopeVoltage newVoltage;
-		newVoltage.gain = 1.0;
-		newVoltage.misc = Dso::MATHMODE_1ADD2;
-		newVoltage.name = QApplication::tr("MATH");
-		newVoltage.offset = 0.0;
-		newVoltage.trigger = 0.0;
-		newVoltage.used = false;
-		this->scope.voltage.append(newVoltage);
+	// Check if math channels are missing
+	for(int mathChannel = 0; mathChannel < MATH_CHANNELS; mathChannel++) {
+		int channel = channels + mathChannel;
+		QString suffix = mathChannel ? QString::number(mathChannel + 1) : QString();
+		
+		if(this->scope.spectrum.count() <= channel) {
+			DsoSettingsScopeSpectrum newSpectrum;
+			newSpectrum.magnitude = 20.0;
+			newSpectrum.name = QApplication::tr("SPM") + suffix;
+			newSpectrum.offset = 0.0;
+			newSpectrum.used = false;
+			this->scope.spectrum.append(newSpectrum);
+		}
+		if(this->scope.voltage.count() <= channel) {
+			DsoSettingsScopeVoltage newVoltage;
+			newVoltage.expression = MathExpression::modeExpression(Dso::MATHMODE_1ADD2);
+			newVoltage.filter.bandwidth = 1e3;
+			newVoltage.filter.design = Dso::FILTERDESIGN_FIR;
+			newVoltage.filter.frequency = 1e3;
+			newVoltage.filter.taps = 63;
+			newVoltage.filter.type = Dso::FILTERTYPE_OFF;
+			newVoltage.gain = 1.0;
+			newVoltage.misc = Dso::MATHMODE_1ADD2;
+			newVoltage.name = QApplication::tr("MATH") + suffix;
+			newVoltage.offset = 0.0;
+			newVoltage.trigger = 0.0;
+			newVoltage.used = false;
+			this->scope.voltage.append(newVoltage);
+		}
+		if(this->view.color.screen.voltage.count() <= channel)
+			this->view.color.screen.voltage.append(mathChannel ? QColor::fromHsv(mathChannel * 60 + 30, 0x3f, 0xbf) : QColor(0x7f, 0x7f, 0x7f, 0xff));
+		if(this->view.color.screen.spectrum.count() <= channel)
+			this->view.color.screen.spectrum.append(this->view.color.screen.voltage[channel].lighter());
+		if(this->view.color.print.voltage.count() <= channel)
+			this->view.color.print.voltage.append(this->view.color.screen.voltage[channel]);
+		if(this->view.color.print.spectrum.count() <= channel)
+			this->view.color.print.spectrum.append(this->view.color.print.voltage[channel].darker());
 	}
-	if(this->view.color.screen.voltage.count() <= (int) channels)
-		this->view.color.screen.voltage.append(QColor(0x7f, 0x7f, 0x7f, 0xff));
-	if(this->view.color.screen.spectrum.count() <= (int) channels)
-		this->view.color.screen.spectrum.append(this->view.color.screen.voltage[channels].lighter());
-	if(this->view.color.print.voltage.count() <= (int) channels)
-		this->view.color.print.voltage.append(this->view.color.screen.voltage[channels]);
-	if(this->view.color.print.spectrum.count() <= (int) channels)
-		this->view.color.print.spectrum.append(this->view.color.print.voltage[channels].darker());
 }
 
 /// \brief Read the settings from the last session or another file.
@@ -258,10 +305,51 @@ int DsoSettings::load(const QString &fileName) {
 		this->options.alwaysSave = settingsLoader->value("alwaysSave").toBool();
 	if(settingsLoader->contains("imageSize"))
 		this->options.imageSize = settingsLoader->value("imageSize").toSize();
+	if(settingsLoader->contains("csvPrecision"))
+		this->options.csvPrecision = settingsLoader->value("csvPrecision").toInt();
+	if(settingsLoader->contains("csvColumns"))
+		this->options.csvColumns = settingsLoader->value("csvColumns").toBool();
+	// Frame history
+	settingsLoader->beginGroup("history");
+	if(settingsLoader->contains("frames"))
+		this->options.history.frames = settingsLoader->value("frames").toInt();
+	if(settingsLoader->contains("memory"))
+		this->options.history.memory = settingsLoader->value("memory").toInt();
+	settingsLoader->endGroup();
+	// Recorder
+	settingsLoader->beginGroup("recorder");
+	if(settingsLoader->contains("backlog"))
+		this->options.recorder.backlog = settingsLoader->value("backlog").toInt();
+	if(settingsLoader->contains("fileDuration"))
+		this->options.recorder.fileDuration = settingsLoader->value("fileDuration").toInt();
+	if(settingsLoader->contains("fileSize"))
+		this->options.recorder.fileSize = settingsLoader->value("fileSize").toInt();
+	settingsLoader->endGroup();
 	settingsLoader->endGroup();
 	
 	// Oszilloskope settings
 	settingsLoader->beginGroup("scope");
+	// Protocol decoder
+	settingsLoader->beginGroup("decoder");
+	if(settingsLoader->contains("baudrate"))
+		this->scope.decoder.baudrate = settingsLoader->value("baudrate").toUInt();
+	if(settingsLoader->contains("bits"))
+		this->scope.decoder.bits = settingsLoader->value("bits").toUInt();
+	if(settingsLoader->contains("clock"))
+		this->scope.decoder.clock = settingsLoader->value("clock").toUInt();
+	if(settingsLoader->contains("data"))
+		this->scope.decoder.data = settingsLoader->value("data").toUInt();
+	if(settingsLoader->contains("msbFirst"))
+		this->scope.decoder.msbFirst = settingsLoader->value("msbFirst").toBool();
+	if(settingsLoader->contains("parity"))
+		this->scope.decoder.parity = (Dso::Parity) settingsLoader->value("parity").toInt();
+	if(settingsLoader->contains("protocol"))
+		this->scope.decoder.protocol = (Dso::Protocol) settingsLoader->value("protocol").toInt();
+	if(settingsLoader->contains("spiMode"))
+		this->scope.decoder.spiMode = settingsLoader->value("spiMode").toUInt();
+	if(settingsLoader->contains("threshold"))
+		this->scope.decoder.threshold = settingsLoader->value("threshold").toDouble();
+	settingsLoader->endGroup();
 	// Horizontal axis
 	settingsLoader->beginGroup("horizontal");
 	if(settingsLoader->contains("format"))
@@ -277,6 +365,36 @@ int DsoSettings::load(const QString &fileName) {
 	if(settingsLoader->contains("timebase"))
 		this->scope.horizontal.timebase = settingsLoader->value("timebase").toDouble();
 	settingsLoader->endGroup();
+	// Mask test
+	settingsLoader->beginGroup("mask");
+	if(settingsLoader->contains("channel"))
+		this->scope.mask.channel = settingsLoader->value("channel").toUInt();
+	if(settingsLoader->contains("enabled"))
+		this->scope.mask.enabled = settingsLoader->value("enabled").toBool();
+	for(int limitId = 0; limitId < 2; limitId++) {
+		QList<QPointF> *limit = limitId ? &this->scope.mask.upper : &this->scope.mask.lower;
+		int size = settingsLoader->beginReadArray(limitId ? "upper" : "lower");
+		limit->clear();
+		for(int point = 0; point < size; point++) {
+			settingsLoader->setArrayIndex(point);
+			limit->append(QPointF(settingsLoader->value("time").toDouble(), settingsLoader->value("voltage").toDouble()));
+		}
+		settingsLoader->endArray();
+	}
+	if(settingsLoader->contains("stopOnFailure"))
+		this->scope.mask.stopOnFailure = settingsLoader->value("stopOnFailure").toBool();
+	if(settingsLoader->contains("toleranceTime"))
+		this->scope.mask.toleranceTime = settingsLoader->value("toleranceTime").toDouble();
+	if(settingsLoader->contains("toleranceVoltage"))
+		this->scope.mask.toleranceVoltage = settingsLoader->value("toleranceVoltage").toDouble();
+	settingsLoader->endGroup();
+	// Phase
+	settingsLoader->beginGroup("phase");
+	if(settingsLoader->contains("enabled"))
+		this->scope.phase.enabled = settingsLoader->value("enabled").toBool();
+	if(settingsLoader->contains("reference"))
+		this->scope.phase.reference = settingsLoader->value("reference").toUInt();
+	settingsLoader->endGroup();
 	// Trigger
 	settingsLoader->beginGroup("trigger");
 	if(settingsLoader->contains("filter"))
@@ -306,6 +424,18 @@ int DsoSettings::load(const QString &fileName) {
 	// Vertical axis
 	for(int channel = 0; channel < this->scope.voltage.count(); channel++) {
 		settingsLoader->beginGroup(QString("vertical%1").arg(channel));
+		if(settingsLoader->contains("expression"))
+			this->scope.voltage[channel].expression = settingsLoader->value("expression").toString();
+		if(settingsLoader->contains("filterBandwidth"))
+			this->scope.voltage[channel].filter.bandwidth = settingsLoader->value("filterBandwidth").toDouble();
+		if(settingsLoader->contains("filterDesign"))
+			this->scope.voltage[channel].filter.design = (Dso::FilterDesign) settingsLoader->value("filterDesign").toInt();
+		if(settingsLoader->contains("filterFrequency"))
+			this->scope.voltage[channel].filter.frequency = settingsLoader->value("filterFrequency").toDouble();
+		if(settingsLoader->contains("filterTaps"))
+			this->scope.voltage[channel].filter.taps = settingsLoader->value("filterTaps").toUInt();
+		if(settingsLoader->contains("filterType"))
+			this->scope.voltage[channel].filter.type = (Dso::FilterType) settingsLoader->value("filterType").toInt();
 		if(settingsLoader->contains("gain"))
 			this->scope.voltage[channel].gain = settingsLoader->value("gain").toDouble();
 		if(settingsLoader->contains("misc"))
@@ -318,12 +448,18 @@ int DsoSettings::load(const QString &fileName) {
 			this->scope.voltage[channel].used = settingsLoader->value("used").toBool();
 		settingsLoader->endGroup();
 	}
+	if(settingsLoader->contains("spectrumHarmonics"))
+		this->scope.spectrumHarmonics = settingsLoader->value("spectrumHarmonics").toBool();
 	if(settingsLoader->contains("spectrumLimit"))
 		this->scope.spectrumLimit = settingsLoader->value("spectrumLimit").toDouble();
+	if(settingsLoader->contains("spectrumPrecise"))
+		this->scope.spectrumPrecise = settingsLoader->value("spectrumPrecise").toBool();
 	if(settingsLoader->contains("spectrumReference"))
 		this->scope.spectrumReference = settingsLoader->value("spectrumReference").toDouble();
 	if(settingsLoader->contains("spectrumWindow"))
 		this->scope.spectrumWindow = (Dso::WindowFunction) settingsLoader->value("spectrumWindow").toInt();
+	if(settingsLoader->contains("spectrumZoom"))
+		this->scope.spectrumZoom = settingsLoader->value("spectrumZoom").toBool();
 	settingsLoader->endGroup();
 	
 	// View
@@ -351,6 +487,8 @@ int DsoSettings::load(const QString &fileName) {
 			colors->grid = settingsLoader->value("grid").value<QColor>();
 		if(settingsLoader->contains("markers"))
 			colors->markers = settingsLoader->value("markers").value<QColor>();
+		if(settingsLoader->contains("mask"))
+			colors->mask = settingsLoader->value("mask").value<QColor>();
 		for(int channel = 0; channel < this->scope.spectrum.count(); channel++) {
 			QString key = QString("spectrum%1").arg(channel);
 			if(settingsLoader->contains(key))
@@ -369,10 +507,18 @@ int DsoSettings::load(const QString &fileName) {
 	// Other view settings
 	if(settingsLoader->contains("digitalPhosphor"))
 		this->view.digitalPhosphor = settingsLoader->value("digitalPhosphor").toBool();
+	if(settingsLoader->contains("digitalPhosphorDepth"))
+		this->view.digitalPhosphorDepth = settingsLoader->value("digitalPhosphorDepth").toInt();
+	if(settingsLoader->contains("frameRate"))
+		this->view.frameRate = settingsLoader->value("frameRate").toInt();
 	if(settingsLoader->contains("interpolation"))
 		this->view.interpolation = (Dso::InterpolationMode) settingsLoader->value("interpolation").toInt();
 	if(settingsLoader->contains("screenColorImages"))
 		this->view.screenColorImages = (Dso::InterpolationMode) settingsLoader->value("screenColorImages").toBool();
+	if(settingsLoader->contains("spectrogram"))
+		this->view.spectrogram = settingsLoader->value("spectrogram").toBool();
+	if(settingsLoader->contains("spectrogramChannel"))
+		this->view.spectrogramChannel = settingsLoader->value("spectrogramChannel").toUInt();
 	if(settingsLoader->contains("zoom"))
 		this->view.zoom = (Dso::InterpolationMode) settingsLoader->value("zoom").toBool();
 	settingsLoader->endGroup();
@@ -438,10 +584,35 @@ int DsoSettings::save(const QString &fileName) {
 		settingsSaver->endGroup();
 		settingsSaver->setValue("alwaysSave", this->options.alwaysSave);
 		settingsSaver->setValue("imageSize", this->options.imageSize);
+		settingsSaver->setValue("csvPrecision", this->options.csvPrecision);
+		settingsSaver->setValue("csvColumns", this->options.csvColumns);
+		// Frame history
+		settingsSaver->beginGroup("history");
+		settingsSaver->setValue("frames", this->options.history.frames);
+		settingsSaver->setValue("memory", this->options.history.memory);
+		settingsSaver->endGroup();
+		// Recorder
+		settingsSaver->beginGroup("recorder");
+		settingsSaver->setValue("backlog", this->options.recorder.backlog);
+		settingsSaver->setValue("fileDuration", this->options.recorder.fileDuration);
+		settingsSaver->setValue("fileSize", this->options.recorder.fileSize);
+		settingsSaver->endGroup();
 		settingsSaver->endGroup();
 	}
 	// Oszilloskope settings
 	settingsSaver->beginGroup("scope");
+	// Protocol decoder
+	settingsSaver->beginGroup("decoder");
+	settingsSaver->setValue("baudrate", this->scope.decoder.baudrate);
+	settingsSaver->setValue("bits", this->scope.decoder.bits);
+	settingsSaver->setValue("clock", this->scope.decoder.clock);
+	settingsSaver->setValue("data", this->scope.decoder.data);
+	settingsSaver->setValue("msbFirst", this->scope.decoder.msbFirst);
+	settingsSaver->setValue("parity", this->scope.decoder.parity);
+	settingsSaver->setValue("protocol", this->scope.decoder.protocol);
+	settingsSaver->setValue("spiMode", this->scope.decoder.spiMode);
+	settingsSaver->setValue("threshold", this->scope.decoder.threshold);
+	settingsSaver->endGroup();
 	// Horizontal axis
 	settingsSaver->beginGroup("horizontal");
 	settingsSaver->setValue("format", this->scope.horizontal.format);
@@ -450,6 +621,30 @@ int DsoSettings::save(const QString &fileName) {
 		settingsSaver->setValue(QString("marker%1").arg(marker), this->scope.horizontal.marker[marker]);
 	settingsSaver->setValue("timebase", this->scope.horizontal.timebase);
 	settingsSaver->endGroup();
+	// Mask test
+	settingsSaver->beginGroup("mask");
+	settingsSaver->setValue("channel", this->scope.mask.channel);
+	settingsSaver->setValue("enabled", this->scope.mask.enabled);
+	for(int limitId = 0; limitId < 2; limitId++) {
+		const QList<QPointF> &limit = limitId ? this->scope.mask.upper : this->scope.mask.lower;
+		settingsSaver->remove(limitId ? "upper" : "lower");
+		settingsSaver->beginWriteArray(limitId ? "upper" : "lower", limit.count());
+		for(int point = 0; point < limit.count(); point++) {
+			settingsSaver->setArrayIndex(point);
+			settingsSaver->setValue("time", limit[point].x());
+			settingsSaver->setValue("voltage", limit[point].y());
+		}
+		settingsSaver->endArray();
+	}
+	settingsSaver->setValue("stopOnFailure", this->scope.mask.stopOnFailure);
+	settingsSaver->setValue("toleranceTime", this->scope.mask.toleranceTime);
+	settingsSaver->setValue("toleranceVoltage", this->scope.mask.toleranceVoltage);
+	settingsSaver->endGroup();
+	// Phase
+	settingsSaver->beginGroup("phase");
+	settingsSaver->setValue("enabled", this->scope.phase.enabled);
+	settingsSaver->setValue("reference", this->scope.phase.reference);
+	settingsSaver->endGroup();
 	// Trigger
 	settingsSaver->beginGroup("trigger");
 	settingsSaver->setValue("filter", this->scope.trigger.filter);
@@ -469,6 +664,15 @@ int DsoSettings::save(const QString &fileName) {
 	// Vertical axis
 	for(int channel = 0; channel < this->scope.voltage.count(); channel++) {
 		settingsSaver->beginGroup(QString("vertical%1").arg(channel));
+		if(channel >= (int) this->scope.physicalChannels)
+			settingsSaver->setValue("expression", this->scope.voltage[channel].expression);
+		else {
+			settingsSaver->setValue("filterBandwidth", this->scope.voltage[channel].filter.bandwidth);
+			settingsSaver->setValue("filterDesign", this->scope.voltage[channel].filter.design);
+			settingsSaver->setValue("filterFrequency", this->scope.voltage[channel].filter.frequency);
+			settingsSaver->setValue("filterTaps", this->scope.voltage[channel].filter.taps);
+			settingsSaver->setValue("filterType", this->scope.voltage[channel].filter.type);
+		}
 		settingsSaver->setValue("gain", this->scope.voltage[channel].gain);
 		settingsSaver->setValue("misc", this->scope.voltage[channel].misc);
 		settingsSaver->setValue("offset", this->scope.voltage[channel].offset);
@@ -476,9 +680,12 @@ int DsoSettings::save(const QString &fileName) {
 		settingsSaver->setValue("used", this->scope.voltage[channel].used);
 		settingsSaver->endGroup();
 	}
+	settingsSaver->setValue("spectrumHarmonics", this->scope.spectrumHarmonics);
 	settingsSaver->setValue("spectrumLimit", this->scope.spectrumLimit);
+	settingsSaver->setValue("spectrumPrecise", this->scope.spectrumPrecise);
 	settingsSaver->setValue("spectrumReference", this->scope.spectrumReference);
 	settingsSaver->setValue("spectrumWindow", this->scope.spectrumWindow);
+	settingsSaver->setValue("spectrumZoom", this->scope.spectrumZoom);
 	settingsSaver->endGroup();
 	
 	// View
@@ -502,6 +709,7 @@ int DsoSettings::save(const QString &fileName) {
 			settingsSaver->setValue("border", colors->border);
 			settingsSaver->setValue("grid", colors->grid);
 			settingsSaver->setValue("markers", colors->markers);
+			settingsSaver->setValue("mask", colors->mask);
 			for(int channel = 0; channel < this->scope.spectrum.count(); channel++)
 				settingsSaver->setValue(QString("spectrum%1").arg(channel), colors->spectrum[channel]);
 			settingsSaver->setValue("text", colors->text);
@@ -513,10 +721,14 @@ int DsoSettings::save(const QString &fileName) {
 	}
 	// Other view settings
 	settingsSaver->setValue("digitalPhosphor", this->view.digitalPhosphor);
+	settingsSaver->setValue("digitalPhosphorDepth", this->view.digitalPhosphorDepth);
+	settingsSaver->setValue("frameRate", this->view.frameRate);
 	if(complete) {
 		settingsSaver->setValue("interpolation", this->view.interpolation);
 		settingsSaver->setValue("screenColorImages", this->view.screenColorImages);
 	}
+	settingsSaver->setValue("spectrogram", this->view.spectrogram);
+	settingsSaver->setValue("spectrogramChannel", this->view.spectrogramChannel);
 	settingsSaver->setValue("zoom", this->view.zoom);
 	settingsSaver->endGroup();
 	
@@ -31,6 +31,7 @@
 #include <QList>
 #include <QObject>
 #include <QPoint>
+#include <QPointF>
 #include <QSize>
 #include <QString>
 
@@ -76,12 +77,33 @@ struct DsoSettingsOptionsWindow {
 	DsoSettingsOptionsWindowToolbar toolbar; ///< Toolbars
 };
 
+////////////////////////////////////////////////////////////////////////////////
+/// \struct DsoSettingsOptionsHistory                                 settings.h
+/// \brief Holds the limits for the kept frames.
+struct DsoSettingsOptionsHistory {
+	int frames; ///< Maximum number of kept frames
+	int memory; ///< Maximum memory for the kept frames in MiB
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \struct DsoSettingsOptionsRecorder                                settings.h
+/// \brief Holds the limits for recordings.
+struct DsoSettingsOptionsRecorder {
+	int backlog; ///< Frames waiting for the disk in MiB before frames are dropped
+	int fileDuration; ///< Minutes after which a new file is started, 0 for no limit
+	int fileSize; ///< MiB after which a new file is started, 0 for no limit
+};
+
 ////////////////////////////////////////////////////////////////////////////////
 /// \struct DsoSettingsOptions                                        settings.h
 /// \brief Holds the general options of the program.
 struct DsoSettingsOptions {
 	bool alwaysSave; ///< Always save the settings on exit
 	QSize imageSize; ///< Size of exported images in pixels
+	int csvPrecision; ///< Significant digits of exported values, 0 for the shortest exact ones
+	bool csvColumns; ///< true exports one column instead of one row per channel
+	DsoSettingsOptionsHistory history; ///< Limits of the frame history
+	DsoSettingsOptionsRecorder recorder; ///< Recording limits
 	DsoSettingsOptionsWindow window; ///< Window layout
 };
 
@@ -97,6 +119,29 @@ struct DsoSettingsScopeHorizontal {
 	unsigned long int samplerate; ///< The samplerate of the oscilloscope in S
 };
 
+////////////////////////////////////////////////////////////////////////////////
+/// \struct DsoSettingsScopeMask                                      settings.h
+/// \brief Holds the settings for the mask test.
+/// The limits are polylines with the time since the first sample in s and the
+/// voltage in V, sorted by time. Outside of a polyline the channel isn't limited.
+struct DsoSettingsScopeMask {
+	unsigned int channel; ///< The tested channel
+	bool enabled; ///< true if every frame is tested against the mask
+	QList<QPointF> lower; ///< The lower limit
+	QList<QPointF> upper; ///< The upper limit
+	bool stopOnFailure; ///< true stops the sampling after a failed frame
+	double toleranceTime; ///< Horizontal tolerance for masks created from a waveform in div
+	double toleranceVoltage; ///< Vertical tolerance for masks created from a waveform in div
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \struct DsoSettingsScopePhase                                     settings.h
+/// \brief Holds the settings for the delay and phase measurement.
+struct DsoSettingsScopePhase {
+	bool enabled; ///< true if the channels are compared to the reference
+	unsigned int reference; ///< The channel the others are compared to
+};
+
 ////////////////////////////////////////////////////////////////////////////////
 /// \struct DsoSettingsScopeTrigger                                   settings.h
 /// \brief Holds the settings for the trigger.
@@ -109,6 +154,21 @@ struct DsoSettingsScopeTrigger {
 	unsigned int source; ///< Channel that is used as trigger source
 };
 
+////////////////////////////////////////////////////////////////////////////////
+/// \struct DsoSettingsScopeDecoder                                   settings.h
+/// \brief Holds the settings for the serial protocol decoder.
+struct DsoSettingsScopeDecoder {
+	unsigned int baudrate; ///< Bits per second for UART
+	unsigned int bits; ///< Data bits per word for UART and SPI
+	unsigned int clock; ///< Channel with the clock (SPI SCLK, I2C SCL)
+	unsigned int data; ///< Channel with the data (UART RX, SPI data, I2C SDA)
+	bool msbFirst; ///< Bit order for SPI, UART is always LSB first
+	Dso::Parity parity; ///< Parity bit for UART
+	Dso::Protocol protocol; ///< The decoded protocol, off disables the decoder
+	unsigned int spiMode; ///< SPI mode 0 to 3, bit 1 is CPOL, bit 0 CPHA
+	double threshold; ///< Logic threshold in V
+};
+
 ////////////////////////////////////////////////////////////////////////////////
 /// \struct DsoSettingsScopeSpectrum                                  settings.h
 /// \brief Holds the settings for the spectrum analysis.
@@ -119,10 +179,23 @@ struct DsoSettingsScopeSpectrum {
 	bool used; ///< true if the spectrum is turned on
 };
 
+////////////////////////////////////////////////////////////////////////////////
+/// \struct DsoSettingsScopeFilter                                    settings.h
+/// \brief Holds the settings for the digital filter of a channel.
+struct DsoSettingsScopeFilter {
+	double bandwidth; ///< Width of the band for bandpass and notch in Hz
+	Dso::FilterDesign design; ///< FIR or IIR implementation
+	double frequency; ///< Cutoff or center frequency in Hz
+	unsigned int taps; ///< Number of coefficients of the FIR filter
+	Dso::FilterType type; ///< The filter response, off disables the filter
+};
+
 ////////////////////////////////////////////////////////////////////////////////
 /// \struct DsoSettingsScopeVoltage                                   settings.h
 /// \brief Holds the settings for the normal voltage graphs.
 struct DsoSettingsScopeVoltage {
+	QString expression; ///< The formula for math-channels in expression mode
+	DsoSettingsScopeFilter filter; ///< The digital filter for real channels
 	double gain; ///< The vertical resolution in V/div
 	int misc; ///< Different enums, coupling for real- and mode for math-channels
 	QString name; ///< Name of this channel
@@ -135,7 +208,10 @@ struct DsoSettingsScopeVoltage {
 /// \struct DsoSettingsScope                                          settings.h
 /// \brief Holds the settings for the oscilloscope.
 struct DsoSettingsScope {
+	DsoSettingsScopeDecoder decoder; ///< Settings for the protocol decoder
 	DsoSettingsScopeHorizontal horizontal; ///< Settings for the horizontal axis
+	DsoSettingsScopeMask mask; ///< Settings for the mask test
+	DsoSettingsScopePhase phase; ///< Settings for the delay and phase measurement
 	DsoSettingsScopeTrigger trigger; ///< Settings for the trigger
 	QList<DsoSettingsScopeSpectrum> spectrum; ///< Spectrum analysis settings
 	QList<DsoSettingsScopeVoltage> voltage; ///< Settings for the normal graphs
@@ -144,6 +220,9 @@ struct DsoSettingsScope {
 	Dso::WindowFunction spectrumWindow; ///< Window function for DFT
 	double spectrumReference; ///< Reference level for spectrum in dBm
 	double spectrumLimit; ///< Minimum magnitude of the spectrum (Avoids peaks)
+	bool spectrumZoom; ///< true if the zoomed scope shows a narrowband spectrum
+	bool spectrumHarmonics; ///< true if the harmonic distortion is measured
+	bool spectrumPrecise; ///< true if the dB values use the exact logarithm
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -155,6 +234,7 @@ struct DsoSettingsColorValues {
 	QColor border; ///< The border of the scope screen
 	QColor grid; ///< The color of the grid
 	QColor markers; ///< The color of the markers
+	QColor mask; ///< The mask and the samples violating it
 	QList<QColor> spectrum; ///< The colors of the spectrum graphs
 	QColor text; ///< The default text color
 	QList<QColor> voltage; ///< The colors of the voltage graphs
@@ -175,9 +255,12 @@ struct DsoSettingsView {
 	DsoSettingsViewColor color; ///< Used colors
 	bool antialiasing; ///< Antialiasing for the graphs
 	bool digitalPhosphor; ///< true slowly fades out the previous graphs
-	int digitalPhosphorDepth; ///< Number of channels shown at one time
+	int digitalPhosphorDepth; ///< Number of graphs until one has faded out, 0 for infinite persistence
+	int frameRate; ///< Maximum number of screen updates per second
 	Dso::InterpolationMode interpolation; ///< Interpolation mode for the graph
 	bool screenColorImages; ///< true exports images with screen colors
+	bool spectrogram; ///< true if the waterfall is shown next to the scope
+	unsigned int spectrogramChannel; ///< The channel shown in the waterfall
 	bool zoom; ///< true if the magnified scope is enabled
 };
 
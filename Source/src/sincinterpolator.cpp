@@ -0,0 +1,147 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  OpenHantek
+//  sincinterpolator.cpp
+//
+//  This program is free software: you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation, either version 3 of the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <cmath>
+
+#include <QtGlobal>
+
+
+#include "sincinterpolator.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// class SincInterpolator
+/// \brief Initializes the interpolator without any filter banks.
+SincInterpolator::SincInterpolator() {
+	this->output = 0;
+	this->outputSize = 0;
+	this->outputLength = 0;
+}
+
+/// \brief Frees the filter banks and the output buffer.
+SincInterpolator::~SincInterpolator() {
+	for(int index = 0; index < this->banks.count(); index++)
+		delete[] this->banks[index];
+	delete[] this->output;
+}
+
+/// \brief Chooses the upsampling ratio for the number of visible samples.
+/// \param visibleSamples The number of samples on the screen.
+/// \return The ratio, 1 if no interpolation is needed.
+unsigned int SincInterpolator::ratioForVisible(double visibleSamples) {
+	if(visibleSamples <= 0)
+		return 1;
+	
+	return qBound(1u, (unsigned int) ceil(SINCINTERPOLATOR_POINTS / visibleSamples), (unsigned int) SINCINTERPOLATOR_MAXIMUM_RATIO);
+}
+
+/// \brief Interpolates the samples between first and last.
+/// \param input The samples.
+/// \param count The number of samples.
+/// \param first The index of the first sample in the interpolated range.
+/// \param last The index of the last sample in the interpolated range.
+/// \param ratio The number of output samples per input sample.
+/// \return The interpolated samples, outputCount() values starting at first.
+const double *SincInterpolator::process(const double *input, unsigned int count, unsigned int first, unsigned int last, unsigned int ratio) {
+	ratio = qBound(1u, ratio, (unsigned int) SINCINTERPOLATOR_MAXIMUM_RATIO);
+	if(!count || first >= count) {
+		this->outputLength = 0;
+		return this->output;
+	}
+	last = qBound(first, last, count - 1);
+	
+	this->outputLength = (last - first) * ratio + 1;
+	if(this->outputSize < this->outputLength) {
+		delete[] this->output;
+		this->output = new double[this->outputLength];
+		this->outputSize = this->outputLength;
+	}
+	
+	const double *bank = this->bank(ratio);
+	const int before = SINCINTERPOLATOR_TAPS / 2 - 1;
+	double *output = this->output;
+	
+	for(unsigned int position = first; position < last; position++) {
+		int start = (int) position - before;
+		
+		if(start >= 0 && start + SINCINTERPOLATOR_TAPS <= (int) count) {
+			// All needed samples are available
+			const double *samples = input + start;
+			for(unsigned int phase = 0; phase < ratio; phase++) {
+				const double *kernel = bank + phase * SINCINTERPOLATOR_TAPS;
+				double sum = 0;
+				for(int tap = 0; tap < SINCINTERPOLATOR_TAPS; tap++)
+					sum += kernel[tap] * samples[tap];
+				*output++ = sum;
+			}
+		}
+		else {
+			// Repeat the first or last sample at the borders
+			for(unsigned int phase = 0; phase < ratio; phase++) {
+				const double *kernel = bank + phase * SINCINTERPOLATOR_TAPS;
+				double sum = 0;
+				for(int tap = 0; tap < SINCINTERPOLATOR_TAPS; tap++)
+					sum += kernel[tap] * input[qBound(0, start + tap, (int) count - 1)];
+				*output++ = sum;
+			}
+		}
+	}
+	*output = input[last];
+	
+	return this->output;
+}
+
+/// \brief Get the number of samples calculated by the last process() call.
+/// \return The number of interpolated samples.
+unsigned int SincInterpolator::outputCount() const {
+	return this->outputLength;
+}
+
+/// \brief Returns the filter bank for a ratio, it's calculated on first use.
+/// \param ratio The upsampling ratio.
+/// \return SINCINTERPOLATOR_TAPS coefficients for each of the ratio phases.
+const double *SincInterpolator::bank(unsigned int ratio) {
+	while((unsigned int) this->banks.count() < ratio)
+		this->banks.append(0);
+	if(this->banks[ratio - 1])
+		return this->banks[ratio - 1];
+	
+	double *bank = new double[ratio * SINCINTERPOLATOR_TAPS];
+	const double halfWidth = SINCINTERPOLATOR_TAPS / 2;
+	for(unsigned int phase = 0; phase < ratio; phase++) {
+		double *kernel = bank + phase * SINCINTERPOLATOR_TAPS;
+		double sum = 0;
+		for(int tap = 0; tap < SINCINTERPOLATOR_TAPS; tap++) {
+			// Distance between the input sample and the interpolated point
+			double distance = tap - (SINCINTERPOLATOR_TAPS / 2 - 1) - (double) phase / ratio;
+			double sinc = (distance == 0) ? 1 : sin(M_PI * distance) / (M_PI * distance);
+			double window = 0.42 + 0.5 * cos(M_PI * distance / halfWidth) + 0.08 * cos(2 * M_PI * distance / halfWidth);
+			kernel[tap] = sinc * window;
+			sum += kernel[tap];
+		}
+		// Unity gain for every phase avoids ripple on constant signals
+		for(int tap = 0; tap < SINCINTERPOLATOR_TAPS; tap++)
+			kernel[tap] /= sum;
+	}
+	
+	this->banks[ratio - 1] = bank;
+	return bank;
+}
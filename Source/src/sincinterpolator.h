@@ -0,0 +1,62 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  OpenHantek
+/// \file sincinterpolator.h
+/// \brief Declares the SincInterpolator class.
+//
+//  This program is free software: you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation, either version 3 of the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef SINCINTERPOLATOR_H
+#define SINCINTERPOLATOR_H
+
+
+#include <QList>
+
+
+#define SINCINTERPOLATOR_TAPS        16 ///< Input samples used for each output
+#define SINCINTERPOLATOR_MAXIMUM_RATIO 32 ///< Highest upsampling ratio
+#define SINCINTERPOLATOR_POINTS    2000 ///< Wanted number of visible points
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// \class SincInterpolator                                   sincinterpolator.h
+/// \brief Upsamples a range of samples with a windowed-sinc polyphase filter.
+/// For every ratio a bank with one Blackman windowed-sinc kernel per phase is
+/// calculated once and kept, so changing the timebase back and forth doesn't
+/// redesign the filters. Each output is a dot product of a fixed length that
+/// the compiler can unroll and vectorize.
+class SincInterpolator {
+	public:
+		SincInterpolator();
+		~SincInterpolator();
+		
+		static unsigned int ratioForVisible(double visibleSamples);
+		
+		const double *process(const double *input, unsigned int count, unsigned int first, unsigned int last, unsigned int ratio);
+		unsigned int outputCount() const;
+	
+	protected:
+		const double *bank(unsigned int ratio);
+		
+		QList<double *> banks; ///< The filter banks, the index is the ratio - 1
+		double *output; ///< The interpolated samples
+		unsigned int outputSize; ///< The allocated size of the output
+		unsigned int outputLength; ///< The number of interpolated samples
+};
+
+
+#endif
@@ -0,0 +1,162 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  OpenHantek
+//  spectrogram.cpp
+//
+//  This program is free software: you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation, either version 3 of the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <cmath>
+#include <cstring>
+
+#include <QtGlobal>
+
+
+#include "spectrogram.h"
+
+#include "dataanalyzer.h"
+#include "decibel.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// class Spectrogram
+/// \brief Initializes the color table, the empty ring and the transformation.
+Spectrogram::Spectrogram() {
+	// Black over blue, purple, orange and yellow to white
+	static const unsigned char stops[][3] = {
+		{0x00, 0x00, 0x00},
+		{0x00, 0x00, 0xa0},
+		{0xa0, 0x00, 0xa0},
+		{0xff, 0x60, 0x00},
+		{0xff, 0xe0, 0x00},
+		{0xff, 0xff, 0xff}
+	};
+	const int stopCount = sizeof(stops) / sizeof(stops[0]);
+	
+	this->colorTable.resize(SPECTROGRAM_COLORS);
+	for(int color = 0; color < SPECTROGRAM_COLORS; color++) {
+		double position = (double) color * (stopCount - 1) / (SPECTROGRAM_COLORS - 1);
+		int stop = qMin((int) position, stopCount - 2);
+		double fraction = position - stop;
+		
+		// Bytes in memory order, so the texels are RGBA on every platform
+		unsigned char texel[4];
+		for(int component = 0; component < 3; component++)
+			texel[component] = (unsigned char) (stops[stop][component] + fraction * (stops[stop + 1][component] - stops[stop][component]) + 0.5);
+		texel[3] = 0xff;
+		memcpy(&this->colorTable[color], texel, sizeof(texel));
+	}
+	
+	this->image.resize(SPECTROGRAM_ROWS * SPECTROGRAM_BINS);
+	this->appended = 0;
+	this->clear();
+	
+	this->input = (double *) fftw_malloc(sizeof(double) * SPECTROGRAM_BINS * 2);
+	this->output = (double *) fftw_malloc(sizeof(double) * SPECTROGRAM_BINS * 2);
+	this->window = (double *) fftw_malloc(sizeof(double) * SPECTROGRAM_BINS * 2);
+	this->lastWindow = (Dso::WindowFunction) -1;
+	this->power.resize(SPECTROGRAM_BINS);
+	this->plan = fftw_plan_r2r_1d(SPECTROGRAM_BINS * 2, this->input, this->output, FFTW_R2HC, FFTW_MEASURE);
+}
+
+/// \brief Frees the transformation.
+Spectrogram::~Spectrogram() {
+	fftw_destroy_plan(this->plan);
+	fftw_free(this->input);
+	fftw_free(this->output);
+	fftw_free(this->window);
+}
+
+/// \brief Appends the spectrum of a record as newest row.
+/// \param samples The samples of the record.
+/// \param count The number of samples.
+/// \param windowFunction The window function applied to each frame.
+/// \param offset Added to the power levels in dB.
+/// \param minimum The power level shown with the first color (dB).
+/// \param maximum The power level shown with the last color (dB).
+/// \param precise true if the power levels should use the exact logarithm.
+void Spectrogram::append(const double *samples, unsigned int count, Dso::WindowFunction windowFunction, double offset, double minimum, double maximum, bool precise) {
+	const unsigned int frameLength = SPECTROGRAM_BINS * 2;
+	if(!samples || !count)
+		return;
+	
+	if(windowFunction != this->lastWindow) {
+		this->lastWindow = windowFunction;
+		DataAnalyzer::calculateWindow(windowFunction, this->window, frameLength);
+	}
+	
+	// Half overlapping frames, spread over long records to limit the work
+	unsigned int frames = 1;
+	unsigned int hop = frameLength;
+	if(count > frameLength) {
+		frames = qMin((count - frameLength) / (frameLength / 2) + 1, (unsigned int) SPECTROGRAM_FRAMES);
+		hop = (frames > 1) ? (count - frameLength) / (frames - 1) : frameLength;
+	}
+	
+	this->power.fill(0);
+	for(unsigned int frame = 0; frame < frames; frame++) {
+		const double *frameSamples = samples + frame * hop;
+		unsigned int available = qMin(count - frame * hop, frameLength);
+		for(unsigned int position = 0; position < available; position++)
+			this->input[position] = this->window[position] * frameSamples[position];
+		for(unsigned int position = available; position < frameLength; position++)
+			this->input[position] = 0;
+		fftw_execute(this->plan);
+		
+		this->power[0] += this->output[0] * this->output[0];
+		for(unsigned int bin = 1; bin < SPECTROGRAM_BINS; bin++)
+			this->power[bin] += this->output[bin] * this->output[bin] + this->output[frameLength - bin] * this->output[frameLength - bin];
+	}
+	
+	// Map the averaged power levels to colors
+	this->newest = (this->newest + 1) % SPECTROGRAM_ROWS;
+	this->appended++;
+	quint32 *row = this->image.data() + this->newest * SPECTROGRAM_BINS;
+	double scale = (maximum > minimum) ? (SPECTROGRAM_COLORS - 1) / (maximum - minimum) : 0;
+	double levelOffset = offset - 10 * log10((double) frames) - 20 * log10((double) SPECTROGRAM_BINS) - minimum;
+	Decibel::fromPower(this->power.constData(), this->power.data(), SPECTROGRAM_BINS, levelOffset, 0, precise);
+	for(unsigned int bin = 0; bin < SPECTROGRAM_BINS; bin++)
+		row[bin] = this->colorTable[qMin((int) (this->power[bin] * scale), SPECTROGRAM_COLORS - 1)];
+}
+
+/// \brief Removes all rows.
+/// The count of appended rows advances by a whole ring, so viewers replace all
+/// of their rows.
+void Spectrogram::clear() {
+	this->image.fill(this->colorTable[0]);
+	this->newest = SPECTROGRAM_ROWS - 1;
+	this->appended += SPECTROGRAM_ROWS;
+}
+
+/// \brief Returns a row of the ring buffer.
+/// \param index The index of the row in the ring.
+/// \return SPECTROGRAM_BINS RGBA texels, the lowest frequency first.
+const quint32 *Spectrogram::row(unsigned int index) const {
+	return this->image.constData() + (index % SPECTROGRAM_ROWS) * SPECTROGRAM_BINS;
+}
+
+/// \brief Returns the position of the newest row in the ring.
+/// \return The index of the row appended last.
+unsigned int Spectrogram::newestRow() const {
+	return this->newest;
+}
+
+/// \brief Returns the number of rows appended so far.
+/// Viewers compare it with their own count to upload only the new rows.
+/// \return The number of rows appended, a clear() counts as a whole ring.
+unsigned long int Spectrogram::appendedRows() const {
+	return this->appended;
+}
@@ -0,0 +1,75 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  OpenHantek
+/// \file spectrogram.h
+/// \brief Declares the Spectrogram class.
+//
+//  This program is free software: you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation, either version 3 of the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef SPECTROGRAM_H
+#define SPECTROGRAM_H
+
+
+#include <QVector>
+
+#include <fftw3.h>
+
+
+#include "dso.h"
+
+
+#define SPECTROGRAM_BINS          256 ///< Frequency bins of a row, the frames are twice as long
+#define SPECTROGRAM_ROWS          256 ///< Rows kept in the ring buffer
+#define SPECTROGRAM_FRAMES         64 ///< Maximum number of frames averaged for a row
+#define SPECTROGRAM_COLORS        256 ///< Entries of the color table
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// \class Spectrogram                                             spectrogram.h
+/// \brief Ring buffer of colored short-time spectrums.
+/// Each record appends one row, the power of up to SPECTROGRAM_FRAMES half
+/// overlapping frames averaged. The rows are RGBA texels that can be uploaded
+/// to a texture as they are, the ring has a fixed size so the memory doesn't
+/// grow with the run time.
+class Spectrogram {
+	public:
+		Spectrogram();
+		~Spectrogram();
+		
+		void append(const double *samples, unsigned int count, Dso::WindowFunction windowFunction, double offset, double minimum, double maximum, bool precise = false);
+		void clear();
+		
+		const quint32 *row(unsigned int index) const;
+		unsigned int newestRow() const;
+		unsigned long int appendedRows() const;
+	
+	protected:
+		QVector<quint32> colorTable; ///< The RGBA texels for the power levels
+		QVector<quint32> image; ///< SPECTROGRAM_ROWS rows of SPECTROGRAM_BINS texels
+		unsigned int newest; ///< The index of the newest row
+		unsigned long int appended; ///< The number of rows appended, including the cleared ones
+		
+		double *input; ///< The windowed frame
+		double *output; ///< The half-complex spectrum of the frame
+		double *window; ///< The window factors
+		Dso::WindowFunction lastWindow; ///< The window function of the factors
+		QVector<double> power; ///< The accumulated power of the frames
+		fftw_plan plan; ///< The plan from input to output
+};
+
+
+#endif
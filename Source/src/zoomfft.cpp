@@ -0,0 +1,342 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  OpenHantek
+//  zoomfft.cpp
+//
+//  This program is free software: you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation, either version 3 of the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <cmath>
+
+#include <QtGlobal>
+
+
+#include "zoomfft.h"
+
+#include "decibel.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// class ZoomFft
+/// \brief Initializes an unconfigured zoom transform.
+ZoomFft::ZoomFft() {
+	this->sampleCount = 0;
+	this->samplerate = 0;
+	this->lowFrequency = 0;
+	this->highFrequency = 0;
+	this->valid = false;
+
+	this->tableLength = 0;
+	this->planSize = 0;
+	this->ncoCos = 0;
+	this->ncoSin = 0;
+	this->firCoefficients = 0;
+	this->compensation = 0;
+	this->mixedReal = 0;
+	this->mixedImaginary = 0;
+	this->fftInput = 0;
+	this->fftOutput = 0;
+	this->fftPlan = 0;
+
+	this->clear();
+}
+
+/// \brief Frees the tables and the FFTW plan.
+ZoomFft::~ZoomFft() {
+	this->clear();
+	this->freeBuffers();
+}
+
+/// \brief Prepares the tables for the given input and frequency band.
+/// Nothing is recalculated if the configuration hasn't changed, the FFTW plan
+/// is only measured again if the transform size changes.
+/// \param sampleCount The number of input samples.
+/// \param samplerate The samplerate of the input samples in S/s.
+/// \param lowFrequency The lower end of the band in Hz.
+/// \param highFrequency The upper end of the band in Hz.
+/// \return true if the band can be analyzed with the given input.
+bool ZoomFft::configure(unsigned int sampleCount, double samplerate, double lowFrequency, double highFrequency) {
+	if(sampleCount == this->sampleCount && samplerate == this->samplerate && lowFrequency == this->lowFrequency && highFrequency == this->highFrequency)
+		return this->valid;
+
+	this->clear();
+	this->sampleCount = sampleCount;
+	this->samplerate = samplerate;
+	this->lowFrequency = lowFrequency;
+	this->highFrequency = highFrequency;
+
+	// Limit the band to the frequencies we can see
+	lowFrequency = qMax(lowFrequency, 0.0);
+	highFrequency = qMin(highFrequency, samplerate / 2);
+	double bandwidth = highFrequency - lowFrequency;
+	if(samplerate <= 0 || bandwidth <= 0 || sampleCount < ZOOMFFT_MINIMUM_LENGTH)
+		return false;
+	this->centerFrequency = (lowFrequency + highFrequency) / 2;
+
+	// Split the total decimation into a coarse CIC and a fine FIR part
+	unsigned int decimation = qMax((unsigned int) (samplerate / (bandwidth * ZOOMFFT_GUARD)), 1u);
+	decimation = qMin(decimation, qMax(sampleCount / ZOOMFFT_MINIMUM_LENGTH / 2, 1u));
+	if(decimation >= 8) {
+		this->firDecimation = 4;
+		this->cicDecimation = decimation / 4;
+	}
+	else {
+		this->firDecimation = decimation;
+		this->cicDecimation = 1;
+	}
+	double cicRate = samplerate / this->cicDecimation;
+	double decimatedRate = cicRate / this->firDecimation;
+
+	// Design the Blackman windowed-sinc lowpass, stored reversed for the dot product
+	this->firLength = (this->firDecimation > 1) ? ZOOMFFT_FIR_TAPS_PER_PHASE * this->firDecimation + 1 : 1;
+	this->firCoefficients = new double[this->firLength];
+	if(this->firLength == 1)
+		this->firCoefficients[0] = 1.0;
+	else {
+		double cutoff = (bandwidth / 2 + decimatedRate / 2) / 2 / cicRate;
+		double sum = 0;
+		unsigned int end = this->firLength - 1;
+		for(unsigned int tap = 0; tap < this->firLength; tap++) {
+			double position = (double) tap - end / 2.0;
+			double sinc = (position == 0) ? 2 * cutoff : sin(2 * M_PI * cutoff * position) / (M_PI * position);
+			double window = 0.42 - 0.5 * cos(2 * M_PI * tap / end) + 0.08 * cos(4 * M_PI * tap / end);
+			this->firCoefficients[end - tap] = sinc * window;
+			sum += sinc * window;
+		}
+		for(unsigned int tap = 0; tap < this->firLength; tap++)
+			this->firCoefficients[tap] /= sum;
+	}
+
+	// The CIC needs a few outputs to settle, the FIR needs a full history
+	unsigned int cicCount = sampleCount / this->cicDecimation;
+	unsigned int cicSettle = (this->cicDecimation > 1) ? ZOOMFFT_CIC_ORDER : 0;
+	if(cicCount < cicSettle + this->firLength) {
+		this->clear();
+		return false;
+	}
+	this->decimatedLength = (cicCount - cicSettle - this->firLength) / this->firDecimation + 1;
+	if(this->decimatedLength < ZOOMFFT_MINIMUM_LENGTH / 2) {
+		this->clear();
+		return false;
+	}
+
+	// Oscillator table that shifts the center of the band to 0 Hz, the buffers are kept for the same sample count
+	if(this->tableLength != sampleCount) {
+		delete[] this->ncoCos;
+		delete[] this->ncoSin;
+		delete[] this->mixedReal;
+		delete[] this->mixedImaginary;
+		this->ncoCos = new double[sampleCount];
+		this->ncoSin = new double[sampleCount];
+		this->mixedReal = new double[sampleCount];
+		this->mixedImaginary = new double[sampleCount];
+		this->tableLength = sampleCount;
+	}
+	double phaseStep = 2 * M_PI * this->centerFrequency / samplerate;
+	for(unsigned int position = 0; position < sampleCount; position++) {
+		this->ncoCos[position] = cos(phaseStep * position);
+		this->ncoSin[position] = -sin(phaseStep * position);
+	}
+
+	// Zero padded transform, the plan is reused until the transform size changes
+	this->fftSize = 256;
+	while(this->fftSize < this->decimatedLength * ZOOMFFT_PADDING && this->fftSize < ZOOMFFT_MAXIMUM_SIZE)
+		this->fftSize *= 2;
+	while(this->fftSize < this->decimatedLength)
+		this->fftSize *= 2;
+	if(this->planSize != this->fftSize) {
+		if(this->fftPlan)
+			fftw_destroy_plan(this->fftPlan);
+		if(this->fftInput)
+			fftw_free(this->fftInput);
+		if(this->fftOutput)
+			fftw_free(this->fftOutput);
+		this->fftInput = (fftw_complex *) fftw_malloc(sizeof(fftw_complex) * this->fftSize);
+		this->fftOutput = (fftw_complex *) fftw_malloc(sizeof(fftw_complex) * this->fftSize);
+		this->fftPlan = fftw_plan_dft_1d(this->fftSize, this->fftInput, this->fftOutput, FFTW_FORWARD, FFTW_MEASURE);
+		this->planSize = this->fftSize;
+	}
+
+	// Bins inside the band, counted from the lowest frequency of the transform
+	this->binInterval = decimatedRate / this->fftSize;
+	int first = (int) ceil((lowFrequency - this->centerFrequency) / this->binInterval) + this->fftSize / 2;
+	int last = (int) floor((highFrequency - this->centerFrequency) / this->binInterval) + this->fftSize / 2;
+	first = qBound(0, first, (int) this->fftSize - 1);
+	last = qBound(first, last, (int) this->fftSize - 1);
+	this->firstBin = first;
+	this->bins = last - first + 1;
+
+	// Undo the passband droop of the CIC filter
+	this->compensation = new double[this->bins];
+	for(unsigned int bin = 0; bin < this->bins; bin++) {
+		double relative = ((double) (this->firstBin + bin) - this->fftSize / 2) * this->binInterval / samplerate;
+		double response = 1.0;
+		if(this->cicDecimation > 1 && relative != 0)
+			response = fabs(sin(M_PI * relative * this->cicDecimation) / (this->cicDecimation * sin(M_PI * relative)));
+		this->compensation[bin] = (response > 0) ? pow(response, -2 * ZOOMFFT_CIC_ORDER) : 1;
+	}
+
+	this->valid = true;
+	return true;
+}
+
+/// \brief Calculates the spectrum of the configured band.
+/// \param input The sampleCount input samples.
+/// \param window The decimatedCount() window factors.
+/// \param output The array for the binCount() spectrum values in dB.
+/// \param offset The offset that is added to all dB values.
+/// \param offsetLimit The minimum dB value.
+/// \param precise true if the dB values should use the exact logarithm.
+void ZoomFft::process(const double *input, const double *window, double *output, double offset, double offsetLimit, bool precise) {
+	if(!this->valid)
+		return;
+
+	// Mix down to baseband
+	for(unsigned int position = 0; position < this->sampleCount; position++) {
+		this->mixedReal[position] = input[position] * this->ncoCos[position];
+		this->mixedImaginary[position] = input[position] * this->ncoSin[position];
+	}
+
+	// CIC decimation, done in place since the output is never ahead of the input
+	unsigned int cicCount = this->sampleCount;
+	if(this->cicDecimation > 1) {
+		double integratorReal[ZOOMFFT_CIC_ORDER], integratorImaginary[ZOOMFFT_CIC_ORDER];
+		double combReal[ZOOMFFT_CIC_ORDER], combImaginary[ZOOMFFT_CIC_ORDER];
+		for(int stage = 0; stage < ZOOMFFT_CIC_ORDER; stage++)
+			integratorReal[stage] = integratorImaginary[stage] = combReal[stage] = combImaginary[stage] = 0;
+		double gain = 1.0 / pow((double) this->cicDecimation, ZOOMFFT_CIC_ORDER);
+
+		cicCount = this->sampleCount / this->cicDecimation;
+		unsigned int position = 0;
+		for(unsigned int cicPosition = 0; cicPosition < cicCount; cicPosition++) {
+			for(unsigned int step = 0; step < this->cicDecimation; step++, position++) {
+				double valueReal = this->mixedReal[position], valueImaginary = this->mixedImaginary[position];
+				for(int stage = 0; stage < ZOOMFFT_CIC_ORDER; stage++) {
+					integratorReal[stage] += valueReal;
+					integratorImaginary[stage] += valueImaginary;
+					valueReal = integratorReal[stage];
+					valueImaginary = integratorImaginary[stage];
+				}
+			}
+
+			double valueReal = integratorReal[ZOOMFFT_CIC_ORDER - 1], valueImaginary = integratorImaginary[ZOOMFFT_CIC_ORDER - 1];
+			for(int stage = 0; stage < ZOOMFFT_CIC_ORDER; stage++) {
+				double delayedReal = combReal[stage], delayedImaginary = combImaginary[stage];
+				combReal[stage] = valueReal;
+				combImaginary[stage] = valueImaginary;
+				valueReal -= delayedReal;
+				valueImaginary -= delayedImaginary;
+			}
+			this->mixedReal[cicPosition] = valueReal * gain;
+			this->mixedImaginary[cicPosition] = valueImaginary * gain;
+		}
+	}
+	const double *cicReal = this->mixedReal + cicCount - (this->decimatedLength - 1) * this->firDecimation - this->firLength;
+	const double *cicImaginary = this->mixedImaginary + (cicReal - this->mixedReal);
+
+	// FIR decimation, the inner loop is a plain dot product
+	for(unsigned int position = 0; position < this->decimatedLength; position++) {
+		const double *historyReal = cicReal + position * this->firDecimation;
+		const double *historyImaginary = cicImaginary + position * this->firDecimation;
+		double sumReal = 0, sumImaginary = 0;
+		for(unsigned int tap = 0; tap < this->firLength; tap++) {
+			sumReal += this->firCoefficients[tap] * historyReal[tap];
+			sumImaginary += this->firCoefficients[tap] * historyImaginary[tap];
+		}
+		this->fftInput[position][0] = sumReal * window[position];
+		this->fftInput[position][1] = sumImaginary * window[position];
+	}
+	for(unsigned int position = this->decimatedLength; position < this->fftSize; position++)
+		this->fftInput[position][0] = this->fftInput[position][1] = 0;
+
+	fftw_execute(this->fftPlan);
+
+	// Get the compensated power of the bins inside the band, the transform output isn't shifted
+	unsigned int halfSize = this->fftSize / 2;
+	for(unsigned int bin = 0; bin < this->bins; bin++) {
+		unsigned int fftBin = (this->firstBin + bin + halfSize) % this->fftSize;
+		output[bin] = (this->fftOutput[fftBin][0] * this->fftOutput[fftBin][0] + this->fftOutput[fftBin][1] * this->fftOutput[fftBin][1]) * this->compensation[bin];
+	}
+	Decibel::fromPower(output, output, this->bins, offset, offsetLimit, precise);
+}
+
+/// \brief Returns the number of decimated samples, the window has to match it.
+/// \return The decimated sample count, 0 if not configured.
+unsigned int ZoomFft::decimatedCount() const {
+	return this->valid ? this->decimatedLength : 0;
+}
+
+/// \brief Returns the number of spectrum values inside the band.
+/// \return The number of output values, 0 if not configured.
+unsigned int ZoomFft::binCount() const {
+	return this->valid ? this->bins : 0;
+}
+
+/// \brief Returns the frequency of the first spectrum value.
+/// \return The frequency of the first output value in Hz.
+double ZoomFft::firstFrequency() const {
+	return this->centerFrequency + ((double) this->firstBin - this->fftSize / 2) * this->binInterval;
+}
+
+/// \brief Returns the distance between two spectrum values.
+/// \return The frequency interval of the output values in Hz.
+double ZoomFft::frequencyInterval() const {
+	return this->binInterval;
+}
+
+/// \brief Forgets the configuration and frees the tables of the band.
+/// The oscillator buffers and the FFTW plan are kept for the next configuration.
+void ZoomFft::clear() {
+	this->valid = false;
+	this->cicDecimation = 1;
+	this->firDecimation = 1;
+	this->firLength = 0;
+	this->decimatedLength = 0;
+	this->fftSize = 0;
+	this->firstBin = 0;
+	this->bins = 0;
+	this->centerFrequency = 0;
+	this->binInterval = 0;
+
+	delete[] this->firCoefficients;
+	this->firCoefficients = 0;
+	delete[] this->compensation;
+	this->compensation = 0;
+}
+
+/// \brief Frees the oscillator buffers and the FFTW plan.
+void ZoomFft::freeBuffers() {
+	if(this->fftPlan)
+		fftw_destroy_plan(this->fftPlan);
+	this->fftPlan = 0;
+	if(this->fftInput)
+		fftw_free(this->fftInput);
+	this->fftInput = 0;
+	if(this->fftOutput)
+		fftw_free(this->fftOutput);
+	this->fftOutput = 0;
+	this->planSize = 0;
+
+	delete[] this->ncoCos;
+	this->ncoCos = 0;
+	delete[] this->ncoSin;
+	this->ncoSin = 0;
+	delete[] this->mixedReal;
+	this->mixedReal = 0;
+	delete[] this->mixedImaginary;
+	this->mixedImaginary = 0;
+	this->tableLength = 0;
+}
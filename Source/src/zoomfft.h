@@ -0,0 +1,94 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  OpenHantek
+/// \file zoomfft.h
+/// \brief Declares the ZoomFft class.
+//
+//  This program is free software: you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation, either version 3 of the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef ZOOMFFT_H
+#define ZOOMFFT_H
+
+
+#include <fftw3.h>
+
+
+#define ZOOMFFT_CIC_ORDER             3 ///< Number of CIC integrator/comb stages
+#define ZOOMFFT_FIR_TAPS_PER_PHASE   16 ///< FIR taps per decimation step
+#define ZOOMFFT_GUARD              1.25 ///< Decimated rate relative to the band
+#define ZOOMFFT_MINIMUM_LENGTH       32 ///< Minimum number of decimated samples
+#define ZOOMFFT_PADDING               4 ///< Zero padding factor for the transform
+#define ZOOMFFT_MAXIMUM_SIZE    (1 << 16) ///< Maximum length of the transform
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// \class ZoomFft                                                     zoomfft.h
+/// \brief Calculates a high-resolution spectrum for a narrow frequency band.
+/// The input is mixed down to baseband by a numerically controlled oscillator,
+/// decimated by a CIC filter followed by a FIR lowpass and transformed with a
+/// complex FFT. The FFTW plan and its buffers only depend on the transform
+/// size and the oscillator buffers on the sample count, so moving the band
+/// only recalculates the oscillator, filter and compensation tables.
+class ZoomFft {
+	public:
+		ZoomFft();
+		~ZoomFft();
+
+		bool configure(unsigned int sampleCount, double samplerate, double lowFrequency, double highFrequency);
+		void process(const double *input, const double *window, double *output, double offset, double offsetLimit, bool precise = false);
+
+		unsigned int decimatedCount() const;
+		unsigned int binCount() const;
+		double firstFrequency() const;
+		double frequencyInterval() const;
+
+	protected:
+		void clear();
+		void freeBuffers();
+
+		// The configuration the tables have been built for
+		unsigned int sampleCount; ///< Number of input samples
+		double samplerate; ///< Samplerate of the input samples in S/s
+		double lowFrequency; ///< Lower end of the band in Hz
+		double highFrequency; ///< Upper end of the band in Hz
+		bool valid; ///< true if the tables match the configuration
+
+		unsigned int cicDecimation; ///< Decimation factor of the CIC filter
+		unsigned int firDecimation; ///< Decimation factor of the FIR filter
+		unsigned int firLength; ///< Number of FIR taps
+		unsigned int decimatedLength; ///< Number of valid decimated samples
+		unsigned int fftSize; ///< Length of the (zero padded) transform
+		unsigned int firstBin; ///< First shifted transform bin inside the band
+		unsigned int bins; ///< Number of transform bins inside the band
+		double centerFrequency; ///< Frequency mixed down to 0 Hz
+		double binInterval; ///< Frequency distance between two bins in Hz
+
+		unsigned int tableLength; ///< Length of the oscillator tables and the mixing buffers
+		unsigned int planSize; ///< Length the FFTW plan and its buffers were made for
+		double *ncoCos; ///< In-phase oscillator table
+		double *ncoSin; ///< Quadrature oscillator table
+		double *firCoefficients; ///< Reversed FIR lowpass coefficients
+		double *compensation; ///< CIC droop compensation for each bin as power factor
+		double *mixedReal; ///< In-phase part of the CIC output
+		double *mixedImaginary; ///< Quadrature part of the CIC output
+		fftw_complex *fftInput; ///< Windowed decimated samples
+		fftw_complex *fftOutput; ///< Complex spectrum
+		fftw_plan fftPlan; ///< The plan for the decimated transform
+};
+
+
+#endif
@@ -0,0 +1,211 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  OpenHantek
+//  capturetest.cpp
+//
+//  Checks that capture files give back the recorded samples. The codec is
+//  checked with both predictions, the SSE2 one and the plain C++ one have to
+//  write the same bytes. Whole frames go through CaptureWriter into a
+//  temporary file and are read back with CaptureReader:
+//    bin/openhantek-tests
+//  Every failed check is printed, the exit code is the number of failures.
+//
+//  This program is free software: you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation, either version 3 of the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#include <QCoreApplication>
+#include <QList>
+#include <QMutex>
+#include <QStringList>
+#include <QTemporaryFile>
+#include <QVector>
+
+
+#include "capturecodec.h"
+#include "capturefile.h"
+#include "settings.h"
+
+
+#define TEST_PATTERNS                 4 ///< Constant, ramp, full scale swing and noisy sine
+#define TEST_STEP           (10.0 / 256) ///< The step of the simulated 8 bit ADC
+#define TEST_OFFSET                 0.3 ///< The value of the code 0
+
+
+static int failures = 0; ///< The number of failed checks
+
+/// \brief Reports a failed check.
+/// \param condition false if the check has failed.
+/// \param name The description of the check.
+static void check(bool condition, const QString &name) {
+	if(!condition) {
+		qWarning("FAIL: %s", qPrintable(name));
+		failures++;
+	}
+}
+
+/// \brief Get a code of a test pattern.
+/// \param pattern The index of the pattern.
+/// \param position The position of the code.
+/// \param bits The resolution of the codes, 8 or 16.
+/// \return The code at the position.
+static qint16 patternCode(int pattern, unsigned int position, int bits) {
+	int factor = 1 << (bits - 8);
+	switch(pattern) {
+		case 0:
+			return 17;
+		case 1:
+			return (qint16) (((int) (position % 256) - 128) * factor);
+		case 2:
+			// The largest second order prediction errors
+			return (qint16) (position % 2 ? (1 << (bits - 1)) - 1 : -(1 << (bits - 1)));
+		default:
+			return (qint16) (((int) floor(100 * sin(position * 0.01) + 0.5) + rand() % 3 - 1) * factor);
+	}
+}
+
+/// \brief Checks the codec with both predictions.
+/// \param patternNames The names of the patterns.
+/// \param counts The code counts, with partial last blocks.
+static void testCodec(const QStringList &patternNames, const QList<unsigned int> &counts) {
+	for(int pattern = 0; pattern < TEST_PATTERNS; pattern++) {
+		for(int countIndex = 0; countIndex < counts.count(); countIndex++) {
+			unsigned int count = counts[countIndex];
+			QString name = QString("codec, %1, %2 codes").arg(patternNames[pattern]).arg(count);
+			
+			QVector<qint16> codes(count);
+			for(unsigned int position = 0; position < count; position++)
+				codes[position] = patternCode(pattern, position, 16);
+			
+			QByteArray vectorized(CaptureCodec::maxEncodedSize(count), 0), plain(CaptureCodec::maxEncodedSize(count), 0);
+			int vectorizedSize = CaptureCodec::encode(codes.constData(), count, (uchar *) vectorized.data(), true);
+			int plainSize = CaptureCodec::encode(codes.constData(), count, (uchar *) plain.data(), false);
+			check(vectorizedSize == plainSize && !memcmp(vectorized.constData(), plain.constData(), plainSize), name + ": the predictions give different bytes");
+			check(plainSize <= CaptureCodec::maxEncodedSize(count), name + ": larger than the maximum size");
+			
+			for(int path = 0; path < 2; path++) {
+				QVector<qint16> decoded(count);
+				bool valid = CaptureCodec::decode((const uchar *) plain.constData(), plainSize, count, decoded.data(), path == 0);
+				check(valid && decoded == codes, name + (path == 0 ? ": SSE2 decoding failed" : ": C++ decoding failed"));
+			}
+			
+			if(count) {
+				QVector<qint16> decoded(count);
+				check(!CaptureCodec::decode((const uchar *) plain.constData(), plainSize - 1, count, decoded.data()), name + ": truncated codes accepted");
+			}
+		}
+	}
+}
+
+/// \brief Records frames into a file and reads them back.
+/// \param patternNames The names of the patterns.
+/// \param counts The sample counts, with partial last blocks.
+static void testFrames(const QStringList &patternNames, const QList<unsigned int> &counts) {
+	QTemporaryFile temporaryFile;
+	if(!temporaryFile.open()) {
+		check(false, "frames: no temporary file");
+		return;
+	}
+	QString fileName = temporaryFile.fileName();
+	temporaryFile.close();
+	
+	// Two channels of different length with two patterns in every frame
+	DsoSettings settings;
+	settings.setChannelCount(2);
+	CaptureWriter writer;
+	if(!writer.open(fileName, &settings, 2)) {
+		check(false, "frames: can't create " + fileName);
+		return;
+	}
+	
+	QMutex mutex;
+	QList<QVector<double> > expected;
+	QStringList frameNames;
+	for(int pattern = 0; pattern < TEST_PATTERNS; pattern++) {
+		for(int countIndex = 0; countIndex < counts.count(); countIndex++) {
+			QList<double *> data;
+			QList<unsigned int> size;
+			for(int channel = 0; channel < 2; channel++) {
+				int channelPattern = (pattern + channel) % TEST_PATTERNS;
+				unsigned int count = counts[countIndex] + channel * 17;
+				QVector<double> samples(count);
+				for(unsigned int position = 0; position < count; position++)
+					samples[position] = patternCode(channelPattern, position, 8) * TEST_STEP + TEST_OFFSET;
+				expected.append(samples);
+				data.append(expected.last().data());
+				size.append(count);
+			}
+			frameNames.append(QString("frames, %1, %2 samples").arg(patternNames[pattern]).arg(counts[countIndex]));
+			
+			writer.addFrame(&data, &size, 1e6, &mutex);
+		}
+	}
+	check(writer.close(), "frames: the recording is incomplete");
+	check(writer.droppedFrames() == 0, "frames: frames were dropped");
+	
+	CaptureReader reader;
+	if(!reader.open(fileName)) {
+		check(false, "frames: can't read " + fileName);
+		return;
+	}
+	check(reader.frameCount() == frameNames.count(), "frames: wrong frame count");
+	check(reader.compressionRatio() > 1, "frames: nothing compressed");
+	
+	QList<double *> data;
+	QList<unsigned int> size;
+	for(int frame = 0; frame < frameNames.count() && frame < reader.frameCount(); frame++) {
+		double samplerate = 0;
+		if(!reader.readFrame(frame, &data, &size, &samplerate)) {
+			check(false, frameNames[frame] + ": can't read the frame");
+			continue;
+		}
+		check(samplerate == 1e6, frameNames[frame] + ": wrong samplerate");
+		
+		for(int channel = 0; channel < 2; channel++) {
+			const QVector<double> &samples = expected[frame * 2 + channel];
+			bool equal = channel < data.count() && size[channel] == (unsigned int) samples.count();
+			for(int position = 0; equal && position < samples.count(); position++)
+				equal = fabs(data[channel][position] - samples[position]) < 1e-9;
+			check(equal, frameNames[frame] + QString(": channel %1 differs").arg(channel + 1));
+		}
+	}
+	for(int channel = 0; channel < data.count(); channel++)
+		delete[] data[channel];
+}
+
+/// \brief Runs all checks.
+int main(int argc, char *argv[]) {
+	QCoreApplication application(argc, argv);
+	srand(1);
+	
+	QStringList patternNames;
+	patternNames << "constant" << "ramp" << "full scale" << "noisy sine";
+	QList<unsigned int> counts;
+	counts << 0 << 1 << 63 << 64 << 65 << 128 << 1000 << 10240;
+	
+	testCodec(patternNames, counts);
+	testFrames(patternNames, counts);
+	
+	if(failures)
+		qWarning("%d checks failed", failures);
+	else
+		qDebug("All checks passed%s", CaptureCodec::hasSse2() ? "" : ", without SSE2");
+	
+	return failures;
+}
@@ -0,0 +1,42 @@
+TEMPLATE = app
+
+# Configuration
+CONFIG += warn_on \
+    qt \
+    console
+QT += opengl widgets
+
+# Source files, the capture files are taken from the program
+SOURCES += capturetest.cpp \
+    ../src/capturecodec.cpp \
+    ../src/capturefile.cpp \
+    ../src/mathexpression.cpp \
+    ../src/settings.cpp
+HEADERS += ../src/capturecodec.h \
+    ../src/capturefile.h \
+    ../src/settings.h
+
+# Destination directory for built binaries
+DESTDIR = bin
+
+# Build directories
+OBJECTS_DIR = build/obj
+MOC_DIR = build/moc
+
+# Include directory
+QMAKE_CXXFLAGS += "-iquote $${IN_PWD}/../src"
+
+# Settings for different operating systems
+unix:!macx {
+    TARGET = openhantek-tests
+    DEFINES += OS_UNIX
+}
+macx {
+    TARGET = OpenHantekTests
+    CONFIG -= app_bundle
+    DEFINES += OS_DARWIN
+}
+win32 {
+    TARGET = OpenHantekTests
+    DEFINES += OS_WINDOWS
+}